@@ -96,13 +96,18 @@
   GPIO peripheral (only) via /dev/gpiomem, and this library supports
   that limited mode of operation.
 
+  bcm2835_init() only maps the GPIO registers, through /dev/gpiomem when
+  it exists (falling back to /dev/mem). Every other peripheral block is
+  mapped, one page at a time, the first time it is needed: by the *_begin()
+  functions, the PWM and pads functions, bcm2835_st_read() and
+  bcm2835_regbase().
+
   If the library runs with effective UID of 0 (ie root), then
-  bcm2835_init() will attempt to open /dev/mem, and, if successful, it
-  will permit use of all peripherals and library functions.
+  those blocks are mapped through /dev/mem, which permits use of all
+  peripherals and library functions.
 
   If the library runs with any other effective UID (ie not root), then
-  bcm2835_init() will attempt to open /dev/gpiomem, and, if
-  successful, will only permit GPIO operations. In particular,
+  only GPIO operations are permitted. In particular,
   bcm2835_spi_begin() and bcm2835_i2c_begin() will return false and all
   other non-gpio operations may fail silently or crash.
 
@@ -655,6 +660,19 @@
 #define BCM2835_HAVE_DMB
 #endif
 
+/* Define BCM2835_SIMULATION (the BCM2835_SIMULATION option of the cFS build does this
+   for the library and every app using it) to build the library without any peripheral
+   access. The register accessors are then empty, /dev/mem is never mapped and the
+   library behaves as the old runtime debug mode did, so it runs on a host without
+   the RPi hardware. The choice is made at build time so that the accessors in the
+   bus loops inline to a single load or store on the target.
+*/
+#ifdef BCM2835_SIMULATION
+#define BCM2835_DEBUG 1
+#else
+#define BCM2835_DEBUG 0
+#endif
+
 /*! \defgroup constants Constants for passing to and from library functions
   The values here are designed to be passed to various functions in the bcm2835 library.
   @{
@@ -717,6 +735,13 @@
 #define BCM2835_SPI2_BASE				0x2150C0
 /*! Base Address of the BSC1 registers */
 #define BCM2835_BSC1_BASE				0x804000
+/*! Base Address of the DMA controller registers (channels 0 to 14) */
+#define BCM2835_DMA_BASE				0x007000
+
+/*! Peripheral addresses as seen by the DMA engine (VC bus address space) */
+#define BCM2835_PERI_BUS_BASE           0x7E000000
+/*! Bus alias of the SDRAM that bypasses the VC L2 cache, used for DMA buffers */
+#define BCM2835_DMA_BUS_SDRAM           0xC0000000
 
 #include <stdlib.h>
 
@@ -727,11 +752,15 @@ extern off_t bcm2835_peripherals_base;
 /*! Size of the peripherals block to be mapped */
 extern size_t bcm2835_peripherals_size;
 
-/*! Virtual memory address of the mapped peripherals block */
+/*! Virtual memory address of the mapped peripherals block.
+  The block is no longer mapped as a whole (MAP_FAILED, except in
+  BCM2835_SIMULATION builds): use the register bases below, or bcm2835_regbase().
+*/
 extern uint32_t *bcm2835_peripherals;
 
 /*! Base of the ST (System Timer) registers.
-  Available after bcm2835_init has been called (as root)
+  Available after bcm2835_init has been called (as root), and mapped on first use:
+  this and the other bases except bcm2835_gpio are MAP_FAILED until then
 */
 extern volatile uint32_t *bcm2835_st;
 
@@ -780,12 +809,11 @@ extern volatile uint32_t *bcm2835_aux;
 */
 extern volatile uint32_t *bcm2835_spi1;
 
-
-/*! Variable for the mutex thought for the I2C access.
+/*! Base of the DMA controller registers.
   Available after bcm2835_init has been called (as root)
 */
+extern volatile uint32_t *bcm2835_dma;
 
-extern uint32_t i2c_mutexvar;
 
 /*! \brief bcm2835RegisterBase
   Register bases for bcm2835_regbase()
@@ -801,9 +829,19 @@ typedef enum
     BCM2835_REGBASE_BSC0 = 7, /*!< Base of the BSC0 registers. */
     BCM2835_REGBASE_BSC1 = 8,  /*!< Base of the BSC1 registers. */
 	BCM2835_REGBASE_AUX  = 9,  /*!< Base of the AUX registers. */
-	BCM2835_REGBASE_SPI1 = 10  /*!< Base of the SPI1 registers. */
+	BCM2835_REGBASE_SPI1 = 10, /*!< Base of the SPI1 registers. */
+	BCM2835_REGBASE_DMA  = 11  /*!< Base of the DMA registers. */
 } bcm2835RegisterBase;
 
+/*! \brief Peripheral mapping figures, see bcm2835_get_map_stats() */
+typedef struct
+{
+    uint32_t InitUs;       /*!< Duration of the last bcm2835_init() */
+    uint32_t MappedBytes;  /*!< Bytes of peripheral registers currently mapped */
+    uint32_t Regions;      /*!< Peripheral blocks currently mapped */
+    uint8_t  GpioMem;      /*!< 1 if the GPIO registers were mapped through /dev/gpiomem */
+} bcm2835_map_stats_t;
+
 /*! Size of memory page on RPi */
 #define BCM2835_PAGE_SIZE               (4*1024)
 /*! Size of memory block on RPi */
@@ -1133,6 +1171,18 @@ typedef enum
     BCM2835_SPI_CS_NONE = 3  /*!< No CS, control it yourself */
 } bcm2835SPIChipSelect;
 
+/*! \brief bcm2835_spi_seg_t
+  One segment of an SPI transaction, see bcm2835_spi_transfer_segments().
+  Either pointer may be NULL: a NULL tx sends zeros, a NULL rx discards the
+  received bytes. rx may point straight into a telemetry (SB) message.
+*/
+typedef struct
+{
+    const char *tx;   /*!< Bytes to send, or NULL */
+    char       *rx;   /*!< Where to put the received bytes, or NULL */
+    uint32_t    len;  /*!< Number of bytes in this segment */
+} bcm2835_spi_seg_t;
+
 /*! \brief bcm2835SPIClockDivider
   Specifies the divider used to generate the SPI clock from the system clock.
   Figures below give the divider, clock period and clock frequency.
@@ -1168,6 +1218,76 @@ typedef enum
     BCM2835_SPI_CLOCK_DIVIDER_1     = 1        /*!< 1 = 3.814697260kHz on Rpi2, 6.1035156kHz on RPI3, same as 0/65536 */
 } bcm2835SPIClockDivider;
 
+/* Defines for DMA
+   Register offsets from the base of a DMA channel, which is
+   BCM2835_DMA_BASE + channel * BCM2835_DMA_CHANNEL_SIZE, per 4.2.1 DMA Register Map
+*/
+#define BCM2835_DMA_CHANNEL_SIZE             0x0100 /*!< Size of the register block of a channel */
+#define BCM2835_DMA_CHANNELS                 15     /*!< Channels 0 to 14; 7 to 14 are DMA Lite */
+#define BCM2835_DMA_CS                       0x0000 /*!< DMA Control and Status */
+#define BCM2835_DMA_CONBLK_AD                0x0004 /*!< DMA Control Block Address */
+#define BCM2835_DMA_TI                       0x0008 /*!< DMA Transfer Information */
+#define BCM2835_DMA_SOURCE_AD                0x000c /*!< DMA Source Address */
+#define BCM2835_DMA_DEST_AD                  0x0010 /*!< DMA Destination Address */
+#define BCM2835_DMA_TXFR_LEN                 0x0014 /*!< DMA Transfer Length */
+#define BCM2835_DMA_DEBUG                    0x0020 /*!< DMA Debug */
+#define BCM2835_DMA_ENABLE                   0x0ff0 /*!< Global enable bits, one per channel */
+
+/* Register masks for DMA_CS */
+#define BCM2835_DMA_CS_RESET                 0x80000000 /*!< Reset the channel */
+#define BCM2835_DMA_CS_ABORT                 0x40000000 /*!< Abort the current control block */
+#define BCM2835_DMA_CS_WAIT_WRITES           0x10000000 /*!< Wait for outstanding writes */
+#define BCM2835_DMA_CS_PANIC_PRIORITY(x)     (((x) & 0xf) << 20) /*!< AXI panic priority */
+#define BCM2835_DMA_CS_PRIORITY(x)           (((x) & 0xf) << 16) /*!< AXI priority */
+#define BCM2835_DMA_CS_ERROR                 0x00000100 /*!< DMA Error */
+#define BCM2835_DMA_CS_INT                   0x00000004 /*!< Interrupt status */
+#define BCM2835_DMA_CS_END                   0x00000002 /*!< DMA End flag, write 1 to clear */
+#define BCM2835_DMA_CS_ACTIVE                0x00000001 /*!< Activate the DMA */
+
+/* Register masks for DMA_TI (also the ti word of a control block) */
+#define BCM2835_DMA_TI_NO_WIDE_BURSTS        0x04000000 /*!< Don't do wide writes as a 2 beat burst */
+#define BCM2835_DMA_TI_PERMAP(x)             (((x) & 0x1f) << 16) /*!< Peripheral mapping (DREQ) */
+#define BCM2835_DMA_TI_SRC_DREQ              0x00000400 /*!< Control source reads with DREQ */
+#define BCM2835_DMA_TI_SRC_INC               0x00000100 /*!< Source address increment */
+#define BCM2835_DMA_TI_DEST_DREQ             0x00000040 /*!< Control destination writes with DREQ */
+#define BCM2835_DMA_TI_DEST_INC              0x00000010 /*!< Destination address increment */
+#define BCM2835_DMA_TI_WAIT_RESP             0x00000008 /*!< Wait for a write response */
+#define BCM2835_DMA_TI_INTEN                 0x00000001 /*!< Interrupt enable */
+
+/* DREQ peripheral numbers for BCM2835_DMA_TI_PERMAP */
+#define BCM2835_DMA_DREQ_SPI0_TX             6 /*!< SPI0 TX FIFO */
+#define BCM2835_DMA_DREQ_SPI0_RX             7 /*!< SPI0 RX FIFO */
+#define BCM2835_DMA_DREQ_PWM                 5 /*!< PWM FIFO */
+
+/*! \brief bcm2835_dma_cb_t
+  DMA control block, read by the DMA engine from a 32 byte aligned bus address.
+*/
+typedef struct
+{
+    uint32_t ti;          /*!< Transfer information, BCM2835_DMA_TI_* */
+    uint32_t source_ad;   /*!< Source bus address */
+    uint32_t dest_ad;     /*!< Destination bus address */
+    uint32_t txfr_len;    /*!< Transfer length in bytes */
+    uint32_t stride;      /*!< 2D mode stride, unused */
+    uint32_t nextconbk;   /*!< Bus address of the next control block, 0 to stop */
+    uint32_t reserved[2];
+} bcm2835_dma_cb_t;
+
+/*! Default DMA channel used for the SPI0 TX FIFO (see bcm2835_spi_dma_begin()) */
+#ifndef BCM2835_SPI_DMA_TX_CHANNEL
+#define BCM2835_SPI_DMA_TX_CHANNEL           6
+#endif
+/*! Default DMA channel used for the SPI0 RX FIFO (see bcm2835_spi_dma_begin()) */
+#ifndef BCM2835_SPI_DMA_RX_CHANNEL
+#define BCM2835_SPI_DMA_RX_CHANNEL           7
+#endif
+/*! Transfers shorter than this many bytes use the polled CPU path, where the
+  DMA set up costs more than it saves. The SPI0 FIFO is 64 bytes deep. */
+#define BCM2835_SPI_DMA_THRESHOLD            96
+/*! Longest DMA transfer. The SPI0 DLEN is 16 bits and the first FIFO word
+  carries the length, so longer transfers use the polled CPU path. */
+#define BCM2835_SPI_DMA_MAX_LEN              65532
+
 /* Defines for I2C
    GPIO register offsets from BCM2835_BSC*_BASE.
    Offsets into the BSC Peripheral block in bytes per 3.1 BSC Register Map
@@ -1225,9 +1345,268 @@ typedef enum
     BCM2835_I2C_REASON_OK   	     = 0x00,      /*!< Success */
     BCM2835_I2C_REASON_ERROR_NACK    = 0x01,      /*!< Received a NACK */
     BCM2835_I2C_REASON_ERROR_CLKT    = 0x02,      /*!< Received Clock Stretch Timeout */
-    BCM2835_I2C_REASON_ERROR_DATA    = 0x04       /*!< Not all data is sent / received */
+    BCM2835_I2C_REASON_ERROR_DATA    = 0x04,      /*!< Not all data is sent / received */
+    BCM2835_I2C_REASON_ERROR_BUS     = 0x08       /*!< Invalid bus index */
 } bcm2835I2CReasonCodes;
 
+/*! \brief bcm2835I2CBus
+  BSC controllers that can be used as I2C masters by the bcm2835_i2c_bus_* functions.
+  Each controller has its own clock divider and scheduler, so devices on different
+  buses can be accessed in parallel from different tasks.
+*/
+typedef enum
+{
+    BCM2835_I2C_BUS_BSC0             = 0,         /*!< BSC0, GPIO 0 (SDA) and 1 (SCL) */
+    BCM2835_I2C_BUS_BSC1             = 1,         /*!< BSC1, GPIO 2 (SDA) and 3 (SCL), P1-03 and P1-05 on V2 boards */
+    BCM2835_I2C_BUS_COUNT            = 2          /*!< Number of controllers */
+} bcm2835I2CBus;
+
+/*! Standard-mode I2C clock, in Hz */
+#define BCM2835_I2C_SPEED_STANDARD      100000
+/*! Fast-mode I2C clock, in Hz */
+#define BCM2835_I2C_SPEED_FAST          400000
+/*! Fast-mode Plus I2C clock, in Hz */
+#define BCM2835_I2C_SPEED_FAST_PLUS     1000000
+/*! A clock step is only accepted if the device also works this percentage above it */
+#define BCM2835_I2C_SPEED_MARGIN_PCT    25
+
+/*! \brief Statistics kept in an I2C device handle, see \ref bcm2835_i2c_device_t */
+typedef struct
+{
+    uint32_t Transactions;    /*!< Number of transfers */
+    uint32_t Bytes;           /*!< Number of bytes moved by successful transfers */
+    uint32_t Errors;          /*!< Number of transfers that did not return BCM2835_I2C_REASON_OK */
+    uint64_t BusTimeUs;       /*!< Cumulative time spent in transfers, in microseconds */
+} bcm2835_i2c_device_stats_t;
+
+/*! \brief Handle of a device on an I2C bus.
+  Set up with bcm2835_i2c_device_init(). The members may be read but should only be
+  changed with the bcm2835_i2c_device_set_* functions.
+*/
+typedef struct
+{
+    uint8_t  bus;             /*!< Controller, see \ref bcm2835I2CBus */
+    uint8_t  address;         /*!< 7 bit slave address */
+    uint16_t divider;         /*!< Clock divider derived from baudrate */
+    uint32_t baudrate;        /*!< Preferred clock of the device, in Hz */
+    uint16_t clkt;            /*!< Clock stretch timeout in SCL cycles, 0 leaves the controller setting */
+    uint32_t fallback_baudrate; /*!< Clock given to bcm2835_i2c_device_init(), lowest clock used by negotiation */
+    uint32_t checked_errors;  /*!< stats.Errors at the last negotiation or revalidation */
+    bcm2835_i2c_device_stats_t stats; /*!< Transfer statistics */
+} bcm2835_i2c_device_t;
+
+/*! \brief Device check used by the I2C clock negotiation.
+  Performs a few transfers that identify the device (e.g. WHO_AM_I and registers with known
+  contents) and returns 1 if all of them gave the expected data, 0 otherwise.
+*/
+typedef uint8_t (*bcm2835_i2c_verify_fn)(bcm2835_i2c_device_t *dev, void *arg);
+
+/*! Maximum number of clients that can register with the I2C bus scheduler of one bus */
+#define BCM2835_I2C_SCHED_MAX_CLIENTS   8
+/*! Maximum length of an I2C bus scheduler client name, including the terminator */
+#define BCM2835_I2C_SCHED_NAME_LEN      16
+/*! Timeout value for bcm2835_i2c_sched_acquire() that waits until the bus is granted */
+#define BCM2835_I2C_SCHED_PEND_FOREVER  (-1)
+
+/*! \brief bcm2835I2CSchedStatus
+  Status codes returned by the bcm2835_i2c_sched_* functions.
+*/
+typedef enum
+{
+    BCM2835_I2C_SCHED_OK             = 0,   /*!< Success */
+    BCM2835_I2C_SCHED_ERR_INVALID    = -1,  /*!< Unknown client id or bad argument */
+    BCM2835_I2C_SCHED_ERR_FULL       = -2,  /*!< No free client slot */
+    BCM2835_I2C_SCHED_ERR_TIMEOUT    = -3,  /*!< The bus was not granted within the timeout */
+    BCM2835_I2C_SCHED_ERR_NOT_OWNER  = -4,  /*!< The client does not hold the bus */
+    BCM2835_I2C_SCHED_ERR_OS         = -5   /*!< An OSAL call failed */
+} bcm2835I2CSchedStatus;
+
+/*! \brief Per-client statistics kept by the I2C bus scheduler.
+  All times are in microseconds.
+*/
+typedef struct
+{
+    uint32_t Grants;          /*!< Number of times the bus was granted to the client */
+    uint32_t Jobs;            /*!< Number of jobs (periods) started by the client */
+    uint32_t DeadlineMisses;  /*!< Number of jobs that still held or waited for the bus after their deadline */
+    uint32_t Timeouts;        /*!< Number of acquire calls that timed out */
+    uint32_t Preemptions;     /*!< Number of times the client handed the bus over in bcm2835_i2c_sched_yield() */
+    uint32_t MaxWaitUs;       /*!< Longest time spent waiting for the bus */
+    uint32_t MaxHoldUs;       /*!< Longest time the bus was held in one grant */
+} bcm2835_i2c_sched_stats_t;
+
+/*! \brief bcm2835SPIController
+  SPI controllers that can be used through bcm2835_spi_device_t handles.
+*/
+typedef enum
+{
+    BCM2835_SPI_CTRL_SPI0  = 0,  /*!< SPI0, chip selects CE0 and CE1 */
+    BCM2835_SPI_CTRL_AUX   = 1,  /*!< AUX SPI1, chip select CE2 */
+    BCM2835_SPI_CTRL_COUNT = 2   /*!< Number of controllers */
+} bcm2835SPIController;
+
+/*! Number of GPIO lines that can have edge events (BCM2835 GPIO 0 to 53) */
+#define BCM2835_GPIO_EVENT_MAX_PINS     54
+/*! GPIO character device of the BCM2835 GPIO lines; line offsets are the GPIO numbers */
+#define BCM2835_GPIO_EVENT_CHIP         "/dev/gpiochip0"
+/*! Stack size of the GPIO event dispatcher task */
+#define BCM2835_GPIO_EVENT_STACK_SIZE   8192
+
+/*! \brief bcm2835GPIOEdge
+  Edges for bcm2835_gpio_event_add(), and the edge of a bcm2835_gpio_event_t.
+*/
+typedef enum
+{
+    BCM2835_GPIO_EDGE_RISING  = 0x01,  /*!< Low to high */
+    BCM2835_GPIO_EDGE_FALLING = 0x02,  /*!< High to low */
+    BCM2835_GPIO_EDGE_BOTH    = 0x03   /*!< Either, only valid for bcm2835_gpio_event_add() */
+} bcm2835GPIOEdge;
+
+/*! \brief bcm2835GPIOEventStatus
+  Status codes returned by the bcm2835_gpio_event* functions.
+*/
+typedef enum
+{
+    BCM2835_GPIO_EVENT_OK          = 0,   /*!< Success */
+    BCM2835_GPIO_EVENT_ERR_INVALID = -1,  /*!< Bad argument, or the dispatcher is not running */
+    BCM2835_GPIO_EVENT_ERR_BUSY    = -2,  /*!< The pin already has a handler */
+    BCM2835_GPIO_EVENT_ERR_OS      = -3   /*!< A system, OSAL or cFE call failed */
+} bcm2835GPIOEventStatus;
+
+/*! \brief One GPIO edge, as delivered to a handler or queue.
+*/
+typedef struct
+{
+    uint64   timestamp_ns;  /*!< Kernel timestamp of the edge (time of injection in simulation builds) */
+    uint8_t  pin;           /*!< GPIO number */
+    uint8_t  edge;          /*!< BCM2835_GPIO_EDGE_RISING or BCM2835_GPIO_EDGE_FALLING */
+} bcm2835_gpio_event_t;
+
+/*! \brief GPIO edge handler, called from the dispatcher task.
+  Must not block; hand work over to another task (e.g. with a semaphore) instead.
+*/
+typedef void (*bcm2835_gpio_event_fn)(const bcm2835_gpio_event_t *event, void *arg);
+
+/*! \brief One step of a GPIO waveform, see \ref bcm2835_wave_t.
+  The pins in set are driven high and those in clr low at the same time (two
+  consecutive register writes), then the waveform holds for delay_us before
+  the next step. Only GPIO 0 to 31 can be used.
+*/
+typedef struct
+{
+    uint32_t set;       /*!< Mask of pins to drive high */
+    uint32_t clr;       /*!< Mask of pins to drive low */
+    uint32_t delay_us;  /*!< Time until the next step, in System Timer ticks (us) */
+} bcm2835_wave_step_t;
+
+/*! \brief A waveform compiled into steps, built with the bcm2835_wave_* functions
+  in storage owned by the caller, and replayed with bcm2835_wave_play().
+*/
+typedef struct
+{
+    bcm2835_wave_step_t *steps;     /*!< Step storage */
+    uint32_t             count;     /*!< Steps in use */
+    uint32_t             capacity;  /*!< Size of steps */
+    uint32_t             duration_us; /*!< Sum of the step delays */
+} bcm2835_wave_t;
+
+/*! \brief Timing of the last bcm2835_wave_play(), to check the edge accuracy of a waveform */
+typedef struct
+{
+    uint32_t steps;        /*!< Steps played */
+    uint32_t duration_us;  /*!< Time from the first to the last step */
+    uint32_t max_late_us;  /*!< Largest delay of a step after its scheduled time */
+    uint32_t late_steps;   /*!< Steps played one tick or more after their scheduled time */
+} bcm2835_wave_result_t;
+
+/*! Number of lateness histogram bins of a periodic wakeup. Bin 0 counts wakeups
+  less than 1 us late, bin n (n > 0) those less than 2^n us late, the last bin all others. */
+#define BCM2835_PERIODIC_HIST_BINS      16
+/*! Default bound of the final spin of a periodic wakeup, in nanoseconds */
+#define BCM2835_PERIODIC_SPIN_MAX_NS    200000
+
+/*! \brief Statistics of a periodic wakeup, see bcm2835_periodic_wait().
+*/
+typedef struct
+{
+    uint32_t Periods;                               /*!< Number of wakeups */
+    uint32_t Overruns;                              /*!< Number of periods skipped because the caller was too late */
+    uint32_t MaxLatenessNs;                         /*!< Latest wakeup, relative to its deadline */
+    uint32_t SleepMarginNs;                         /*!< Current calibrated sleep overshoot */
+    uint64   SumLatenessNs;                         /*!< Sum of the lateness of all wakeups, for the mean */
+    uint32_t Hist[BCM2835_PERIODIC_HIST_BINS];      /*!< Lateness histogram, see BCM2835_PERIODIC_HIST_BINS */
+} bcm2835_periodic_stats_t;
+
+/*! \brief State of a periodic wakeup. Initialise with bcm2835_periodic_init().
+*/
+typedef struct
+{
+    uint64   PeriodNs;   /*!< Period */
+    uint64   NextNs;     /*!< Next deadline on CLOCK_MONOTONIC */
+    uint32_t SpinMaxNs;  /*!< Bound of the final spin */
+    bcm2835_periodic_stats_t Stats;
+} bcm2835_periodic_t;
+
+/*! Timeout value for the bcm2835_spi_* functions that waits without limit */
+#define BCM2835_SPI_PEND_FOREVER        (-1)
+/*! Number of requests that can be queued on the worker of one SPI controller */
+#define BCM2835_SPI_WORKER_QUEUE_DEPTH  8
+/*! Stack size of an SPI controller worker task */
+#define BCM2835_SPI_WORKER_STACK_SIZE   8192
+
+/*! \brief bcm2835SPIStatus
+  Status codes returned by the SPI device and worker functions.
+*/
+typedef enum
+{
+    BCM2835_SPI_OK            = 0,   /*!< Success */
+    BCM2835_SPI_PENDING       = 1,   /*!< The request is queued or running */
+    BCM2835_SPI_ERR_INVALID   = -1,  /*!< Bad argument, or the controller/worker is not set up */
+    BCM2835_SPI_ERR_TIMEOUT   = -2,  /*!< The controller or the request did not complete within the timeout */
+    BCM2835_SPI_ERR_FULL      = -3,  /*!< The worker queue is full */
+    BCM2835_SPI_ERR_OS        = -4   /*!< An OSAL or cFE call failed */
+} bcm2835SPIStatus;
+
+/*! \brief Handle of a device on an SPI controller.
+  Holds everything the device needs from the controller; the settings are applied
+  under the controller lock at the start of every transaction, so devices with
+  different settings can share a controller.
+*/
+typedef struct
+{
+    uint8_t  controller;   /*!< Controller, see \ref bcm2835SPIController */
+    uint8_t  chip_select;  /*!< \ref bcm2835SPIChipSelect. AUX only supports BCM2835_SPI_CS2 */
+    uint8_t  mode;         /*!< \ref bcm2835SPIMode. AUX only supports BCM2835_SPI_MODE0 */
+    uint8_t  bit_order;    /*!< \ref bcm2835SPIBitOrder. AUX only supports MSB first */
+    uint32_t speed_hz;     /*!< SCLK frequency */
+} bcm2835_spi_device_t;
+
+/*! \brief Per-controller statistics of the SPI device functions.
+  All times are in microseconds.
+*/
+typedef struct
+{
+    uint32_t Transactions;  /*!< Number of completed transactions */
+    uint32_t Bytes;         /*!< Number of bytes clocked */
+    uint32_t Timeouts;      /*!< Number of transactions that timed out waiting for the controller */
+    uint32_t MaxWaitUs;     /*!< Longest time a transaction waited for the controller */
+    uint64   BusTimeUs;     /*!< Total time the controller was busy with transactions */
+} bcm2835_spi_stats_t;
+
+/*! \brief Asynchronous SPI request, run by the worker of the device's controller.
+  Initialise once with bcm2835_spi_request_init(), then submit and wait as often as needed.
+  The device and the segments must stay valid until the request has completed.
+*/
+typedef struct
+{
+    const bcm2835_spi_device_t *dev;     /*!< Device, set by bcm2835_spi_submit() */
+    const bcm2835_spi_seg_t    *segs;    /*!< Segments, set by bcm2835_spi_submit() */
+    uint32_t                    count;   /*!< Number of segments */
+    volatile int32_t            status;  /*!< BCM2835_SPI_PENDING until collected by bcm2835_spi_request_wait() */
+    volatile int32_t            result;  /*!< Status of the transaction, written by the worker */
+    osal_id_t                   done;    /*!< Given by the worker when the request has completed */
+} bcm2835_spi_request_t;
+
 /* Defines for ST
    GPIO register offsets from BCM2835_ST_BASE.
    Offsets into the ST Peripheral block in bytes per 12.1 System Timer Registers
@@ -1278,6 +1657,242 @@ typedef enum
 #define BCM2835_PWM0_SERIAL     0x0002  /*!< Run in serial mode */
 #define BCM2835_PWM0_ENABLE     0x0001  /*!< Channel Enable */
 
+#define BCM2835_PWM_DMAC_ENAB       0x80000000                /*!< Enable the PWM DMA requests */
+#define BCM2835_PWM_DMAC_PANIC(x)   (((x) & 0xff) << 8)       /*!< FIFO level of the panic signal */
+#define BCM2835_PWM_DMAC_DREQ(x)    ((x) & 0xff)              /*!< FIFO level of the DREQ signal */
+
+#define BCM2835_PWMCLK_CNTL_BUSY    0x80  /*!< Clock generator is running */
+#define BCM2835_PWMCLK_CNTL_KILL    0x20  /*!< Stop the clock generator at once (may glitch) */
+#define BCM2835_PWMCLK_CNTL_ENAB    0x10  /*!< Enable the clock generator */
+#define BCM2835_PWMCLK_CNTL_SRC_OSC 0x01  /*!< Source: 19.2 MHz oscillator */
+/*! Longest wait for the PWM clock generator to stop before it is killed */
+#define BCM2835_PWMCLK_BUSY_TIMEOUT_US 1000
+
+/*! Default DMA channel of the PWM stream (see bcm2835_pwm_stream_begin()) */
+#ifndef BCM2835_PWM_STREAM_DMA_CHANNEL
+#define BCM2835_PWM_STREAM_DMA_CHANNEL 5
+#endif
+/*! Pages of samples in the ring buffer of the PWM stream, 1024 samples each */
+#define BCM2835_PWM_STREAM_RING_PAGES  4
+/*! Samples of the ring ahead of the DMA read position that may already be in flight
+  (control block prefetch and the PWM FIFO), never rewritten by bcm2835_pwm_stream_write() */
+#define BCM2835_PWM_STREAM_GUARD       32
+
+/*! \brief Statistics of the PWM stream, see bcm2835_pwm_stream_get_stats() */
+typedef struct
+{
+    uint32_t Samples;    /*!< Samples accepted by bcm2835_pwm_stream_write() */
+    uint32_t Underruns;  /*!< Times the DMA consumed all the queued samples */
+    uint32_t Queued;     /*!< Samples written and not yet played */
+} bcm2835_pwm_stream_stats_t;
+
+/*! Records kept by the bus trace, a power of 2 */
+#ifndef BCM2835_TRACE_DEPTH
+#define BCM2835_TRACE_DEPTH      1024
+#endif
+/*! Bytes of transferred data kept in each trace record */
+#define BCM2835_TRACE_DATA       8
+/*! Records searched ahead for a match during replay */
+#define BCM2835_TRACE_REPLAY_WINDOW 64
+/*! First word of a trace file, "BTRC" */
+#define BCM2835_TRACE_MAGIC      0x43525442
+/*! Format version of a trace file */
+#define BCM2835_TRACE_VERSION    1
+
+/*! \brief bcm2835TraceKind
+  Transaction types of the bus trace
+*/
+typedef enum
+{
+    BCM2835_TRACE_I2C_WRITE      = 1,  /*!< bcm2835_i2c_bus_write() */
+    BCM2835_TRACE_I2C_READ       = 2,  /*!< bcm2835_i2c_bus_read() */
+    BCM2835_TRACE_I2C_READ_REG   = 3,  /*!< bcm2835_i2c_bus_read_register_rs() */
+    BCM2835_TRACE_I2C_WRITE_READ = 4,  /*!< bcm2835_i2c_bus_write_read_rs() */
+    BCM2835_TRACE_SPI0           = 5,  /*!< bcm2835_spi_transfer_segments() */
+    BCM2835_TRACE_AUX_SPI        = 6   /*!< bcm2835_aux_spi_transfer_segments() */
+} bcm2835TraceKind;
+
+/*! \brief bcm2835TraceClock
+  Time base of the timestamps of a trace
+*/
+typedef enum
+{
+    BCM2835_TRACE_CLOCK_MONOTONIC = 0, /*!< CLOCK_MONOTONIC, low 32 bits in us */
+    BCM2835_TRACE_CLOCK_ST        = 1  /*!< System Timer, low 32 bits (CLO) */
+} bcm2835TraceClock;
+
+/*! \brief One bus transaction of the trace, 32 bytes */
+typedef struct
+{
+    uint32_t seq;           /*!< Sequence number from 1, 0 while the record is being written */
+    uint32_t timestamp_us;  /*!< Start of the transaction, see \ref bcm2835TraceClock */
+    uint32_t duration_us;   /*!< Duration of the transaction */
+    uint32_t caller;        /*!< OSAL id of the calling task, as an integer */
+    uint16_t len;           /*!< Bytes transferred in both directions */
+    uint8_t  kind;          /*!< See \ref bcm2835TraceKind */
+    uint8_t  controller;    /*!< I2C bus (\ref bcm2835I2CBus) or 0 for SPI */
+    uint8_t  address;       /*!< I2C slave address or SPI chip select */
+    uint8_t  reg;           /*!< First byte written, usually the register */
+    uint8_t  status;        /*!< Reason code of I2C transactions (\ref bcm2835I2CReasonCodes), 0 for SPI */
+    uint8_t  spare;
+    uint8_t  data[BCM2835_TRACE_DATA]; /*!< First bytes read, or written if nothing is read */
+} bcm2835_trace_rec_t;
+
+/*! \brief Header of a trace file, followed by count records oldest first */
+typedef struct
+{
+    uint32_t magic;         /*!< BCM2835_TRACE_MAGIC */
+    uint16_t version;       /*!< BCM2835_TRACE_VERSION */
+    uint16_t rec_size;      /*!< sizeof(bcm2835_trace_rec_t) */
+    uint32_t count;         /*!< Records in the file */
+    uint8_t  clock;         /*!< See \ref bcm2835TraceClock */
+    uint8_t  spare[3];
+} bcm2835_trace_file_hdr_t;
+
+/*! \brief Bus trace figures, see bcm2835_trace_get_stats() */
+typedef struct
+{
+    uint32_t Recorded;      /*!< Transactions recorded since start */
+    uint32_t Overwritten;   /*!< Records lost to newer ones */
+    uint32_t ReplayLoaded;  /*!< Records loaded for replay */
+    uint32_t ReplayHits;    /*!< Simulated transactions served from a replay record */
+    uint32_t ReplayMisses;  /*!< Simulated transactions with no matching record */
+} bcm2835_trace_stats_t;
+
+/*! Bins of the bus latency histograms: bin 0 counts 0 us, bin n from 2^(n-1) to 2^n - 1 us,
+  the last bin everything above */
+#define BCM2835_BUS_HIST_BINS      16
+/*! Devices (controller and address pairs) with their own bus statistics */
+#define BCM2835_BUS_STATS_DEVICES  16
+
+/*! \brief bcm2835Bus
+  Bus controllers of the bus statistics
+*/
+typedef enum
+{
+    BCM2835_BUS_I2C0    = 0,  /*!< BSC0 */
+    BCM2835_BUS_I2C1    = 1,  /*!< BSC1 */
+    BCM2835_BUS_SPI0    = 2,  /*!< SPI0 */
+    BCM2835_BUS_AUX_SPI = 3,  /*!< AUX SPI (SPI1) */
+    BCM2835_BUS_COUNT   = 4   /*!< Number of controllers */
+} bcm2835Bus;
+
+/*! \brief Waits for the lock of a bus controller (I2C scheduler or SPI device lock) */
+typedef struct
+{
+    uint32_t Waits;                       /*!< Lock requests */
+    uint32_t Timeouts;                    /*!< Requests that timed out */
+    uint32_t TotalUs;                     /*!< Sum of the waits */
+    uint32_t MaxUs;                       /*!< Longest wait */
+    uint32_t Hist[BCM2835_BUS_HIST_BINS]; /*!< Histogram of the waits */
+} bcm2835_bus_lock_stats_t;
+
+/*! \brief Transactions with one device */
+typedef struct
+{
+    uint8_t  Bus;                         /*!< See \ref bcm2835Bus */
+    uint8_t  Address;                     /*!< I2C slave address or SPI chip select */
+    uint16_t Spare;
+    uint32_t Transactions;                /*!< Transactions */
+    uint32_t Errors;                      /*!< Transactions that failed */
+    uint32_t Bytes;                       /*!< Bytes transferred */
+    uint32_t TotalUs;                     /*!< Sum of the transfer times */
+    uint32_t MaxUs;                       /*!< Longest transfer */
+    uint32_t Hist[BCM2835_BUS_HIST_BINS]; /*!< Histogram of the transfer times */
+} bcm2835_bus_dev_stats_t;
+
+/*! \brief Bus statistics, see bcm2835_bus_get_stats() */
+typedef struct
+{
+    bcm2835_bus_lock_stats_t Lock[BCM2835_BUS_COUNT];          /*!< Lock waits by controller */
+    bcm2835_bus_dev_stats_t  Dev[BCM2835_BUS_STATS_DEVICES];   /*!< Devices in order of first use */
+    uint32_t                 Devices;                          /*!< Valid entries of Dev */
+    uint32_t                 Untracked;                        /*!< Transactions of devices beyond Dev */
+} bcm2835_bus_stats_t;
+
+/*! Timeout of bcm2835_lock_acquire() to wait without limit */
+#define BCM2835_LOCK_PEND_FOREVER  (-1)
+/*! Upper bound of the adaptive spin of bcm2835_lock_acquire(), in polls of the lock */
+#ifndef BCM2835_LOCK_SPIN_MAX
+#define BCM2835_LOCK_SPIN_MAX      200
+#endif
+
+/*! \brief bcm2835LockStatus
+  Status codes returned by bcm2835_lock_acquire()
+*/
+typedef enum
+{
+    BCM2835_LOCK_OK          = 0,   /*!< The lock is held by the caller */
+    BCM2835_LOCK_ERR_TIMEOUT = -1,  /*!< The lock was not free in time */
+    BCM2835_LOCK_ERR_OS      = -2   /*!< The futex call failed, e.g. the caller already holds the lock */
+} bcm2835LockStatus;
+
+/*! \brief Figures of a bcm2835_lock_t, see bcm2835_lock_get_stats() */
+typedef struct
+{
+    uint32_t Acquisitions;   /*!< Times the lock was taken */
+    uint32_t Contended;      /*!< Acquisitions that found the lock held */
+    uint32_t Timeouts;       /*!< Acquisitions that timed out */
+    uint32_t WaitTotalUs;    /*!< Sum of the waits of contended acquisitions */
+    uint32_t WaitMaxUs;      /*!< Longest wait */
+    uint32_t HoldTotalUs;    /*!< Sum of the times the lock was held */
+    uint32_t HoldMaxUs;      /*!< Longest time the lock was held */
+} bcm2835_lock_stats_t;
+
+/*! \brief Lock for short critical sections, see bcm2835_lock_init().
+  The members are private. */
+typedef struct
+{
+    uint32_t             Word;         /*!< Futex word: thread id of the owner and FUTEX_WAITERS, 0 if free */
+    uint32_t             Spins;        /*!< Adaptive spin count */
+    uint64_t             HoldStartUs;  /*!< When the owner took the lock */
+    bcm2835_lock_stats_t Stats;
+} bcm2835_lock_t;
+
+/*! Largest depth of a bcm2835_sb_pool_t */
+#define BCM2835_SB_POOL_MAX        8
+
+/*! \brief Software Bus buffers allocated ahead, see bcm2835_sb_pool_init().
+  The members are private. */
+typedef struct
+{
+    CFE_SB_Buffer_t *Buf[BCM2835_SB_POOL_MAX];  /*!< Buffers held, the first Count are valid */
+    size_t           Size;                      /*!< Size of each buffer */
+    uint16_t         Depth;                     /*!< Buffers the pool is filled up to */
+    uint16_t         Count;                     /*!< Buffers held */
+} bcm2835_sb_pool_t;
+
+/*! \brief Sequence lock of a latest-value cache, see bcm2835_seqlock_write().
+  Zero-initialise it, or call bcm2835_seqlock_init(). The member is private. */
+typedef struct
+{
+    uint32_t Seq;  /*!< Odd while the value is being written, 0 if never written */
+} bcm2835_seqlock_t;
+
+/*! Event IDs tracked by a bcm2835_evs_limit_t, higher IDs are always sent */
+#ifndef BCM2835_EVS_LIMIT_IDS
+#define BCM2835_EVS_LIMIT_IDS  32
+#endif
+
+/*! \brief Events of one ID in the current window of a bcm2835_evs_limit_t */
+typedef struct
+{
+    uint16_t Type;        /*!< Type of the last event */
+    uint16_t Sent;        /*!< Events sent */
+    uint32_t Suppressed;  /*!< Events counted but not sent */
+} bcm2835_evs_limit_entry_t;
+
+/*! \brief Event rate limiter of an app, see bcm2835_evs_limit_init().
+  The members are private. */
+typedef struct
+{
+    const char               *Name;         /*!< Prefix of the summary events */
+    uint16_t                  Burst;        /*!< Events of an ID sent per window */
+    uint32_t                  WindowS;      /*!< Length of the window in seconds */
+    uint32_t                  WindowStart;  /*!< Start of the window, cFE time seconds */
+    bcm2835_evs_limit_entry_t Entry[BCM2835_EVS_LIMIT_IDS];
+} bcm2835_evs_limit_t;
+
 /*! \brief bcm2835PWMClockDivider
   Specifies the divider used to generate the PWM clock from the system clock.
   Figures below give the divider, clock period and clock frequency.
@@ -1315,10 +1930,10 @@ extern "C" {
       @{
     */
 
-    /*! Initialise the library by opening /dev/mem (if you are root) 
-      or /dev/gpiomem (if you are not)
-      and getting pointers to the 
-      internal memory for BCM 2835 device registers. You must call this (successfully)
+    /*! Initialise the library by mapping the GPIO registers from /dev/gpiomem
+      (or /dev/mem if there is no /dev/gpiomem and you are root).
+      The other device registers are mapped from /dev/mem when first used.
+      You must call this (successfully)
       before calling any other 
       functions in this library (except bcm2835_set_debug). 
       If bcm2835_init() fails by returning 0, 
@@ -1335,12 +1950,17 @@ extern "C" {
     */
     extern int bcm2835_close(void);
 
+    /*! Reads how long bcm2835_init() took and how much is mapped.
+      \param[out] stats Mapping figures
+    */
+    extern void bcm2835_get_map_stats(bcm2835_map_stats_t *stats);
+
     /*! Sets the debug level of the library.
-      A value of 1 prevents mapping to /dev/mem, and makes the library print out
-      what it would do, rather than accessing the GPIO registers.
-      A value of 0, the default, causes normal operation.
-      Call this before calling bcm2835_init();
-      \param[in] debug The new debug level. 1 means debug
+      Debug mode is now selected at build time with BCM2835_SIMULATION, which
+      prevents mapping to /dev/mem and makes the register accessors do nothing.
+      This function is kept for source compatibility; it only reports a request
+      that does not match the way the library was built.
+      \param[in] debug The requested debug level. 1 means debug
     */
     extern void  bcm2835_set_debug(uint8_t debug);
 
@@ -1358,23 +1978,29 @@ extern "C" {
       @{
     */
 
-    /*! Gets the base of a register
+    /*! Gets the base of a register, mapping its peripheral block if needed
       \param[in] regbase You can use one of the common values BCM2835_REGBASE_*
       in \ref bcm2835RegisterBase
-      \return the register base
+      \return the register base, MAP_FAILED if it cannot be mapped
       \sa Physical Addresses
     */
     extern uint32_t* bcm2835_regbase(uint8_t regbase);
 
-    /*! Reads 32 bit value from a peripheral address WITH a memory barrier before and after each read.
-      This is safe, but slow.  The MB before protects this read from any in-flight reads that didn't
-      use a MB.  The MB after protects subsequent reads from another peripheral.
-
-      \param[in] paddr Physical address to read from. See BCM2835_GPIO_BASE etc.
-      \return the value read from the 32 bit register
-      \sa Physical Addresses
-    */
-    extern uint32_t bcm2835_peri_read(volatile uint32_t* paddr);
+    /*! Issues a full memory barrier.
+      Accesses to different peripherals may be reordered by the bus, so a barrier is
+      needed whenever the code switches from one peripheral to another. Code that
+      drives a single peripheral for a while (e.g. a FIFO loop) should issue one
+      barrier on entry, use the _nb accessors for every register of that peripheral,
+      and issue one barrier before returning.
+    */
+    static inline void bcm2835_memory_barrier(void)
+    {
+#ifdef BCM2835_SIMULATION
+        __asm__ __volatile__ ("" ::: "memory");
+#else
+        __sync_synchronize();
+#endif
+    }
 
     /*! Reads 32 bit value from a peripheral address WITHOUT the read barriers
       You should only use this when:
@@ -1386,21 +2012,32 @@ extern "C" {
       \return the value read from the 32 bit register
       \sa Physical Addresses
     */
-    extern uint32_t bcm2835_peri_read_nb(volatile uint32_t* paddr);
-
-
-    /*! Writes 32 bit value from a peripheral address WITH a memory barrier before and after each write
-      This is safe, but slow.  The MB before ensures that any in-flight write to another peripheral
-      completes before this write is issued.  The MB after ensures that subsequent reads and writes
-      to another peripheral will see the effect of this write.
+    static inline uint32_t bcm2835_peri_read_nb(volatile uint32_t* paddr)
+    {
+#ifdef BCM2835_SIMULATION
+        (void)paddr;
+        return 0;
+#else
+        return *paddr;
+#endif
+    }
 
-      This is a tricky optimization; if you aren't sure, use the barrier version.
+    /*! Reads 32 bit value from a peripheral address WITH a memory barrier before and after each read.
+      This is safe, but slow.  The MB before protects this read from any in-flight reads that didn't
+      use a MB.  The MB after protects subsequent reads from another peripheral.
 
       \param[in] paddr Physical address to read from. See BCM2835_GPIO_BASE etc.
-      \param[in] value The 32 bit value to write
+      \return the value read from the 32 bit register
       \sa Physical Addresses
     */
-    extern void bcm2835_peri_write(volatile uint32_t* paddr, uint32_t value);
+    static inline uint32_t bcm2835_peri_read(volatile uint32_t* paddr)
+    {
+        uint32_t ret;
+        bcm2835_memory_barrier();
+        ret = bcm2835_peri_read_nb(paddr);
+        bcm2835_memory_barrier();
+        return ret;
+    }
 
     /*! Writes 32 bit value from a peripheral address without the write barrier
       You should only use this when:
@@ -1414,7 +2051,45 @@ extern "C" {
       \param[in] value The 32 bit value to write
       \sa Physical Addresses
     */
-    extern void bcm2835_peri_write_nb(volatile uint32_t* paddr, uint32_t value);
+    static inline void bcm2835_peri_write_nb(volatile uint32_t* paddr, uint32_t value)
+    {
+#ifdef BCM2835_SIMULATION
+        (void)paddr;
+        (void)value;
+#else
+        *paddr = value;
+#endif
+    }
+
+    /*! Writes 32 bit value from a peripheral address WITH a memory barrier before and after each write
+      This is safe, but slow.  The MB before ensures that any in-flight write to another peripheral
+      completes before this write is issued.  The MB after ensures that subsequent reads and writes
+      to another peripheral will see the effect of this write.
+
+      \param[in] paddr Physical address to read from. See BCM2835_GPIO_BASE etc.
+      \param[in] value The 32 bit value to write
+      \sa Physical Addresses
+    */
+    static inline void bcm2835_peri_write(volatile uint32_t* paddr, uint32_t value)
+    {
+        bcm2835_memory_barrier();
+        bcm2835_peri_write_nb(paddr, value);
+        bcm2835_memory_barrier();
+    }
+
+    /*! Alters a number of bits in a 32 peripheral regsiter, without memory barriers.
+      Same rules as bcm2835_peri_read_nb() and bcm2835_peri_write_nb().
+      \param[in] paddr Physical address to read from. See BCM2835_GPIO_BASE etc.
+      \param[in] value The 32 bit value to write, masked in by mask.
+      \param[in] mask Bitmask that defines the bits that will be altered in the register.
+      \sa Physical Addresses
+    */
+    static inline void bcm2835_peri_set_bits_nb(volatile uint32_t* paddr, uint32_t value, uint32_t mask)
+    {
+        uint32_t v = bcm2835_peri_read_nb(paddr);
+        v = (v & ~mask) | (value & mask);
+        bcm2835_peri_write_nb(paddr, v);
+    }
 
     /*! Alters a number of bits in a 32 peripheral regsiter.
       It reads the current valu and then alters the bits defines as 1 in mask, 
@@ -1428,7 +2103,12 @@ extern "C" {
       \param[in] mask Bitmask that defines the bits that will be altered in the register.
       \sa Physical Addresses
     */
-    extern void bcm2835_peri_set_bits(volatile uint32_t* paddr, uint32_t value, uint32_t mask);
+    static inline void bcm2835_peri_set_bits(volatile uint32_t* paddr, uint32_t value, uint32_t mask)
+    {
+        bcm2835_memory_barrier();
+        bcm2835_peri_set_bits_nb(paddr, value, mask);
+        bcm2835_memory_barrier();
+    }
     /*! @}    end of lowlevel */
 
     /*! \defgroup gpio GPIO register access
@@ -1688,6 +2368,120 @@ extern "C" {
 
     /*! @}  */
 
+    /*! \defgroup wave GPIO waveforms
+      A waveform is compiled once into steps of (set mask, clear mask, delay) and then
+      replayed by a tight loop timed by the System Timer, with no function call or
+      mask computation per edge. It suits bit-banged multi-pin protocols (software
+      SPI, strobes, 1-Wire reset/presence pulses) whose edges must be a few
+      microseconds apart. The pins must already be outputs.
+      Playback keeps the CPU busy and can be delayed by preemption: run it from a
+      high priority task and check bcm2835_wave_result_t for late steps.
+      @{
+    */
+
+    /*! Prepares an empty waveform.
+      \param[out] w Waveform
+      \param[in] steps Storage for the steps, used until the waveform is no longer played
+      \param[in] capacity Number of elements of steps
+    */
+    extern void bcm2835_wave_init(bcm2835_wave_t *w, bcm2835_wave_step_t *steps, uint32_t capacity);
+
+    /*! Empties a waveform, keeping its storage. */
+    extern void bcm2835_wave_clear(bcm2835_wave_t *w);
+
+    /*! Appends a step. A step with no delay is merged with the following one
+      if their masks do not drive the same pin.
+      \param[in] w Waveform
+      \param[in] set Mask of pins to drive high
+      \param[in] clr Mask of pins to drive low
+      \param[in] delay_us Time until the next step, in microseconds
+      \return 1 if successful, 0 if the waveform is full
+    */
+    extern int bcm2835_wave_add(bcm2835_wave_t *w, uint32_t set, uint32_t clr, uint32_t delay_us);
+
+    /*! Appends the clock and data edges of a bit-banged SPI write in mode 0,
+      MSB first: data is set up while the clock is low and sampled on the rising edge.
+      The clock is left low.
+      \param[in] w Waveform
+      \param[in] sclk GPIO of the clock
+      \param[in] mosi GPIO of the data
+      \param[in] buf Bytes to send
+      \param[in] len Number of bytes in buf
+      \param[in] half_period_us Duration of each clock phase, in microseconds
+      \return 1 if successful, 0 if the waveform was too small (it is left unchanged)
+    */
+    extern int bcm2835_wave_add_spi(bcm2835_wave_t *w, uint8_t sclk, uint8_t mosi, const uint8_t *buf, uint32_t len,
+                                    uint32_t half_period_us);
+
+    /*! Plays a waveform: the first step is output at once and each following one at
+      its scheduled time, counted from the first.
+      \param[in] w Waveform
+      \param[out] result Timing of the playback, may be NULL
+    */
+    extern void bcm2835_wave_play(const bcm2835_wave_t *w, bcm2835_wave_result_t *result);
+
+    /*! @} */
+
+    /*! \defgroup gpioevents GPIO edge events
+      Instead of polling the EDS registers, a dispatcher task waits in epoll on the edge
+      events of any number of GPIO lines, requested from the Linux GPIO character device,
+      and delivers each edge with its kernel timestamp to a handler or an OSAL queue.
+      Waiting costs no CPU and a data-ready line wakes its consumer within the scheduling
+      latency of the dispatcher. In BCM2835_SIMULATION builds the lines are pipes and
+      edges are produced with bcm2835_gpio_event_inject().
+      All functions require BCM2835_LIB_Init to have run.
+      @{
+    */
+
+    /*! Starts the dispatcher task, as a child task of the calling app.
+      Does nothing if it is already running.
+      \param[in] priority OSAL priority of the dispatcher task
+      \return status see \ref bcm2835GPIOEventStatus
+    */
+    extern int32_t bcm2835_gpio_events_start(uint32_t priority);
+
+    /*! Requests the edge events of a pin and calls a handler for each of them.
+      The pin is configured as an input by the kernel.
+      \param[in] pin GPIO number
+      \param[in] edges Edges to report, see \ref bcm2835GPIOEdge
+      \param[in] fn Handler, called from the dispatcher task
+      \param[in] arg Passed to the handler
+      \return status see \ref bcm2835GPIOEventStatus
+    */
+    extern int32_t bcm2835_gpio_event_add(uint8_t pin, uint8_t edges, bcm2835_gpio_event_fn fn, void *arg);
+
+    /*! Requests the edge events of a pin and puts each of them in an OSAL queue, so
+      a task can block on its queue until the next edge.
+      \param[in] pin GPIO number
+      \param[in] edges Edges to report, see \ref bcm2835GPIOEdge
+      \param[in] queue OSAL queue with messages of sizeof(bcm2835_gpio_event_t).
+      Events are dropped (and counted) when the queue is full.
+      \return status see \ref bcm2835GPIOEventStatus
+    */
+    extern int32_t bcm2835_gpio_event_add_queue(uint8_t pin, uint8_t edges, osal_id_t queue);
+
+    /*! Stops reporting the edges of a pin and releases its line.
+      \param[in] pin GPIO number
+      \return status see \ref bcm2835GPIOEventStatus
+    */
+    extern int32_t bcm2835_gpio_event_remove(uint8_t pin);
+
+    /*! Number of events of a pin lost because its queue was full.
+      \param[in] pin GPIO number
+      \return the number of events dropped since the pin was added
+    */
+    extern uint32_t bcm2835_gpio_event_dropped(uint8_t pin);
+
+    /*! Injects an edge on a pin, for testing in BCM2835_SIMULATION builds.
+      \param[in] pin GPIO number, with a handler or queue
+      \param[in] edge BCM2835_GPIO_EDGE_RISING or BCM2835_GPIO_EDGE_FALLING
+      \return status see \ref bcm2835GPIOEventStatus; BCM2835_GPIO_EVENT_ERR_INVALID
+      in hardware builds
+    */
+    extern int32_t bcm2835_gpio_event_inject(uint8_t pin, uint8_t edge);
+
+    /*! @} */
+
     /*! \defgroup spi SPI access
       These functions let you use SPI0 (Serial Peripheral Interface) to 
       interface with an external SPI device.
@@ -1782,6 +2576,20 @@ extern "C" {
     */
     extern void bcm2835_spi_transfernb(char* tbuf, char* rbuf, uint32_t len);
 
+    /*! Transfers a chain of segments to and from the currently selected SPI slave
+      as one transaction: the CS pins stay asserted from the first byte of the first
+      segment to the last byte of the last one, so e.g. a command, an address and a
+      payload can come from separate buffers, and a read can land directly in its
+      final buffer (such as an SB message payload) without a staging copy.
+      The bytes are only bit reversed when the bit order is LSB first.
+      Uses DMA when enabled and the total length qualifies (see bcm2835_spi_dma_begin()),
+      otherwise polled transfer as per section 10.6.1 of the BCM 2835 ARM Peripherls manual
+      \param[in] segs The segments, in bus order
+      \param[in] count Number of segments
+      \sa bcm2835_spi_transfernb()
+    */
+    extern void bcm2835_spi_transfer_segments(const bcm2835_spi_seg_t *segs, uint32_t count);
+
     /*! Transfers any number of bytes to and from the currently selected SPI slave
       using bcm2835_spi_transfernb.
       The returned data from the slave replaces the transmitted data in the buffer.
@@ -1868,6 +2676,14 @@ extern "C" {
     */
     extern void bcm2835_aux_spi_transfernb(const char *tbuf, char *rbuf, uint32_t len);
 
+    /*! Transfers a chain of segments to and from the AUX SPI slave as one transaction,
+      with the CE2 pin asserted from the first to the last byte.
+      \param[in] segs The segments, in bus order, see bcm2835_spi_seg_t
+      \param[in] count Number of segments
+      \sa bcm2835_spi_transfer_segments()
+    */
+    extern void bcm2835_aux_spi_transfer_segments(const bcm2835_spi_seg_t *segs, uint32_t count);
+
     /*! Transfers one byte to and from the AUX SPI slave.
       Clocks the 8 bit value out on MOSI, and simultaneously clocks in data from MISO. 
       Returns the read data byte from the slave.
@@ -1879,6 +2695,117 @@ extern "C" {
     
     /*! @} */
 
+    /*! \defgroup spidev SPI device handles
+      Thread-safe access to SPI0 and AUX SPI1. Each controller has its own lock, so
+      transactions on the two controllers run in parallel, and devices sharing a
+      controller are serialised. Optionally each controller gets a worker task that
+      runs queued requests, so a task can keep a long transfer (e.g. a flash log page)
+      in flight on one controller while it works with a device on the other one.
+      The controllers must have been started with bcm2835_spi_begin() and
+      bcm2835_aux_spi_begin(). All functions require BCM2835_LIB_Init to have run.
+      @{
+    */
+
+    /*! Initialises a device handle.
+      \param[out] dev The handle
+      \param[in] controller Controller of the device, see \ref bcm2835SPIController
+      \param[in] chip_select Chip select of the device, see \ref bcm2835SPIChipSelect
+      \param[in] mode Data mode of the device, see \ref bcm2835SPIMode
+      \param[in] speed_hz SCLK frequency of the device
+      The bit order is set to MSB first. Transactions on a handle with settings the
+      controller does not support fail with BCM2835_SPI_ERR_INVALID.
+      \return status see \ref bcm2835SPIStatus, BCM2835_SPI_ERR_INVALID if the
+      controller does not support the settings
+    */
+    extern int32_t bcm2835_spi_device_init(bcm2835_spi_device_t *dev, uint8_t controller, uint8_t chip_select,
+                                           uint8_t mode, uint32_t speed_hz);
+
+    /*! Runs a transaction on the device from the calling task.
+      Waits for the controller lock, applies the device settings and transfers the segments.
+      \param[in] dev The device
+      \param[in] segs The segments, see bcm2835_spi_transfer_segments()
+      \param[in] count Number of segments
+      \param[in] timeout_ms Maximum time to wait for the controller, or BCM2835_SPI_PEND_FOREVER
+      \return status see \ref bcm2835SPIStatus
+    */
+    extern int32_t bcm2835_spi_device_transfer(const bcm2835_spi_device_t *dev, const bcm2835_spi_seg_t *segs,
+                                               uint32_t count, int32_t timeout_ms);
+
+    /*! Starts the worker task of a controller, as a child task of the calling app.
+      Does nothing if it is already running.
+      \param[in] controller The controller, see \ref bcm2835SPIController
+      \param[in] priority OSAL priority of the worker task
+      \return status see \ref bcm2835SPIStatus
+    */
+    extern int32_t bcm2835_spi_worker_start(uint8_t controller, uint32_t priority);
+
+    /*! Initialises a request, creating its completion semaphore.
+      \param[out] req The request
+      \param[in] name Name of the completion semaphore, unique in the system
+      \return status see \ref bcm2835SPIStatus
+    */
+    extern int32_t bcm2835_spi_request_init(bcm2835_spi_request_t *req, const char *name);
+
+    /*! Queues a transaction on the worker of the device's controller and returns.
+      \param[in,out] req An initialised request that is not pending
+      \param[in] dev The device
+      \param[in] segs The segments, see bcm2835_spi_transfer_segments()
+      \param[in] count Number of segments
+      \return status see \ref bcm2835SPIStatus
+    */
+    extern int32_t bcm2835_spi_submit(bcm2835_spi_request_t *req, const bcm2835_spi_device_t *dev,
+                                      const bcm2835_spi_seg_t *segs, uint32_t count);
+
+    /*! Waits for a submitted request to complete.
+      \param[in] req The request
+      \param[in] timeout_ms Maximum time to wait, 0 to poll or BCM2835_SPI_PEND_FOREVER
+      \return the status of the transaction, or BCM2835_SPI_ERR_TIMEOUT if it is still pending
+    */
+    extern int32_t bcm2835_spi_request_wait(bcm2835_spi_request_t *req, int32_t timeout_ms);
+
+    /*! Gets a copy of the statistics of a controller.
+      Throughput is Bytes over BusTimeUs; summing both controllers gives the combined figure.
+      \param[in] controller The controller, see \ref bcm2835SPIController
+      \param[out] stats The statistics
+      \return status see \ref bcm2835SPIStatus
+    */
+    extern int32_t bcm2835_spi_get_stats(uint8_t controller, bcm2835_spi_stats_t *stats);
+
+    /*! @} */
+
+    /*! \defgroup spidma SPI0 DMA transfers
+      Once enabled with bcm2835_spi_dma_begin(), bcm2835_spi_transfer_segments(), bcm2835_spi_transfernb(),
+      bcm2835_spi_transfern() and bcm2835_spi_writenb() run transfers of at least BCM2835_SPI_DMA_THRESHOLD bytes on two
+      DMA channels, one feeding the TX FIFO and one draining the RX FIFO, and sleep until the
+      transfer is complete instead of polling the FIFOs. Shorter transfers, and all transfers
+      when DMA is not enabled, use the polled CPU path as before.
+      The DMA buffers and control blocks are page aligned memory from malloc_aligned(), locked
+      and translated to bus addresses through /proc/self/pagemap, and accessed by the CPU through
+      an uncached /dev/mem mapping. This requires root.
+      @{
+    */
+
+    /*! Enables DMA for the SPI0 bulk transfers.
+      Call after bcm2835_spi_begin().
+      \param[in] tx_channel DMA channel feeding the TX FIFO, e.g. BCM2835_SPI_DMA_TX_CHANNEL.
+      \param[in] rx_channel DMA channel draining the RX FIFO, e.g. BCM2835_SPI_DMA_RX_CHANNEL.
+      The channels must not be used by the kernel or another process.
+      \return 1 if successful, 0 otherwise (e.g. not root, or in BCM2835_SIMULATION builds),
+      in which case all transfers keep using the polled CPU path.
+    */
+    extern int bcm2835_spi_dma_begin(uint8_t tx_channel, uint8_t rx_channel);
+
+    /*! Disables DMA for the SPI0 transfers and releases the DMA buffers.
+    */
+    extern void bcm2835_spi_dma_end(void);
+
+    /*! Sets the length from which SPI0 transfers use DMA.
+      \param[in] len Minimum transfer length in bytes, default BCM2835_SPI_DMA_THRESHOLD.
+    */
+    extern void bcm2835_spi_dma_set_threshold(uint32_t len);
+
+    /*! @} */
+
     /*! \defgroup i2c I2C access
       These functions let you use I2C (The Broadcom Serial Control bus with the Philips
       I2C bus/interface version 2.1 January 2000.) to interface with an external I2C device.
@@ -1964,6 +2891,262 @@ extern "C" {
     */
     extern uint8_t bcm2835_i2c_write_read_rs(char* cmds, uint32_t cmds_len, char* buf, uint32_t buf_len);
 
+    /*! Returns the bus used by the bcm2835_i2c_* functions without a bus argument:
+      BCM2835_I2C_BUS_BSC0 when the library is compiled with I2C_V1, BCM2835_I2C_BUS_BSC1 otherwise.
+      \return bus see \ref bcm2835I2CBus
+    */
+    extern uint8_t bcm2835_i2c_default_bus(void);
+
+    /*! @} */
+
+    /*! \defgroup i2cbus I2C access on a given controller
+      Same as the \ref i2c functions, on the BSC controller given by the bus argument
+      (see \ref bcm2835I2CBus). The slave address, clock divider and byte timing are kept
+      per controller, and transfers on different controllers may run concurrently.
+      @{
+    */
+
+    /*! Start I2C operations on a controller. Sets its SDA and SCL pins to ALT0.
+      \param[in] bus Controller, see \ref bcm2835I2CBus
+      \return 1 if successful, 0 otherwise (bad bus, or perhaps because you are not running as root)
+    */
+    extern int bcm2835_i2c_bus_begin(uint8_t bus);
+
+    /*! End I2C operations on a controller. Returns its pins to inputs.
+      \param[in] bus Controller, see \ref bcm2835I2CBus
+    */
+    extern void bcm2835_i2c_bus_end(uint8_t bus);
+
+    /*! Sets the I2C slave address of a controller.
+      \param[in] bus Controller, see \ref bcm2835I2CBus
+      \param[in] addr The I2C slave address.
+    */
+    extern void bcm2835_i2c_bus_setSlaveAddress(uint8_t bus, uint8_t addr);
+
+    /*! Sets the I2C clock divider of a controller.
+      \param[in] bus Controller, see \ref bcm2835I2CBus
+      \param[in] divider The desired I2C clock divider, one of BCM2835_I2C_CLOCK_DIVIDER_*,
+      see \ref bcm2835I2CClockDivider
+    */
+    extern void bcm2835_i2c_bus_setClockDivider(uint8_t bus, uint16_t divider);
+
+    /*! Sets the I2C clock divider of a controller from a baudrate.
+      \param[in] bus Controller, see \ref bcm2835I2CBus
+      \param[in] baudrate The desired I2C baudrate
+    */
+    extern void bcm2835_i2c_bus_set_baudrate(uint8_t bus, uint32_t baudrate);
+
+    /*! Transfers any number of bytes to the slave selected on a controller.
+      \param[in] bus Controller, see \ref bcm2835I2CBus
+      \param[in] buf Buffer of bytes to send.
+      \param[in] len Number of bytes in the buf buffer, and the number of bytes to send.
+      \return reason see \ref bcm2835I2CReasonCodes
+    */
+    extern uint8_t bcm2835_i2c_bus_write(uint8_t bus, const char * buf, uint32_t len);
+
+    /*! Transfers any number of bytes from the slave selected on a controller.
+      \param[in] bus Controller, see \ref bcm2835I2CBus
+      \param[in] buf Buffer of bytes to receive.
+      \param[in] len Number of bytes in the buf buffer, and the number of bytes to received.
+      \return reason see \ref bcm2835I2CReasonCodes
+    */
+    extern uint8_t bcm2835_i2c_bus_read(uint8_t bus, char* buf, uint32_t len);
+
+    /*! Reads a register with a repeated start from the slave selected on a controller.
+      \param[in] bus Controller, see \ref bcm2835I2CBus
+      \param[in] regaddr Buffer containing the slave register you wish to read from.
+      \param[in] buf Buffer of bytes to receive.
+      \param[in] len Number of bytes in the buf buffer, and the number of bytes to received.
+      \return reason see \ref bcm2835I2CReasonCodes
+    */
+    extern uint8_t bcm2835_i2c_bus_read_register_rs(uint8_t bus, char* regaddr, char* buf, uint32_t len);
+
+    /*! Writes bytes and reads the response with a repeated start from the slave selected on a controller.
+      \param[in] bus Controller, see \ref bcm2835I2CBus
+      \param[in] cmds Buffer containing the bytes to send before the repeated start condition.
+      \param[in] cmds_len Number of bytes to send from cmds buffer
+      \param[in] buf Buffer of bytes to receive.
+      \param[in] buf_len Number of bytes to receive in the buf buffer.
+      \return reason see \ref bcm2835I2CReasonCodes
+    */
+    extern uint8_t bcm2835_i2c_bus_write_read_rs(uint8_t bus, char* cmds, uint32_t cmds_len, char* buf, uint32_t buf_len);
+
+    /*! @} */
+
+    /*! \defgroup i2cdev I2C device handles
+      Access to a device through a \ref bcm2835_i2c_device_t handle. The controller of the
+      device is programmed with its address, clock divider and clock stretch timeout
+      before each transfer, but only the registers that differ from the values last written
+      are touched. Each transfer updates the statistics of the handle.
+      The bus must have been started with bcm2835_i2c_bus_begin().
+      @{
+    */
+
+    /*! Initialises a device handle and clears its statistics.
+      \param[out] dev Handle to initialise
+      \param[in] bus Controller the device is wired to, see \ref bcm2835I2CBus
+      \param[in] address 7 bit slave address
+      \param[in] baudrate Preferred clock of the device, in Hz
+    */
+    extern void bcm2835_i2c_device_init(bcm2835_i2c_device_t *dev, uint8_t bus, uint8_t address, uint32_t baudrate);
+
+    /*! Changes the clock of a device. Takes effect on its next transfer.
+      \param[in] dev Device handle
+      \param[in] baudrate Clock in Hz
+    */
+    extern void bcm2835_i2c_device_set_baudrate(bcm2835_i2c_device_t *dev, uint32_t baudrate);
+
+    /*! Changes the clock stretch timeout of a device. Takes effect on its next transfer.
+      \param[in] dev Device handle
+      \param[in] clkt Timeout in SCL cycles, 0 to leave the controller setting
+    */
+    extern void bcm2835_i2c_device_set_timeout(bcm2835_i2c_device_t *dev, uint16_t clkt);
+
+    /*! Finds the highest reliable clock of a device. Tries BCM2835_I2C_SPEED_STANDARD,
+      BCM2835_I2C_SPEED_FAST and BCM2835_I2C_SPEED_FAST_PLUS in turn, up to max_baudrate.
+      A step is accepted when verify succeeds trials times without transfer errors, both at the
+      step and BCM2835_I2C_SPEED_MARGIN_PCT above it. Stops at the first failing step.
+      If no step is accepted the fallback clock of the handle is kept.
+      The caller must own the bus.
+      \param[in] dev Device handle
+      \param[in] max_baudrate Highest clock the device is rated for, in Hz
+      \param[in] trials Number of verify calls per tested clock
+      \param[in] verify Device check, see \ref bcm2835_i2c_verify_fn
+      \param[in] arg Passed to verify
+      \return The clock selected, in Hz
+    */
+    extern uint32_t bcm2835_i2c_device_negotiate(bcm2835_i2c_device_t *dev, uint32_t max_baudrate, uint8_t trials,
+                                                 bcm2835_i2c_verify_fn verify, void *arg);
+
+    /*! Checks that a device still works at its clock. If transfers failed since the last check,
+      or verify fails now, the clock backs off to the next lower step (not below the fallback clock).
+      Meant to be called periodically while the caller owns the bus.
+      \param[in] dev Device handle
+      \param[in] verify Device check, see \ref bcm2835_i2c_verify_fn
+      \param[in] arg Passed to verify
+      \return The clock in use after the check, in Hz
+    */
+    extern uint32_t bcm2835_i2c_device_revalidate(bcm2835_i2c_device_t *dev, bcm2835_i2c_verify_fn verify, void *arg);
+
+    /*! Clears the statistics of a device handle.
+      \param[in] dev Device handle
+    */
+    extern void bcm2835_i2c_device_reset_stats(bcm2835_i2c_device_t *dev);
+
+    /*! Writes bytes to a device. See bcm2835_i2c_write().
+      \param[in] dev Device handle
+      \param[in] buf Buffer of bytes to send.
+      \param[in] len Number of bytes to send.
+      \return reason see \ref bcm2835I2CReasonCodes
+    */
+    extern uint8_t bcm2835_i2c_device_write(bcm2835_i2c_device_t *dev, const char * buf, uint32_t len);
+
+    /*! Reads bytes from a device. See bcm2835_i2c_read().
+      \param[in] dev Device handle
+      \param[in] buf Buffer of bytes to receive.
+      \param[in] len Number of bytes to receive.
+      \return reason see \ref bcm2835I2CReasonCodes
+    */
+    extern uint8_t bcm2835_i2c_device_read(bcm2835_i2c_device_t *dev, char* buf, uint32_t len);
+
+    /*! Reads a register of a device with a repeated start. See bcm2835_i2c_read_register_rs().
+      \param[in] dev Device handle
+      \param[in] regaddr Buffer containing the register to read from.
+      \param[in] buf Buffer of bytes to receive.
+      \param[in] len Number of bytes to receive.
+      \return reason see \ref bcm2835I2CReasonCodes
+    */
+    extern uint8_t bcm2835_i2c_device_read_register_rs(bcm2835_i2c_device_t *dev, char* regaddr, char* buf, uint32_t len);
+
+    /*! Writes bytes and reads the response of a device with a repeated start.
+      See bcm2835_i2c_write_read_rs().
+      \param[in] dev Device handle
+      \param[in] cmds Buffer containing the bytes to send before the repeated start condition.
+      \param[in] cmds_len Number of bytes to send from cmds buffer
+      \param[in] buf Buffer of bytes to receive.
+      \param[in] buf_len Number of bytes to receive in the buf buffer.
+      \return reason see \ref bcm2835I2CReasonCodes
+    */
+    extern uint8_t bcm2835_i2c_device_write_read_rs(bcm2835_i2c_device_t *dev, char* cmds, uint32_t cmds_len, char* buf, uint32_t buf_len);
+
+    /*! @} */
+
+    /*! \defgroup i2csched I2C bus scheduler
+      Arbitrates each I2C bus between several tasks. Each task registers as a client
+      of one bus with a priority and a period and/or relative deadline. Pending requests
+      are granted earliest-deadline-first, ties are broken by priority. Every controller
+      has its own scheduler and lock, so clients on different buses never wait for each other. Long sequences of transfers
+      should call bcm2835_i2c_sched_yield() between transfers so that a more urgent
+      client never waits behind a whole slow read sequence.
+      All functions require BCM2835_LIB_Init to have run.
+      @{
+    */
+
+    /*! Registers a client of the I2C bus scheduler.
+      \param[in] bus Controller used by the client, see \ref bcm2835I2CBus
+      \param[in] name Name of the client, for diagnostics.
+      \param[in] priority Tie-break priority, lower value is more important (as in OSAL).
+      \param[in] period_us Period of the client in microseconds, 0 if aperiodic.
+      \param[in] deadline_us Relative deadline of each job in microseconds.
+      If 0 the period is used; if both are 0 the client is background and is only
+      ordered by priority after all clients with a deadline.
+      \param[out] client_id Id to pass to the other bcm2835_i2c_sched_* functions.
+      \return status see \ref bcm2835I2CSchedStatus
+    */
+    extern int32_t bcm2835_i2c_sched_register(uint8_t bus, const char *name, uint8_t priority, uint32_t period_us,
+                                              uint32_t deadline_us, uint32_t *client_id);
+
+    /*! Changes the period and relative deadline of a client, e.g. when its rate changes.
+      The job in progress keeps its deadline.
+      \param[in] client_id Id returned by bcm2835_i2c_sched_register()
+      \param[in] period_us Period of the client in microseconds, 0 if aperiodic.
+      \param[in] deadline_us Relative deadline of each job in microseconds, as in
+      bcm2835_i2c_sched_register()
+      \return status see \ref bcm2835I2CSchedStatus
+    */
+    extern int32_t bcm2835_i2c_sched_set_period(uint32_t client_id, uint32_t period_us, uint32_t deadline_us);
+
+    /*! Starts a new job of the client, typically once per period.
+      The absolute deadline of the job is set to now plus the relative deadline.
+      If a client acquires the bus without starting a job, a job is implicitly
+      started by bcm2835_i2c_sched_acquire().
+      \param[in] client_id Id returned by bcm2835_i2c_sched_register()
+      \return status see \ref bcm2835I2CSchedStatus
+    */
+    extern int32_t bcm2835_i2c_sched_start_job(uint32_t client_id);
+
+    /*! Waits until the bus is granted to the client.
+      \param[in] client_id Id returned by bcm2835_i2c_sched_register()
+      \param[in] timeout_ms Maximum time to wait, 0 to poll or
+      BCM2835_I2C_SCHED_PEND_FOREVER to wait without limit.
+      \return status see \ref bcm2835I2CSchedStatus
+    */
+    extern int32_t bcm2835_i2c_sched_acquire(uint32_t client_id, int32_t timeout_ms);
+
+    /*! Releases the bus, completes the current job of the client and grants the bus
+      to the most urgent waiting client, if any. A job released after its deadline
+      is counted as a deadline miss.
+      \param[in] client_id Id returned by bcm2835_i2c_sched_register()
+      \return status see \ref bcm2835I2CSchedStatus
+    */
+    extern int32_t bcm2835_i2c_sched_release(uint32_t client_id);
+
+    /*! Called by the bus owner between two transfers. If a waiting client has an earlier
+      deadline (or the same deadline and a better priority) the bus is handed over and the
+      call returns once it has been granted back. Otherwise it returns immediately.
+      \param[in] client_id Id returned by bcm2835_i2c_sched_register(), must own the bus
+      \return status see \ref bcm2835I2CSchedStatus, BCM2835_I2C_SCHED_ERR_NOT_OWNER
+      if the client does not own the bus
+    */
+    extern int32_t bcm2835_i2c_sched_yield(uint32_t client_id);
+
+    /*! Gets a copy of the statistics of a client.
+      \param[in] client_id Id returned by bcm2835_i2c_sched_register()
+      \param[out] stats Statistics of the client.
+      \return status see \ref bcm2835I2CSchedStatus
+    */
+    extern int32_t bcm2835_i2c_sched_get_stats(uint32_t client_id, bcm2835_i2c_sched_stats_t *stats);
+
     /*! @} */
 
     /*! \defgroup st System Timer access
@@ -1984,6 +3167,44 @@ extern "C" {
 
     /*! @}  */
 
+    /*! \defgroup periodic Periodic wakeup
+      Drift-free periodic loops. Deadlines are absolute on CLOCK_MONOTONIC, so an
+      oversleep in one period does not delay the following ones. Each wait sleeps with
+      clock_nanosleep(TIMER_ABSTIME) until shortly before the deadline, by a margin
+      calibrated from the overshoot of the previous sleeps, and spins for the rest,
+      the spin being bounded by SpinMaxNs. The lateness of every wakeup is recorded.
+      Works in BCM2835_SIMULATION builds and without root.
+      @{
+    */
+
+    /*! Initialises a periodic wakeup. The first deadline is one period from now.
+      \param[out] p The periodic wakeup
+      \param[in] period_us The period in microseconds, not 0
+      \return 1 if successful, 0 otherwise
+    */
+    extern int bcm2835_periodic_init(bcm2835_periodic_t *p, uint32_t period_us);
+
+    /*! Waits for the next deadline and advances it by one period.
+      If the caller is already more than a whole period late, the missed deadlines
+      are skipped (counted as Overruns) and the call returns immediately.
+      \param[in,out] p The periodic wakeup
+      \return the number of deadlines skipped, 0 when on time
+    */
+    extern uint32_t bcm2835_periodic_wait(bcm2835_periodic_t *p);
+
+    /*! Gets a copy of the statistics of a periodic wakeup.
+      \param[in] p The periodic wakeup
+      \param[out] stats The statistics
+    */
+    extern void bcm2835_periodic_get_stats(const bcm2835_periodic_t *p, bcm2835_periodic_stats_t *stats);
+
+    /*! Clears the statistics of a periodic wakeup, keeping the calibrated sleep margin.
+      \param[in,out] p The periodic wakeup
+    */
+    extern void bcm2835_periodic_reset_stats(bcm2835_periodic_t *p);
+
+    /*! @}  */
+
     /*! \defgroup pwm Pulse Width Modulation
       Allows control of 2 independent PWM channels. A limited subset of GPIO pins
       can be connected to one of these 2 channels, allowing PWM control of GPIO pins.
@@ -1994,6 +3215,8 @@ extern "C" {
 
     /*! Sets the PWM clock divisor, 
       to control the basic PWM pulse widths.
+      The clock generator is stopped while the divisor changes: this waits for it to
+      go idle (normally a few clock periods), rather than a fixed delay.
       \param[in] divisor Divides the basic 19.2MHz PWM clock. You can use one of the common
       values BCM2835_PWM_CLOCK_DIVIDER_* in \ref bcm2835PWMClockDivider
     */
@@ -2022,10 +3245,279 @@ extern "C" {
     */
     extern void bcm2835_pwm_set_data(uint8_t channel, uint32_t data);
     
-    
-    int32 BCM2835_LIB_Init(void);
+    /*! @}  */
+
+    /*! \defgroup pwmstream PWM sample streaming
+      A DMA channel paced by the PWM DREQ feeds one PWM channel from a ring buffer of
+      samples (DATA values), so a new sample is output every range PWM clock cycles
+      with no CPU work per sample. The sample rate is 19.2 MHz / divisor / range.
+      The producer tops the ring up with bcm2835_pwm_stream_write(), at least once
+      per ring period (BCM2835_PWM_STREAM_RING_PAGES * 1024 samples). When it falls
+      behind, the last written sample is held and an underrun is counted.
+      Requires root; not available in BCM2835_SIMULATION builds.
+      @{
+    */
+
+    /*! Starts streaming on a PWM channel in Mark-Space mode.
+      The ring is filled with idle until samples are written.
+      The GPIO of the channel must be set to its PWM Alt Function by the caller.
+      \param[in] channel The PWM channel. 0 or 1.
+      \param[in] dma_channel DMA channel to use, e.g. BCM2835_PWM_STREAM_DMA_CHANNEL
+      \param[in] divisor PWM clock divisor, see bcm2835_pwm_set_clock()
+      \param[in] range PWM range, i.e. PWM clock cycles per sample
+      \param[in] idle Sample output before the first write
+      \return 1 if successful, 0 otherwise
+    */
+    extern int bcm2835_pwm_stream_begin(uint8_t channel, uint8_t dma_channel, uint32_t divisor, uint32_t range,
+                                        uint32_t idle);
+
+    /*! Queues samples for output, without blocking.
+      \param[in] samples Samples, each from 0 to range
+      \param[in] count Number of samples
+      \return the number of samples queued, fewer than count when the ring is full
+    */
+    extern uint32_t bcm2835_pwm_stream_write(const uint32_t *samples, uint32_t count);
+
+    /*! Number of samples bcm2835_pwm_stream_write() would accept now. */
+    extern uint32_t bcm2835_pwm_stream_space(void);
+
+    /*! Reads the stream statistics.
+      \param[out] stats Statistics
+    */
+    extern void bcm2835_pwm_stream_get_stats(bcm2835_pwm_stream_stats_t *stats);
+
+    /*! Stops streaming, and puts the PWM channel back to data register mode.
+      Called by bcm2835_close(). */
+    extern void bcm2835_pwm_stream_end(void);
+
+    /*! @}  */
+
+    /*! \defgroup lock Bus locks
+      A mutex for critical sections of a few hundred microseconds at most, such as
+      one bus transaction. Taking a free lock is a single compare-and-swap. A taker
+      that finds it held polls it for a while, adapting the number of polls to how
+      long past waits took, then blocks in the kernel on a priority-inheritance futex
+      (FUTEX_LOCK_PI), so the owner runs at the priority of the most urgent waiter.
+      The lock is not recursive and must be released by the task that took it.
+      @{
+    */
+
+    /*! Initialises a lock, free and with zero statistics.
+      \param[out] lock The lock
+    */
+    extern void bcm2835_lock_init(bcm2835_lock_t *lock);
+
+    /*! Takes a lock.
+      \param[in] lock The lock
+      \param[in] timeout_us Maximum wait in microseconds, 0 to only try, or
+      BCM2835_LOCK_PEND_FOREVER to wait without limit.
+      \return status see \ref bcm2835LockStatus
+    */
+    extern int32_t bcm2835_lock_acquire(bcm2835_lock_t *lock, int32_t timeout_us);
+
+    /*! Releases a lock taken by the caller.
+      \param[in] lock The lock
+    */
+    extern void bcm2835_lock_release(bcm2835_lock_t *lock);
+
+    /*! Reads the statistics of a lock.
+      \param[in] lock The lock
+      \param[out] stats Statistics
+      \param[in] reset 1 to zero the statistics as they are read
+    */
+    extern void bcm2835_lock_get_stats(bcm2835_lock_t *lock, bcm2835_lock_stats_t *stats, uint8_t reset);
 
     /*! @}  */
+
+    /*! \defgroup sbpool Software Bus buffer pool
+      Buffers from CFE_SB_AllocateMessageBuffer() taken ahead, for packets that are
+      built in place and sent without a copy by CFE_SB_TransmitBuffer(). SB owns a
+      buffer once it is sent, so the pool is refilled afterwards, away from the
+      start of the next packet. A pool is not thread safe, each belongs to one task.
+      @{
+    */
+
+    /*! Initialises an empty pool. No buffer is allocated until bcm2835_sb_pool_fill().
+      \param[out] pool The pool
+      \param[in] size Size of each buffer, the largest packet built in it
+      \param[in] depth Number of buffers kept, up to BCM2835_SB_POOL_MAX
+      \return 1 if successful, 0 on a bad argument
+    */
+    extern int bcm2835_sb_pool_init(bcm2835_sb_pool_t *pool, size_t size, uint16_t depth);
+
+    /*! Allocates buffers until the pool holds its depth or SB has no memory left.
+      \param[in] pool The pool
+    */
+    extern void bcm2835_sb_pool_fill(bcm2835_sb_pool_t *pool);
+
+    /*! Takes a buffer of the pool, or allocates one if the pool is empty.
+      The caller either sends it with CFE_SB_TransmitBuffer() or releases it
+      with CFE_SB_ReleaseMessageBuffer().
+      \param[in] pool The pool
+      \return the buffer, NULL if SB has no memory
+    */
+    extern CFE_SB_Buffer_t *bcm2835_sb_pool_get(bcm2835_sb_pool_t *pool);
+
+    /*! Returns the buffers held by the pool to SB, e.g. when the task exits.
+      \param[in] pool The pool
+    */
+    extern void bcm2835_sb_pool_drain(bcm2835_sb_pool_t *pool);
+
+    /*! @}  */
+
+    /*! \defgroup seqlock Latest-value caches
+      A sequence lock publishes the latest value of a task, such as the last sample
+      of an acquisition task, to readers that must never block it. The single writer
+      never waits; a reader copies the value and retries if it was rewritten during
+      the copy. The value is a plain buffer owned by the caller, and every write
+      and read of it goes through these functions.
+      @{
+    */
+
+    /*! Initialises a sequence lock, with no value written.
+      \param[out] lock The lock
+    */
+    extern void bcm2835_seqlock_init(bcm2835_seqlock_t *lock);
+
+    /*! Writes the value. Only one task may write a given value.
+      \param[in] lock The lock of the value
+      \param[out] value The value
+      \param[in] src New contents of the value
+      \param[in] size Size of the value in bytes
+    */
+    extern void bcm2835_seqlock_write(bcm2835_seqlock_t *lock, void *value, const void *src, uint32_t size);
+
+    /*! Reads a consistent copy of the value.
+      \param[in] lock The lock of the value
+      \param[in] value The value
+      \param[out] dst Copy of the value, undefined unless 1 is returned
+      \param[in] size Size of the value in bytes
+      \param[in] tries Copies attempted before giving up while the value is being rewritten
+      \return 1 if dst holds a value, 0 if none was written yet or no copy was consistent
+    */
+    extern int bcm2835_seqlock_read(const bcm2835_seqlock_t *lock, const void *value, void *dst, uint32_t size,
+                                    uint32_t tries);
+
+    /*! @}  */
+
+    /*! \defgroup evslimit Rate limited events
+      Limits the events of an app that can repeat at a high rate, such as the
+      errors of a message pipe. The first burst events of each ID in a window are
+      sent; the later ones are only counted, without formatting their text, and
+      one event per ID reports the count when the window ends. Events that answer
+      a command should be sent with CFE_EVS_SendEvent() directly. The events are
+      sent on behalf of the calling app, and a limiter must only be used by one task.
+      @{
+    */
+
+    /*! Initialises a limiter and starts its first window.
+      \param[out] lim The limiter
+      \param[in] name Prefix of the summary events, e.g. the app name. Not copied.
+      \param[in] burst Events of an ID sent in each window
+      \param[in] window_s Length of the window in seconds
+    */
+    extern void bcm2835_evs_limit_init(bcm2835_evs_limit_t *lim, const char *name, uint16_t burst, uint32_t window_s);
+
+    /*! Counts an event and decides whether it is sent.
+      \param[in] lim The limiter
+      \param[in] event_id Event ID
+      \param[in] event_type Event type, reused by the summary of the ID
+      \return 1 if the event is to be sent, 0 if the burst of its ID is used up
+    */
+    extern int bcm2835_evs_limit_check(bcm2835_evs_limit_t *lim, uint16_t event_id, uint16_t event_type);
+
+    /*! Sends an event with CFE_EVS_SendEvent() unless bcm2835_evs_limit_check() suppresses it.
+      \param[in] lim The limiter
+      \param[in] event_id Event ID
+      \param[in] event_type Event type
+      \param[in] spec printf format of the event text
+    */
+    extern void bcm2835_evs_limit_send(bcm2835_evs_limit_t *lim, uint16_t event_id, uint16_t event_type,
+                                       const char *spec, ...) OS_PRINTF(4, 5);
+
+    /*! Ends the window once it has lasted window_s seconds: sends one event per ID with
+      the number of events suppressed, and resets the counts. Meant to be called
+      periodically, e.g. once per HK request.
+      \param[in] lim The limiter
+    */
+    extern void bcm2835_evs_limit_flush(bcm2835_evs_limit_t *lim);
+
+    /*! @}  */
+
+    /*! \defgroup trace Bus transaction trace
+      Every I2C and SPI transaction is recorded in a fixed-size record of a ring of
+      BCM2835_TRACE_DEPTH records, the oldest being overwritten. Recording takes no
+      lock, so it is left enabled. The System Timer is the time base once
+      bcm2835_init() has mapped it, CLOCK_MONOTONIC otherwise.
+      In BCM2835_SIMULATION builds the transactions are served by replaying a trace
+      loaded with bcm2835_trace_replay_load(): each transaction takes the status,
+      data and duration of the next record of the same kind, controller, address
+      and register. With no matching record it succeeds at once and reads zeros.
+      All functions require BCM2835_LIB_Init to have run.
+      @{
+    */
+
+    /*! Enables or disables recording. Enabled by default.
+      \param[in] enable 1 to record, 0 to stop
+    */
+    extern void bcm2835_trace_enable(uint8_t enable);
+
+    /*! Copies the records still in the ring, oldest first. Records being
+      written during the copy are left out.
+      \param[out] recs Buffer for the records
+      \param[in] max Size of recs in records
+      \return the number of records copied
+    */
+    extern uint32_t bcm2835_trace_snapshot(bcm2835_trace_rec_t *recs, uint32_t max);
+
+    /*! Writes the records still in the ring to a trace file, see bcm2835_trace_file_hdr_t.
+      \param[in] path OSAL path of the file, overwritten if it exists
+      \return the number of records written, or -1 on error
+    */
+    extern int32_t bcm2835_trace_dump(const char *path);
+
+    /*! Loads a trace file for replay, replacing any loaded before.
+      The replay restarts from the first record.
+      \param[in] path OSAL path of a file written by bcm2835_trace_dump()
+      \return the number of records loaded, or -1 on error
+    */
+    extern int32_t bcm2835_trace_replay_load(const char *path);
+
+    /*! Reads the trace statistics.
+      \param[out] stats Statistics
+    */
+    extern void bcm2835_trace_get_stats(bcm2835_trace_stats_t *stats);
+
+    /*! @}  */
+
+    /*! \defgroup busstats Bus statistics
+      Every I2C and SPI transaction is counted for its device (controller and address)
+      in a log2 histogram of its duration, with its bytes and errors. Waits for the bus
+      in bcm2835_i2c_sched_acquire() and for the SPI device locks are counted by
+      controller. Devices get an entry on their first transaction, up to
+      BCM2835_BUS_STATS_DEVICES. Counting takes no lock.
+      @{
+    */
+
+    /*! Reads the bus statistics.
+      \param[out] stats Statistics
+      \param[in] reset 1 to zero the statistics as they are read, so that each
+      call covers the time since the previous one. Device entries are kept.
+    */
+    extern void bcm2835_bus_get_stats(bcm2835_bus_stats_t *stats, uint8_t reset);
+
+    /*! Reads the statistics of the lock of a bus controller: the I2C scheduler
+      of a BSC or the device lock of an SPI controller.
+      \param[in] bus Controller, see \ref bcm2835Bus
+      \param[out] stats Statistics
+      \param[in] reset 1 to zero the statistics as they are read
+      \return 1 if successful, 0 if the controller has no lock
+    */
+    extern int bcm2835_bus_get_lock_stats(uint8_t bus, bcm2835_lock_stats_t *stats, uint8_t reset);
+
+    /*! @}  */
+
+    int32 BCM2835_LIB_Init(void);
 #ifdef __cplusplus
 }
 #endif
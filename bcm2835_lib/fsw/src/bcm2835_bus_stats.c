@@ -0,0 +1,265 @@
+/*************************************************************************
+**
+**      GSC-18128-1, "Core Flight Executive Version 6.7"
+**
+**      Copyright (c) 2006-2019 United States Government as represented by
+**      the Administrator of the National Aeronautics and Space Administration.
+**      All Rights Reserved.
+**
+**      Licensed under the Apache License, Version 2.0 (the "License");
+**      you may not use this file except in compliance with the License.
+**      You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**      Unless required by applicable law or agreed to in writing, software
+**      distributed under the License is distributed on an "AS IS" BASIS,
+**      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**      See the License for the specific language governing permissions and
+**      limitations under the License.
+**
+** File: bcm2835_bus_stats.c
+**
+** Purpose:
+**  Per-device transfer time and per-controller lock wait histograms of
+**  the I2C and SPI controllers.
+**
+** Notes:
+**  Every counter is updated with an atomic add, so transactions on
+**  different controllers never serialise on the statistics. A device
+**  entry is claimed by a compare-and-swap of its key and never released,
+**  which keeps lookups lock-free. A reset exchanges each counter with 0:
+**  a transaction counted during a read-and-reset lands in one period or
+**  the next, never in neither.
+**
+*************************************************************************/
+
+#include <string.h>
+
+#include "bcm2835_lib_internal.h"
+
+/*************************************************************************
+** Macro Definitions
+*************************************************************************/
+
+/* Key of a device entry, 0 while the entry is free */
+#define BCM2835_BUS_KEY(Bus, Address) (0x10000 | ((uint32)(Bus) << 8) | (Address))
+
+/*************************************************************************
+** Type Definitions
+*************************************************************************/
+
+/* Bus and Address of Stats are unused, the key holds them */
+typedef struct
+{
+    uint32                  Key;
+    bcm2835_bus_dev_stats_t Stats;
+} BCM2835_BUS_Dev_t;
+
+/*************************************************************************
+** Local Data
+*************************************************************************/
+
+static bcm2835_bus_lock_stats_t BCM2835_BUS_Lock[BCM2835_BUS_COUNT];
+static BCM2835_BUS_Dev_t        BCM2835_BUS_Dev[BCM2835_BUS_STATS_DEVICES];
+static uint32                   BCM2835_BUS_Untracked;
+
+/*************************************************************************
+** Local Functions
+*************************************************************************/
+
+static uint32 BCM2835_BUS_Bin(uint32 Us)
+{
+    uint32 Bin = (Us == 0) ? 0 : 32 - (uint32)__builtin_clz(Us);
+
+    return (Bin < BCM2835_BUS_HIST_BINS) ? Bin : BCM2835_BUS_HIST_BINS - 1;
+}
+
+static void BCM2835_BUS_Add(uint32 *Counter, uint32 Value)
+{
+    __atomic_fetch_add(Counter, Value, __ATOMIC_RELAXED);
+}
+
+static void BCM2835_BUS_Max(uint32 *Max, uint32 Value)
+{
+    uint32 Old = __atomic_load_n(Max, __ATOMIC_RELAXED);
+
+    while (Value > Old && !__atomic_compare_exchange_n(Max, &Old, Value, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    {
+    }
+}
+
+static uint32 BCM2835_BUS_Take(uint32 *Counter, uint8 Reset)
+{
+    if (Reset)
+    {
+        return __atomic_exchange_n(Counter, 0, __ATOMIC_RELAXED);
+    }
+
+    return __atomic_load_n(Counter, __ATOMIC_RELAXED);
+}
+
+static void BCM2835_BUS_TakeHist(uint32 *Dst, uint32 *Src, uint8 Reset)
+{
+    uint32 i;
+
+    for (i = 0; i < BCM2835_BUS_HIST_BINS; i++)
+    {
+        Dst[i] = BCM2835_BUS_Take(&Src[i], Reset);
+    }
+}
+
+/* Entry of a device, claimed on first use. NULL when the table is full. */
+static bcm2835_bus_dev_stats_t *BCM2835_BUS_FindDev(uint8 Bus, uint8 Address)
+{
+    uint32 Key = BCM2835_BUS_KEY(Bus, Address);
+    uint32 Old;
+    uint32 i;
+
+    for (i = 0; i < BCM2835_BUS_STATS_DEVICES; i++)
+    {
+        Old = __atomic_load_n(&BCM2835_BUS_Dev[i].Key, __ATOMIC_RELAXED);
+
+        /* On a lost race Old becomes the key of the winner */
+        if (Old == 0 && __atomic_compare_exchange_n(&BCM2835_BUS_Dev[i].Key, &Old, Key, false, __ATOMIC_RELAXED,
+                                                    __ATOMIC_RELAXED))
+        {
+            return &BCM2835_BUS_Dev[i].Stats;
+        }
+        if (Old == Key)
+        {
+            return &BCM2835_BUS_Dev[i].Stats;
+        }
+    }
+
+    return NULL;
+}
+
+/*************************************************************************
+** Internal Functions
+*************************************************************************/
+
+void BCM2835_BUS_Account(uint8 Bus, uint8 Address, uint32 Len, uint32 DurationUs, uint8 Status)
+{
+    bcm2835_bus_dev_stats_t *Dev = BCM2835_BUS_FindDev(Bus, Address);
+
+    if (Dev == NULL)
+    {
+        BCM2835_BUS_Add(&BCM2835_BUS_Untracked, 1);
+        return;
+    }
+
+    BCM2835_BUS_Add(&Dev->Transactions, 1);
+    BCM2835_BUS_Add(&Dev->Hist[BCM2835_BUS_Bin(DurationUs)], 1);
+    BCM2835_BUS_Add(&Dev->TotalUs, DurationUs);
+    BCM2835_BUS_Max(&Dev->MaxUs, DurationUs);
+    if (Status != 0)
+    {
+        BCM2835_BUS_Add(&Dev->Errors, 1);
+    }
+    else
+    {
+        BCM2835_BUS_Add(&Dev->Bytes, Len);
+    }
+}
+
+void BCM2835_BUS_AccountWait(uint8 Bus, uint32 WaitUs, bool TimedOut)
+{
+    bcm2835_bus_lock_stats_t *Lock;
+
+    if (Bus >= BCM2835_BUS_COUNT)
+    {
+        return;
+    }
+
+    Lock = &BCM2835_BUS_Lock[Bus];
+
+    BCM2835_BUS_Add(&Lock->Waits, 1);
+    BCM2835_BUS_Add(&Lock->Hist[BCM2835_BUS_Bin(WaitUs)], 1);
+    BCM2835_BUS_Add(&Lock->TotalUs, WaitUs);
+    BCM2835_BUS_Max(&Lock->MaxUs, WaitUs);
+    if (TimedOut)
+    {
+        BCM2835_BUS_Add(&Lock->Timeouts, 1);
+    }
+}
+
+/*************************************************************************
+** Public Functions
+*************************************************************************/
+
+void bcm2835_bus_get_stats(bcm2835_bus_stats_t *stats, uint8_t reset)
+{
+    bcm2835_bus_lock_stats_t *Lock;
+    bcm2835_bus_dev_stats_t  *Src;
+    bcm2835_bus_dev_stats_t  *Dst;
+    uint32                    Key;
+    uint32                    i;
+
+    memset(stats, 0, sizeof(*stats));
+
+    for (i = 0; i < BCM2835_BUS_COUNT; i++)
+    {
+        Lock = &BCM2835_BUS_Lock[i];
+
+        stats->Lock[i].Waits    = BCM2835_BUS_Take(&Lock->Waits, reset);
+        stats->Lock[i].Timeouts = BCM2835_BUS_Take(&Lock->Timeouts, reset);
+        stats->Lock[i].TotalUs  = BCM2835_BUS_Take(&Lock->TotalUs, reset);
+        stats->Lock[i].MaxUs    = BCM2835_BUS_Take(&Lock->MaxUs, reset);
+        BCM2835_BUS_TakeHist(stats->Lock[i].Hist, Lock->Hist, reset);
+    }
+
+    for (i = 0; i < BCM2835_BUS_STATS_DEVICES; i++)
+    {
+        Key = __atomic_load_n(&BCM2835_BUS_Dev[i].Key, __ATOMIC_RELAXED);
+        if (Key == 0)
+        {
+            break;
+        }
+
+        Src = &BCM2835_BUS_Dev[i].Stats;
+        Dst = &stats->Dev[stats->Devices++];
+
+        Dst->Bus          = (uint8)(Key >> 8);
+        Dst->Address      = (uint8)Key;
+        Dst->Transactions = BCM2835_BUS_Take(&Src->Transactions, reset);
+        Dst->Errors       = BCM2835_BUS_Take(&Src->Errors, reset);
+        Dst->Bytes        = BCM2835_BUS_Take(&Src->Bytes, reset);
+        Dst->TotalUs      = BCM2835_BUS_Take(&Src->TotalUs, reset);
+        Dst->MaxUs        = BCM2835_BUS_Take(&Src->MaxUs, reset);
+        BCM2835_BUS_TakeHist(Dst->Hist, Src->Hist, reset);
+    }
+
+    stats->Untracked = BCM2835_BUS_Take(&BCM2835_BUS_Untracked, reset);
+}
+
+int bcm2835_bus_get_lock_stats(uint8_t bus, bcm2835_lock_stats_t *stats, uint8_t reset)
+{
+    bcm2835_lock_t *Lock = NULL;
+
+    if (bus == BCM2835_BUS_I2C0 || bus == BCM2835_BUS_I2C1)
+    {
+        Lock = BCM2835_I2C_SchedLock(bus);
+    }
+    else if (bus == BCM2835_BUS_SPI0)
+    {
+        Lock = BCM2835_SPI_DevLock(BCM2835_SPI_CTRL_SPI0);
+    }
+    else if (bus == BCM2835_BUS_AUX_SPI)
+    {
+        Lock = BCM2835_SPI_DevLock(BCM2835_SPI_CTRL_AUX);
+    }
+
+    if (Lock == NULL)
+    {
+        return 0;
+    }
+
+    bcm2835_lock_get_stats(Lock, stats, reset);
+
+    return 1;
+}
+
+/************************/
+/*  End of File Comment */
+/************************/
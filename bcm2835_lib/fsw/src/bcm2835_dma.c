@@ -0,0 +1,211 @@
+/*************************************************************************
+**
+**      GSC-18128-1, "Core Flight Executive Version 6.7"
+**
+**      Copyright (c) 2006-2019 United States Government as represented by
+**      the Administrator of the National Aeronautics and Space Administration.
+**      All Rights Reserved.
+**
+**      Licensed under the Apache License, Version 2.0 (the "License");
+**      you may not use this file except in compliance with the License.
+**      You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**      Unless required by applicable law or agreed to in writing, software
+**      distributed under the License is distributed on an "AS IS" BASIS,
+**      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**      See the License for the specific language governing permissions and
+**      limitations under the License.
+**
+** File: bcm2835_dma.c
+**
+** Purpose:
+**  DMA channel and DMA memory helpers shared by the SPI0 and PWM paths.
+**
+** Notes:
+**  DMA memory is a page-aligned block from malloc_aligned(), locked in
+**  memory. Its pages are not physically contiguous, so users chain one
+**  control block per page, and the CPU accesses each page through an
+**  uncached /dev/mem mapping of its physical address so no cache
+**  maintenance is needed around the transfers.
+**
+*************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "bcm2835_lib_internal.h"
+
+/*************************************************************************
+** Macro Definitions
+*************************************************************************/
+
+/* Legacy DMA channels can only address the first GB of SDRAM */
+#define BCM2835_DMA_PHYS_LIMIT  0x40000000ULL
+
+/*************************************************************************
+** Local Functions
+*************************************************************************/
+
+/* Physical address of a locked page of this process, 0 if unknown */
+static uint64 BCM2835_DMA_Phys(int PagemapFd, const void *Virt)
+{
+    uint64 Entry;
+    off_t  Offset = ((uintptr_t)Virt / BCM2835_PAGE_SIZE) * sizeof(Entry);
+
+    if (pread(PagemapFd, &Entry, sizeof(Entry), Offset) != sizeof(Entry))
+    {
+        return 0;
+    }
+
+    /* Bit 63 is "present", bits 0-54 the page frame number (zeroed unless root) */
+    if (!(Entry & (1ULL << 63)))
+    {
+        return 0;
+    }
+
+    return (Entry & ((1ULL << 55) - 1)) * BCM2835_PAGE_SIZE;
+}
+
+/*************************************************************************
+** Internal Functions
+*************************************************************************/
+
+volatile uint32_t *BCM2835_DMA_Reg(uint8 Channel, uint32 Reg)
+{
+    return bcm2835_dma + (Channel * BCM2835_DMA_CHANNEL_SIZE + Reg) / 4;
+}
+
+void BCM2835_DMA_Reset(uint8 Channel)
+{
+    bcm2835_peri_write(BCM2835_DMA_Reg(Channel, BCM2835_DMA_CS), BCM2835_DMA_CS_RESET);
+    bcm2835_delayMicroseconds(10);
+}
+
+void BCM2835_DMA_Enable(uint8 Channel)
+{
+    bcm2835_peri_set_bits(bcm2835_dma + BCM2835_DMA_ENABLE/4, 1U << Channel, 1U << Channel);
+    BCM2835_DMA_Reset(Channel);
+}
+
+void BCM2835_DMA_Start(uint8 Channel, uint32_t CbBus)
+{
+    bcm2835_peri_write_nb(BCM2835_DMA_Reg(Channel, BCM2835_DMA_CS), BCM2835_DMA_CS_END);
+    bcm2835_peri_write_nb(BCM2835_DMA_Reg(Channel, BCM2835_DMA_CONBLK_AD), CbBus);
+    bcm2835_peri_write_nb(BCM2835_DMA_Reg(Channel, BCM2835_DMA_CS),
+                          BCM2835_DMA_CS_ACTIVE | BCM2835_DMA_CS_WAIT_WRITES |
+                          BCM2835_DMA_CS_PRIORITY(8) | BCM2835_DMA_CS_PANIC_PRIORITY(8));
+}
+
+int BCM2835_DMA_MemAlloc(BCM2835_DMA_Mem_t *Mem, uint32 Pages, const char *Who)
+{
+    size_t Size = (size_t)Pages * BCM2835_PAGE_SIZE;
+    int    PagemapFd;
+    uint64 Phys;
+    uint32 i;
+
+    Mem->Block = malloc_aligned(Size);
+    Mem->Fd    = -1;
+    Mem->Pages = Pages;
+    if (Mem->Block == NULL)
+    {
+        return 0;
+    }
+
+    /* Touch and lock the pages so their physical addresses stay valid */
+    memset(Mem->Block, 0, Size);
+    if (mlock(Mem->Block, Size) != 0)
+    {
+        fprintf(stderr, "%s: Unable to lock the DMA buffers: %s\n", Who, strerror(errno));
+        free(Mem->Block);
+        Mem->Block = NULL;
+        return 0;
+    }
+
+    PagemapFd = open("/proc/self/pagemap", O_RDONLY);
+    Mem->Fd   = open("/dev/mem", O_RDWR | O_SYNC);
+    if (PagemapFd < 0 || Mem->Fd < 0)
+    {
+        fprintf(stderr, "%s: Unable to open pagemap or /dev/mem: %s\n", Who, strerror(errno));
+        if (PagemapFd >= 0)
+        {
+            close(PagemapFd);
+        }
+        BCM2835_DMA_MemFree(Mem);
+        return 0;
+    }
+
+    for (i = 0; i < Pages; i++)
+    {
+        void *View;
+
+        Phys = BCM2835_DMA_Phys(PagemapFd, (uint8_t *)Mem->Block + i * BCM2835_PAGE_SIZE);
+        if (Phys == 0 || Phys >= BCM2835_DMA_PHYS_LIMIT)
+        {
+            fprintf(stderr, "%s: No usable physical address for DMA page %u\n", Who, (unsigned)i);
+            break;
+        }
+
+        View = mmap(NULL, BCM2835_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, Mem->Fd, (off_t)Phys);
+        if (View == MAP_FAILED)
+        {
+            fprintf(stderr, "%s: mmap of DMA page %u failed: %s\n", Who, (unsigned)i, strerror(errno));
+            break;
+        }
+
+        Mem->Virt[i] = View;
+        Mem->Bus[i]  = (uint32_t)Phys | BCM2835_DMA_BUS_SDRAM;
+    }
+    close(PagemapFd);
+
+    if (i < Pages)
+    {
+        BCM2835_DMA_MemFree(Mem);
+        return 0;
+    }
+
+    return 1;
+}
+
+void BCM2835_DMA_MemFree(BCM2835_DMA_Mem_t *Mem)
+{
+    uint32 i;
+
+    /* Nothing allocated; Fd is not valid either */
+    if (Mem->Block == NULL)
+    {
+        return;
+    }
+
+    for (i = 0; i < Mem->Pages; i++)
+    {
+        if (Mem->Virt[i] != NULL)
+        {
+            munmap(Mem->Virt[i], BCM2835_PAGE_SIZE);
+            Mem->Virt[i] = NULL;
+        }
+    }
+
+    if (Mem->Fd >= 0)
+    {
+        close(Mem->Fd);
+        Mem->Fd = -1;
+    }
+
+    if (Mem->Block != NULL)
+    {
+        munlock(Mem->Block, (size_t)Mem->Pages * BCM2835_PAGE_SIZE);
+        free(Mem->Block);
+        Mem->Block = NULL;
+    }
+}
+
+/************************/
+/*  End of File Comment */
+/************************/
@@ -0,0 +1,117 @@
+/*************************************************************************
+**
+**      GSC-18128-1, "Core Flight Executive Version 6.7"
+**
+**      Copyright (c) 2006-2019 United States Government as represented by
+**      the Administrator of the National Aeronautics and Space Administration.
+**      All Rights Reserved.
+**
+**      Licensed under the Apache License, Version 2.0 (the "License");
+**      you may not use this file except in compliance with the License.
+**      You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**      Unless required by applicable law or agreed to in writing, software
+**      distributed under the License is distributed on an "AS IS" BASIS,
+**      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**      See the License for the specific language governing permissions and
+**      limitations under the License.
+**
+** File: bcm2835_evs_limit.c
+**
+** Purpose:
+**  Rate limited event reporting of the apps using the library.
+**
+** Notes:
+**  The state is owned by the app, so one library instance serves every
+**  app. The event text is only formatted for the events that are sent.
+**
+*************************************************************************/
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "bcm2835_lib_internal.h"
+
+/*************************************************************************
+** Public Functions
+*************************************************************************/
+
+void bcm2835_evs_limit_init(bcm2835_evs_limit_t *lim, const char *name, uint16_t burst, uint32_t window_s)
+{
+    memset(lim, 0, sizeof(*lim));
+
+    lim->Name        = name;
+    lim->Burst       = burst;
+    lim->WindowS     = window_s;
+    lim->WindowStart = CFE_TIME_GetTime().Seconds;
+}
+
+int bcm2835_evs_limit_check(bcm2835_evs_limit_t *lim, uint16_t event_id, uint16_t event_type)
+{
+    bcm2835_evs_limit_entry_t *Entry;
+
+    if (event_id >= BCM2835_EVS_LIMIT_IDS)
+    {
+        return 1;
+    }
+
+    Entry       = &lim->Entry[event_id];
+    Entry->Type = event_type;
+
+    if (Entry->Sent >= lim->Burst)
+    {
+        Entry->Suppressed++;
+        return 0;
+    }
+
+    Entry->Sent++;
+    return 1;
+}
+
+void bcm2835_evs_limit_send(bcm2835_evs_limit_t *lim, uint16_t event_id, uint16_t event_type, const char *spec, ...)
+{
+    char    Text[CFE_MISSION_EVS_MAX_MESSAGE_LENGTH];
+    va_list Args;
+
+    if (!bcm2835_evs_limit_check(lim, event_id, event_type))
+    {
+        return;
+    }
+
+    va_start(Args, spec);
+    vsnprintf(Text, sizeof(Text), spec, Args);
+    va_end(Args);
+
+    CFE_EVS_SendEvent(event_id, event_type, "%s", Text);
+}
+
+void bcm2835_evs_limit_flush(bcm2835_evs_limit_t *lim)
+{
+    uint32 Now = CFE_TIME_GetTime().Seconds;
+    uint16 EventID;
+
+    if (Now - lim->WindowStart < lim->WindowS)
+    {
+        return;
+    }
+
+    for (EventID = 0; EventID < BCM2835_EVS_LIMIT_IDS; EventID++)
+    {
+        if (lim->Entry[EventID].Suppressed != 0)
+        {
+            CFE_EVS_SendEvent(EventID, lim->Entry[EventID].Type, "%s: %lu more events with this ID in %lu s",
+                              lim->Name, (unsigned long)lim->Entry[EventID].Suppressed,
+                              (unsigned long)(Now - lim->WindowStart));
+        }
+    }
+
+    memset(lim->Entry, 0, sizeof(lim->Entry));
+    lim->WindowStart = Now;
+}
+
+/************************/
+/*  End of File Comment */
+/************************/
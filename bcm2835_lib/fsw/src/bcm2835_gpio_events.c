@@ -0,0 +1,450 @@
+/*************************************************************************
+**
+**      GSC-18128-1, "Core Flight Executive Version 6.7"
+**
+**      Copyright (c) 2006-2019 United States Government as represented by
+**      the Administrator of the National Aeronautics and Space Administration.
+**      All Rights Reserved.
+**
+**      Licensed under the Apache License, Version 2.0 (the "License");
+**      you may not use this file except in compliance with the License.
+**      You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**      Unless required by applicable law or agreed to in writing, software
+**      distributed under the License is distributed on an "AS IS" BASIS,
+**      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**      See the License for the specific language governing permissions and
+**      limitations under the License.
+**
+** File: bcm2835_gpio_events.c
+**
+** Purpose:
+**  GPIO edge event dispatcher.
+**
+** Notes:
+**  Every pin owns one file descriptor registered in a single epoll set:
+**  a line event handle of the GPIO character device, or the read end of
+**  a pipe in simulation builds. Both deliver struct gpioevent_data, so the
+**  dispatcher does not know which backend it runs on.
+**  The kernel timestamps line events with CLOCK_MONOTONIC (Linux 5.7 and
+**  later), the same clock as BCM2835_LIB_GetTimeUs.
+**
+*************************************************************************/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/ioctl.h>
+#include <linux/gpio.h>
+
+#include "bcm2835_lib_internal.h"
+
+/*************************************************************************
+** Macro Definitions
+*************************************************************************/
+
+/* Events taken from epoll, and from one line, per call */
+#define BCM2835_GPIO_EVENT_BATCH    16
+
+#define BCM2835_GPIO_EVENT_LABEL    "bcm2835_lib"
+
+/*************************************************************************
+** Type Definitions
+*************************************************************************/
+
+typedef struct
+{
+    bool                  Active;
+    int                   Fd;        /* Line event handle, or read end of the pipe */
+    int                   InjectFd;  /* Write end of the pipe (simulation only) */
+    bcm2835_gpio_event_fn Fn;        /* NULL when the events go to Queue */
+    void                 *Arg;
+    osal_id_t             Queue;
+    uint32                Dropped;
+} BCM2835_GPIO_EventPin_t;
+
+/*************************************************************************
+** Local Data
+*************************************************************************/
+
+static BCM2835_GPIO_EventPin_t BCM2835_GPIO_EventPins[BCM2835_GPIO_EVENT_MAX_PINS];
+
+static osal_id_t        BCM2835_GPIO_EventLock;
+static CFE_ES_TaskId_t  BCM2835_GPIO_EventTaskId;
+static int              BCM2835_GPIO_EpollFd  = -1;
+static int              BCM2835_GPIO_ChipFd   = -1;
+static bool             BCM2835_GPIO_EventsInitialized;
+static volatile bool    BCM2835_GPIO_EventsRunning;
+
+/*************************************************************************
+** Local Functions
+*************************************************************************/
+
+/* Creates the file descriptor(s) of a pin; called with the lock held */
+static int32 BCM2835_GPIO_EventOpen(uint8 Pin, uint8 Edges, BCM2835_GPIO_EventPin_t *Entry)
+{
+#if BCM2835_DEBUG
+    int Fds[2];
+
+    (void)Pin;
+    (void)Edges;
+
+    if (pipe(Fds) < 0)
+    {
+        return BCM2835_GPIO_EVENT_ERR_OS;
+    }
+
+    /* Non-blocking on both ends: drained like a line, and inject never blocks */
+    fcntl(Fds[0], F_SETFL, O_NONBLOCK);
+    fcntl(Fds[1], F_SETFL, O_NONBLOCK);
+
+    Entry->Fd       = Fds[0];
+    Entry->InjectFd = Fds[1];
+#else
+    struct gpioevent_request Req;
+
+    if (BCM2835_GPIO_ChipFd < 0)
+    {
+        BCM2835_GPIO_ChipFd = open(BCM2835_GPIO_EVENT_CHIP, O_RDONLY | O_CLOEXEC);
+        if (BCM2835_GPIO_ChipFd < 0)
+        {
+            OS_printf("BCM2835 Lib: unable to open %s: %s\n", BCM2835_GPIO_EVENT_CHIP, strerror(errno));
+            return BCM2835_GPIO_EVENT_ERR_OS;
+        }
+    }
+
+    memset(&Req, 0, sizeof(Req));
+    Req.lineoffset  = Pin;
+    Req.handleflags = GPIOHANDLE_REQUEST_INPUT;
+    Req.eventflags  = ((Edges & BCM2835_GPIO_EDGE_RISING) ? GPIOEVENT_REQUEST_RISING_EDGE : 0) |
+                     ((Edges & BCM2835_GPIO_EDGE_FALLING) ? GPIOEVENT_REQUEST_FALLING_EDGE : 0);
+    strncpy(Req.consumer_label, BCM2835_GPIO_EVENT_LABEL, sizeof(Req.consumer_label) - 1);
+
+    if (ioctl(BCM2835_GPIO_ChipFd, GPIO_GET_LINEEVENT_IOCTL, &Req) < 0)
+    {
+        OS_printf("BCM2835 Lib: events of GPIO %u not requested: %s\n", (unsigned int)Pin, strerror(errno));
+        return BCM2835_GPIO_EVENT_ERR_OS;
+    }
+
+    /* The dispatcher drains each line until it would block */
+    fcntl(Req.fd, F_SETFL, fcntl(Req.fd, F_GETFL) | O_NONBLOCK);
+
+    Entry->Fd       = Req.fd;
+    Entry->InjectFd = -1;
+#endif
+
+    return BCM2835_GPIO_EVENT_OK;
+}
+
+static void BCM2835_GPIO_EventClose(BCM2835_GPIO_EventPin_t *Entry)
+{
+    if (Entry->Fd >= 0)
+    {
+        close(Entry->Fd);
+    }
+    if (Entry->InjectFd >= 0)
+    {
+        close(Entry->InjectFd);
+    }
+
+    memset(Entry, 0, sizeof(*Entry));
+    Entry->Fd       = -1;
+    Entry->InjectFd = -1;
+}
+
+static int32 BCM2835_GPIO_EventAdd(uint8 Pin, uint8 Edges, bcm2835_gpio_event_fn Fn, void *Arg, osal_id_t Queue)
+{
+    BCM2835_GPIO_EventPin_t *Entry;
+    struct epoll_event       Ev;
+    int32                    Status;
+
+    if (!BCM2835_GPIO_EventsInitialized || Pin >= BCM2835_GPIO_EVENT_MAX_PINS ||
+        (Edges & BCM2835_GPIO_EDGE_BOTH) == 0 || (Edges & ~BCM2835_GPIO_EDGE_BOTH) != 0)
+    {
+        return BCM2835_GPIO_EVENT_ERR_INVALID;
+    }
+
+    Entry = &BCM2835_GPIO_EventPins[Pin];
+
+    OS_MutSemTake(BCM2835_GPIO_EventLock);
+
+    if (Entry->Active)
+    {
+        OS_MutSemGive(BCM2835_GPIO_EventLock);
+        return BCM2835_GPIO_EVENT_ERR_BUSY;
+    }
+
+    Status = BCM2835_GPIO_EventOpen(Pin, Edges, Entry);
+    if (Status == BCM2835_GPIO_EVENT_OK)
+    {
+        Entry->Fn      = Fn;
+        Entry->Arg     = Arg;
+        Entry->Queue   = Queue;
+        Entry->Dropped = 0;
+        Entry->Active  = true;
+
+        memset(&Ev, 0, sizeof(Ev));
+        Ev.events   = EPOLLIN;
+        Ev.data.u32 = Pin;
+        if (epoll_ctl(BCM2835_GPIO_EpollFd, EPOLL_CTL_ADD, Entry->Fd, &Ev) < 0)
+        {
+            BCM2835_GPIO_EventClose(Entry);
+            Status = BCM2835_GPIO_EVENT_ERR_OS;
+        }
+    }
+
+    OS_MutSemGive(BCM2835_GPIO_EventLock);
+
+    return Status;
+}
+
+/* Reads and delivers the pending events of one pin */
+static void BCM2835_GPIO_EventDrain(uint8 Pin)
+{
+    BCM2835_GPIO_EventPin_t *Entry = &BCM2835_GPIO_EventPins[Pin];
+    struct gpioevent_data    Data[BCM2835_GPIO_EVENT_BATCH];
+    bcm2835_gpio_event_t     Event;
+    bcm2835_gpio_event_fn    Fn;
+    void                    *Arg;
+    osal_id_t                Queue;
+    ssize_t                  Len;
+    uint32                   Count;
+    uint32                   i;
+
+    do
+    {
+        /* The pin may be removed between epoll_wait and here */
+        OS_MutSemTake(BCM2835_GPIO_EventLock);
+        if (!Entry->Active)
+        {
+            OS_MutSemGive(BCM2835_GPIO_EventLock);
+            return;
+        }
+        Len   = read(Entry->Fd, Data, sizeof(Data));
+        Fn    = Entry->Fn;
+        Arg   = Entry->Arg;
+        Queue = Entry->Queue;
+        OS_MutSemGive(BCM2835_GPIO_EventLock);
+
+        if (Len <= 0)
+        {
+            return;
+        }
+
+        Count = (uint32)Len / sizeof(Data[0]);
+        for (i = 0; i < Count; i++)
+        {
+            Event.timestamp_ns = Data[i].timestamp;
+            Event.pin          = Pin;
+            Event.edge         = (Data[i].id == GPIOEVENT_EVENT_RISING_EDGE) ? BCM2835_GPIO_EDGE_RISING
+                                                                             : BCM2835_GPIO_EDGE_FALLING;
+
+            /* Handlers run unlocked, so they may add or remove pins */
+            if (Fn != NULL)
+            {
+                Fn(&Event, Arg);
+            }
+            else if (OS_QueuePut(Queue, &Event, sizeof(Event), 0) != OS_SUCCESS)
+            {
+                Entry->Dropped++;
+            }
+        }
+    } while (Count == BCM2835_GPIO_EVENT_BATCH);
+}
+
+static void BCM2835_GPIO_EventTask(void)
+{
+    struct epoll_event Ev[BCM2835_GPIO_EVENT_BATCH];
+    int                Ready;
+    int                i;
+
+    if (CFE_ES_RegisterChildTask() != CFE_SUCCESS)
+    {
+        BCM2835_GPIO_EventsRunning = false;
+        return;
+    }
+
+    for (;;)
+    {
+        Ready = epoll_wait(BCM2835_GPIO_EpollFd, Ev, BCM2835_GPIO_EVENT_BATCH, -1);
+        if (Ready < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            OS_printf("BCM2835 Lib: GPIO event wait failed: %s\n", strerror(errno));
+            break;
+        }
+
+        for (i = 0; i < Ready; i++)
+        {
+            BCM2835_GPIO_EventDrain((uint8)Ev[i].data.u32);
+        }
+    }
+
+    BCM2835_GPIO_EventsRunning = false;
+    CFE_ES_ExitChildTask();
+}
+
+/*************************************************************************
+** Internal Functions
+*************************************************************************/
+
+int32 BCM2835_GPIO_EventInit(void)
+{
+    uint32 Pin;
+
+    memset(BCM2835_GPIO_EventPins, 0, sizeof(BCM2835_GPIO_EventPins));
+    for (Pin = 0; Pin < BCM2835_GPIO_EVENT_MAX_PINS; Pin++)
+    {
+        BCM2835_GPIO_EventPins[Pin].Fd       = -1;
+        BCM2835_GPIO_EventPins[Pin].InjectFd = -1;
+    }
+
+    if (OS_MutSemCreate(&BCM2835_GPIO_EventLock, "gpio_evt_lock", 0) != OS_SUCCESS)
+    {
+        OS_printf("BCM2835 Lib: GPIO event lock not created.\n");
+        return CFE_STATUS_NOT_IMPLEMENTED;
+    }
+
+    BCM2835_GPIO_EpollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (BCM2835_GPIO_EpollFd < 0)
+    {
+        OS_printf("BCM2835 Lib: GPIO event epoll set not created: %s\n", strerror(errno));
+        return CFE_STATUS_NOT_IMPLEMENTED;
+    }
+
+    BCM2835_GPIO_EventsInitialized = true;
+
+    return CFE_SUCCESS;
+}
+
+/*************************************************************************
+** Public Functions
+*************************************************************************/
+
+int32_t bcm2835_gpio_events_start(uint32_t priority)
+{
+    if (!BCM2835_GPIO_EventsInitialized)
+    {
+        return BCM2835_GPIO_EVENT_ERR_INVALID;
+    }
+
+    if (BCM2835_GPIO_EventsRunning)
+    {
+        return BCM2835_GPIO_EVENT_OK;
+    }
+
+    BCM2835_GPIO_EventsRunning = true;
+
+    if (CFE_ES_CreateChildTask(&BCM2835_GPIO_EventTaskId, "GPIO_EVENTS", BCM2835_GPIO_EventTask,
+                               CFE_ES_TASK_STACK_ALLOCATE, BCM2835_GPIO_EVENT_STACK_SIZE, priority,
+                               0) != CFE_SUCCESS)
+    {
+        BCM2835_GPIO_EventsRunning = false;
+        return BCM2835_GPIO_EVENT_ERR_OS;
+    }
+
+    return BCM2835_GPIO_EVENT_OK;
+}
+
+int32_t bcm2835_gpio_event_add(uint8_t pin, uint8_t edges, bcm2835_gpio_event_fn fn, void *arg)
+{
+    if (fn == NULL)
+    {
+        return BCM2835_GPIO_EVENT_ERR_INVALID;
+    }
+
+    return BCM2835_GPIO_EventAdd(pin, edges, fn, arg, OS_OBJECT_ID_UNDEFINED);
+}
+
+int32_t bcm2835_gpio_event_add_queue(uint8_t pin, uint8_t edges, osal_id_t queue)
+{
+    return BCM2835_GPIO_EventAdd(pin, edges, NULL, NULL, queue);
+}
+
+int32_t bcm2835_gpio_event_remove(uint8_t pin)
+{
+    BCM2835_GPIO_EventPin_t *Entry;
+    int32                    Status = BCM2835_GPIO_EVENT_OK;
+
+    if (!BCM2835_GPIO_EventsInitialized || pin >= BCM2835_GPIO_EVENT_MAX_PINS)
+    {
+        return BCM2835_GPIO_EVENT_ERR_INVALID;
+    }
+
+    Entry = &BCM2835_GPIO_EventPins[pin];
+
+    OS_MutSemTake(BCM2835_GPIO_EventLock);
+
+    if (Entry->Active)
+    {
+        epoll_ctl(BCM2835_GPIO_EpollFd, EPOLL_CTL_DEL, Entry->Fd, NULL);
+        BCM2835_GPIO_EventClose(Entry);
+    }
+    else
+    {
+        Status = BCM2835_GPIO_EVENT_ERR_INVALID;
+    }
+
+    OS_MutSemGive(BCM2835_GPIO_EventLock);
+
+    return Status;
+}
+
+uint32_t bcm2835_gpio_event_dropped(uint8_t pin)
+{
+    if (pin >= BCM2835_GPIO_EVENT_MAX_PINS)
+    {
+        return 0;
+    }
+
+    return BCM2835_GPIO_EventPins[pin].Dropped;
+}
+
+int32_t bcm2835_gpio_event_inject(uint8_t pin, uint8_t edge)
+{
+#if BCM2835_DEBUG
+    struct gpioevent_data Data;
+    int32                 Status = BCM2835_GPIO_EVENT_OK;
+
+    if (pin >= BCM2835_GPIO_EVENT_MAX_PINS ||
+        (edge != BCM2835_GPIO_EDGE_RISING && edge != BCM2835_GPIO_EDGE_FALLING))
+    {
+        return BCM2835_GPIO_EVENT_ERR_INVALID;
+    }
+
+    Data.timestamp = BCM2835_LIB_GetTimeUs() * 1000;
+    Data.id        = (edge == BCM2835_GPIO_EDGE_RISING) ? GPIOEVENT_EVENT_RISING_EDGE : GPIOEVENT_EVENT_FALLING_EDGE;
+
+    OS_MutSemTake(BCM2835_GPIO_EventLock);
+    if (!BCM2835_GPIO_EventPins[pin].Active)
+    {
+        Status = BCM2835_GPIO_EVENT_ERR_INVALID;
+    }
+    else if (write(BCM2835_GPIO_EventPins[pin].InjectFd, &Data, sizeof(Data)) != sizeof(Data))
+    {
+        /* Pipe full: the dispatcher is not keeping up, same as a lost edge */
+        BCM2835_GPIO_EventPins[pin].Dropped++;
+        Status = BCM2835_GPIO_EVENT_ERR_OS;
+    }
+    OS_MutSemGive(BCM2835_GPIO_EventLock);
+
+    return Status;
+#else
+    (void)pin;
+    (void)edge;
+
+    return BCM2835_GPIO_EVENT_ERR_INVALID;
+#endif
+}
+
+/************************/
+/*  End of File Comment */
+/************************/
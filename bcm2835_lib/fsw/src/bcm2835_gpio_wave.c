@@ -0,0 +1,228 @@
+/*************************************************************************
+**
+**      GSC-18128-1, "Core Flight Executive Version 6.7"
+**
+**      Copyright (c) 2006-2019 United States Government as represented by
+**      the Administrator of the National Aeronautics and Space Administration.
+**      All Rights Reserved.
+**
+**      Licensed under the Apache License, Version 2.0 (the "License");
+**      you may not use this file except in compliance with the License.
+**      You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**      Unless required by applicable law or agreed to in writing, software
+**      distributed under the License is distributed on an "AS IS" BASIS,
+**      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**      See the License for the specific language governing permissions and
+**      limitations under the License.
+**
+** File: bcm2835_gpio_wave.c
+**
+** Purpose:
+**  Precompiled GPIO waveforms replayed on the System Timer.
+**
+** Notes:
+**  Step times are absolute (counted from the first step), so a late step
+**  does not shift the ones after it. Only the low word of the System
+**  Timer is read; a waveform must be shorter than 2^31 us.
+**  Without access to the System Timer (simulation builds) the monotonic
+**  clock is used instead and the GPIO writes do nothing.
+**
+*************************************************************************/
+
+#include <string.h>
+#include <sys/mman.h>
+
+#include "bcm2835_lib_internal.h"
+
+/*************************************************************************
+** Local Functions
+*************************************************************************/
+
+/* Current System Timer tick; Clo is NULL when the timer is not mapped */
+static inline uint32 BCM2835_WaveNow(volatile uint32_t *Clo)
+{
+    if (Clo == NULL)
+    {
+        return (uint32)BCM2835_LIB_GetTimeUs();
+    }
+
+    return bcm2835_peri_read_nb(Clo);
+}
+
+/*************************************************************************
+** Public Functions
+*************************************************************************/
+
+void bcm2835_wave_init(bcm2835_wave_t *w, bcm2835_wave_step_t *steps, uint32_t capacity)
+{
+    w->steps    = steps;
+    w->capacity = capacity;
+    bcm2835_wave_clear(w);
+}
+
+void bcm2835_wave_clear(bcm2835_wave_t *w)
+{
+    w->count       = 0;
+    w->duration_us = 0;
+}
+
+int bcm2835_wave_add(bcm2835_wave_t *w, uint32_t set, uint32_t clr, uint32_t delay_us)
+{
+    bcm2835_wave_step_t *Last = (w->count > 0) ? &w->steps[w->count - 1] : NULL;
+
+    if (Last != NULL && Last->delay_us == 0 && ((Last->set | Last->clr) & (set | clr)) == 0)
+    {
+        Last->set |= set;
+        Last->clr |= clr;
+        Last->delay_us = delay_us;
+    }
+    else
+    {
+        if (w->count >= w->capacity)
+        {
+            return 0;
+        }
+
+        w->steps[w->count].set      = set;
+        w->steps[w->count].clr      = clr;
+        w->steps[w->count].delay_us = delay_us;
+        w->count++;
+    }
+
+    w->duration_us += delay_us;
+
+    return 1;
+}
+
+int bcm2835_wave_add_spi(bcm2835_wave_t *w, uint8_t sclk, uint8_t mosi, const uint8_t *buf, uint32_t len,
+                         uint32_t half_period_us)
+{
+    uint32              SaveCount    = w->count;
+    uint32              SaveDuration = w->duration_us;
+    bcm2835_wave_step_t SaveLast     = {0, 0, 0};
+    uint32 Sclk;
+    uint32 Mosi;
+    uint32 i;
+    int    Bit;
+    int    Ok = 1;
+
+    if (sclk > 31 || mosi > 31 || sclk == mosi || (buf == NULL && len > 0))
+    {
+        return 0;
+    }
+
+    /* The first step may be merged into the last one */
+    if (SaveCount > 0)
+    {
+        SaveLast = w->steps[SaveCount - 1];
+    }
+
+    Sclk = (uint32)1 << sclk;
+    Mosi = (uint32)1 << mosi;
+
+    for (i = 0; i < len && Ok; i++)
+    {
+        for (Bit = 7; Bit >= 0 && Ok; Bit--)
+        {
+            if (buf[i] & (1 << Bit))
+            {
+                Ok = bcm2835_wave_add(w, Mosi, Sclk, half_period_us);
+            }
+            else
+            {
+                Ok = bcm2835_wave_add(w, 0, Sclk | Mosi, half_period_us);
+            }
+
+            Ok = Ok && bcm2835_wave_add(w, Sclk, 0, half_period_us);
+        }
+    }
+
+    Ok = Ok && bcm2835_wave_add(w, 0, Sclk, 0);
+
+    if (!Ok)
+    {
+        w->count       = SaveCount;
+        w->duration_us = SaveDuration;
+        if (SaveCount > 0)
+        {
+            w->steps[SaveCount - 1] = SaveLast;
+        }
+    }
+
+    return Ok;
+}
+
+void bcm2835_wave_play(const bcm2835_wave_t *w, bcm2835_wave_result_t *result)
+{
+    const bcm2835_wave_step_t *Step;
+    volatile uint32_t         *Clo;
+    volatile uint32_t         *Set = bcm2835_gpio + BCM2835_GPSET0 / 4;
+    volatile uint32_t         *Clr = bcm2835_gpio + BCM2835_GPCLR0 / 4;
+    bcm2835_wave_result_t      Res;
+    uint32                     Start;
+    uint32                     Due;
+    uint32                     Now;
+    uint32                     Late;
+    uint32                     i;
+
+    memset(&Res, 0, sizeof(Res));
+
+    if (w->count > 0)
+    {
+        /* In simulation builds the timer pointer is set but reads return 0 */
+        Clo = (BCM2835_DEBUG || !BCM2835_LIB_MapRegion(BCM2835_REGBASE_ST)) ? NULL : bcm2835_st + BCM2835_ST_CLO / 4;
+
+        bcm2835_memory_barrier();
+
+        Start = BCM2835_WaveNow(Clo);
+        Due   = Start;
+
+        for (i = 0, Step = w->steps; i < w->count; i++, Step++)
+        {
+            /* Read the timer for every step, a step that is already due may be later than the last reading */
+            Now = BCM2835_WaveNow(Clo);
+            while ((int32)(Now - Due) < 0)
+            {
+                Now = BCM2835_WaveNow(Clo);
+            }
+
+            if (Step->set != 0)
+            {
+                bcm2835_peri_write_nb(Set, Step->set);
+            }
+            if (Step->clr != 0)
+            {
+                bcm2835_peri_write_nb(Clr, Step->clr);
+            }
+
+            Late = Now - Due;
+            if (Late > 0)
+            {
+                Res.late_steps++;
+                if (Late > Res.max_late_us)
+                {
+                    Res.max_late_us = Late;
+                }
+            }
+
+            Due += Step->delay_us;
+        }
+
+        bcm2835_memory_barrier();
+
+        Res.steps       = w->count;
+        Res.duration_us = BCM2835_WaveNow(Clo) - Start;
+    }
+
+    if (result != NULL)
+    {
+        *result = Res;
+    }
+}
+
+/************************/
+/*  End of File Comment */
+/************************/
@@ -0,0 +1,552 @@
+/*************************************************************************
+**
+**      GSC-18128-1, "Core Flight Executive Version 6.7"
+**
+**      Copyright (c) 2006-2019 United States Government as represented by
+**      the Administrator of the National Aeronautics and Space Administration.
+**      All Rights Reserved.
+**
+**      Licensed under the Apache License, Version 2.0 (the "License");
+**      you may not use this file except in compliance with the License.
+**      You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**      Unless required by applicable law or agreed to in writing, software
+**      distributed under the License is distributed on an "AS IS" BASIS,
+**      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**      See the License for the specific language governing permissions and
+**      limitations under the License.
+**
+** File: bcm2835_i2c_sched.c
+**
+** Purpose:
+**  Deadline-aware arbitration of each I2C bus between the apps that
+**  share it.
+**
+** Notes:
+**  Waiting clients are granted the bus earliest-deadline-first, ties are
+**  broken by the OSAL style priority (lower value is more important).
+**  Clients without a deadline are served after all clients with one.
+**  The bus is handed over directly to the next client on release, so a
+**  woken client never has to race for it again.
+**  Every BSC controller has an independent scheduler instance. Client ids
+**  encode the bus, so the public functions find the instance from the id.
+**
+*************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "bcm2835_lib_internal.h"
+
+/*************************************************************************
+** Macro Definitions
+*************************************************************************/
+
+/* Deadline key of clients with no deadline, sorts after every real deadline */
+#define BCM2835_I2C_SCHED_NO_DEADLINE  0xFFFFFFFFFFFFFFFFULL
+
+/* Owner value when the bus is free */
+#define BCM2835_I2C_SCHED_NO_OWNER     (-1)
+
+/* Client id <-> bus and slot */
+#define BCM2835_I2C_SCHED_ID(Bus, Slot)  ((uint32)(Bus) * BCM2835_I2C_SCHED_MAX_CLIENTS + (Slot))
+#define BCM2835_I2C_SCHED_BUS(Id)        ((Id) / BCM2835_I2C_SCHED_MAX_CLIENTS)
+#define BCM2835_I2C_SCHED_SLOT(Id)       ((Id) % BCM2835_I2C_SCHED_MAX_CLIENTS)
+
+/*************************************************************************
+** Type Definitions
+*************************************************************************/
+
+typedef struct
+{
+    bool      InUse;
+    char      Name[BCM2835_I2C_SCHED_NAME_LEN];
+    uint8     Priority;
+    uint32    DeadlineUs;
+
+    bool      JobActive;
+    bool      Waiting;
+    uint64    AbsDeadline;
+    uint64    WaitStartUs;
+    uint64    GrantUs;
+
+    osal_id_t WakeSem;
+
+    bcm2835_i2c_sched_stats_t Stats;
+} BCM2835_I2C_SchedClient_t;
+
+typedef struct
+{
+    bool           Initialized;
+    bcm2835_lock_t Lock;
+    int32          Owner;
+
+    BCM2835_I2C_SchedClient_t Clients[BCM2835_I2C_SCHED_MAX_CLIENTS];
+} BCM2835_I2C_Sched_t;
+
+/*************************************************************************
+** Local Data
+*************************************************************************/
+
+static BCM2835_I2C_Sched_t BCM2835_I2C_Sched[BCM2835_I2C_BUS_COUNT];
+
+/*************************************************************************
+** Local Functions
+*************************************************************************/
+
+/* Scheduler instance of a client id, or NULL if the id is not registered */
+static BCM2835_I2C_Sched_t *BCM2835_I2C_SchedFromId(uint32 ClientId)
+{
+    BCM2835_I2C_Sched_t *Sched;
+
+    if (BCM2835_I2C_SCHED_BUS(ClientId) >= BCM2835_I2C_BUS_COUNT)
+    {
+        return NULL;
+    }
+
+    Sched = &BCM2835_I2C_Sched[BCM2835_I2C_SCHED_BUS(ClientId)];
+    if (!Sched->Initialized || !Sched->Clients[BCM2835_I2C_SCHED_SLOT(ClientId)].InUse)
+    {
+        return NULL;
+    }
+
+    return Sched;
+}
+
+static uint64 BCM2835_I2C_SchedDeadlineKey(const BCM2835_I2C_SchedClient_t *Client)
+{
+    if (!Client->JobActive || Client->AbsDeadline == 0)
+    {
+        return BCM2835_I2C_SCHED_NO_DEADLINE;
+    }
+
+    return Client->AbsDeadline;
+}
+
+/* True if client A must be served before client B */
+static bool BCM2835_I2C_SchedMoreUrgent(const BCM2835_I2C_SchedClient_t *A, const BCM2835_I2C_SchedClient_t *B)
+{
+    uint64 KeyA = BCM2835_I2C_SchedDeadlineKey(A);
+    uint64 KeyB = BCM2835_I2C_SchedDeadlineKey(B);
+
+    if (KeyA != KeyB)
+    {
+        return (KeyA < KeyB);
+    }
+
+    return (A->Priority < B->Priority);
+}
+
+/* Most urgent waiting client, or BCM2835_I2C_SCHED_NO_OWNER. Call with the lock held. */
+static int32 BCM2835_I2C_SchedPickNext(BCM2835_I2C_Sched_t *Sched)
+{
+    int32 i;
+    int32 Next = BCM2835_I2C_SCHED_NO_OWNER;
+
+    for (i = 0; i < BCM2835_I2C_SCHED_MAX_CLIENTS; i++)
+    {
+        if (Sched->Clients[i].InUse && Sched->Clients[i].Waiting)
+        {
+            if (Next == BCM2835_I2C_SCHED_NO_OWNER ||
+                BCM2835_I2C_SchedMoreUrgent(&Sched->Clients[i], &Sched->Clients[Next]))
+            {
+                Next = i;
+            }
+        }
+    }
+
+    return Next;
+}
+
+static void BCM2835_I2C_SchedStartJob(BCM2835_I2C_SchedClient_t *Client, uint64 Now)
+{
+    Client->JobActive   = true;
+    Client->AbsDeadline = (Client->DeadlineUs != 0) ? (Now + Client->DeadlineUs) : 0;
+    Client->Stats.Jobs++;
+}
+
+/* Closes the current job of a client, counting a miss if it ran past its deadline */
+static void BCM2835_I2C_SchedEndJob(BCM2835_I2C_SchedClient_t *Client, uint64 Now)
+{
+    if (Client->JobActive && Client->AbsDeadline != 0 && Now > Client->AbsDeadline)
+    {
+        Client->Stats.DeadlineMisses++;
+    }
+
+    Client->JobActive = false;
+}
+
+/* Makes Slot the owner. Call with the lock held. */
+static void BCM2835_I2C_SchedGrant(BCM2835_I2C_Sched_t *Sched, int32 Slot, uint64 Now)
+{
+    BCM2835_I2C_SchedClient_t *Client = &Sched->Clients[Slot];
+    uint64                     Waited;
+
+    if (Client->Waiting)
+    {
+        Waited = Now - Client->WaitStartUs;
+        if (Waited > Client->Stats.MaxWaitUs)
+        {
+            Client->Stats.MaxWaitUs = (Waited > 0xFFFFFFFF) ? 0xFFFFFFFF : (uint32)Waited;
+        }
+        Client->Waiting = false;
+    }
+
+    Client->GrantUs = Now;
+    Client->Stats.Grants++;
+    Sched->Owner = Slot;
+}
+
+/* Accounts the hold time of the current owner. Call with the lock held. */
+static void BCM2835_I2C_SchedAccountHold(BCM2835_I2C_Sched_t *Sched, uint64 Now)
+{
+    BCM2835_I2C_SchedClient_t *Client = &Sched->Clients[Sched->Owner];
+    uint64                     Held   = Now - Client->GrantUs;
+
+    if (Held > Client->Stats.MaxHoldUs)
+    {
+        Client->Stats.MaxHoldUs = (Held > 0xFFFFFFFF) ? 0xFFFFFFFF : (uint32)Held;
+    }
+}
+
+/* Passes the bus to the most urgent waiting client, or frees it. Call with the lock held. */
+static void BCM2835_I2C_SchedHandOver(BCM2835_I2C_Sched_t *Sched, uint64 Now)
+{
+    int32 Next = BCM2835_I2C_SchedPickNext(Sched);
+
+    if (Next == BCM2835_I2C_SCHED_NO_OWNER)
+    {
+        Sched->Owner = BCM2835_I2C_SCHED_NO_OWNER;
+    }
+    else
+    {
+        BCM2835_I2C_SchedGrant(Sched, Next, Now);
+        OS_BinSemGive(Sched->Clients[Next].WakeSem);
+    }
+}
+
+/*************************************************************************
+** Internal Functions
+*************************************************************************/
+
+int32 BCM2835_I2C_SchedInit(void)
+{
+    BCM2835_I2C_Sched_t *Sched;
+    uint32               Bus;
+
+    memset(BCM2835_I2C_Sched, 0, sizeof(BCM2835_I2C_Sched));
+
+    for (Bus = 0; Bus < BCM2835_I2C_BUS_COUNT; Bus++)
+    {
+        Sched        = &BCM2835_I2C_Sched[Bus];
+        Sched->Owner = BCM2835_I2C_SCHED_NO_OWNER;
+
+        bcm2835_lock_init(&Sched->Lock);
+
+        Sched->Initialized = true;
+    }
+
+    return CFE_SUCCESS;
+}
+
+bcm2835_lock_t *BCM2835_I2C_SchedLock(uint8 Bus)
+{
+    if (Bus >= BCM2835_I2C_BUS_COUNT || !BCM2835_I2C_Sched[Bus].Initialized)
+    {
+        return NULL;
+    }
+
+    return &BCM2835_I2C_Sched[Bus].Lock;
+}
+
+/*************************************************************************
+** Public Functions
+*************************************************************************/
+
+int32_t bcm2835_i2c_sched_register(uint8_t bus, const char *name, uint8_t priority, uint32_t period_us,
+                                   uint32_t deadline_us, uint32_t *client_id)
+{
+    BCM2835_I2C_Sched_t       *Sched;
+    BCM2835_I2C_SchedClient_t *Client;
+    char                       SemName[OS_MAX_API_NAME];
+    uint32                     i;
+    int32_t                    status = BCM2835_I2C_SCHED_ERR_FULL;
+
+    if (bus >= BCM2835_I2C_BUS_COUNT || !BCM2835_I2C_Sched[bus].Initialized || name == NULL || client_id == NULL)
+    {
+        return BCM2835_I2C_SCHED_ERR_INVALID;
+    }
+
+    Sched = &BCM2835_I2C_Sched[bus];
+
+    bcm2835_lock_acquire(&Sched->Lock, BCM2835_LOCK_PEND_FOREVER);
+
+    for (i = 0; i < BCM2835_I2C_SCHED_MAX_CLIENTS; i++)
+    {
+        Client = &Sched->Clients[i];
+        if (!Client->InUse)
+        {
+            memset(Client, 0, sizeof(*Client));
+
+            snprintf(SemName, sizeof(SemName), "i2c_sched_%u_%u", (unsigned int)bus, (unsigned int)i);
+            if (OS_BinSemCreate(&Client->WakeSem, SemName, 0, 0) != OS_SUCCESS)
+            {
+                status = BCM2835_I2C_SCHED_ERR_OS;
+                break;
+            }
+
+            strncpy(Client->Name, name, sizeof(Client->Name) - 1);
+            Client->Priority   = priority;
+            Client->DeadlineUs = (deadline_us != 0) ? deadline_us : period_us;
+            Client->InUse      = true;
+
+            *client_id = BCM2835_I2C_SCHED_ID(bus, i);
+            status     = BCM2835_I2C_SCHED_OK;
+            break;
+        }
+    }
+
+    bcm2835_lock_release(&Sched->Lock);
+
+    return status;
+}
+
+int32_t bcm2835_i2c_sched_set_period(uint32_t client_id, uint32_t period_us, uint32_t deadline_us)
+{
+    BCM2835_I2C_Sched_t *Sched = BCM2835_I2C_SchedFromId(client_id);
+
+    if (Sched == NULL)
+    {
+        return BCM2835_I2C_SCHED_ERR_INVALID;
+    }
+
+    /* The current job keeps its deadline, the next one gets the new one */
+    bcm2835_lock_acquire(&Sched->Lock, BCM2835_LOCK_PEND_FOREVER);
+    Sched->Clients[BCM2835_I2C_SCHED_SLOT(client_id)].DeadlineUs = (deadline_us != 0) ? deadline_us : period_us;
+    bcm2835_lock_release(&Sched->Lock);
+
+    return BCM2835_I2C_SCHED_OK;
+}
+
+int32_t bcm2835_i2c_sched_start_job(uint32_t client_id)
+{
+    BCM2835_I2C_Sched_t       *Sched = BCM2835_I2C_SchedFromId(client_id);
+    BCM2835_I2C_SchedClient_t *Client;
+    uint64                     Now;
+
+    if (Sched == NULL)
+    {
+        return BCM2835_I2C_SCHED_ERR_INVALID;
+    }
+
+    Client = &Sched->Clients[BCM2835_I2C_SCHED_SLOT(client_id)];
+
+    bcm2835_lock_acquire(&Sched->Lock, BCM2835_LOCK_PEND_FOREVER);
+
+    Now = BCM2835_LIB_GetTimeUs();
+
+    /* A job that was never completed counts as missed once its deadline is gone */
+    BCM2835_I2C_SchedEndJob(Client, Now);
+    BCM2835_I2C_SchedStartJob(Client, Now);
+
+    bcm2835_lock_release(&Sched->Lock);
+
+    return BCM2835_I2C_SCHED_OK;
+}
+
+int32_t bcm2835_i2c_sched_acquire(uint32_t client_id, int32_t timeout_ms)
+{
+    BCM2835_I2C_Sched_t       *Sched = BCM2835_I2C_SchedFromId(client_id);
+    BCM2835_I2C_SchedClient_t *Client;
+    int32                      Slot;
+    int32                      OsStatus;
+    uint64                     Now;
+    uint8                      Bus;
+
+    if (Sched == NULL)
+    {
+        return BCM2835_I2C_SCHED_ERR_INVALID;
+    }
+
+    Bus    = (uint8)BCM2835_I2C_SCHED_BUS(client_id);
+    Slot   = BCM2835_I2C_SCHED_SLOT(client_id);
+    Client = &Sched->Clients[Slot];
+
+    bcm2835_lock_acquire(&Sched->Lock, BCM2835_LOCK_PEND_FOREVER);
+
+    if (Sched->Owner == Slot)
+    {
+        bcm2835_lock_release(&Sched->Lock);
+        return BCM2835_I2C_SCHED_OK;
+    }
+
+    Now = BCM2835_LIB_GetTimeUs();
+
+    if (!Client->JobActive)
+    {
+        BCM2835_I2C_SchedStartJob(Client, Now);
+    }
+
+    if (Sched->Owner == BCM2835_I2C_SCHED_NO_OWNER)
+    {
+        BCM2835_I2C_SchedGrant(Sched, Slot, Now);
+        bcm2835_lock_release(&Sched->Lock);
+        BCM2835_BUS_AccountWait(Bus, 0, false);
+        return BCM2835_I2C_SCHED_OK;
+    }
+
+    if (timeout_ms == 0)
+    {
+        Client->Stats.Timeouts++;
+        bcm2835_lock_release(&Sched->Lock);
+        BCM2835_BUS_AccountWait(Bus, 0, true);
+        return BCM2835_I2C_SCHED_ERR_TIMEOUT;
+    }
+
+    Client->Waiting     = true;
+    Client->WaitStartUs = Now;
+
+    bcm2835_lock_release(&Sched->Lock);
+
+    if (timeout_ms < 0)
+    {
+        OsStatus = OS_BinSemTake(Client->WakeSem);
+    }
+    else
+    {
+        OsStatus = OS_BinSemTimedWait(Client->WakeSem, (uint32)timeout_ms);
+    }
+
+    bcm2835_lock_acquire(&Sched->Lock, BCM2835_LOCK_PEND_FOREVER);
+
+    if (Sched->Owner == Slot)
+    {
+        /*
+        ** The bus may have been handed over between the timeout and taking the lock.
+        ** The semaphore was given in that case, consume it so the next wait blocks.
+        */
+        if (OsStatus != OS_SUCCESS)
+        {
+            OS_BinSemTake(Client->WakeSem);
+        }
+
+        bcm2835_lock_release(&Sched->Lock);
+        BCM2835_BUS_AccountWait(Bus, (uint32)(BCM2835_LIB_GetTimeUs() - Now), false);
+        return BCM2835_I2C_SCHED_OK;
+    }
+
+    Client->Waiting = false;
+    Client->Stats.Timeouts++;
+    BCM2835_I2C_SchedEndJob(Client, BCM2835_LIB_GetTimeUs());
+
+    bcm2835_lock_release(&Sched->Lock);
+    BCM2835_BUS_AccountWait(Bus, (uint32)(BCM2835_LIB_GetTimeUs() - Now), true);
+
+    return (OsStatus == OS_SEM_TIMEOUT || OsStatus == OS_SUCCESS) ? BCM2835_I2C_SCHED_ERR_TIMEOUT
+                                                                  : BCM2835_I2C_SCHED_ERR_OS;
+}
+
+int32_t bcm2835_i2c_sched_release(uint32_t client_id)
+{
+    BCM2835_I2C_Sched_t *Sched = BCM2835_I2C_SchedFromId(client_id);
+    int32                Slot;
+    uint64               Now;
+
+    if (Sched == NULL)
+    {
+        return BCM2835_I2C_SCHED_ERR_INVALID;
+    }
+
+    Slot = BCM2835_I2C_SCHED_SLOT(client_id);
+
+    bcm2835_lock_acquire(&Sched->Lock, BCM2835_LOCK_PEND_FOREVER);
+
+    if (Sched->Owner != Slot)
+    {
+        bcm2835_lock_release(&Sched->Lock);
+        return BCM2835_I2C_SCHED_ERR_NOT_OWNER;
+    }
+
+    Now = BCM2835_LIB_GetTimeUs();
+
+    BCM2835_I2C_SchedAccountHold(Sched, Now);
+    BCM2835_I2C_SchedEndJob(&Sched->Clients[Slot], Now);
+    BCM2835_I2C_SchedHandOver(Sched, Now);
+
+    bcm2835_lock_release(&Sched->Lock);
+
+    return BCM2835_I2C_SCHED_OK;
+}
+
+int32_t bcm2835_i2c_sched_yield(uint32_t client_id)
+{
+    BCM2835_I2C_Sched_t       *Sched = BCM2835_I2C_SchedFromId(client_id);
+    BCM2835_I2C_SchedClient_t *Client;
+    int32                      Next;
+    int32                      Self;
+    uint64                     Now;
+
+    if (Sched == NULL)
+    {
+        return BCM2835_I2C_SCHED_ERR_INVALID;
+    }
+
+    Self = BCM2835_I2C_SCHED_SLOT(client_id);
+
+    bcm2835_lock_acquire(&Sched->Lock, BCM2835_LOCK_PEND_FOREVER);
+
+    if (Sched->Owner != Self)
+    {
+        bcm2835_lock_release(&Sched->Lock);
+        return BCM2835_I2C_SCHED_ERR_NOT_OWNER;
+    }
+
+    Next = BCM2835_I2C_SchedPickNext(Sched);
+
+    if (Next == BCM2835_I2C_SCHED_NO_OWNER ||
+        !BCM2835_I2C_SchedMoreUrgent(&Sched->Clients[Next], &Sched->Clients[Self]))
+    {
+        bcm2835_lock_release(&Sched->Lock);
+        return BCM2835_I2C_SCHED_OK;
+    }
+
+    Client = &Sched->Clients[Self];
+    Now    = BCM2835_LIB_GetTimeUs();
+
+    BCM2835_I2C_SchedAccountHold(Sched, Now);
+    Client->Stats.Preemptions++;
+    Client->Waiting     = true;
+    Client->WaitStartUs = Now;
+
+    BCM2835_I2C_SchedGrant(Sched, Next, Now);
+    OS_BinSemGive(Sched->Clients[Next].WakeSem);
+
+    bcm2835_lock_release(&Sched->Lock);
+
+    /* The current job is still active, so the bus comes back once the more urgent work is done */
+    OS_BinSemTake(Client->WakeSem);
+
+    return BCM2835_I2C_SCHED_OK;
+}
+
+int32_t bcm2835_i2c_sched_get_stats(uint32_t client_id, bcm2835_i2c_sched_stats_t *stats)
+{
+    BCM2835_I2C_Sched_t *Sched = BCM2835_I2C_SchedFromId(client_id);
+
+    if (Sched == NULL || stats == NULL)
+    {
+        return BCM2835_I2C_SCHED_ERR_INVALID;
+    }
+
+    bcm2835_lock_acquire(&Sched->Lock, BCM2835_LOCK_PEND_FOREVER);
+    *stats = Sched->Clients[BCM2835_I2C_SCHED_SLOT(client_id)].Stats;
+    bcm2835_lock_release(&Sched->Lock);
+
+    return BCM2835_I2C_SCHED_OK;
+}
+
+/************************/
+/*  End of File Comment */
+/************************/
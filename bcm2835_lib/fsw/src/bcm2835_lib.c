@@ -16,23 +16,25 @@
 #include <time.h>
 #include <unistd.h>
 #include <sys/types.h>
+#include <pthread.h>
 
 #define BCK2835_LIBRARY_BUILD
-#include "bcm2835_lib.h"
+#include "bcm2835_lib_internal.h"
 
 #include "osconfig.h"
 #include "cfe.h"
 
 /* This define enables a little test program (by default a blinking output on pin RPI_GPIO_PIN_11)
 // You can do some safe, non-destructive testing on any platform with:
-// gcc bcm2835.c -D BCM2835_TEST
+// gcc bcm2835.c -D BCM2835_TEST -D BCM2835_SIMULATION
 // ./a.out
 */
 /*#define BCM2835_TEST*/
 
-/* Uncommenting this define compiles alternative I2C code for the version 1 RPi
+/* Uncommenting this define makes BSC0 the default I2C bus, for the version 1 RPi
 // The P1 header I2C pins are connected to SDA0 and SCL0 on V1.
-// By default I2C code is generated for the V2 RPi which has SDA1 and SCL1 connected.
+// By default the bcm2835_i2c_* functions use BSC1, as the V2 RPi has SDA1 and SCL1 connected.
+// Both controllers can always be used through the bcm2835_i2c_bus_* functions.
 */
 /* #define I2C_V1*/
 
@@ -46,9 +48,6 @@ size_t bcm2835_peripherals_size = BCM2835_PERI_SIZE;
  */
 uint32_t *bcm2835_peripherals = (uint32_t *)MAP_FAILED;
 
-/* I2C Mutex variable */
-uint32_t i2c_mutexvar;
-
 /* And the register bases within the peripherals block
  */
 volatile uint32_t *bcm2835_gpio        = (uint32_t *)MAP_FAILED;
@@ -61,14 +60,45 @@ volatile uint32_t *bcm2835_bsc1        = (uint32_t *)MAP_FAILED;
 volatile uint32_t *bcm2835_st	       = (uint32_t *)MAP_FAILED;
 volatile uint32_t *bcm2835_aux	       = (uint32_t *)MAP_FAILED;
 volatile uint32_t *bcm2835_spi1        = (uint32_t *)MAP_FAILED;
+volatile uint32_t *bcm2835_dma         = (uint32_t *)MAP_FAILED;
 
+/* Peripheral blocks, indexed by bcm2835RegisterBase and mapped page by page
+// on first use by BCM2835_LIB_MapRegion()
+*/
+typedef struct
+{
+    volatile uint32_t **base;   /* Register base pointer, set once mapped */
+    off_t offset;               /* Offset of the registers in the peripherals block */
+    size_t size;                /* Bytes of registers used */
+    void *map;                  /* Page aligned mapping, MAP_FAILED if none */
+    size_t map_size;
+    uint8_t tried;              /* Mapping attempted: do not retry after a failure */
+} bcm2835_region_t;
+
+#define BCM2835_REGION_COUNT (BCM2835_REGBASE_DMA + 1)
+
+static bcm2835_region_t bcm2835_regions[BCM2835_REGION_COUNT] =
+{
+    { NULL,          0,                  0,      MAP_FAILED, 0, 0 },
+    { &bcm2835_st,   BCM2835_ST_BASE,    0x20,   MAP_FAILED, 0, 0 }, /* BCM2835_REGBASE_ST */
+    { &bcm2835_gpio, BCM2835_GPIO_BASE,  0x100,  MAP_FAILED, 0, 0 }, /* BCM2835_REGBASE_GPIO */
+    { &bcm2835_pwm,  BCM2835_GPIO_PWM,   0x28,   MAP_FAILED, 0, 0 }, /* BCM2835_REGBASE_PWM */
+    { &bcm2835_clk,  BCM2835_CLOCK_BASE, 0xa8,   MAP_FAILED, 0, 0 }, /* BCM2835_REGBASE_CLK */
+    { &bcm2835_pads, BCM2835_GPIO_PADS,  0x38,   MAP_FAILED, 0, 0 }, /* BCM2835_REGBASE_PADS */
+    { &bcm2835_spi0, BCM2835_SPI0_BASE,  0x18,   MAP_FAILED, 0, 0 }, /* BCM2835_REGBASE_SPI0 */
+    { &bcm2835_bsc0, BCM2835_BSC0_BASE,  0x20,   MAP_FAILED, 0, 0 }, /* BCM2835_REGBASE_BSC0 */
+    { &bcm2835_bsc1, BCM2835_BSC1_BASE,  0x20,   MAP_FAILED, 0, 0 }, /* BCM2835_REGBASE_BSC1 */
+    { &bcm2835_aux,  BCM2835_AUX_BASE,   0x80,   MAP_FAILED, 0, 0 }, /* BCM2835_REGBASE_AUX */
+    { &bcm2835_spi1, BCM2835_SPI1_BASE,  0x40,   MAP_FAILED, 0, 0 }, /* BCM2835_REGBASE_SPI1 */
+    { &bcm2835_dma,  BCM2835_DMA_BASE,   0x1000, MAP_FAILED, 0, 0 }  /* BCM2835_REGBASE_DMA */
+};
+
+/* /dev/mem, opened when the first block other than GPIO is mapped */
+static int bcm2835_memfd = -1;
+static pthread_mutex_t bcm2835_map_lock = PTHREAD_MUTEX_INITIALIZER;
+static bcm2835_map_stats_t bcm2835_map_stats;
 
 
-/* This variable allows us to test on hardware other than RPi.
-// It prevents access to the kernel memory, and does not do any peripheral access
-// Instead it prints out what it _would_ do if debug were 0
- */
-static uint8_t debug = 0;
 
 /* RPI 4 has different pullup registers - we need to know if we have that type */
 
@@ -78,14 +108,13 @@ static uint8_t pud_type_rpi4 = 0;
 
 static uint8_t pud_compat_setting = BCM2835_GPIO_PUD_OFF;
 
-/* I2C The time needed to transmit one byte. In microseconds.
- */
-static int i2c_byte_wait_us = 0;
-
 /* SPI bit order. BCM2835 SPI0 only supports MSBFIRST, so we instead 
  * have a software based bit reversal, based on a contribution by Damiano Benedetti
  */
 static uint8_t bcm2835_spi_bit_order = BCM2835_SPI_BIT_ORDER_MSBFIRST;
+
+/* Chip select last set with bcm2835_spi_chipSelect(), for the bus trace */
+static uint8_t bcm2835_spi_cs = BCM2835_SPI_CS0;
 static uint8_t bcm2835_byte_reverse_table[] = 
 {
     0x00, 0x80, 0x40, 0xc0, 0x20, 0xa0, 0x60, 0xe0,
@@ -130,6 +159,15 @@ static uint8_t bcm2835_correct_order(uint8_t b)
 	return b;
 }
 
+/* The table to apply to every byte for the current bit order, NULL if none */
+static const uint8_t *bcm2835_spi_reverse_table(void)
+{
+    if (bcm2835_spi_bit_order == BCM2835_SPI_BIT_ORDER_LSBFIRST)
+	return bcm2835_byte_reverse_table;
+    else
+	return NULL;
+}
+
 #ifdef BCM2835_HAVE_LIBCAP
 #include <sys/capability.h>
 static int bcm2835_has_capability(cap_value_t capability)
@@ -151,122 +189,33 @@ static int bcm2835_has_capability(cap_value_t capability)
 // Low level register access functions
 */
 
-/* Function to return the pointers to the hardware register bases */
+/* Function to return the pointers to the hardware register bases,
+// mapping the block on first use
+*/
 uint32_t* bcm2835_regbase(uint8_t regbase)
 {
-    switch (regbase)
-    {
-	case BCM2835_REGBASE_ST:
-	    return (uint32_t *)bcm2835_st;
-	case BCM2835_REGBASE_GPIO:
-	    return (uint32_t *)bcm2835_gpio;
-	case BCM2835_REGBASE_PWM:
-	    return (uint32_t *)bcm2835_pwm;
-	case BCM2835_REGBASE_CLK:
-	    return (uint32_t *)bcm2835_clk;
-	case BCM2835_REGBASE_PADS:
-	    return (uint32_t *)bcm2835_pads;
-	case BCM2835_REGBASE_SPI0:
-	    return (uint32_t *)bcm2835_spi0;
-	case BCM2835_REGBASE_BSC0:
-	    return (uint32_t *)bcm2835_bsc0;
-	case BCM2835_REGBASE_BSC1:
-	    return (uint32_t *)bcm2835_st;
-	case BCM2835_REGBASE_AUX:
-	    return (uint32_t *)bcm2835_aux;
-	case BCM2835_REGBASE_SPI1:
-	    return (uint32_t *)bcm2835_spi1;
-
-    }
-    return (uint32_t *)MAP_FAILED;
-}
-
-void  bcm2835_set_debug(uint8_t d)
-{
-    debug = d;
-}
-
-unsigned int bcm2835_version(void) 
-{
-    return BCM2835_VERSION;
-}
-
-/* Read with memory barriers from peripheral
- *
- */
-uint32_t bcm2835_peri_read(volatile uint32_t* paddr)
-{
-    uint32_t ret;
-    if (debug)
-    {
-		return 0;
-    }
-    else
-    {
-       __sync_synchronize();
-       ret = *paddr;
-       __sync_synchronize();
-       return ret;
-    }
-}
+    if (!BCM2835_LIB_MapRegion(regbase))
+	return (uint32_t *)MAP_FAILED;
 
-/* read from peripheral without the read barrier
- * This can only be used if more reads to THE SAME peripheral
- * will follow.  The sequence must terminate with memory barrier
- * before any read or write to another peripheral can occur.
- * The MB can be explicit, or one of the barrier read/write calls.
- */
-uint32_t bcm2835_peri_read_nb(volatile uint32_t* paddr)
-{
-    if (debug)
-    {
-	return 0;
-    }
-    else
-    {
-	return *paddr;
-    }
+    return (uint32_t *)*bcm2835_regions[regbase].base;
 }
 
-/* Write with memory barriers to peripheral
- */
-
-void bcm2835_peri_write(volatile uint32_t* paddr, uint32_t value)
+/* Debug mode is fixed at build time by BCM2835_SIMULATION, see bcm2835_lib.h */
+void  bcm2835_set_debug(uint8_t d)
 {
-    if (debug)
+    if ((d != 0) != BCM2835_DEBUG)
     {
-
-    }
-    else
-    {
-        __sync_synchronize();
-        *paddr = value;
-        __sync_synchronize();
+	fprintf(stderr, "bcm2835_set_debug: debug=%u ignored, library built %s BCM2835_SIMULATION\n",
+		(unsigned)d, BCM2835_DEBUG ? "with" : "without");
     }
 }
 
-/* write to peripheral without the write barrier */
-void bcm2835_peri_write_nb(volatile uint32_t* paddr, uint32_t value)
+unsigned int bcm2835_version(void) 
 {
-    if (debug)
-    {
-
-    }
-    else
-    {
-	*paddr = value;
-    }
+    return BCM2835_VERSION;
 }
 
-/* Set/clear only the bits in value covered by the mask
- * This is not atomic - can be interrupted.
- */
-void bcm2835_peri_set_bits(volatile uint32_t* paddr, uint32_t value, uint32_t mask)
-{
-    uint32_t v = bcm2835_peri_read(paddr);
-    v = (v & ~mask) | (value & mask);
-    bcm2835_peri_write(paddr, v);
-}
+/* The peripheral register accessors are static inline in bcm2835_lib.h */
 
 /*
 // Low level convenience functions
@@ -502,7 +451,7 @@ void bcm2835_gpio_pudclk(uint8_t pin, uint8_t on)
 /* Read GPIO pad behaviour for groups of GPIOs */
 uint32_t bcm2835_gpio_pad(uint8_t group)
 {
-  if (bcm2835_pads == MAP_FAILED){
+  if (!BCM2835_LIB_MapRegion(BCM2835_REGBASE_PADS)){
     return 0;
   }
   
@@ -516,7 +465,7 @@ uint32_t bcm2835_gpio_pad(uint8_t group)
 */
 void bcm2835_gpio_set_pad(uint8_t group, uint32_t control)
 {
-  if (bcm2835_pads == MAP_FAILED){
+  if (!BCM2835_LIB_MapRegion(BCM2835_REGBASE_PADS)){
     return;
   }
   
@@ -542,7 +491,7 @@ void bcm2835_delayMicroseconds(uint64_t micros)
     struct timespec t1;
     uint64_t        start;
 	
-    if (debug)
+    if (BCM2835_DEBUG)
     {
 	/* Cant access sytem timers in debug mode */
 	return;
@@ -694,7 +643,7 @@ int bcm2835_spi_begin(void)
 {
     volatile uint32_t* paddr;
 
-    if (bcm2835_spi0 == MAP_FAILED)
+    if (!BCM2835_LIB_MapRegion(BCM2835_REGBASE_SPI0))
       return 0; /* bcm2835_init() failed, or not root */
     
     /* Set the SPI0 pins to the Alt 0 function to enable SPI0 access on them */
@@ -716,6 +665,8 @@ int bcm2835_spi_begin(void)
 
 void bcm2835_spi_end(void)
 {  
+    bcm2835_spi_dma_end();
+
     /* Set all the SPI0 pins back to input */
     bcm2835_gpio_fsel(RPI_GPIO_P1_26, BCM2835_GPIO_FSEL_INPT); /* CE1 */
     bcm2835_gpio_fsel(RPI_GPIO_P1_24, BCM2835_GPIO_FSEL_INPT); /* CE0 */
@@ -766,13 +717,14 @@ uint8_t bcm2835_spi_transfer(uint8_t value)
     // accesses a different peripheral? 
     // Clear TX and RX fifos
     */
-    bcm2835_peri_set_bits(paddr, BCM2835_SPI0_CS_CLEAR, BCM2835_SPI0_CS_CLEAR);
+    bcm2835_memory_barrier();
+    bcm2835_peri_set_bits_nb(paddr, BCM2835_SPI0_CS_CLEAR, BCM2835_SPI0_CS_CLEAR);
 
     /* Set TA = 1 */
-    bcm2835_peri_set_bits(paddr, BCM2835_SPI0_CS_TA, BCM2835_SPI0_CS_TA);
+    bcm2835_peri_set_bits_nb(paddr, BCM2835_SPI0_CS_TA, BCM2835_SPI0_CS_TA);
 
     /* Maybe wait for TXD */
-    while (!(bcm2835_peri_read(paddr) & BCM2835_SPI0_CS_TXD))
+    while (!(bcm2835_peri_read_nb(paddr) & BCM2835_SPI0_CS_TXD))
 	;
 
     /* Write to FIFO, no barrier */
@@ -785,96 +737,185 @@ uint8_t bcm2835_spi_transfer(uint8_t value)
     /* Read any byte that was sent back by the slave while we sere sending to it */
     ret = bcm2835_correct_order(bcm2835_peri_read_nb(fifo));
 
-    /* Set TA = 0, and also set the barrier */
-    bcm2835_peri_set_bits(paddr, 0, BCM2835_SPI0_CS_TA);
+    /* Set TA = 0 */
+    bcm2835_peri_set_bits_nb(paddr, 0, BCM2835_SPI0_CS_TA);
+    bcm2835_memory_barrier();
 
     return ret;
 }
 
-/* Writes (and reads) an number of bytes to SPI */
-void bcm2835_spi_transfernb(char* tbuf, char* rbuf, uint32_t len)
+/* Polled transfer of a chain of segments as per section 10.6.1, under one TA.
+// Inlined with reverse either NULL or the table, so the MSB first loop has no
+// per byte translation at all.
+*/
+static inline void bcm2835_spi_fifo_segments(const bcm2835_spi_seg_t *segs, uint32_t count, const uint8_t *reverse)
 {
     volatile uint32_t* paddr = bcm2835_spi0 + BCM2835_SPI0_CS/4;
     volatile uint32_t* fifo = bcm2835_spi0 + BCM2835_SPI0_FIFO/4;
-    uint32_t TXCnt=0;
-    uint32_t RXCnt=0;
+    uint32_t TXSeg = 0, TXCnt = 0;
+    uint32_t RXSeg = 0, RXCnt = 0;
+    uint8_t b;
 
-    /* This is Polled transfer as per section 10.6.1
-    // BUG ALERT: what happens if we get interupted in this section, and someone else
+    /* Skip empty segments up front, the loops below only step over full ones */
+    while (TXSeg < count && segs[TXSeg].len == 0)
+	TXSeg++;
+    RXSeg = TXSeg;
+
+    /* BUG ALERT: what happens if we get interupted in this section, and someone else
     // accesses a different peripheral? 
     */
 
     /* Clear TX and RX fifos */
-    bcm2835_peri_set_bits(paddr, BCM2835_SPI0_CS_CLEAR, BCM2835_SPI0_CS_CLEAR);
+    bcm2835_memory_barrier();
+    bcm2835_peri_set_bits_nb(paddr, BCM2835_SPI0_CS_CLEAR, BCM2835_SPI0_CS_CLEAR);
 
     /* Set TA = 1 */
-    bcm2835_peri_set_bits(paddr, BCM2835_SPI0_CS_TA, BCM2835_SPI0_CS_TA);
+    bcm2835_peri_set_bits_nb(paddr, BCM2835_SPI0_CS_TA, BCM2835_SPI0_CS_TA);
 
     /* Use the FIFO's to reduce the interbyte times */
-    while((TXCnt < len)||(RXCnt < len))
+    while ((TXSeg < count) || (RXSeg < count))
     {
         /* TX fifo not full, so add some more bytes */
-        while(((bcm2835_peri_read(paddr) & BCM2835_SPI0_CS_TXD))&&(TXCnt < len ))
+        while ((TXSeg < count) && (bcm2835_peri_read_nb(paddr) & BCM2835_SPI0_CS_TXD))
         {
-	    bcm2835_peri_write_nb(fifo, bcm2835_correct_order(tbuf[TXCnt]));
-	    TXCnt++;
+	    b = segs[TXSeg].tx ? (uint8_t)segs[TXSeg].tx[TXCnt] : 0;
+	    bcm2835_peri_write_nb(fifo, reverse ? reverse[b] : b);
+	    if (++TXCnt == segs[TXSeg].len)
+	    {
+		TXCnt = 0;
+		do TXSeg++; while (TXSeg < count && segs[TXSeg].len == 0);
+	    }
         }
         /* Rx fifo not empty, so get the next received bytes */
-        while(((bcm2835_peri_read(paddr) & BCM2835_SPI0_CS_RXD))&&( RXCnt < len ))
+        while ((RXSeg < count) && (bcm2835_peri_read_nb(paddr) & BCM2835_SPI0_CS_RXD))
         {
-	    rbuf[RXCnt] = bcm2835_correct_order(bcm2835_peri_read_nb(fifo));
-	    RXCnt++;
+	    b = bcm2835_peri_read_nb(fifo);
+	    if (segs[RXSeg].rx)
+		segs[RXSeg].rx[RXCnt] = reverse ? reverse[b] : b;
+	    if (++RXCnt == segs[RXSeg].len)
+	    {
+		RXCnt = 0;
+		do RXSeg++; while (RXSeg < count && segs[RXSeg].len == 0);
+	    }
         }
     }
     /* Wait for DONE to be set */
     while (!(bcm2835_peri_read_nb(paddr) & BCM2835_SPI0_CS_DONE))
 	;
 
-    /* Set TA = 0, and also set the barrier */
-    bcm2835_peri_set_bits(paddr, 0, BCM2835_SPI0_CS_TA);
+    /* Set TA = 0 */
+    bcm2835_peri_set_bits_nb(paddr, 0, BCM2835_SPI0_CS_TA);
+    bcm2835_memory_barrier();
 }
 
-/* Writes an number of bytes to SPI */
-void bcm2835_spi_writenb(const char* tbuf, uint32_t len)
+/* First bytes sent and received by a segmented transfer, for the bus trace.
+// Returns the total length, has_rx is set if any segment receives.
+*/
+static uint32_t bcm2835_spi_trace_head(const bcm2835_spi_seg_t *segs, uint32_t count,
+				       uint8_t *tx, uint8_t *rx, uint8_t *has_rx)
 {
-    volatile uint32_t* paddr = bcm2835_spi0 + BCM2835_SPI0_CS/4;
-    volatile uint32_t* fifo = bcm2835_spi0 + BCM2835_SPI0_FIFO/4;
-    uint32_t i;
+    uint32_t len = 0;
+    uint32_t i, j;
 
-    /* This is Polled transfer as per section 10.6.1
-    // BUG ALERT: what happens if we get interupted in this section, and someone else
-    // accesses a different peripheral?
-    // Answer: an ISR is required to issue the required memory barriers.
-    */
+    memset(tx, 0, BCM2835_TRACE_DATA);
+    memset(rx, 0, BCM2835_TRACE_DATA);
+    *has_rx = 0;
 
-    /* Clear TX and RX fifos */
-    bcm2835_peri_set_bits(paddr, BCM2835_SPI0_CS_CLEAR, BCM2835_SPI0_CS_CLEAR);
+    for (i = 0; i < count; i++)
+    {
+	for (j = 0; j < segs[i].len && len + j < BCM2835_TRACE_DATA; j++)
+	{
+	    if (segs[i].tx)
+		tx[len + j] = segs[i].tx[j];
+	    if (segs[i].rx)
+		rx[len + j] = segs[i].rx[j];
+	}
+	if (segs[i].rx)
+	    *has_rx = 1;
+	len += segs[i].len;
+    }
 
-    /* Set TA = 1 */
-    bcm2835_peri_set_bits(paddr, BCM2835_SPI0_CS_TA, BCM2835_SPI0_CS_TA);
+    return len;
+}
+
+static void bcm2835_spi_trace_segments(uint8_t kind, uint8_t cs, const bcm2835_spi_seg_t *segs, uint32_t count,
+				       uint32 trace_start)
+{
+    uint8_t tx[BCM2835_TRACE_DATA];
+    uint8_t rx[BCM2835_TRACE_DATA];
+    uint8_t has_rx;
+    uint32_t len = bcm2835_spi_trace_head(segs, count, tx, rx, &has_rx);
+    uint32_t n = MIN(len, BCM2835_TRACE_DATA);
 
-    for (i = 0; i < len; i++)
+    BCM2835_TRACE_Record(kind, 0, cs, len, tx, n, rx, has_rx ? n : 0, trace_start, 0);
+}
+
+/* Simulated transfer: the received bytes come from the replayed trace */
+static void bcm2835_spi_replay_segments(uint8_t kind, uint8_t cs, const bcm2835_spi_seg_t *segs, uint32_t count)
+{
+    uint8_t tx[BCM2835_TRACE_DATA];
+    uint8_t rx[BCM2835_TRACE_DATA];
+    uint8_t has_rx;
+    uint32_t len = bcm2835_spi_trace_head(segs, count, tx, rx, &has_rx);
+    uint32_t n = MIN(len, BCM2835_TRACE_DATA);
+    uint32_t pos = 0;
+    uint32_t i, j;
+
+    BCM2835_TRACE_Replay(kind, 0, cs, len, tx, n, rx, has_rx ? n : 0);
+
+    for (i = 0; i < count; i++)
     {
-	/* Maybe wait for TXD */
-	while (!(bcm2835_peri_read(paddr) & BCM2835_SPI0_CS_TXD))
-	    ;
-	
-	/* Write to FIFO, no barrier */
-	bcm2835_peri_write_nb(fifo, bcm2835_correct_order(tbuf[i]));
-	
-	/* Read from FIFO to prevent stalling */
-	while (bcm2835_peri_read(paddr) & BCM2835_SPI0_CS_RXD)
-	    (void) bcm2835_peri_read_nb(fifo);
+	for (j = 0; segs[i].rx && j < segs[i].len; j++)
+	    segs[i].rx[j] = (pos + j < n) ? rx[pos + j] : 0;
+	pos += segs[i].len;
     }
-    
-    /* Wait for DONE to be set */
-    while (!(bcm2835_peri_read_nb(paddr) & BCM2835_SPI0_CS_DONE)) {
-	while (bcm2835_peri_read(paddr) & BCM2835_SPI0_CS_RXD)
-		(void) bcm2835_peri_read_nb(fifo);
-    };
+}
 
-    /* Set TA = 0, and also set the barrier */
-    bcm2835_peri_set_bits(paddr, 0, BCM2835_SPI0_CS_TA);
+void bcm2835_spi_transfer_segments(const bcm2835_spi_seg_t *segs, uint32_t count)
+{
+    const uint8_t *reverse = bcm2835_spi_reverse_table();
+    uint32 trace_start;
+
+    if (BCM2835_DEBUG)
+    {
+	bcm2835_spi_replay_segments(BCM2835_TRACE_SPI0, bcm2835_spi_cs, segs, count);
+	return;
+    }
+
+    trace_start = BCM2835_TRACE_Now();
+
+    /* Long transactions go through the DMA engine when it is enabled */
+    if (!BCM2835_SPI_DmaTransfer(segs, count, reverse))
+    {
+	if (reverse)
+	    bcm2835_spi_fifo_segments(segs, count, bcm2835_byte_reverse_table);
+	else
+	    bcm2835_spi_fifo_segments(segs, count, NULL);
+    }
+
+    bcm2835_spi_trace_segments(BCM2835_TRACE_SPI0, bcm2835_spi_cs, segs, count, trace_start);
+}
+
+/* Writes (and reads) an number of bytes to SPI */
+void bcm2835_spi_transfernb(char* tbuf, char* rbuf, uint32_t len)
+{
+    bcm2835_spi_seg_t seg;
+
+    seg.tx  = tbuf;
+    seg.rx  = rbuf;
+    seg.len = len;
+    bcm2835_spi_transfer_segments(&seg, 1);
+}
+
+/* Writes an number of bytes to SPI, the received bytes are discarded */
+void bcm2835_spi_writenb(const char* tbuf, uint32_t len)
+{
+    bcm2835_spi_seg_t seg;
+
+    seg.tx  = tbuf;
+    seg.rx  = NULL;
+    seg.len = len;
+    bcm2835_spi_transfer_segments(&seg, 1);
 }
 
 /* Writes (and reads) an number of bytes to SPI
@@ -890,6 +931,7 @@ void bcm2835_spi_chipSelect(uint8_t cs)
     volatile uint32_t* paddr = bcm2835_spi0 + BCM2835_SPI0_CS/4;
     /* Mask in the CS bits of CS */
     bcm2835_peri_set_bits(paddr, cs, BCM2835_SPI0_CS_CS);
+    bcm2835_spi_cs = cs;
 }
 
 void bcm2835_spi_setChipSelectPolarity(uint8_t cs, uint8_t active)
@@ -939,13 +981,17 @@ void bcm2835_spi_write(uint16_t data)
 
 int bcm2835_aux_spi_begin(void)
 {
-    volatile uint32_t* enable = bcm2835_aux + BCM2835_AUX_ENABLE/4;
-    volatile uint32_t* cntl0 = bcm2835_spi1 + BCM2835_AUX_SPI_CNTL0/4;
-    volatile uint32_t* cntl1 = bcm2835_spi1 + BCM2835_AUX_SPI_CNTL1/4;
+    volatile uint32_t* enable;
+    volatile uint32_t* cntl0;
+    volatile uint32_t* cntl1;
 
-    if (bcm2835_spi1 == MAP_FAILED)
+    if (!BCM2835_LIB_MapRegion(BCM2835_REGBASE_AUX) || !BCM2835_LIB_MapRegion(BCM2835_REGBASE_SPI1))
 	return 0; /* bcm2835_init() failed, or not root */
 
+    enable = bcm2835_aux + BCM2835_AUX_ENABLE/4;
+    cntl0 = bcm2835_spi1 + BCM2835_AUX_SPI_CNTL0/4;
+    cntl1 = bcm2835_spi1 + BCM2835_AUX_SPI_CNTL1/4;
+
     /* Set the SPI pins to the Alt 4 function to enable SPI1 access on them */
     bcm2835_gpio_fsel(RPI_V2_GPIO_P1_36, BCM2835_GPIO_FSEL_ALT4);	/* SPI1_CE2_N */
     bcm2835_gpio_fsel(RPI_V2_GPIO_P1_35, BCM2835_GPIO_FSEL_ALT4);	/* SPI1_MISO */
@@ -1072,21 +1118,66 @@ void bcm2835_aux_spi_writenb(const char *tbuf, uint32_t len) {
     }
 }
 
-void bcm2835_aux_spi_transfernb(const char *tbuf, char *rbuf, uint32_t len) {
+/* Cursor over a chain of SPI segments, for the AUX SPI which packs bytes in words */
+typedef struct
+{
+    const bcm2835_spi_seg_t *segs;
+    uint32_t count;
+    uint32_t seg;
+    uint32_t pos;
+} bcm2835_spi_cursor_t;
+
+static void bcm2835_spi_cursor_init(bcm2835_spi_cursor_t *c, const bcm2835_spi_seg_t *segs, uint32_t count)
+{
+    c->segs = segs;
+    c->count = count;
+    c->seg = 0;
+    c->pos = 0;
+    while (c->seg < c->count && c->segs[c->seg].len == 0)
+	c->seg++;
+}
+
+static void bcm2835_spi_cursor_step(bcm2835_spi_cursor_t *c)
+{
+    if (++c->pos == c->segs[c->seg].len) {
+	c->pos = 0;
+	do c->seg++; while (c->seg < c->count && c->segs[c->seg].len == 0);
+    }
+}
+
+static uint8_t bcm2835_spi_cursor_get(bcm2835_spi_cursor_t *c)
+{
+    const char *tx = c->segs[c->seg].tx;
+    uint8_t byte = (tx != NULL) ? (uint8_t) tx[c->pos] : (uint8_t) 0;
+
+    bcm2835_spi_cursor_step(c);
+    return byte;
+}
+
+static void bcm2835_spi_cursor_put(bcm2835_spi_cursor_t *c, uint8_t byte)
+{
+    char *rx = c->segs[c->seg].rx;
+
+    if (rx != NULL)
+	rx[c->pos] = (char) byte;
+    bcm2835_spi_cursor_step(c);
+}
+
+void bcm2835_aux_spi_transfer_segments(const bcm2835_spi_seg_t *segs, uint32_t count) {
     volatile uint32_t* cntl0 = bcm2835_spi1 + BCM2835_AUX_SPI_CNTL0/4;
     volatile uint32_t* cntl1 = bcm2835_spi1 + BCM2835_AUX_SPI_CNTL1/4;
     volatile uint32_t* stat = bcm2835_spi1 + BCM2835_AUX_SPI_STAT/4;
     volatile uint32_t* txhold = bcm2835_spi1 + BCM2835_AUX_SPI_TXHOLD/4;
     volatile uint32_t* io = bcm2835_spi1 + BCM2835_AUX_SPI_IO/4;
 
-	char *tx = (char *)tbuf;
-	char *rx = (char *)rbuf;
-	uint32_t tx_len = len;
-	uint32_t rx_len = len;
-	uint32_t count;
+	bcm2835_spi_cursor_t tx;
+	bcm2835_spi_cursor_t rx;
+	uint32_t tx_len = 0;
+	uint32_t rx_len;
+	uint32_t n;
 	uint32_t data;
 	uint32_t i;
-	uint8_t byte;
+	uint32 trace_start;
 
 	uint32_t _cntl0 = (spi1_speed << BCM2835_AUX_SPI_CNTL0_SPEED_SHIFT);
 	_cntl0 |= BCM2835_AUX_SPI_CNTL0_CS2_N;
@@ -1094,23 +1185,38 @@ void bcm2835_aux_spi_transfernb(const char *tbuf, char *rbuf, uint32_t len) {
 	_cntl0 |= BCM2835_AUX_SPI_CNTL0_MSBF_OUT;
 	_cntl0 |= BCM2835_AUX_SPI_CNTL0_VAR_WIDTH;
 
+	/* AUX SPI transfers always use CE2 */
+	if (BCM2835_DEBUG) {
+		bcm2835_spi_replay_segments(BCM2835_TRACE_AUX_SPI, BCM2835_SPI_CS2, segs, count);
+		return;
+	}
+
+	trace_start = BCM2835_TRACE_Now();
+
+	for (i = 0; i < count; i++)
+		tx_len += segs[i].len;
+	rx_len = tx_len;
+
+	bcm2835_spi_cursor_init(&tx, segs, count);
+	bcm2835_spi_cursor_init(&rx, segs, count);
+
 	bcm2835_peri_write(cntl0, _cntl0);
 	bcm2835_peri_write(cntl1, BCM2835_AUX_SPI_CNTL1_MSBF_IN);
 
 	while ((tx_len > 0) || (rx_len > 0)) {
 
 		while (!(bcm2835_peri_read(stat) & BCM2835_AUX_SPI_STAT_TX_FULL) && (tx_len > 0)) {
-			count = MIN(tx_len, 3);
+			n = MIN(tx_len, 3);
 			data = 0;
 
-			for (i = 0; i < count; i++) {
-				byte = (tx != NULL) ? (uint8_t) *tx++ : (uint8_t) 0;
-				data |= byte << (8 * (2 - i));
+			for (i = 0; i < n; i++) {
+				data |= bcm2835_spi_cursor_get(&tx) << (8 * (2 - i));
 			}
 
-			data |= (count * 8) << 24;
-			tx_len -= count;
+			data |= (n * 8) << 24;
+			tx_len -= n;
 
+			/* TXHOLD keeps CE2 asserted after this word */
 			if (tx_len != 0) {
 				bcm2835_peri_write(txhold, data);
 			} else {
@@ -1120,49 +1226,38 @@ void bcm2835_aux_spi_transfernb(const char *tbuf, char *rbuf, uint32_t len) {
 		}
 
 		while (!(bcm2835_peri_read(stat) & BCM2835_AUX_SPI_STAT_RX_EMPTY) && (rx_len > 0)) {
-			count = MIN(rx_len, 3);
+			n = MIN(rx_len, 3);
 			data = bcm2835_peri_read(io);
 
-			if (rbuf != NULL) {
-				switch (count) {
-				case 3:
-					*rx++ = (char)((data >> 16) & 0xFF);
-					/*@fallthrough@*/
-					/* no break */
-				case 2:
-					*rx++ = (char)((data >> 8) & 0xFF);
-					/*@fallthrough@*/
-					/* no break */
-				case 1:
-					*rx++ = (char)((data >> 0) & 0xFF);
-				}
+			for (i = n; i > 0; i--) {
+				bcm2835_spi_cursor_put(&rx, (uint8_t)((data >> (8 * (i - 1))) & 0xFF));
 			}
 
-			rx_len -= count;
+			rx_len -= n;
 		}
 
 		while (!(bcm2835_peri_read(stat) & BCM2835_AUX_SPI_STAT_BUSY) && (rx_len > 0)) {
-			count = MIN(rx_len, 3);
+			n = MIN(rx_len, 3);
 			data = bcm2835_peri_read(io);
 
-			if (rbuf != NULL) {
-				switch (count) {
-				case 3:
-					*rx++ = (char)((data >> 16) & 0xFF);
-					/*@fallthrough@*/
-					/* no break */
-				case 2:
-					*rx++ = (char)((data >> 8) & 0xFF);
-					/*@fallthrough@*/
-					/* no break */
-				case 1:
-					*rx++ = (char)((data >> 0) & 0xFF);
-				}
+			for (i = n; i > 0; i--) {
+				bcm2835_spi_cursor_put(&rx, (uint8_t)((data >> (8 * (i - 1))) & 0xFF));
 			}
 
-			rx_len -= count;
+			rx_len -= n;
 		}
 	}
+
+	bcm2835_spi_trace_segments(BCM2835_TRACE_AUX_SPI, BCM2835_SPI_CS2, segs, count, trace_start);
+}
+
+void bcm2835_aux_spi_transfernb(const char *tbuf, char *rbuf, uint32_t len) {
+	bcm2835_spi_seg_t seg;
+
+	seg.tx  = tbuf;
+	seg.rx  = rbuf;
+	seg.len = len;
+	bcm2835_aux_spi_transfer_segments(&seg, 1);
 }
 
 void bcm2835_aux_spi_transfern(char *buf, uint32_t len) {
@@ -1204,114 +1299,181 @@ uint8_t bcm2835_aux_spi_transfer(uint8_t value)
 }
 
 
-int bcm2835_i2c_begin(void)
+/* Per-controller state of the BSC (I2C) masters.
+// Each controller keeps its own clock divider derived byte time, so two buses
+// can run at different baud rates and be used from different tasks at the same time.
+*/
+typedef struct
+{
+    volatile uint32_t **base;   /* Address of the mapped register base pointer */
+    uint8_t regbase;            /* Its bcm2835RegisterBase, to map it on first use */
+    uint8_t sda;                /* GPIO used as SDA (Alt 0) */
+    uint8_t scl;                /* GPIO used as SCL (Alt 0) */
+    int byte_wait_us;           /* Time for transmitting one byte at the current divider */
+    int32_t address;            /* Last slave address written, -1 if unknown */
+    int32_t divider;            /* Last clock divider written, -1 if unknown */
+    int32_t clkt;               /* Last clock stretch timeout written, -1 if unknown */
+} bcm2835_i2c_bus_t;
+
+static bcm2835_i2c_bus_t bcm2835_i2c_buses[BCM2835_I2C_BUS_COUNT] =
+{
+    { &bcm2835_bsc0, BCM2835_REGBASE_BSC0, RPI_GPIO_P1_03,    RPI_GPIO_P1_05,    0, -1, -1, -1 }, /* BSC0 */
+    { &bcm2835_bsc1, BCM2835_REGBASE_BSC1, RPI_V2_GPIO_P1_03, RPI_V2_GPIO_P1_05, 0, -1, -1, -1 }  /* BSC1 */
+};
+
+/* Register address of a controller */
+#define BCM2835_I2C_REG(b, reg) (*(b)->base + (reg)/4)
+
+/* Bus used by the functions without a bus argument */
+uint8_t bcm2835_i2c_default_bus(void)
+{
+#ifdef I2C_V1
+    return BCM2835_I2C_BUS_BSC0;
+#else
+    return BCM2835_I2C_BUS_BSC1;
+#endif
+}
+
+int bcm2835_i2c_bus_begin(uint8_t bus)
 {
+    bcm2835_i2c_bus_t *b;
     uint16_t cdiv;
 
-    if (   bcm2835_bsc0 == MAP_FAILED
-	|| bcm2835_bsc1 == MAP_FAILED)
+    if (bus >= BCM2835_I2C_BUS_COUNT)
+      return 0;
+
+    b = &bcm2835_i2c_buses[bus];
+
+    if (!BCM2835_LIB_MapRegion(b->regbase))
       return 0; /* bcm2835_init() failed, or not root */
 
-#ifdef I2C_V1
-    volatile uint32_t* paddr = bcm2835_bsc0 + BCM2835_BSC_DIV/4;
-    /* Set the I2C/BSC0 pins to the Alt 0 function to enable I2C access on them */
-    bcm2835_gpio_fsel(RPI_GPIO_P1_03, BCM2835_GPIO_FSEL_ALT0); /* SDA */
-    bcm2835_gpio_fsel(RPI_GPIO_P1_05, BCM2835_GPIO_FSEL_ALT0); /* SCL */
-#else
-    volatile uint32_t* paddr = bcm2835_bsc1 + BCM2835_BSC_DIV/4;
-    /* Set the I2C/BSC1 pins to the Alt 0 function to enable I2C access on them */
-    bcm2835_gpio_fsel(RPI_V2_GPIO_P1_03, BCM2835_GPIO_FSEL_ALT0); /* SDA */
-    bcm2835_gpio_fsel(RPI_V2_GPIO_P1_05, BCM2835_GPIO_FSEL_ALT0); /* SCL */
-#endif    
+    /* Set the I2C/BSC pins to the Alt 0 function to enable I2C access on them */
+    bcm2835_gpio_fsel(b->sda, BCM2835_GPIO_FSEL_ALT0); /* SDA */
+    bcm2835_gpio_fsel(b->scl, BCM2835_GPIO_FSEL_ALT0); /* SCL */
 
     /* Read the clock divider register */
-    cdiv = bcm2835_peri_read(paddr);
+    cdiv = bcm2835_peri_read(BCM2835_I2C_REG(b, BCM2835_BSC_DIV));
     /* Calculate time for transmitting one byte
     // 1000000 = micros seconds in a second
     // 9 = Clocks per byte : 8 bits + ACK
     */
-    i2c_byte_wait_us = ((float)cdiv / BCM2835_CORE_CLK_HZ) * 1000000 * 9;
+    b->byte_wait_us = ((float)cdiv / BCM2835_CORE_CLK_HZ) * 1000000 * 9;
+
+    /* Start with what the hardware holds, the address and timeout are written on first use */
+    b->divider = cdiv;
+    b->address = -1;
+    b->clkt    = -1;
 
     return 1;
 }
 
-void bcm2835_i2c_end(void)
+void bcm2835_i2c_bus_end(uint8_t bus)
 {
-#ifdef I2C_V1
-    /* Set all the I2C/BSC0 pins back to input */
-    bcm2835_gpio_fsel(RPI_GPIO_P1_03, BCM2835_GPIO_FSEL_INPT); /* SDA */
-    bcm2835_gpio_fsel(RPI_GPIO_P1_05, BCM2835_GPIO_FSEL_INPT); /* SCL */
-#else
-    /* Set all the I2C/BSC1 pins back to input */
-    bcm2835_gpio_fsel(RPI_V2_GPIO_P1_03, BCM2835_GPIO_FSEL_INPT); /* SDA */
-    bcm2835_gpio_fsel(RPI_V2_GPIO_P1_05, BCM2835_GPIO_FSEL_INPT); /* SCL */
-#endif
+    if (bus >= BCM2835_I2C_BUS_COUNT)
+      return;
+
+    /* Set all the I2C/BSC pins back to input */
+    bcm2835_gpio_fsel(bcm2835_i2c_buses[bus].sda, BCM2835_GPIO_FSEL_INPT); /* SDA */
+    bcm2835_gpio_fsel(bcm2835_i2c_buses[bus].scl, BCM2835_GPIO_FSEL_INPT); /* SCL */
 }
 
-void bcm2835_i2c_setSlaveAddress(uint8_t addr)
+void bcm2835_i2c_bus_setSlaveAddress(uint8_t bus, uint8_t addr)
 {
+    if (bus >= BCM2835_I2C_BUS_COUNT)
+      return;
+
     /* Set I2C Device Address */
-#ifdef I2C_V1
-    volatile uint32_t* paddr = bcm2835_bsc0 + BCM2835_BSC_A/4;
-#else	
-    volatile uint32_t* paddr = bcm2835_bsc1 + BCM2835_BSC_A/4;
-#endif
-    bcm2835_peri_write(paddr, addr);
+    bcm2835_peri_write(BCM2835_I2C_REG(&bcm2835_i2c_buses[bus], BCM2835_BSC_A), addr);
+    bcm2835_i2c_buses[bus].address = addr;
 }
 
 /* defaults to 0x5dc, should result in a 166.666 kHz I2C clock frequency.
 // The divisor must be a power of 2. Odd numbers
 // rounded down.
 */
-void bcm2835_i2c_setClockDivider(uint16_t divider)
+void bcm2835_i2c_bus_setClockDivider(uint8_t bus, uint16_t divider)
 {
-#ifdef I2C_V1
-    volatile uint32_t* paddr = bcm2835_bsc0 + BCM2835_BSC_DIV/4;
-#else
-    volatile uint32_t* paddr = bcm2835_bsc1 + BCM2835_BSC_DIV/4;
-#endif    
-    bcm2835_peri_write(paddr, divider);
+    bcm2835_i2c_bus_t *b;
+
+    if (bus >= BCM2835_I2C_BUS_COUNT)
+      return;
+
+    b = &bcm2835_i2c_buses[bus];
+    bcm2835_peri_write(BCM2835_I2C_REG(b, BCM2835_BSC_DIV), divider);
+    b->divider = divider;
     /* Calculate time for transmitting one byte
     // 1000000 = micros seconds in a second
     // 9 = Clocks per byte : 8 bits + ACK
     */
-    i2c_byte_wait_us = ((float)divider / BCM2835_CORE_CLK_HZ) * 1000000 * 9;
+    b->byte_wait_us = ((float)divider / BCM2835_CORE_CLK_HZ) * 1000000 * 9;
 }
 
 /* set I2C clock divider by means of a baudrate number */
-void bcm2835_i2c_set_baudrate(uint32_t baudrate)
+void bcm2835_i2c_bus_set_baudrate(uint8_t bus, uint32_t baudrate)
 {
 	uint32_t divider;
 	/* use 0xFFFE mask to limit a max value and round down any odd number */
 	divider = (BCM2835_CORE_CLK_HZ / baudrate) & 0xFFFE;
-	bcm2835_i2c_setClockDivider( (uint16_t)divider );
+	bcm2835_i2c_bus_setClockDivider(bus, (uint16_t)divider );
+}
+
+/* Wait for the write phase of a repeated start to complete and the first byte back.
+// Polls the status until data is in the FIFO, the slave NACKed or the clock stretch
+// timed out, instead of sleeping for the worst case. The spin is bounded to twice
+// the nominal time of the bytes still on the wire, after which the caller's DONE
+// loop takes over as before.
+*/
+static void bcm2835_i2c_wait_rs_read(bcm2835_i2c_bus_t *b, volatile uint32_t *status, uint32_t bytes)
+{
+    uint64 deadline_us = BCM2835_LIB_GetTimeUs() + 2 * (uint64)b->byte_wait_us * bytes + 1;
+
+    while (!(bcm2835_peri_read_nb(status) & (BCM2835_BSC_S_RXD | BCM2835_BSC_S_ERR | BCM2835_BSC_S_CLKT)))
+    {
+	if (BCM2835_LIB_GetTimeUs() > deadline_us)
+	    break;
+    }
 }
 
 /* Writes an number of bytes to I2C */
-uint8_t bcm2835_i2c_write(const char * buf, uint32_t len)
+uint8_t bcm2835_i2c_bus_write(uint8_t bus, const char * buf, uint32_t len)
 {
-#ifdef I2C_V1
-    volatile uint32_t* dlen    = bcm2835_bsc0 + BCM2835_BSC_DLEN/4;
-    volatile uint32_t* fifo    = bcm2835_bsc0 + BCM2835_BSC_FIFO/4;
-    volatile uint32_t* status  = bcm2835_bsc0 + BCM2835_BSC_S/4;
-    volatile uint32_t* control = bcm2835_bsc0 + BCM2835_BSC_C/4;
-#else
-    volatile uint32_t* dlen    = bcm2835_bsc1 + BCM2835_BSC_DLEN/4;
-    volatile uint32_t* fifo    = bcm2835_bsc1 + BCM2835_BSC_FIFO/4;
-    volatile uint32_t* status  = bcm2835_bsc1 + BCM2835_BSC_S/4;
-    volatile uint32_t* control = bcm2835_bsc1 + BCM2835_BSC_C/4;
-#endif    
+    volatile uint32_t* dlen;
+    volatile uint32_t* fifo;
+    volatile uint32_t* status;
+    volatile uint32_t* control;
 
     uint32_t remaining = len;
     uint32_t i = 0;
     uint8_t reason = BCM2835_I2C_REASON_OK;
+    uint8_t address;
+    uint32 trace_start;
+
+    if (bus >= BCM2835_I2C_BUS_COUNT)
+	return BCM2835_I2C_REASON_ERROR_BUS;
+
+    /* Simulated transactions are served from the replayed trace */
+    address = (uint8_t) bcm2835_i2c_buses[bus].address;
+    if (BCM2835_DEBUG)
+	return BCM2835_TRACE_Replay(BCM2835_TRACE_I2C_WRITE, bus, address, len, buf, len, NULL, 0);
+
+    trace_start = BCM2835_TRACE_Now();
+
+    dlen    = BCM2835_I2C_REG(&bcm2835_i2c_buses[bus], BCM2835_BSC_DLEN);
+    fifo    = BCM2835_I2C_REG(&bcm2835_i2c_buses[bus], BCM2835_BSC_FIFO);
+    status  = BCM2835_I2C_REG(&bcm2835_i2c_buses[bus], BCM2835_BSC_S);
+    control = BCM2835_I2C_REG(&bcm2835_i2c_buses[bus], BCM2835_BSC_C);
+
+    /* Only the BSC is accessed from here on, so the accesses need no barriers
+    // of their own: one on entry and one before returning is enough.
+    */
+    bcm2835_memory_barrier();
 
     /* Clear FIFO */
-    bcm2835_peri_set_bits(control, BCM2835_BSC_C_CLEAR_1 , BCM2835_BSC_C_CLEAR_1 );
+    bcm2835_peri_set_bits_nb(control, BCM2835_BSC_C_CLEAR_1 , BCM2835_BSC_C_CLEAR_1 );
     /* Clear Status */
-    bcm2835_peri_write(status, BCM2835_BSC_S_CLKT | BCM2835_BSC_S_ERR | BCM2835_BSC_S_DONE);
+    bcm2835_peri_write_nb(status, BCM2835_BSC_S_CLKT | BCM2835_BSC_S_ERR | BCM2835_BSC_S_DONE);
     /* Set Data Length */
-    bcm2835_peri_write(dlen, len);
+    bcm2835_peri_write_nb(dlen, len);
     /* pre populate FIFO with max buffer */
     while( remaining && ( i < BCM2835_BSC_FIFO_SIZE ) )
     {
@@ -1321,28 +1483,28 @@ uint8_t bcm2835_i2c_write(const char * buf, uint32_t len)
     }
     
     /* Enable device and start transfer */
-    bcm2835_peri_write(control, BCM2835_BSC_C_I2CEN | BCM2835_BSC_C_ST);
+    bcm2835_peri_write_nb(control, BCM2835_BSC_C_I2CEN | BCM2835_BSC_C_ST);
     
     /* Transfer is over when BCM2835_BSC_S_DONE */
-    while(!(bcm2835_peri_read(status) & BCM2835_BSC_S_DONE ))
+    while(!(bcm2835_peri_read_nb(status) & BCM2835_BSC_S_DONE ))
     {
-        while ( remaining && (bcm2835_peri_read(status) & BCM2835_BSC_S_TXD ))
+        while ( remaining && (bcm2835_peri_read_nb(status) & BCM2835_BSC_S_TXD ))
     	{
 	    /* Write to FIFO */
-	    bcm2835_peri_write(fifo, buf[i]);
+	    bcm2835_peri_write_nb(fifo, buf[i]);
 	    i++;
 	    remaining--;
     	}
     }
 
     /* Received a NACK */
-    if (bcm2835_peri_read(status) & BCM2835_BSC_S_ERR)
+    if (bcm2835_peri_read_nb(status) & BCM2835_BSC_S_ERR)
     {
 	reason = BCM2835_I2C_REASON_ERROR_NACK;
     }
 
     /* Received Clock Stretch Timeout */
-    else if (bcm2835_peri_read(status) & BCM2835_BSC_S_CLKT)
+    else if (bcm2835_peri_read_nb(status) & BCM2835_BSC_S_CLKT)
     {
 	reason = BCM2835_I2C_REASON_ERROR_CLKT;
     }
@@ -1353,32 +1515,51 @@ uint8_t bcm2835_i2c_write(const char * buf, uint32_t len)
 	reason = BCM2835_I2C_REASON_ERROR_DATA;
     }
 
-    bcm2835_peri_set_bits(control, BCM2835_BSC_S_DONE , BCM2835_BSC_S_DONE);
+    bcm2835_peri_set_bits_nb(control, BCM2835_BSC_S_DONE , BCM2835_BSC_S_DONE);
+
+    bcm2835_memory_barrier();
+
+    BCM2835_TRACE_Record(BCM2835_TRACE_I2C_WRITE, bus, address, len, buf, len, NULL, 0, trace_start, reason);
 
     return reason;
 }
 
 /* Read an number of bytes from I2C */
-uint8_t bcm2835_i2c_read(char* buf, uint32_t len)
+uint8_t bcm2835_i2c_bus_read(uint8_t bus, char* buf, uint32_t len)
 {
-#ifdef I2C_V1
-    volatile uint32_t* dlen    = bcm2835_bsc0 + BCM2835_BSC_DLEN/4;
-    volatile uint32_t* fifo    = bcm2835_bsc0 + BCM2835_BSC_FIFO/4;
-    volatile uint32_t* status  = bcm2835_bsc0 + BCM2835_BSC_S/4;
-    volatile uint32_t* control = bcm2835_bsc0 + BCM2835_BSC_C/4;
-#else
-    volatile uint32_t* dlen    = bcm2835_bsc1 + BCM2835_BSC_DLEN/4;
-    volatile uint32_t* fifo    = bcm2835_bsc1 + BCM2835_BSC_FIFO/4;
-    volatile uint32_t* status  = bcm2835_bsc1 + BCM2835_BSC_S/4;
-    volatile uint32_t* control = bcm2835_bsc1 + BCM2835_BSC_C/4;
-#endif    
+    volatile uint32_t* dlen;
+    volatile uint32_t* fifo;
+    volatile uint32_t* status;
+    volatile uint32_t* control;
 
     uint32_t remaining = len;
     uint32_t i = 0;
     uint8_t reason = BCM2835_I2C_REASON_OK;
+    uint8_t address;
+    uint32 trace_start;
+
+    if (bus >= BCM2835_I2C_BUS_COUNT)
+	return BCM2835_I2C_REASON_ERROR_BUS;
+
+    /* Simulated transactions are served from the replayed trace */
+    address = (uint8_t) bcm2835_i2c_buses[bus].address;
+    if (BCM2835_DEBUG)
+	return BCM2835_TRACE_Replay(BCM2835_TRACE_I2C_READ, bus, address, len, NULL, 0, buf, len);
+
+    trace_start = BCM2835_TRACE_Now();
+
+    dlen    = BCM2835_I2C_REG(&bcm2835_i2c_buses[bus], BCM2835_BSC_DLEN);
+    fifo    = BCM2835_I2C_REG(&bcm2835_i2c_buses[bus], BCM2835_BSC_FIFO);
+    status  = BCM2835_I2C_REG(&bcm2835_i2c_buses[bus], BCM2835_BSC_S);
+    control = BCM2835_I2C_REG(&bcm2835_i2c_buses[bus], BCM2835_BSC_C);
+
+    /* Only the BSC is accessed from here on, so the accesses need no barriers
+    // of their own: one on entry and one before returning is enough.
+    */
+    bcm2835_memory_barrier();
 
     /* Clear FIFO */
-    bcm2835_peri_set_bits(control, BCM2835_BSC_C_CLEAR_1 , BCM2835_BSC_C_CLEAR_1 );
+    bcm2835_peri_set_bits_nb(control, BCM2835_BSC_C_CLEAR_1 , BCM2835_BSC_C_CLEAR_1 );
     /* Clear Status */
     bcm2835_peri_write_nb(status, BCM2835_BSC_S_CLKT | BCM2835_BSC_S_ERR | BCM2835_BSC_S_DONE);
     /* Set Data Length */
@@ -1409,13 +1590,13 @@ uint8_t bcm2835_i2c_read(char* buf, uint32_t len)
     }
     
     /* Received a NACK */
-    if (bcm2835_peri_read(status) & BCM2835_BSC_S_ERR)
+    if (bcm2835_peri_read_nb(status) & BCM2835_BSC_S_ERR)
     {
 	reason = BCM2835_I2C_REASON_ERROR_NACK;
     }
 
     /* Received Clock Stretch Timeout */
-    else if (bcm2835_peri_read(status) & BCM2835_BSC_S_CLKT)
+    else if (bcm2835_peri_read_nb(status) & BCM2835_BSC_S_CLKT)
     {
 	reason = BCM2835_I2C_REASON_ERROR_CLKT;
     }
@@ -1426,7 +1607,11 @@ uint8_t bcm2835_i2c_read(char* buf, uint32_t len)
 	reason = BCM2835_I2C_REASON_ERROR_DATA;
     }
 
-    bcm2835_peri_set_bits(status, BCM2835_BSC_S_DONE , BCM2835_BSC_S_DONE);
+    bcm2835_peri_set_bits_nb(status, BCM2835_BSC_S_DONE , BCM2835_BSC_S_DONE);
+
+    bcm2835_memory_barrier();
+
+    BCM2835_TRACE_Record(BCM2835_TRACE_I2C_READ, bus, address, len, NULL, 0, buf, len, trace_start, reason);
 
     return reason;
 }
@@ -1434,79 +1619,94 @@ uint8_t bcm2835_i2c_read(char* buf, uint32_t len)
 /* Read an number of bytes from I2C sending a repeated start after writing
 // the required register. Only works if your device supports this mode
 */
-uint8_t bcm2835_i2c_read_register_rs(char* regaddr, char* buf, uint32_t len)
+uint8_t bcm2835_i2c_bus_read_register_rs(uint8_t bus, char* regaddr, char* buf, uint32_t len)
 {   
-#ifdef I2C_V1
-    volatile uint32_t* dlen    = bcm2835_bsc0 + BCM2835_BSC_DLEN/4;
-    volatile uint32_t* fifo    = bcm2835_bsc0 + BCM2835_BSC_FIFO/4;
-    volatile uint32_t* status  = bcm2835_bsc0 + BCM2835_BSC_S/4;
-    volatile uint32_t* control = bcm2835_bsc0 + BCM2835_BSC_C/4;
-#else
-    volatile uint32_t* dlen    = bcm2835_bsc1 + BCM2835_BSC_DLEN/4;
-    volatile uint32_t* fifo    = bcm2835_bsc1 + BCM2835_BSC_FIFO/4;
-    volatile uint32_t* status  = bcm2835_bsc1 + BCM2835_BSC_S/4;
-    volatile uint32_t* control = bcm2835_bsc1 + BCM2835_BSC_C/4;
-#endif    
-	uint32_t remaining = len;
+    volatile uint32_t* dlen;
+    volatile uint32_t* fifo;
+    volatile uint32_t* status;
+    volatile uint32_t* control;
+    uint32_t remaining = len;
     uint32_t i = 0;
     uint8_t reason = BCM2835_I2C_REASON_OK;
+    uint8_t address;
+    uint32 trace_start;
+
+    if (bus >= BCM2835_I2C_BUS_COUNT)
+	return BCM2835_I2C_REASON_ERROR_BUS;
+
+    /* Simulated transactions are served from the replayed trace */
+    address = (uint8_t) bcm2835_i2c_buses[bus].address;
+    if (BCM2835_DEBUG)
+	return BCM2835_TRACE_Replay(BCM2835_TRACE_I2C_READ_REG, bus, address, len + 1, regaddr, 1, buf, len);
+
+    trace_start = BCM2835_TRACE_Now();
+
+    dlen    = BCM2835_I2C_REG(&bcm2835_i2c_buses[bus], BCM2835_BSC_DLEN);
+    fifo    = BCM2835_I2C_REG(&bcm2835_i2c_buses[bus], BCM2835_BSC_FIFO);
+    status  = BCM2835_I2C_REG(&bcm2835_i2c_buses[bus], BCM2835_BSC_S);
+    control = BCM2835_I2C_REG(&bcm2835_i2c_buses[bus], BCM2835_BSC_C);
+
+    /* Only the BSC is accessed from here on, so the accesses need no barriers
+    // of their own: one on entry and one before returning is enough.
+    */
+    bcm2835_memory_barrier();
     
     /* Clear FIFO */
-    bcm2835_peri_set_bits(control, BCM2835_BSC_C_CLEAR_1 , BCM2835_BSC_C_CLEAR_1 );
+    bcm2835_peri_set_bits_nb(control, BCM2835_BSC_C_CLEAR_1 , BCM2835_BSC_C_CLEAR_1 );
     /* Clear Status */
-    bcm2835_peri_write(status, BCM2835_BSC_S_CLKT | BCM2835_BSC_S_ERR | BCM2835_BSC_S_DONE);
+    bcm2835_peri_write_nb(status, BCM2835_BSC_S_CLKT | BCM2835_BSC_S_ERR | BCM2835_BSC_S_DONE);
     /* Set Data Length */
-    bcm2835_peri_write(dlen, 1);
+    bcm2835_peri_write_nb(dlen, 1);
     /* Enable device and start transfer */
-    bcm2835_peri_write(control, BCM2835_BSC_C_I2CEN);
-    bcm2835_peri_write(fifo, regaddr[0]);
-    bcm2835_peri_write(control, BCM2835_BSC_C_I2CEN | BCM2835_BSC_C_ST);
+    bcm2835_peri_write_nb(control, BCM2835_BSC_C_I2CEN);
+    bcm2835_peri_write_nb(fifo, regaddr[0]);
+    bcm2835_peri_write_nb(control, BCM2835_BSC_C_I2CEN | BCM2835_BSC_C_ST);
     
     /* poll for transfer has started */
-    while ( !( bcm2835_peri_read(status) & BCM2835_BSC_S_TA ) )
+    while ( !( bcm2835_peri_read_nb(status) & BCM2835_BSC_S_TA ) )
     {
         /* Linux may cause us to miss entire transfer stage */
-        if(bcm2835_peri_read(status) & BCM2835_BSC_S_DONE)
+        if(bcm2835_peri_read_nb(status) & BCM2835_BSC_S_DONE)
             break;
     }
     
     /* Send a repeated start with read bit set in address */
-    bcm2835_peri_write(dlen, len);
-    bcm2835_peri_write(control, BCM2835_BSC_C_I2CEN | BCM2835_BSC_C_ST  | BCM2835_BSC_C_READ );
+    bcm2835_peri_write_nb(dlen, len);
+    bcm2835_peri_write_nb(control, BCM2835_BSC_C_I2CEN | BCM2835_BSC_C_ST  | BCM2835_BSC_C_READ );
     
     /* Wait for write to complete and first byte back. */
-    bcm2835_delayMicroseconds(i2c_byte_wait_us * 3);
+    bcm2835_i2c_wait_rs_read(&bcm2835_i2c_buses[bus], status, 3);
     
     /* wait for transfer to complete */
-    while (!(bcm2835_peri_read(status) & BCM2835_BSC_S_DONE))
+    while (!(bcm2835_peri_read_nb(status) & BCM2835_BSC_S_DONE))
     {
         /* we must empty the FIFO as it is populated and not use any delay */
-        while (remaining && bcm2835_peri_read(status) & BCM2835_BSC_S_RXD)
+        while (remaining && bcm2835_peri_read_nb(status) & BCM2835_BSC_S_RXD)
     	{
 	    /* Read from FIFO */
-	    buf[i] = bcm2835_peri_read(fifo);
+	    buf[i] = bcm2835_peri_read_nb(fifo);
 	    i++;
 	    remaining--;
     	}
     }
     
     /* transfer has finished - grab any remaining stuff in FIFO */
-    while (remaining && (bcm2835_peri_read(status) & BCM2835_BSC_S_RXD))
+    while (remaining && (bcm2835_peri_read_nb(status) & BCM2835_BSC_S_RXD))
     {
         /* Read from FIFO */
-        buf[i] = bcm2835_peri_read(fifo);
+        buf[i] = bcm2835_peri_read_nb(fifo);
         i++;
         remaining--;
     }
     
     /* Received a NACK */
-    if (bcm2835_peri_read(status) & BCM2835_BSC_S_ERR)
+    if (bcm2835_peri_read_nb(status) & BCM2835_BSC_S_ERR)
     {
 		reason = BCM2835_I2C_REASON_ERROR_NACK;
     }
 
     /* Received Clock Stretch Timeout */
-    else if (bcm2835_peri_read(status) & BCM2835_BSC_S_CLKT)
+    else if (bcm2835_peri_read_nb(status) & BCM2835_BSC_S_CLKT)
     {
 	reason = BCM2835_I2C_REASON_ERROR_CLKT;
     }
@@ -1517,7 +1717,11 @@ uint8_t bcm2835_i2c_read_register_rs(char* regaddr, char* buf, uint32_t len)
 	reason = BCM2835_I2C_REASON_ERROR_DATA;
     }
 
-    bcm2835_peri_set_bits(control, BCM2835_BSC_S_DONE , BCM2835_BSC_S_DONE);
+    bcm2835_peri_set_bits_nb(control, BCM2835_BSC_S_DONE , BCM2835_BSC_S_DONE);
+
+    bcm2835_memory_barrier();
+
+    BCM2835_TRACE_Record(BCM2835_TRACE_I2C_READ_REG, bus, address, len + 1, regaddr, 1, buf, len, trace_start, reason);
 
     return reason;
 }
@@ -1525,32 +1729,47 @@ uint8_t bcm2835_i2c_read_register_rs(char* regaddr, char* buf, uint32_t len)
 /* Sending an arbitrary number of bytes before issuing a repeated start 
 // (with no prior stop) and reading a response. Some devices require this behavior.
 */
-uint8_t bcm2835_i2c_write_read_rs(char* cmds, uint32_t cmds_len, char* buf, uint32_t buf_len)
+uint8_t bcm2835_i2c_bus_write_read_rs(uint8_t bus, char* cmds, uint32_t cmds_len, char* buf, uint32_t buf_len)
 {   
-#ifdef I2C_V1
-    volatile uint32_t* dlen    = bcm2835_bsc0 + BCM2835_BSC_DLEN/4;
-    volatile uint32_t* fifo    = bcm2835_bsc0 + BCM2835_BSC_FIFO/4;
-    volatile uint32_t* status  = bcm2835_bsc0 + BCM2835_BSC_S/4;
-    volatile uint32_t* control = bcm2835_bsc0 + BCM2835_BSC_C/4;
-#else
-    volatile uint32_t* dlen    = bcm2835_bsc1 + BCM2835_BSC_DLEN/4;
-    volatile uint32_t* fifo    = bcm2835_bsc1 + BCM2835_BSC_FIFO/4;
-    volatile uint32_t* status  = bcm2835_bsc1 + BCM2835_BSC_S/4;
-    volatile uint32_t* control = bcm2835_bsc1 + BCM2835_BSC_C/4;
-#endif    
+    volatile uint32_t* dlen;
+    volatile uint32_t* fifo;
+    volatile uint32_t* status;
+    volatile uint32_t* control;
 
     uint32_t remaining = cmds_len;
     uint32_t i = 0;
     uint8_t reason = BCM2835_I2C_REASON_OK;
+    uint8_t address;
+    uint32 trace_start;
+
+    if (bus >= BCM2835_I2C_BUS_COUNT)
+	return BCM2835_I2C_REASON_ERROR_BUS;
+
+    /* Simulated transactions are served from the replayed trace */
+    address = (uint8_t) bcm2835_i2c_buses[bus].address;
+    if (BCM2835_DEBUG)
+	return BCM2835_TRACE_Replay(BCM2835_TRACE_I2C_WRITE_READ, bus, address, cmds_len + buf_len, cmds, cmds_len, buf, buf_len);
+
+    trace_start = BCM2835_TRACE_Now();
+
+    dlen    = BCM2835_I2C_REG(&bcm2835_i2c_buses[bus], BCM2835_BSC_DLEN);
+    fifo    = BCM2835_I2C_REG(&bcm2835_i2c_buses[bus], BCM2835_BSC_FIFO);
+    status  = BCM2835_I2C_REG(&bcm2835_i2c_buses[bus], BCM2835_BSC_S);
+    control = BCM2835_I2C_REG(&bcm2835_i2c_buses[bus], BCM2835_BSC_C);
+
+    /* Only the BSC is accessed from here on, so the accesses need no barriers
+    // of their own: one on entry and one before returning is enough.
+    */
+    bcm2835_memory_barrier();
     
     /* Clear FIFO */
-    bcm2835_peri_set_bits(control, BCM2835_BSC_C_CLEAR_1 , BCM2835_BSC_C_CLEAR_1 );
+    bcm2835_peri_set_bits_nb(control, BCM2835_BSC_C_CLEAR_1 , BCM2835_BSC_C_CLEAR_1 );
 
     /* Clear Status */
-    bcm2835_peri_write(status, BCM2835_BSC_S_CLKT | BCM2835_BSC_S_ERR | BCM2835_BSC_S_DONE);
+    bcm2835_peri_write_nb(status, BCM2835_BSC_S_CLKT | BCM2835_BSC_S_ERR | BCM2835_BSC_S_DONE);
 
     /* Set Data Length */
-    bcm2835_peri_write(dlen, cmds_len);
+    bcm2835_peri_write_nb(dlen, cmds_len);
  
     /* pre populate FIFO with max buffer */
     while( remaining && ( i < BCM2835_BSC_FIFO_SIZE ) )
@@ -1561,10 +1780,10 @@ uint8_t bcm2835_i2c_write_read_rs(char* cmds, uint32_t cmds_len, char* buf, uint
     }
 
     /* Enable device and start transfer */
-    bcm2835_peri_write(control, BCM2835_BSC_C_I2CEN | BCM2835_BSC_C_ST);
+    bcm2835_peri_write_nb(control, BCM2835_BSC_C_I2CEN | BCM2835_BSC_C_ST);
     
     /* poll for transfer has started (way to do repeated start, from BCM2835 datasheet) */
-    while ( !( bcm2835_peri_read(status) & BCM2835_BSC_S_TA ) )
+    while ( !( bcm2835_peri_read_nb(status) & BCM2835_BSC_S_TA ) )
     {
         /* Linux may cause us to miss entire transfer stage */
         if(bcm2835_peri_read_nb(status) & BCM2835_BSC_S_DONE)
@@ -1575,17 +1794,17 @@ uint8_t bcm2835_i2c_write_read_rs(char* cmds, uint32_t cmds_len, char* buf, uint
     i = 0;
 
     /* Send a repeated start with read bit set in address */
-    bcm2835_peri_write(dlen, buf_len);
-    bcm2835_peri_write(control, BCM2835_BSC_C_I2CEN | BCM2835_BSC_C_ST  | BCM2835_BSC_C_READ );
+    bcm2835_peri_write_nb(dlen, buf_len);
+    bcm2835_peri_write_nb(control, BCM2835_BSC_C_I2CEN | BCM2835_BSC_C_ST  | BCM2835_BSC_C_READ );
     
     /* Wait for write to complete and first byte back. */
-    bcm2835_delayMicroseconds(i2c_byte_wait_us * (cmds_len + 1));
+    bcm2835_i2c_wait_rs_read(&bcm2835_i2c_buses[bus], status, cmds_len + 1);
     
     /* wait for transfer to complete */
     while (!(bcm2835_peri_read_nb(status) & BCM2835_BSC_S_DONE))
     {
         /* we must empty the FIFO as it is populated and not use any delay */
-        while (remaining && bcm2835_peri_read(status) & BCM2835_BSC_S_RXD)
+        while (remaining && bcm2835_peri_read_nb(status) & BCM2835_BSC_S_RXD)
     	{
 	    /* Read from FIFO, no barrier */
 	    buf[i] = bcm2835_peri_read_nb(fifo);
@@ -1595,22 +1814,22 @@ uint8_t bcm2835_i2c_write_read_rs(char* cmds, uint32_t cmds_len, char* buf, uint
     }
     
     /* transfer has finished - grab any remaining stuff in FIFO */
-    while (remaining && (bcm2835_peri_read(status) & BCM2835_BSC_S_RXD))
+    while (remaining && (bcm2835_peri_read_nb(status) & BCM2835_BSC_S_RXD))
     {
         /* Read from FIFO */
-        buf[i] = bcm2835_peri_read(fifo);
+        buf[i] = bcm2835_peri_read_nb(fifo);
         i++;
         remaining--;
     }
     
     /* Received a NACK */
-    if (bcm2835_peri_read(status) & BCM2835_BSC_S_ERR)
+    if (bcm2835_peri_read_nb(status) & BCM2835_BSC_S_ERR)
     {
 	reason = BCM2835_I2C_REASON_ERROR_NACK;
     }
 
     /* Received Clock Stretch Timeout */
-    else if (bcm2835_peri_read(status) & BCM2835_BSC_S_CLKT)
+    else if (bcm2835_peri_read_nb(status) & BCM2835_BSC_S_CLKT)
     {
 	reason = BCM2835_I2C_REASON_ERROR_CLKT;
     }
@@ -1621,11 +1840,250 @@ uint8_t bcm2835_i2c_write_read_rs(char* cmds, uint32_t cmds_len, char* buf, uint
 	reason = BCM2835_I2C_REASON_ERROR_DATA;
     }
 
-    bcm2835_peri_set_bits(control, BCM2835_BSC_S_DONE , BCM2835_BSC_S_DONE);
+    bcm2835_peri_set_bits_nb(control, BCM2835_BSC_S_DONE , BCM2835_BSC_S_DONE);
+
+    bcm2835_memory_barrier();
+
+    BCM2835_TRACE_Record(BCM2835_TRACE_I2C_WRITE_READ, bus, address, cmds_len + buf_len, cmds, cmds_len, buf, buf_len, trace_start, reason);
 
     return reason;
 }
 
+/* The functions without a bus argument use the default controller,
+// BSC0 when compiled with I2C_V1 and BSC1 otherwise.
+*/
+int bcm2835_i2c_begin(void)
+{
+    return bcm2835_i2c_bus_begin(bcm2835_i2c_default_bus());
+}
+
+void bcm2835_i2c_end(void)
+{
+    bcm2835_i2c_bus_end(bcm2835_i2c_default_bus());
+}
+
+void bcm2835_i2c_setSlaveAddress(uint8_t addr)
+{
+    bcm2835_i2c_bus_setSlaveAddress(bcm2835_i2c_default_bus(), addr);
+}
+
+void bcm2835_i2c_setClockDivider(uint16_t divider)
+{
+    bcm2835_i2c_bus_setClockDivider(bcm2835_i2c_default_bus(), divider);
+}
+
+void bcm2835_i2c_set_baudrate(uint32_t baudrate)
+{
+    bcm2835_i2c_bus_set_baudrate(bcm2835_i2c_default_bus(), baudrate);
+}
+
+uint8_t bcm2835_i2c_write(const char * buf, uint32_t len)
+{
+    return bcm2835_i2c_bus_write(bcm2835_i2c_default_bus(), buf, len);
+}
+
+uint8_t bcm2835_i2c_read(char* buf, uint32_t len)
+{
+    return bcm2835_i2c_bus_read(bcm2835_i2c_default_bus(), buf, len);
+}
+
+uint8_t bcm2835_i2c_read_register_rs(char* regaddr, char* buf, uint32_t len)
+{
+    return bcm2835_i2c_bus_read_register_rs(bcm2835_i2c_default_bus(), regaddr, buf, len);
+}
+
+uint8_t bcm2835_i2c_write_read_rs(char* cmds, uint32_t cmds_len, char* buf, uint32_t buf_len)
+{
+    return bcm2835_i2c_bus_write_read_rs(bcm2835_i2c_default_bus(), cmds, cmds_len, buf, buf_len);
+}
+
+/* Per-device access.
+// A device handle remembers its bus, address, clock and timeout. Registers are only
+// written when the controller holds different values, so consecutive accesses to the
+// same device cost no setup writes. Every transfer is counted in the handle.
+*/
+void bcm2835_i2c_device_init(bcm2835_i2c_device_t *dev, uint8_t bus, uint8_t address, uint32_t baudrate)
+{
+    memset(dev, 0, sizeof(*dev));
+    dev->bus     = bus;
+    dev->address = address;
+    dev->fallback_baudrate = baudrate;
+    bcm2835_i2c_device_set_baudrate(dev, baudrate);
+}
+
+void bcm2835_i2c_device_set_baudrate(bcm2835_i2c_device_t *dev, uint32_t baudrate)
+{
+    dev->baudrate = baudrate;
+    /* use 0xFFFE mask to limit a max value and round down any odd number */
+    dev->divider  = (BCM2835_CORE_CLK_HZ / baudrate) & 0xFFFE;
+}
+
+void bcm2835_i2c_device_set_timeout(bcm2835_i2c_device_t *dev, uint16_t clkt)
+{
+    dev->clkt = clkt;
+}
+
+void bcm2835_i2c_device_reset_stats(bcm2835_i2c_device_t *dev)
+{
+    memset(&dev->stats, 0, sizeof(dev->stats));
+}
+
+/* Program the controller for the device, skipping registers that already match */
+static uint8_t bcm2835_i2c_device_select(bcm2835_i2c_device_t *dev)
+{
+    bcm2835_i2c_bus_t *b;
+
+    if (dev->bus >= BCM2835_I2C_BUS_COUNT)
+	return BCM2835_I2C_REASON_ERROR_BUS;
+
+    b = &bcm2835_i2c_buses[dev->bus];
+
+    if (b->address != dev->address)
+	bcm2835_i2c_bus_setSlaveAddress(dev->bus, dev->address);
+
+    if (b->divider != dev->divider)
+	bcm2835_i2c_bus_setClockDivider(dev->bus, dev->divider);
+
+    if (dev->clkt != 0 && b->clkt != dev->clkt)
+    {
+	bcm2835_peri_write(BCM2835_I2C_REG(b, BCM2835_BSC_CLKT), dev->clkt);
+	b->clkt = dev->clkt;
+    }
+
+    return BCM2835_I2C_REASON_OK;
+}
+
+static uint8_t bcm2835_i2c_device_account(bcm2835_i2c_device_t *dev, uint64 start_us, uint32_t len, uint8_t reason)
+{
+    dev->stats.Transactions++;
+    dev->stats.BusTimeUs += BCM2835_LIB_GetTimeUs() - start_us;
+    if (reason == BCM2835_I2C_REASON_OK)
+	dev->stats.Bytes += len;
+    else
+	dev->stats.Errors++;
+
+    return reason;
+}
+
+uint8_t bcm2835_i2c_device_write(bcm2835_i2c_device_t *dev, const char * buf, uint32_t len)
+{
+    uint64 start_us = BCM2835_LIB_GetTimeUs();
+    uint8_t reason = bcm2835_i2c_device_select(dev);
+
+    if (reason == BCM2835_I2C_REASON_OK)
+	reason = bcm2835_i2c_bus_write(dev->bus, buf, len);
+
+    return bcm2835_i2c_device_account(dev, start_us, len, reason);
+}
+
+uint8_t bcm2835_i2c_device_read(bcm2835_i2c_device_t *dev, char* buf, uint32_t len)
+{
+    uint64 start_us = BCM2835_LIB_GetTimeUs();
+    uint8_t reason = bcm2835_i2c_device_select(dev);
+
+    if (reason == BCM2835_I2C_REASON_OK)
+	reason = bcm2835_i2c_bus_read(dev->bus, buf, len);
+
+    return bcm2835_i2c_device_account(dev, start_us, len, reason);
+}
+
+uint8_t bcm2835_i2c_device_read_register_rs(bcm2835_i2c_device_t *dev, char* regaddr, char* buf, uint32_t len)
+{
+    uint64 start_us = BCM2835_LIB_GetTimeUs();
+    uint8_t reason = bcm2835_i2c_device_select(dev);
+
+    if (reason == BCM2835_I2C_REASON_OK)
+	reason = bcm2835_i2c_bus_read_register_rs(dev->bus, regaddr, buf, len);
+
+    return bcm2835_i2c_device_account(dev, start_us, len + 1, reason);
+}
+
+uint8_t bcm2835_i2c_device_write_read_rs(bcm2835_i2c_device_t *dev, char* cmds, uint32_t cmds_len, char* buf, uint32_t buf_len)
+{
+    uint64 start_us = BCM2835_LIB_GetTimeUs();
+    uint8_t reason = bcm2835_i2c_device_select(dev);
+
+    if (reason == BCM2835_I2C_REASON_OK)
+	reason = bcm2835_i2c_bus_write_read_rs(dev->bus, cmds, cmds_len, buf, buf_len);
+
+    return bcm2835_i2c_device_account(dev, start_us, cmds_len + buf_len, reason);
+}
+
+/* Clock steps tried by the negotiation, in Hz */
+static const uint32_t bcm2835_i2c_speed_steps[] =
+{
+    BCM2835_I2C_SPEED_STANDARD,
+    BCM2835_I2C_SPEED_FAST,
+    BCM2835_I2C_SPEED_FAST_PLUS
+};
+#define BCM2835_I2C_SPEED_STEPS (sizeof(bcm2835_i2c_speed_steps) / sizeof(bcm2835_i2c_speed_steps[0]))
+
+/* Run verify trials times at a clock, 1 if all passed without transfer errors */
+static uint8_t bcm2835_i2c_device_try(bcm2835_i2c_device_t *dev, uint32_t baudrate, uint8_t trials,
+				      bcm2835_i2c_verify_fn verify, void *arg)
+{
+    uint32_t errors = dev->stats.Errors;
+    uint8_t t;
+
+    bcm2835_i2c_device_set_baudrate(dev, baudrate);
+
+    for (t = 0; t < trials; t++)
+    {
+	if (!verify(dev, arg))
+	    return 0;
+    }
+
+    return (dev->stats.Errors == errors);
+}
+
+uint32_t bcm2835_i2c_device_negotiate(bcm2835_i2c_device_t *dev, uint32_t max_baudrate, uint8_t trials,
+				      bcm2835_i2c_verify_fn verify, void *arg)
+{
+    uint32_t best = dev->fallback_baudrate;
+    uint32_t step;
+    uint32_t i;
+
+    for (i = 0; i < BCM2835_I2C_SPEED_STEPS && bcm2835_i2c_speed_steps[i] <= max_baudrate; i++)
+    {
+	step = bcm2835_i2c_speed_steps[i];
+
+	if (!bcm2835_i2c_device_try(dev, step, trials, verify, arg)
+	    || !bcm2835_i2c_device_try(dev, step + (step / 100) * BCM2835_I2C_SPEED_MARGIN_PCT, trials, verify, arg))
+	    break;
+
+	if (step > best)
+	    best = step;
+    }
+
+    bcm2835_i2c_device_set_baudrate(dev, best);
+    dev->checked_errors = dev->stats.Errors;
+
+    return dev->baudrate;
+}
+
+uint32_t bcm2835_i2c_device_revalidate(bcm2835_i2c_device_t *dev, bcm2835_i2c_verify_fn verify, void *arg)
+{
+    uint32_t lower = dev->fallback_baudrate;
+    uint32_t i;
+
+    if (dev->stats.Errors != dev->checked_errors || !verify(dev, arg))
+    {
+	/* Next lower step, never below the fallback clock */
+	for (i = 0; i < BCM2835_I2C_SPEED_STEPS; i++)
+	{
+	    if (bcm2835_i2c_speed_steps[i] < dev->baudrate && bcm2835_i2c_speed_steps[i] > lower)
+		lower = bcm2835_i2c_speed_steps[i];
+	}
+
+	if (lower < dev->baudrate)
+	    bcm2835_i2c_device_set_baudrate(dev, lower);
+    }
+
+    dev->checked_errors = dev->stats.Errors;
+
+    return dev->baudrate;
+}
+
 /* Read the System Timer Counter (64-bits) */
 uint64_t bcm2835_st_read(void)
 {
@@ -1633,7 +2091,7 @@ uint64_t bcm2835_st_read(void)
     uint32_t hi, lo;
     uint64_t st;
 
-    if (bcm2835_st==MAP_FAILED)
+    if (bcm2835_st==MAP_FAILED && !BCM2835_LIB_MapRegion(BCM2835_REGBASE_ST))
 	return 0;
 
     paddr = bcm2835_st + BCM2835_ST_CHI/4;
@@ -1673,27 +2131,39 @@ void bcm2835_st_delay(uint64_t offset_micros, uint64_t micros)
 
 void bcm2835_pwm_set_clock(uint32_t divisor)
 {
-    if (   bcm2835_clk == MAP_FAILED
-        || bcm2835_pwm == MAP_FAILED)
+    if (   !BCM2835_LIB_MapRegion(BCM2835_REGBASE_CLK)
+        || !BCM2835_LIB_MapRegion(BCM2835_REGBASE_PWM))
       return; /* bcm2835_init() failed or not root */
   
+    uint64_t start;
+
     /* From Gerts code */
     divisor &= 0xfff;
     /* Stop PWM clock */
-    bcm2835_peri_write(bcm2835_clk + BCM2835_PWMCLK_CNTL, BCM2835_PWM_PASSWRD | 0x01);
-    bcm2835_delay(110); /* Prevents clock going slow */
-    /* Wait for the clock to be not busy */
-    while ((bcm2835_peri_read(bcm2835_clk + BCM2835_PWMCLK_CNTL) & 0x80) != 0)
-	bcm2835_delay(1); 
+    bcm2835_peri_write(bcm2835_clk + BCM2835_PWMCLK_CNTL, BCM2835_PWM_PASSWRD | BCM2835_PWMCLK_CNTL_SRC_OSC);
+    /* The divider may only change once the generator is idle: wait for BUSY to
+       clear (a few periods of the old clock) instead of the fixed 110 ms Gert used.
+       Kill it if it does not stop. */
+    start = BCM2835_LIB_GetTimeUs();
+    while ((bcm2835_peri_read(bcm2835_clk + BCM2835_PWMCLK_CNTL) & BCM2835_PWMCLK_CNTL_BUSY) != 0)
+    {
+	if (BCM2835_LIB_GetTimeUs() - start > BCM2835_PWMCLK_BUSY_TIMEOUT_US)
+	{
+	    bcm2835_peri_write(bcm2835_clk + BCM2835_PWMCLK_CNTL,
+			       BCM2835_PWM_PASSWRD | BCM2835_PWMCLK_CNTL_KILL | BCM2835_PWMCLK_CNTL_SRC_OSC);
+	    break;
+	}
+    }
     /* set the clock divider and enable PWM clock */
     bcm2835_peri_write(bcm2835_clk + BCM2835_PWMCLK_DIV, BCM2835_PWM_PASSWRD | (divisor << 12));
-    bcm2835_peri_write(bcm2835_clk + BCM2835_PWMCLK_CNTL, BCM2835_PWM_PASSWRD | 0x11); /* Source=osc and enable */
+    bcm2835_peri_write(bcm2835_clk + BCM2835_PWMCLK_CNTL,
+		       BCM2835_PWM_PASSWRD | BCM2835_PWMCLK_CNTL_ENAB | BCM2835_PWMCLK_CNTL_SRC_OSC);
 }
 
 void bcm2835_pwm_set_mode(uint8_t channel, uint8_t markspace, uint8_t enabled)
 {
-  if (   bcm2835_clk == MAP_FAILED
-       || bcm2835_pwm == MAP_FAILED)
+  if (   !BCM2835_LIB_MapRegion(BCM2835_REGBASE_CLK)
+       || !BCM2835_LIB_MapRegion(BCM2835_REGBASE_PWM))
     return; /* bcm2835_init() failed or not root */
 
   uint32_t control = bcm2835_peri_read(bcm2835_pwm + BCM2835_PWM_CONTROL);
@@ -1729,8 +2199,8 @@ void bcm2835_pwm_set_mode(uint8_t channel, uint8_t markspace, uint8_t enabled)
 
 void bcm2835_pwm_set_range(uint8_t channel, uint32_t range)
 {
-  if (   bcm2835_clk == MAP_FAILED
-       || bcm2835_pwm == MAP_FAILED)
+  if (   !BCM2835_LIB_MapRegion(BCM2835_REGBASE_CLK)
+       || !BCM2835_LIB_MapRegion(BCM2835_REGBASE_PWM))
     return; /* bcm2835_init() failed or not root */
 
   if (channel == 0)
@@ -1741,8 +2211,8 @@ void bcm2835_pwm_set_range(uint8_t channel, uint32_t range)
 
 void bcm2835_pwm_set_data(uint8_t channel, uint32_t data)
 {
-  if (   bcm2835_clk == MAP_FAILED
-       || bcm2835_pwm == MAP_FAILED)
+  if (   !BCM2835_LIB_MapRegion(BCM2835_REGBASE_CLK)
+       || !BCM2835_LIB_MapRegion(BCM2835_REGBASE_PWM))
     return; /* bcm2835_init() failed or not root */
 
   if (channel == 0)
@@ -1780,14 +2250,113 @@ static void unmapmem(void **pmem, size_t size)
     *pmem = MAP_FAILED;
 }
 
+/* True if this process may map /dev/mem */
+static int bcm2835_can_map_mem(void)
+{
+    return geteuid() == 0
+#ifdef BCM2835_HAVE_LIBCAP
+	|| bcm2835_has_capability(CAP_SYS_RAWIO)
+#endif
+	;
+}
+
+/* Maps the pages holding a peripheral block at offset 'off' of file 'fd'.
+// Called with bcm2835_map_lock held.
+*/
+static int bcm2835_map_block(bcm2835_region_t *r, int fd, off_t off)
+{
+    size_t in_page = r->offset & (BCM2835_PAGE_SIZE - 1);
+    size_t len = (in_page + r->size + BCM2835_PAGE_SIZE - 1) & ~(size_t)(BCM2835_PAGE_SIZE - 1);
+    void *map;
+
+    map = mapmem("peripheral", len, fd, off - in_page);
+    if (map == MAP_FAILED)
+	return 0;
+
+    r->map = map;
+    r->map_size = len;
+    *r->base = (volatile uint32_t *)((uint8_t *)map + in_page);
+
+    bcm2835_map_stats.MappedBytes += len;
+    bcm2835_map_stats.Regions++;
+    return 1;
+}
+
+int BCM2835_LIB_MapRegion(uint8_t regbase)
+{
+    bcm2835_region_t *r;
+    int ok = 0;
+
+    if (regbase == 0 || regbase >= BCM2835_REGION_COUNT)
+	return 0;
+
+    r = &bcm2835_regions[regbase];
+
+    /* Already mapped: the common case, without the lock */
+    if (*r->base != MAP_FAILED)
+	return 1;
+
+    if (BCM2835_DEBUG)
+	return 0;
+
+    pthread_mutex_lock(&bcm2835_map_lock);
+
+    if (*r->base != MAP_FAILED)
+	ok = 1;
+    else if (!r->tried)
+    {
+	r->tried = 1;
+
+	if (bcm2835_memfd < 0 && bcm2835_can_map_mem())
+	    bcm2835_memfd = open("/dev/mem", O_RDWR | O_SYNC);
+
+	if (bcm2835_memfd >= 0)
+	    ok = bcm2835_map_block(r, bcm2835_memfd, bcm2835_peripherals_base + r->offset);
+    }
+
+    pthread_mutex_unlock(&bcm2835_map_lock);
+    return ok;
+}
+
+/* Unmaps every peripheral block, so they are mapped again on next use */
+static void bcm2835_unmap_regions(void)
+{
+    uint8_t i;
+
+    pthread_mutex_lock(&bcm2835_map_lock);
+    for (i = 1; i < BCM2835_REGION_COUNT; i++)
+    {
+	unmapmem(&bcm2835_regions[i].map, bcm2835_regions[i].map_size);
+	*bcm2835_regions[i].base = MAP_FAILED;
+	bcm2835_regions[i].tried = 0;
+    }
+    if (bcm2835_memfd >= 0)
+    {
+	close(bcm2835_memfd);
+	bcm2835_memfd = -1;
+    }
+    bcm2835_map_stats.MappedBytes = 0;
+    bcm2835_map_stats.Regions = 0;
+    bcm2835_map_stats.GpioMem = 0;
+    pthread_mutex_unlock(&bcm2835_map_lock);
+}
+
+void bcm2835_get_map_stats(bcm2835_map_stats_t *stats)
+{
+    pthread_mutex_lock(&bcm2835_map_lock);
+    *stats = bcm2835_map_stats;
+    pthread_mutex_unlock(&bcm2835_map_lock);
+}
+
 /* Initialise this library. */
 int bcm2835_init(void)
 {
     int  memfd;
     int  ok;
     FILE *fp;
+    uint64 start_us = BCM2835_LIB_GetTimeUs();
 
-    if (debug) 
+    if (BCM2835_DEBUG) 
     {
         bcm2835_peripherals = (uint32_t*)BCM2835_PERI_BASE;
 
@@ -1801,6 +2370,7 @@ int bcm2835_init(void)
 	bcm2835_st   = bcm2835_peripherals + BCM2835_ST_BASE/4;
 	bcm2835_aux  = bcm2835_peripherals + BCM2835_AUX_BASE/4;
 	bcm2835_spi1 = bcm2835_peripherals + BCM2835_SPI1_BASE/4;
+	bcm2835_dma  = bcm2835_peripherals + BCM2835_DMA_BASE/4;
 
 	return 1; /* Success */
     }
@@ -1859,68 +2429,30 @@ int bcm2835_init(void)
     }
     /* else we are prob on RPi 1 with BCM2835, and use the hardwired defaults */
 
-    /* Now get ready to map the peripherals block 
-     * If we are not root, try for the new /dev/gpiomem interface and accept
-     * the fact that we can only access GPIO
-     * else try for the /dev/mem interface and get access to everything
+    /* Map the GPIO registers only, the other blocks are mapped on first use.
+     * /dev/gpiomem maps exactly the GPIO page and needs no privileges;
+     * without it, root falls back to /dev/mem
      */
-    memfd = -1;
     ok = 0;
-    if (geteuid() == 0
-#ifdef BCM2835_HAVE_LIBCAP
-	|| bcm2835_has_capability(CAP_SYS_RAWIO)
-#endif
-	)
+    bcm2835_unmap_regions();
+    pthread_mutex_lock(&bcm2835_map_lock);
+    bcm2835_regions[BCM2835_REGBASE_GPIO].tried = 1;
+    if ((memfd = open("/dev/gpiomem", O_RDWR | O_SYNC) ) >= 0)
     {
-      /* Open the master /dev/mem device */
-      if ((memfd = open("/dev/mem", O_RDWR | O_SYNC) ) < 0) 
-	{
-
-	  goto exit;
-	}
-      
-      /* Base of the peripherals block is mapped to VM */
-      bcm2835_peripherals = mapmem("gpio", bcm2835_peripherals_size, memfd, bcm2835_peripherals_base);
-      if (bcm2835_peripherals == MAP_FAILED) goto exit;
-      
-      /* Now compute the base addresses of various peripherals, 
-      // which are at fixed offsets within the mapped peripherals block
-      // Caution: bcm2835_peripherals is uint32_t*, so divide offsets by 4
-      */
-      bcm2835_gpio = bcm2835_peripherals + BCM2835_GPIO_BASE/4;
-      bcm2835_pwm  = bcm2835_peripherals + BCM2835_GPIO_PWM/4;
-      bcm2835_clk  = bcm2835_peripherals + BCM2835_CLOCK_BASE/4;
-      bcm2835_pads = bcm2835_peripherals + BCM2835_GPIO_PADS/4;
-      bcm2835_spi0 = bcm2835_peripherals + BCM2835_SPI0_BASE/4;
-      bcm2835_bsc0 = bcm2835_peripherals + BCM2835_BSC0_BASE/4; /* I2C */
-      bcm2835_bsc1 = bcm2835_peripherals + BCM2835_BSC1_BASE/4; /* I2C */
-      bcm2835_st   = bcm2835_peripherals + BCM2835_ST_BASE/4;
-      bcm2835_aux  = bcm2835_peripherals + BCM2835_AUX_BASE/4;
-      bcm2835_spi1 = bcm2835_peripherals + BCM2835_SPI1_BASE/4;
-
-      ok = 1;
+      ok = bcm2835_map_block(&bcm2835_regions[BCM2835_REGBASE_GPIO], memfd, 0);
+      bcm2835_map_stats.GpioMem = ok;
+      close(memfd);
     }
-    else
+    if (!ok && bcm2835_can_map_mem())
     {
-      /* Not root, try /dev/gpiomem */
-      /* Open the master /dev/mem device */
-      if ((memfd = open("/dev/gpiomem", O_RDWR | O_SYNC) ) < 0) 
-	{
-
-	  goto exit;
-	}
-      
-      /* Base of the peripherals block is mapped to VM */
-      bcm2835_peripherals_base = 0;
-      bcm2835_peripherals = mapmem("gpio", bcm2835_peripherals_size, memfd, bcm2835_peripherals_base);
-      if (bcm2835_peripherals == MAP_FAILED) goto exit;
-      bcm2835_gpio = bcm2835_peripherals;
-      ok = 1;
+      /* Open the master /dev/mem device, kept for the other blocks */
+      bcm2835_memfd = open("/dev/mem", O_RDWR | O_SYNC);
+      if (bcm2835_memfd >= 0)
+	ok = bcm2835_map_block(&bcm2835_regions[BCM2835_REGBASE_GPIO], bcm2835_memfd,
+			       bcm2835_peripherals_base + BCM2835_GPIO_BASE);
     }
-
-exit:
-    if (memfd >= 0)
-        close(memfd);
+    bcm2835_map_stats.InitUs = (uint32_t)(BCM2835_LIB_GetTimeUs() - start_us);
+    pthread_mutex_unlock(&bcm2835_map_lock);
 
     if (!ok)
 	bcm2835_close();
@@ -1931,20 +2463,12 @@ exit:
 /* Close this library and deallocate everything */
 int bcm2835_close(void)
 {
-    if (debug) return 1; /* Success */
-
-    unmapmem((void**) &bcm2835_peripherals, bcm2835_peripherals_size);
-    bcm2835_peripherals = MAP_FAILED;
-    bcm2835_gpio = MAP_FAILED;
-    bcm2835_pwm  = MAP_FAILED;
-    bcm2835_clk  = MAP_FAILED;
-    bcm2835_pads = MAP_FAILED;
-    bcm2835_spi0 = MAP_FAILED;
-    bcm2835_bsc0 = MAP_FAILED;
-    bcm2835_bsc1 = MAP_FAILED;
-    bcm2835_st   = MAP_FAILED;
-    bcm2835_aux  = MAP_FAILED;
-    bcm2835_spi1 = MAP_FAILED;
+    if (BCM2835_DEBUG) return 1; /* Success */
+
+    bcm2835_spi_dma_end();
+    bcm2835_pwm_stream_end();
+
+    bcm2835_unmap_regions();
     return 1; /* Success */
 }    
 
@@ -1954,7 +2478,7 @@ int bcm2835_close(void)
 */
 int main(int argc, char **argv)
 {
-    /* Be non-destructive */
+    /* Be non-destructive: build with BCM2835_SIMULATION */
     bcm2835_set_debug(1);
 
     if (!bcm2835_init())
@@ -2028,8 +2552,19 @@ int main(int argc, char **argv)
 }
 #endif
 
+uint64 BCM2835_LIB_GetTimeUs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ((uint64)ts.tv_sec * 1000000) + ((uint64)ts.tv_nsec / 1000);
+}
+
 int32 BCM2835_LIB_Init(void)
 {
+    bcm2835_map_stats_t MapStats;
+
     /*
      * Call a C library function, like strcpy(), and test its result.
      *
@@ -2047,12 +2582,30 @@ int32 BCM2835_LIB_Init(void)
         return CFE_STATUS_NOT_IMPLEMENTED;
     }
     
-    if(OS_MutSemCreate(&(i2c_mutexvar), "i2c_send_mutex", 0) != OS_SUCCESS){
-        OS_printf("BCM2835 Lib Mutex Sem not created.\n");
+    if(BCM2835_I2C_SchedInit() != CFE_SUCCESS){
+        OS_printf("BCM2835 Lib I2C scheduler not created.\n");
+        return CFE_STATUS_NOT_IMPLEMENTED;
+    }
+
+    if(BCM2835_SPI_DevInit() != CFE_SUCCESS){
+        OS_printf("BCM2835 Lib SPI controller locks not created.\n");
+        return CFE_STATUS_NOT_IMPLEMENTED;
+    }
+
+    if(BCM2835_GPIO_EventInit() != CFE_SUCCESS){
+        OS_printf("BCM2835 Lib GPIO event dispatcher not created.\n");
+        return CFE_STATUS_NOT_IMPLEMENTED;
+    }
+
+    if(BCM2835_TRACE_Init() != CFE_SUCCESS){
+        OS_printf("BCM2835 Lib bus trace not created.\n");
         return CFE_STATUS_NOT_IMPLEMENTED;
     }
     
-    OS_printf("BCM2835 Lib Initialized.\n");
+    bcm2835_get_map_stats(&MapStats);
+    OS_printf("BCM2835 Lib Initialized in %u us, %u bytes of registers mapped%s.\n",
+              (unsigned int)MapStats.InitUs, (unsigned int)MapStats.MappedBytes,
+              MapStats.GpioMem ? " (/dev/gpiomem)" : "");
 
     return CFE_SUCCESS;
 
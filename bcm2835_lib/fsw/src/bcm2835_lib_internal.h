@@ -0,0 +1,191 @@
+/*************************************************************************
+**
+**      GSC-18128-1, "Core Flight Executive Version 6.7"
+**
+**      Copyright (c) 2006-2019 United States Government as represented by
+**      the Administrator of the National Aeronautics and Space Administration.
+**      All Rights Reserved.
+**
+**      Licensed under the Apache License, Version 2.0 (the "License");
+**      you may not use this file except in compliance with the License.
+**      You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**      Unless required by applicable law or agreed to in writing, software
+**      distributed under the License is distributed on an "AS IS" BASIS,
+**      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**      See the License for the specific language governing permissions and
+**      limitations under the License.
+**
+** File: bcm2835_lib_internal.h
+**
+** Purpose:
+**  Internal (private) definitions shared between the source units
+**  of the BCM2835 Lib.
+**
+** Notes:
+**
+*************************************************************************/
+#ifndef _bcm2835_lib_internal_h_
+#define _bcm2835_lib_internal_h_
+
+/* Include all external/public definitions */
+#include "bcm2835_lib.h"
+
+/*************************************************************************
+** Type Definitions
+*************************************************************************/
+
+/**
+ * Locked DMA memory, see BCM2835_DMA_MemAlloc. Virt and Bus point to
+ * arrays of Pages elements owned by the user.
+ */
+typedef struct
+{
+    void     *Block;  /* page-aligned allocation */
+    int       Fd;     /* /dev/mem, for the uncached views */
+    uint32    Pages;
+    uint8_t **Virt;   /* uncached view of each page */
+    uint32_t *Bus;    /* bus address of each page */
+} BCM2835_DMA_Mem_t;
+
+/*************************************************************************
+** Function Declarations
+*************************************************************************/
+
+/**
+ * Monotonic time in microseconds, used for scheduling and statistics.
+ * Unlike bcm2835_st_read() this is also valid in debug mode and for
+ * non-root processes.
+ */
+uint64 BCM2835_LIB_GetTimeUs(void);
+
+/**
+ * Map the peripheral block of a bcm2835RegisterBase if it is not mapped
+ * yet, setting its register base pointer (bcm2835_spi0 ...).
+ * A block that failed to map is not retried until bcm2835_init.
+ * Returns 1 if the block is mapped, 0 otherwise.
+ */
+int BCM2835_LIB_MapRegion(uint8_t regbase);
+
+/**
+ * Create the OSAL resources of the I2C bus scheduler.
+ * Called once from BCM2835_LIB_Init.
+ */
+int32 BCM2835_I2C_SchedInit(void);
+
+/**
+ * Lock of the I2C bus scheduler of a controller, NULL if there is none.
+ */
+bcm2835_lock_t *BCM2835_I2C_SchedLock(uint8 Bus);
+
+/**
+ * Lock of an SPI controller (bcm2835SPIController), NULL if there is none.
+ */
+bcm2835_lock_t *BCM2835_SPI_DevLock(uint8 Controller);
+
+/**
+ * Create the OSAL resources of the SPI device handles.
+ * Called once from BCM2835_LIB_Init.
+ */
+int32 BCM2835_SPI_DevInit(void);
+
+/**
+ * Create the lock and epoll set of the GPIO event dispatcher.
+ * Called once from BCM2835_LIB_Init.
+ */
+int32 BCM2835_GPIO_EventInit(void);
+
+/**
+ * Create the lock of the bus trace and choose its time base.
+ * Called once from BCM2835_LIB_Init, after bcm2835_init.
+ */
+int32 BCM2835_TRACE_Init(void);
+
+/**
+ * Current time in the time base of the bus trace, in microseconds.
+ */
+uint32 BCM2835_TRACE_Now(void);
+
+/**
+ * Record a bus transaction that started at StartUs (BCM2835_TRACE_Now)
+ * and count it in the bus statistics, which is done even when the trace
+ * is disabled. Len is the number of bytes transferred; the register is the first
+ * byte of Tx and the data the first bytes of Rx, or of Tx if RxLen is 0.
+ */
+void BCM2835_TRACE_Record(uint8 Kind, uint8 Controller, uint8 Address, uint32 Len, const void *Tx, uint32 TxLen,
+                          const void *Rx, uint32 RxLen, uint32 StartUs, uint8 Status);
+
+/**
+ * Count a transaction of DurationUs with a device in the bus statistics.
+ * Status is 0 if it succeeded.
+ */
+void BCM2835_BUS_Account(uint8 Bus, uint8 Address, uint32 Len, uint32 DurationUs, uint8 Status);
+
+/**
+ * Count a wait for the lock of a bus controller in the bus statistics.
+ */
+void BCM2835_BUS_AccountWait(uint8 Bus, uint32 WaitUs, bool TimedOut);
+
+/**
+ * Simulated bus transaction: serve it from the replayed trace, filling
+ * Rx and waiting for the recorded duration, and record it.
+ * Returns the recorded status, BCM2835_I2C_REASON_OK if none matched.
+ */
+uint8 BCM2835_TRACE_Replay(uint8 Kind, uint8 Controller, uint8 Address, uint32 Len, const void *Tx, uint32 TxLen,
+                           void *Rx, uint32 RxLen);
+
+/**
+ * Run an SPI0 transaction on the DMA engine if DMA is enabled and its
+ * total length is in range. reverse is the table applied to every byte
+ * (NULL for MSB first).
+ * Returns 1 if the transaction was done, 0 if the caller must poll it,
+ * which includes a DMA transfer that failed or timed out.
+ */
+uint8_t BCM2835_SPI_DmaTransfer(const bcm2835_spi_seg_t *segs, uint32_t count, const uint8_t *reverse);
+
+/**
+ * Address of a register (BCM2835_DMA_CS ...) of a DMA channel.
+ */
+volatile uint32_t *BCM2835_DMA_Reg(uint8 Channel, uint32 Reg);
+
+/**
+ * Reset a DMA channel, stopping any transfer.
+ */
+void BCM2835_DMA_Reset(uint8 Channel);
+
+/**
+ * Set the global enable bit of a DMA channel and reset it.
+ */
+void BCM2835_DMA_Enable(uint8 Channel);
+
+/**
+ * Start a DMA channel on the control block at bus address CbBus.
+ */
+void BCM2835_DMA_Start(uint8 Channel, uint32_t CbBus);
+
+/**
+ * Allocate, zero and lock Pages pages of DMA memory and map them
+ * uncached. Mem->Virt and Mem->Bus must be set by the caller.
+ * Who prefixes the error messages.
+ * Returns 1 if successful, 0 otherwise (nothing is left allocated).
+ */
+int BCM2835_DMA_MemAlloc(BCM2835_DMA_Mem_t *Mem, uint32 Pages, const char *Who);
+
+/**
+ * Release memory from BCM2835_DMA_MemAlloc. Does nothing if none is
+ * allocated, including on a zeroed BCM2835_DMA_Mem_t.
+ */
+void BCM2835_DMA_MemFree(BCM2835_DMA_Mem_t *Mem);
+
+/**
+ * Page aligned allocation, see bcm2835_lib.c
+ */
+void *malloc_aligned(size_t size);
+
+#endif /* _bcm2835_lib_internal_h_ */
+
+/************************/
+/*  End of File Comment */
+/************************/
@@ -0,0 +1,305 @@
+/*************************************************************************
+**
+**      GSC-18128-1, "Core Flight Executive Version 6.7"
+**
+**      Copyright (c) 2006-2019 United States Government as represented by
+**      the Administrator of the National Aeronautics and Space Administration.
+**      All Rights Reserved.
+**
+**      Licensed under the Apache License, Version 2.0 (the "License");
+**      you may not use this file except in compliance with the License.
+**      You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**      Unless required by applicable law or agreed to in writing, software
+**      distributed under the License is distributed on an "AS IS" BASIS,
+**      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**      See the License for the specific language governing permissions and
+**      limitations under the License.
+**
+** File: bcm2835_lock.c
+**
+** Purpose:
+**  Spin-then-block bus lock on a priority-inheritance futex.
+**
+** Notes:
+**  The lock word follows the kernel PI futex protocol: 0 when free, the
+**  thread id of the owner when held, with FUTEX_WAITERS set by the kernel
+**  once a taker blocks. Taking and releasing without contention are then
+**  one compare-and-swap each; only a release that finds FUTEX_WAITERS
+**  enters the kernel, which hands the lock to the most urgent waiter.
+**  The timeout is an absolute CLOCK_MONOTONIC deadline passed to
+**  FUTEX_LOCK_PI2 (Linux 5.14). Older kernels only have FUTEX_LOCK_PI,
+**  whose deadline is on CLOCK_REALTIME, so there a step of the wall
+**  clock while a taker is blocked shortens or stretches its timeout.
+**
+**  The spin count adapts like the glibc adaptive mutex: a taker polls up
+**  to twice the recent average of polls that succeeded, plus a margin,
+**  so spinning stops being tried on a lock that is held for long. On a
+**  single CPU the owner cannot run while a taker spins, so takers block
+**  at once.
+**
+**  The statistics are updated with relaxed atomics, the acquisition and
+**  hold figures when the lock is released.
+**
+*************************************************************************/
+
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#include "bcm2835_lib_internal.h"
+
+/*************************************************************************
+** Macro Definitions
+*************************************************************************/
+
+#define BCM2835_LOCK_NS_PER_SEC 1000000000L
+
+#ifndef FUTEX_LOCK_PI2
+#define FUTEX_LOCK_PI2 13
+#endif
+
+/* Polls tried above twice the average */
+#define BCM2835_LOCK_SPIN_MARGIN 10
+
+/*************************************************************************
+** Local Data
+*************************************************************************/
+
+/* Kernel thread id of the caller, 0 until its first lock */
+static __thread uint32 BCM2835_LOCK_Tid;
+
+/* Online CPUs, 0 until the first contended lock */
+static int32 BCM2835_LOCK_Cpus;
+
+/* Set once the kernel has rejected FUTEX_LOCK_PI2 */
+static uint8 BCM2835_LOCK_NoPi2;
+
+/*************************************************************************
+** Local Functions
+*************************************************************************/
+
+static uint32 BCM2835_LOCK_Self(void)
+{
+    if (BCM2835_LOCK_Tid == 0)
+    {
+        BCM2835_LOCK_Tid = (uint32)syscall(SYS_gettid);
+    }
+
+    return BCM2835_LOCK_Tid;
+}
+
+static bool BCM2835_LOCK_Try(bcm2835_lock_t *lock, uint32 Tid)
+{
+    uint32 Free = 0;
+
+    return __atomic_compare_exchange_n(&lock->Word, &Free, Tid, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+}
+
+static void BCM2835_LOCK_Relax(void)
+{
+#if defined(__arm__) || defined(__aarch64__)
+    __asm__ __volatile__("yield" ::: "memory");
+#elif defined(__i386__) || defined(__x86_64__)
+    __builtin_ia32_pause();
+#endif
+}
+
+static void BCM2835_LOCK_Max(uint32 *Max, uint32 Value)
+{
+    uint32 Old = __atomic_load_n(Max, __ATOMIC_RELAXED);
+
+    while (Value > Old && !__atomic_compare_exchange_n(Max, &Old, Value, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    {
+    }
+}
+
+static uint32 BCM2835_LOCK_Take(uint32 *Counter, uint8 Reset)
+{
+    if (Reset)
+    {
+        return __atomic_exchange_n(Counter, 0, __ATOMIC_RELAXED);
+    }
+
+    return __atomic_load_n(Counter, __ATOMIC_RELAXED);
+}
+
+/* Polls the lock up to the adaptive spin count, true if it was taken */
+static bool BCM2835_LOCK_Spin(bcm2835_lock_t *lock, uint32 Tid)
+{
+    int32  Cpus  = __atomic_load_n(&BCM2835_LOCK_Cpus, __ATOMIC_RELAXED);
+    uint32 Spins = __atomic_load_n(&lock->Spins, __ATOMIC_RELAXED);
+    uint32 Limit = Spins * 2 + BCM2835_LOCK_SPIN_MARGIN;
+    uint32 Count;
+
+    if (Cpus == 0)
+    {
+        Cpus = (int32)sysconf(_SC_NPROCESSORS_ONLN);
+        __atomic_store_n(&BCM2835_LOCK_Cpus, Cpus, __ATOMIC_RELAXED);
+    }
+
+    if (Cpus == 1)
+    {
+        return false;
+    }
+
+    if (Limit > BCM2835_LOCK_SPIN_MAX)
+    {
+        Limit = BCM2835_LOCK_SPIN_MAX;
+    }
+
+    for (Count = 0; Count < Limit; Count++)
+    {
+        if (__atomic_load_n(&lock->Word, __ATOMIC_RELAXED) == 0 && BCM2835_LOCK_Try(lock, Tid))
+        {
+            __atomic_store_n(&lock->Spins, Spins + ((int32)(Count - Spins) / 8), __ATOMIC_RELAXED);
+            return true;
+        }
+        BCM2835_LOCK_Relax();
+    }
+
+    __atomic_store_n(&lock->Spins, Spins + ((int32)(Limit - Spins) / 8), __ATOMIC_RELAXED);
+    return false;
+}
+
+/* Absolute deadline TimeoutUs from now on Clock */
+static void BCM2835_LOCK_Deadline(struct timespec *Deadline, clockid_t Clock, int32 TimeoutUs)
+{
+    clock_gettime(Clock, Deadline);
+    Deadline->tv_sec += TimeoutUs / 1000000;
+    Deadline->tv_nsec += (long)(TimeoutUs % 1000000) * 1000;
+    if (Deadline->tv_nsec >= BCM2835_LOCK_NS_PER_SEC)
+    {
+        Deadline->tv_sec++;
+        Deadline->tv_nsec -= BCM2835_LOCK_NS_PER_SEC;
+    }
+}
+
+/* Blocks in the kernel until the lock is handed over or the timeout expires */
+static int32 BCM2835_LOCK_Block(bcm2835_lock_t *lock, int32 TimeoutUs)
+{
+    struct timespec  Deadline;
+    struct timespec *Timeout = NULL;
+    bool             Pi2     = !__atomic_load_n(&BCM2835_LOCK_NoPi2, __ATOMIC_RELAXED);
+    long             Rc;
+
+    if (TimeoutUs >= 0)
+    {
+        BCM2835_LOCK_Deadline(&Deadline, Pi2 ? CLOCK_MONOTONIC : CLOCK_REALTIME, TimeoutUs);
+        Timeout = &Deadline;
+    }
+
+    for (;;)
+    {
+        Rc = syscall(SYS_futex, &lock->Word, (Pi2 ? FUTEX_LOCK_PI2 : FUTEX_LOCK_PI) | FUTEX_PRIVATE_FLAG, 0, Timeout,
+                     NULL, 0);
+        if (Rc == 0)
+        {
+            return BCM2835_LOCK_OK;
+        }
+        if (errno == ETIMEDOUT)
+        {
+            return BCM2835_LOCK_ERR_TIMEOUT;
+        }
+        if (errno == ENOSYS && Pi2)
+        {
+            /* Kernel before 5.14: FUTEX_LOCK_PI, whose deadline can only be on CLOCK_REALTIME */
+            __atomic_store_n(&BCM2835_LOCK_NoPi2, 1, __ATOMIC_RELAXED);
+            Pi2 = false;
+            if (Timeout != NULL)
+            {
+                BCM2835_LOCK_Deadline(&Deadline, CLOCK_REALTIME, TimeoutUs);
+            }
+            continue;
+        }
+        if (errno != EINTR && errno != EAGAIN)
+        {
+            return BCM2835_LOCK_ERR_OS;
+        }
+    }
+}
+
+/*************************************************************************
+** Public Functions
+*************************************************************************/
+
+void bcm2835_lock_init(bcm2835_lock_t *lock)
+{
+    memset(lock, 0, sizeof(*lock));
+}
+
+int32_t bcm2835_lock_acquire(bcm2835_lock_t *lock, int32_t timeout_us)
+{
+    uint32 Tid = BCM2835_LOCK_Self();
+    uint64 StartUs;
+    uint32 WaitUs;
+    int32  Status = BCM2835_LOCK_OK;
+
+    if (BCM2835_LOCK_Try(lock, Tid))
+    {
+        lock->HoldStartUs = BCM2835_LIB_GetTimeUs();
+        return BCM2835_LOCK_OK;
+    }
+
+    StartUs = BCM2835_LIB_GetTimeUs();
+
+    if (timeout_us == 0)
+    {
+        Status = BCM2835_LOCK_ERR_TIMEOUT;
+    }
+    else if (!BCM2835_LOCK_Spin(lock, Tid))
+    {
+        Status = BCM2835_LOCK_Block(lock, timeout_us);
+    }
+
+    if (Status != BCM2835_LOCK_OK)
+    {
+        __atomic_fetch_add(&lock->Stats.Timeouts, 1, __ATOMIC_RELAXED);
+        return Status;
+    }
+
+    lock->HoldStartUs = BCM2835_LIB_GetTimeUs();
+    WaitUs            = (uint32)(lock->HoldStartUs - StartUs);
+
+    __atomic_fetch_add(&lock->Stats.Contended, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&lock->Stats.WaitTotalUs, WaitUs, __ATOMIC_RELAXED);
+    BCM2835_LOCK_Max(&lock->Stats.WaitMaxUs, WaitUs);
+
+    return BCM2835_LOCK_OK;
+}
+
+void bcm2835_lock_release(bcm2835_lock_t *lock)
+{
+    uint32 Tid    = BCM2835_LOCK_Self();
+    uint32 HoldUs = (uint32)(BCM2835_LIB_GetTimeUs() - lock->HoldStartUs);
+
+    __atomic_fetch_add(&lock->Stats.Acquisitions, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&lock->Stats.HoldTotalUs, HoldUs, __ATOMIC_RELAXED);
+    BCM2835_LOCK_Max(&lock->Stats.HoldMaxUs, HoldUs);
+
+    /* With FUTEX_WAITERS set the kernel picks the next owner */
+    if (!__atomic_compare_exchange_n(&lock->Word, &Tid, 0, false, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+    {
+        syscall(SYS_futex, &lock->Word, FUTEX_UNLOCK_PI | FUTEX_PRIVATE_FLAG, 0, NULL, NULL, 0);
+    }
+}
+
+void bcm2835_lock_get_stats(bcm2835_lock_t *lock, bcm2835_lock_stats_t *stats, uint8_t reset)
+{
+    stats->Acquisitions = BCM2835_LOCK_Take(&lock->Stats.Acquisitions, reset);
+    stats->Contended    = BCM2835_LOCK_Take(&lock->Stats.Contended, reset);
+    stats->Timeouts     = BCM2835_LOCK_Take(&lock->Stats.Timeouts, reset);
+    stats->WaitTotalUs  = BCM2835_LOCK_Take(&lock->Stats.WaitTotalUs, reset);
+    stats->WaitMaxUs    = BCM2835_LOCK_Take(&lock->Stats.WaitMaxUs, reset);
+    stats->HoldTotalUs  = BCM2835_LOCK_Take(&lock->Stats.HoldTotalUs, reset);
+    stats->HoldMaxUs    = BCM2835_LOCK_Take(&lock->Stats.HoldMaxUs, reset);
+}
+
+/************************/
+/*  End of File Comment */
+/************************/
@@ -0,0 +1,200 @@
+/*************************************************************************
+**
+**      GSC-18128-1, "Core Flight Executive Version 6.7"
+**
+**      Copyright (c) 2006-2019 United States Government as represented by
+**      the Administrator of the National Aeronautics and Space Administration.
+**      All Rights Reserved.
+**
+**      Licensed under the Apache License, Version 2.0 (the "License");
+**      you may not use this file except in compliance with the License.
+**      You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**      Unless required by applicable law or agreed to in writing, software
+**      distributed under the License is distributed on an "AS IS" BASIS,
+**      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**      See the License for the specific language governing permissions and
+**      limitations under the License.
+**
+** File: bcm2835_periodic.c
+**
+** Purpose:
+**  Periodic wakeup service with absolute deadlines.
+**
+** Notes:
+**  The sleep margin follows the measured overshoot of clock_nanosleep:
+**  it rises halfway to a larger overshoot at once and decays slowly
+**  towards smaller ones, so a single late wakeup makes the next ones spin
+**  a little longer rather than be late too.
+**
+*************************************************************************/
+
+#include <string.h>
+#include <time.h>
+
+#include "bcm2835_lib_internal.h"
+
+/*************************************************************************
+** Macro Definitions
+*************************************************************************/
+
+#define BCM2835_PERIODIC_NS_PER_SEC       1000000000ULL
+
+/* Sleep margin before the first calibration */
+#define BCM2835_PERIODIC_INITIAL_MARGIN_NS 50000
+
+/* Decay of the sleep margin towards a smaller overshoot, as a shift */
+#define BCM2835_PERIODIC_MARGIN_DECAY     4
+
+/*************************************************************************
+** Local Functions
+*************************************************************************/
+
+static uint64 BCM2835_PeriodicNowNs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ((uint64)ts.tv_sec * BCM2835_PERIODIC_NS_PER_SEC) + (uint64)ts.tv_nsec;
+}
+
+static void BCM2835_PeriodicSleepUntil(uint64 DeadlineNs)
+{
+    struct timespec ts;
+
+    ts.tv_sec  = DeadlineNs / BCM2835_PERIODIC_NS_PER_SEC;
+    ts.tv_nsec = DeadlineNs % BCM2835_PERIODIC_NS_PER_SEC;
+
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) != 0)
+    {
+        /* Interrupted by a signal, sleep again until the same deadline */
+    }
+}
+
+static void BCM2835_PeriodicCalibrate(bcm2835_periodic_t *p, uint64 OvershootNs)
+{
+    uint32 Margin = p->Stats.SleepMarginNs;
+
+    if (OvershootNs > Margin)
+    {
+        Margin += (uint32)((OvershootNs - Margin + 1) / 2);
+    }
+    else
+    {
+        Margin -= (uint32)((Margin - OvershootNs) >> BCM2835_PERIODIC_MARGIN_DECAY);
+    }
+
+    if (Margin > p->SpinMaxNs)
+    {
+        Margin = p->SpinMaxNs;
+    }
+
+    p->Stats.SleepMarginNs = Margin;
+}
+
+static void BCM2835_PeriodicRecord(bcm2835_periodic_t *p, uint64 LatenessNs)
+{
+    uint64 Us  = LatenessNs / 1000;
+    uint32 Bin = 0;
+
+    while (Us > 0 && Bin < BCM2835_PERIODIC_HIST_BINS - 1)
+    {
+        Us >>= 1;
+        Bin++;
+    }
+
+    p->Stats.Periods++;
+    p->Stats.Hist[Bin]++;
+    p->Stats.SumLatenessNs += LatenessNs;
+    if (LatenessNs > p->Stats.MaxLatenessNs)
+    {
+        p->Stats.MaxLatenessNs = (LatenessNs > 0xFFFFFFFFULL) ? 0xFFFFFFFF : (uint32)LatenessNs;
+    }
+}
+
+/*************************************************************************
+** Public Functions
+*************************************************************************/
+
+int bcm2835_periodic_init(bcm2835_periodic_t *p, uint32_t period_us)
+{
+    if (p == NULL || period_us == 0)
+    {
+        return 0;
+    }
+
+    memset(p, 0, sizeof(*p));
+    p->PeriodNs               = (uint64)period_us * 1000;
+    p->SpinMaxNs              = BCM2835_PERIODIC_SPIN_MAX_NS;
+    p->Stats.SleepMarginNs    = BCM2835_PERIODIC_INITIAL_MARGIN_NS;
+    p->NextNs                 = BCM2835_PeriodicNowNs() + p->PeriodNs;
+
+    return 1;
+}
+
+uint32_t bcm2835_periodic_wait(bcm2835_periodic_t *p)
+{
+    uint64 Deadline = p->NextNs;
+    uint64 WakeTarget;
+    uint64 Now;
+    uint32 Skipped = 0;
+
+    Now = BCM2835_PeriodicNowNs();
+
+    /* More than a period late: skip the missed deadlines instead of bursting */
+    if (Now >= Deadline + p->PeriodNs)
+    {
+        Skipped = (uint32)((Now - Deadline) / p->PeriodNs);
+        p->NextNs += (uint64)(Skipped + 1) * p->PeriodNs;
+        p->Stats.Overruns += Skipped;
+        BCM2835_PeriodicRecord(p, Now - Deadline);
+        return Skipped;
+    }
+
+    if (Now + p->Stats.SleepMarginNs < Deadline)
+    {
+        WakeTarget = Deadline - p->Stats.SleepMarginNs;
+        BCM2835_PeriodicSleepUntil(WakeTarget);
+
+        Now = BCM2835_PeriodicNowNs();
+        BCM2835_PeriodicCalibrate(p, Now - WakeTarget);
+    }
+
+    /* Bounded final spin up to the deadline */
+    while (Now < Deadline && Deadline - Now <= p->SpinMaxNs)
+    {
+        Now = BCM2835_PeriodicNowNs();
+    }
+
+    /* Only reached if the margin was larger than the spin bound allows */
+    if (Now < Deadline)
+    {
+        BCM2835_PeriodicSleepUntil(Deadline);
+        Now = BCM2835_PeriodicNowNs();
+    }
+
+    BCM2835_PeriodicRecord(p, Now - Deadline);
+    p->NextNs += p->PeriodNs;
+
+    return Skipped;
+}
+
+void bcm2835_periodic_get_stats(const bcm2835_periodic_t *p, bcm2835_periodic_stats_t *stats)
+{
+    *stats = p->Stats;
+}
+
+void bcm2835_periodic_reset_stats(bcm2835_periodic_t *p)
+{
+    uint32 Margin = p->Stats.SleepMarginNs;
+
+    memset(&p->Stats, 0, sizeof(p->Stats));
+    p->Stats.SleepMarginNs = Margin;
+}
+
+/************************/
+/*  End of File Comment */
+/************************/
@@ -0,0 +1,327 @@
+/*************************************************************************
+**
+**      GSC-18128-1, "Core Flight Executive Version 6.7"
+**
+**      Copyright (c) 2006-2019 United States Government as represented by
+**      the Administrator of the National Aeronautics and Space Administration.
+**      All Rights Reserved.
+**
+**      Licensed under the Apache License, Version 2.0 (the "License");
+**      you may not use this file except in compliance with the License.
+**      You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**      Unless required by applicable law or agreed to in writing, software
+**      distributed under the License is distributed on an "AS IS" BASIS,
+**      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**      See the License for the specific language governing permissions and
+**      limitations under the License.
+**
+** File: bcm2835_pwm_dma.c
+**
+** Purpose:
+**  DMA-fed PWM sample streaming.
+**
+** Notes:
+**  The ring buffer is one control block per page, the last one linked
+**  back to the first, so the DMA channel loops over it for ever at the
+**  pace of the PWM FIFO DREQ. The play position is read back from the
+**  channel's SOURCE_AD. Samples the DMA has passed are overwritten with
+**  the last written one, so a late producer holds the output instead of
+**  replaying an old lap of the ring.
+**  Layout: page 0 holds the control blocks, then the ring pages.
+**
+*************************************************************************/
+
+#include <string.h>
+#include <sys/mman.h>
+
+#include "bcm2835_lib_internal.h"
+
+/*************************************************************************
+** Macro Definitions
+*************************************************************************/
+
+#define BCM2835_PWM_STREAM_PAGE_SAMPLES (BCM2835_PAGE_SIZE / sizeof(uint32_t))
+#define BCM2835_PWM_STREAM_SAMPLES      (BCM2835_PWM_STREAM_RING_PAGES * BCM2835_PWM_STREAM_PAGE_SAMPLES)
+#define BCM2835_PWM_STREAM_PAGES        (1 + BCM2835_PWM_STREAM_RING_PAGES)
+
+/* PWM FIFO as seen by the DMA engine */
+#define BCM2835_PWM_STREAM_FIFO_BUS     (BCM2835_PERI_BUS_BASE + BCM2835_GPIO_PWM + BCM2835_PWM_FIF1 * 4)
+
+/* PWM FIFO levels of the DREQ and panic signals (the FIFO is 8 words deep) */
+#define BCM2835_PWM_STREAM_DREQ_LEVEL   3
+#define BCM2835_PWM_STREAM_PANIC_LEVEL  7
+
+/*************************************************************************
+** Type Definitions
+*************************************************************************/
+
+typedef struct
+{
+    bool     Ready;
+    uint8    Channel;
+    uint8    DmaChannel;
+
+    uint32   Wr;       /* Next sample to write */
+    uint32   LastRd;   /* Play position at the last update */
+    uint32   Hold;     /* Last sample written */
+    bcm2835_pwm_stream_stats_t Stats;
+
+    BCM2835_DMA_Mem_t Mem;
+
+    uint8_t *Virt[BCM2835_PWM_STREAM_PAGES];
+    uint32_t Bus[BCM2835_PWM_STREAM_PAGES];
+} BCM2835_PWM_Stream_t;
+
+/*************************************************************************
+** Local Data
+*************************************************************************/
+
+static BCM2835_PWM_Stream_t BCM2835_PWM_Stream;
+
+/*************************************************************************
+** Local Functions
+*************************************************************************/
+
+static uint32_t *BCM2835_PWM_StreamSample(uint32 Index)
+{
+    return (uint32_t *)BCM2835_PWM_Stream.Virt[1 + Index / BCM2835_PWM_STREAM_PAGE_SAMPLES] +
+           Index % BCM2835_PWM_STREAM_PAGE_SAMPLES;
+}
+
+/* Ring index the DMA reads next */
+static uint32 BCM2835_PWM_StreamPlayPos(void)
+{
+    uint32_t Src  = bcm2835_peri_read(BCM2835_DMA_Reg(BCM2835_PWM_Stream.DmaChannel, BCM2835_DMA_SOURCE_AD));
+    uint32_t Page = Src & ~(uint32_t)(BCM2835_PAGE_SIZE - 1);
+    uint32   i;
+
+    for (i = 0; i < BCM2835_PWM_STREAM_RING_PAGES; i++)
+    {
+        if (BCM2835_PWM_Stream.Bus[1 + i] == Page)
+        {
+            return i * BCM2835_PWM_STREAM_PAGE_SAMPLES + (Src - Page) / sizeof(uint32_t);
+        }
+    }
+
+    /* Between two control blocks */
+    return BCM2835_PWM_Stream.LastRd;
+}
+
+/* Accounts for the samples played since the last call */
+static void BCM2835_PWM_StreamUpdate(void)
+{
+    BCM2835_PWM_Stream_t *S  = &BCM2835_PWM_Stream;
+    uint32                Rd = BCM2835_PWM_StreamPlayPos();
+    uint32                Played;
+
+    Played = (Rd + BCM2835_PWM_STREAM_SAMPLES - S->LastRd) % BCM2835_PWM_STREAM_SAMPLES;
+
+    /* Hold the last sample in the slots already played */
+    while (S->LastRd != Rd)
+    {
+        *BCM2835_PWM_StreamSample(S->LastRd) = S->Hold;
+        S->LastRd = (S->LastRd + 1) % BCM2835_PWM_STREAM_SAMPLES;
+    }
+
+    if (Played > S->Stats.Queued)
+    {
+        if (S->Stats.Queued > 0)
+        {
+            S->Stats.Underruns++;
+        }
+        S->Stats.Queued = 0;
+        S->Wr           = Rd;
+    }
+    else
+    {
+        S->Stats.Queued -= Played;
+    }
+}
+
+static uint32 BCM2835_PWM_StreamFree(void)
+{
+    uint32 Used = BCM2835_PWM_Stream.Stats.Queued + BCM2835_PWM_STREAM_GUARD;
+
+    return (Used >= BCM2835_PWM_STREAM_SAMPLES) ? 0 : BCM2835_PWM_STREAM_SAMPLES - Used;
+}
+
+/*************************************************************************
+** Public Functions
+*************************************************************************/
+
+int bcm2835_pwm_stream_begin(uint8_t channel, uint8_t dma_channel, uint32_t divisor, uint32_t range, uint32_t idle)
+{
+    BCM2835_PWM_Stream_t *S = &BCM2835_PWM_Stream;
+    bcm2835_dma_cb_t     *Cbs;
+    uint32_t              Control;
+    uint32                i;
+
+    if (BCM2835_DEBUG || !BCM2835_LIB_MapRegion(BCM2835_REGBASE_DMA) || !BCM2835_LIB_MapRegion(BCM2835_REGBASE_PWM) ||
+        !BCM2835_LIB_MapRegion(BCM2835_REGBASE_CLK))
+    {
+        return 0; /* bcm2835_init() failed, or not root */
+    }
+
+    if (channel > 1 || dma_channel >= BCM2835_DMA_CHANNELS || range == 0)
+    {
+        return 0;
+    }
+
+    bcm2835_pwm_stream_end();
+
+    S->Mem.Virt = S->Virt;
+    S->Mem.Bus  = S->Bus;
+    if (!BCM2835_DMA_MemAlloc(&S->Mem, BCM2835_PWM_STREAM_PAGES, "bcm2835_pwm_stream_begin"))
+    {
+        return 0;
+    }
+
+    S->Channel    = channel;
+    S->DmaChannel = dma_channel;
+    S->Wr         = 0;
+    S->LastRd     = 0;
+    S->Hold       = idle;
+    memset(&S->Stats, 0, sizeof(S->Stats));
+
+    for (i = 0; i < BCM2835_PWM_STREAM_SAMPLES; i++)
+    {
+        *BCM2835_PWM_StreamSample(i) = idle;
+    }
+
+    Cbs = (bcm2835_dma_cb_t *)S->Virt[0];
+    for (i = 0; i < BCM2835_PWM_STREAM_RING_PAGES; i++)
+    {
+        Cbs[i].ti        = BCM2835_DMA_TI_PERMAP(BCM2835_DMA_DREQ_PWM) | BCM2835_DMA_TI_DEST_DREQ |
+                           BCM2835_DMA_TI_SRC_INC | BCM2835_DMA_TI_WAIT_RESP | BCM2835_DMA_TI_NO_WIDE_BURSTS;
+        Cbs[i].source_ad = S->Bus[1 + i];
+        Cbs[i].dest_ad   = BCM2835_PWM_STREAM_FIFO_BUS;
+        Cbs[i].txfr_len  = BCM2835_PAGE_SIZE;
+        Cbs[i].stride    = 0;
+        Cbs[i].nextconbk = S->Bus[0] + ((i + 1) % BCM2835_PWM_STREAM_RING_PAGES) * sizeof(bcm2835_dma_cb_t);
+    }
+
+    bcm2835_pwm_set_clock(divisor);
+    bcm2835_pwm_set_range(channel, range);
+
+    /* Clear the FIFO and switch the channel to it, leaving the other channel alone */
+    Control = bcm2835_peri_read(bcm2835_pwm + BCM2835_PWM_CONTROL);
+    if (channel == 0)
+    {
+        Control = (Control & ~(BCM2835_PWM0_SERIAL | BCM2835_PWM0_REPEATFF)) |
+                  BCM2835_PWM0_MS_MODE | BCM2835_PWM0_USEFIFO | BCM2835_PWM0_ENABLE;
+    }
+    else
+    {
+        Control = (Control & ~(BCM2835_PWM1_SERIAL | BCM2835_PWM1_REPEATFF)) |
+                  BCM2835_PWM1_MS_MODE | BCM2835_PWM1_USEFIFO | BCM2835_PWM1_ENABLE;
+    }
+    bcm2835_peri_write(bcm2835_pwm + BCM2835_PWM_CONTROL, Control | BCM2835_PWM_CLEAR_FIFO);
+    bcm2835_peri_write(bcm2835_pwm + BCM2835_PWM_DMAC,
+                       BCM2835_PWM_DMAC_ENAB | BCM2835_PWM_DMAC_PANIC(BCM2835_PWM_STREAM_PANIC_LEVEL) |
+                           BCM2835_PWM_DMAC_DREQ(BCM2835_PWM_STREAM_DREQ_LEVEL));
+
+    /* Control blocks and samples must be in memory before the engine starts */
+    bcm2835_memory_barrier();
+    BCM2835_DMA_Enable(dma_channel);
+    BCM2835_DMA_Start(dma_channel, S->Bus[0]);
+    bcm2835_memory_barrier();
+
+    S->Ready = true;
+
+    return 1;
+}
+
+uint32_t bcm2835_pwm_stream_write(const uint32_t *samples, uint32_t count)
+{
+    BCM2835_PWM_Stream_t *S = &BCM2835_PWM_Stream;
+    uint32                Accepted;
+    uint32                Chunk;
+    uint32                Done = 0;
+
+    if (!S->Ready || samples == NULL)
+    {
+        return 0;
+    }
+
+    BCM2835_PWM_StreamUpdate();
+
+    Accepted = BCM2835_PWM_StreamFree();
+    if (Accepted > count)
+    {
+        Accepted = count;
+    }
+
+    /* Copy page by page, the ring pages are not contiguous */
+    while (Done < Accepted)
+    {
+        Chunk = BCM2835_PWM_STREAM_PAGE_SAMPLES - S->Wr % BCM2835_PWM_STREAM_PAGE_SAMPLES;
+        if (Chunk > Accepted - Done)
+        {
+            Chunk = Accepted - Done;
+        }
+
+        memcpy(BCM2835_PWM_StreamSample(S->Wr), samples + Done, Chunk * sizeof(uint32_t));
+
+        S->Wr = (S->Wr + Chunk) % BCM2835_PWM_STREAM_SAMPLES;
+        Done += Chunk;
+    }
+
+    if (Accepted > 0)
+    {
+        S->Hold = samples[Accepted - 1];
+        S->Stats.Queued  += Accepted;
+        S->Stats.Samples += Accepted;
+    }
+
+    return Accepted;
+}
+
+uint32_t bcm2835_pwm_stream_space(void)
+{
+    if (!BCM2835_PWM_Stream.Ready)
+    {
+        return 0;
+    }
+
+    BCM2835_PWM_StreamUpdate();
+
+    return BCM2835_PWM_StreamFree();
+}
+
+void bcm2835_pwm_stream_get_stats(bcm2835_pwm_stream_stats_t *stats)
+{
+    if (BCM2835_PWM_Stream.Ready)
+    {
+        BCM2835_PWM_StreamUpdate();
+    }
+
+    *stats = BCM2835_PWM_Stream.Stats;
+}
+
+void bcm2835_pwm_stream_end(void)
+{
+    BCM2835_PWM_Stream_t *S = &BCM2835_PWM_Stream;
+    uint32_t              Control;
+
+    if (S->Ready)
+    {
+        BCM2835_DMA_Reset(S->DmaChannel);
+        bcm2835_peri_write(bcm2835_pwm + BCM2835_PWM_DMAC, 0);
+
+        /* Back to the data register, which still holds the value set before streaming */
+        Control = bcm2835_peri_read(bcm2835_pwm + BCM2835_PWM_CONTROL);
+        Control &= ~((S->Channel == 0) ? BCM2835_PWM0_USEFIFO : BCM2835_PWM1_USEFIFO);
+        bcm2835_peri_write(bcm2835_pwm + BCM2835_PWM_CONTROL, Control);
+
+        S->Ready = false;
+    }
+
+    BCM2835_DMA_MemFree(&S->Mem);
+}
+
+/************************/
+/*  End of File Comment */
+/************************/
@@ -0,0 +1,91 @@
+/*************************************************************************
+**
+**      GSC-18128-1, "Core Flight Executive Version 6.7"
+**
+**      Copyright (c) 2006-2019 United States Government as represented by
+**      the Administrator of the National Aeronautics and Space Administration.
+**      All Rights Reserved.
+**
+**      Licensed under the Apache License, Version 2.0 (the "License");
+**      you may not use this file except in compliance with the License.
+**      You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**      Unless required by applicable law or agreed to in writing, software
+**      distributed under the License is distributed on an "AS IS" BASIS,
+**      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**      See the License for the specific language governing permissions and
+**      limitations under the License.
+**
+** File: bcm2835_sb_pool.c
+**
+** Purpose:
+**  Software Bus buffers allocated ahead for packets built in place.
+**
+** Notes:
+**  SB frees a transmitted buffer once it is delivered, so each packet
+**  still costs one allocation. The pool only moves it away from the
+**  start of the next packet and rides out short SB memory shortages.
+**
+*************************************************************************/
+
+#include <string.h>
+
+#include "bcm2835_lib_internal.h"
+
+/*************************************************************************
+** Public Functions
+*************************************************************************/
+
+int bcm2835_sb_pool_init(bcm2835_sb_pool_t *pool, size_t size, uint16_t depth)
+{
+    if (pool == NULL || size == 0 || depth == 0 || depth > BCM2835_SB_POOL_MAX)
+    {
+        return 0;
+    }
+
+    memset(pool, 0, sizeof(*pool));
+    pool->Size  = size;
+    pool->Depth = depth;
+
+    return 1;
+}
+
+void bcm2835_sb_pool_fill(bcm2835_sb_pool_t *pool)
+{
+    CFE_SB_Buffer_t *Buf;
+
+    while (pool->Count < pool->Depth)
+    {
+        Buf = CFE_SB_AllocateMessageBuffer(pool->Size);
+        if (Buf == NULL)
+        {
+            break;
+        }
+
+        pool->Buf[pool->Count++] = Buf;
+    }
+}
+
+CFE_SB_Buffer_t *bcm2835_sb_pool_get(bcm2835_sb_pool_t *pool)
+{
+    if (pool->Count == 0)
+    {
+        return CFE_SB_AllocateMessageBuffer(pool->Size);
+    }
+
+    return pool->Buf[--pool->Count];
+}
+
+void bcm2835_sb_pool_drain(bcm2835_sb_pool_t *pool)
+{
+    while (pool->Count > 0)
+    {
+        CFE_SB_ReleaseMessageBuffer(pool->Buf[--pool->Count]);
+    }
+}
+
+/************************/
+/*  End of File Comment */
+/************************/
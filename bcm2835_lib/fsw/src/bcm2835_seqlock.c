@@ -0,0 +1,85 @@
+/*************************************************************************
+**
+**      GSC-18128-1, "Core Flight Executive Version 6.7"
+**
+**      Copyright (c) 2006-2019 United States Government as represented by
+**      the Administrator of the National Aeronautics and Space Administration.
+**      All Rights Reserved.
+**
+**      Licensed under the Apache License, Version 2.0 (the "License");
+**      you may not use this file except in compliance with the License.
+**      You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**      Unless required by applicable law or agreed to in writing, software
+**      distributed under the License is distributed on an "AS IS" BASIS,
+**      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**      See the License for the specific language governing permissions and
+**      limitations under the License.
+**
+** File: bcm2835_seqlock.c
+**
+** Purpose:
+**  Single-writer sequence lock of a latest-value cache.
+**
+** Notes:
+**  The writer makes the sequence odd, copies the value and makes it even
+**  again. A reader keeps its copy only if it saw the same even sequence
+**  before and after it, so a copy overlapping a write is never used.
+**
+*************************************************************************/
+
+#include <string.h>
+
+#include "bcm2835_lib_internal.h"
+
+/*************************************************************************
+** Public Functions
+*************************************************************************/
+
+void bcm2835_seqlock_init(bcm2835_seqlock_t *lock)
+{
+    __atomic_store_n(&lock->Seq, 0, __ATOMIC_RELAXED);
+}
+
+void bcm2835_seqlock_write(bcm2835_seqlock_t *lock, void *value, const void *src, uint32_t size)
+{
+    uint32 Seq = __atomic_load_n(&lock->Seq, __ATOMIC_RELAXED);
+
+    __atomic_store_n(&lock->Seq, Seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    memcpy(value, src, size);
+
+    __atomic_store_n(&lock->Seq, Seq + 2, __ATOMIC_RELEASE);
+}
+
+int bcm2835_seqlock_read(const bcm2835_seqlock_t *lock, const void *value, void *dst, uint32_t size, uint32_t tries)
+{
+    uint32 Seq;
+    uint32 Try;
+
+    for (Try = 0; Try < tries; Try++)
+    {
+        Seq = __atomic_load_n(&lock->Seq, __ATOMIC_ACQUIRE);
+        if (Seq & 1)
+        {
+            continue;
+        }
+
+        memcpy(dst, value, size);
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&lock->Seq, __ATOMIC_RELAXED) == Seq)
+        {
+            return Seq != 0;
+        }
+    }
+
+    return 0;
+}
+
+/************************/
+/*  End of File Comment */
+/************************/
@@ -0,0 +1,436 @@
+/*************************************************************************
+**
+**      GSC-18128-1, "Core Flight Executive Version 6.7"
+**
+**      Copyright (c) 2006-2019 United States Government as represented by
+**      the Administrator of the National Aeronautics and Space Administration.
+**      All Rights Reserved.
+**
+**      Licensed under the Apache License, Version 2.0 (the "License");
+**      you may not use this file except in compliance with the License.
+**      You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**      Unless required by applicable law or agreed to in writing, software
+**      distributed under the License is distributed on an "AS IS" BASIS,
+**      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**      See the License for the specific language governing permissions and
+**      limitations under the License.
+**
+** File: bcm2835_spi_dev.c
+**
+** Purpose:
+**  Per-controller SPI device handles, locks and optional worker tasks.
+**
+** Notes:
+**  The lock of a controller is a bcm2835_lock_t, which can be taken
+**  with a timeout and lends the priority of a blocked caller to the
+**  owner. The settings last applied to each controller
+**  are cached, so a device that owns the controller alone only pays for
+**  the register writes on its first transaction.
+**  A worker task takes request pointers from its controller's queue and
+**  runs them through the same locked path as a direct transaction.
+**
+*************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "bcm2835_lib_internal.h"
+
+/*************************************************************************
+** Macro Definitions
+*************************************************************************/
+
+/* Longest timeout in ms that fits the microsecond timeout of bcm2835_lock_acquire */
+#define BCM2835_SPI_MAX_TIMEOUT_MS (0x7FFFFFFF / 1000)
+
+/*************************************************************************
+** Type Definitions
+*************************************************************************/
+
+typedef struct
+{
+    bool           Initialized;
+    bcm2835_lock_t Lock;
+
+    bool                 Applied;  /* Settings below are in the registers */
+    bcm2835_spi_device_t Settings;
+
+    bool            WorkerRunning;
+    osal_id_t       Queue;
+    CFE_ES_TaskId_t WorkerId;
+
+    bcm2835_spi_stats_t Stats;
+    uint32              LockTimeouts; /* Not yet in Stats, counted without the lock */
+} BCM2835_SPI_Ctrl_t;
+
+/*************************************************************************
+** Local Data
+*************************************************************************/
+
+static BCM2835_SPI_Ctrl_t BCM2835_SPI_Ctrl[BCM2835_SPI_CTRL_COUNT];
+
+/*************************************************************************
+** Local Functions
+*************************************************************************/
+
+/* Applies the device settings to its controller, called with the lock held */
+static void BCM2835_SPI_Apply(BCM2835_SPI_Ctrl_t *Ctrl, const bcm2835_spi_device_t *dev)
+{
+    if (Ctrl->Applied && Ctrl->Settings.chip_select == dev->chip_select && Ctrl->Settings.mode == dev->mode &&
+        Ctrl->Settings.bit_order == dev->bit_order && Ctrl->Settings.speed_hz == dev->speed_hz)
+    {
+        return;
+    }
+
+    if (dev->controller == BCM2835_SPI_CTRL_SPI0)
+    {
+        bcm2835_spi_chipSelect(dev->chip_select);
+        bcm2835_spi_setDataMode(dev->mode);
+        bcm2835_spi_setBitOrder(dev->bit_order);
+        bcm2835_spi_set_speed_hz(dev->speed_hz);
+    }
+    else
+    {
+        bcm2835_aux_spi_setClockDivider(bcm2835_aux_spi_CalcClockDivider(dev->speed_hz));
+    }
+
+    Ctrl->Settings = *dev;
+    Ctrl->Applied  = true;
+}
+
+/* The AUX controller is set up for CE2, mode 0 and MSB first only */
+static bool BCM2835_SPI_DevSupported(const bcm2835_spi_device_t *dev)
+{
+    if (dev->controller == BCM2835_SPI_CTRL_SPI0)
+    {
+        return true;
+    }
+
+    return dev->chip_select == BCM2835_SPI_CS2 && dev->mode == BCM2835_SPI_MODE0 &&
+           dev->bit_order == BCM2835_SPI_BIT_ORDER_MSBFIRST;
+}
+
+/* Folds the timeouts counted without the lock into the stats, called with the lock held */
+static void BCM2835_SPI_FoldTimeouts(BCM2835_SPI_Ctrl_t *Ctrl)
+{
+    Ctrl->Stats.Timeouts += __atomic_exchange_n(&Ctrl->LockTimeouts, 0, __ATOMIC_RELAXED);
+}
+
+/* Controller of the bus statistics */
+static uint8 BCM2835_SPI_DevBus(const bcm2835_spi_device_t *dev)
+{
+    return (dev->controller == BCM2835_SPI_CTRL_SPI0) ? BCM2835_BUS_SPI0 : BCM2835_BUS_AUX_SPI;
+}
+
+static int32_t BCM2835_SPI_Run(const bcm2835_spi_device_t *dev, const bcm2835_spi_seg_t *segs, uint32_t count,
+                               int32_t timeout_ms)
+{
+    BCM2835_SPI_Ctrl_t *Ctrl;
+    int32               LockStatus;
+    uint64              StartUs;
+    uint64              GrantUs;
+    uint32              Bytes = 0;
+    uint32              i;
+
+    if (dev == NULL || dev->controller >= BCM2835_SPI_CTRL_COUNT || !BCM2835_SPI_DevSupported(dev) ||
+        (segs == NULL && count > 0))
+    {
+        return BCM2835_SPI_ERR_INVALID;
+    }
+
+    Ctrl = &BCM2835_SPI_Ctrl[dev->controller];
+    if (!Ctrl->Initialized)
+    {
+        return BCM2835_SPI_ERR_INVALID;
+    }
+
+    StartUs = BCM2835_LIB_GetTimeUs();
+
+    if (timeout_ms < 0 || timeout_ms > BCM2835_SPI_MAX_TIMEOUT_MS)
+    {
+        LockStatus = bcm2835_lock_acquire(&Ctrl->Lock, BCM2835_LOCK_PEND_FOREVER);
+    }
+    else
+    {
+        LockStatus = bcm2835_lock_acquire(&Ctrl->Lock, timeout_ms * 1000);
+    }
+
+    if (LockStatus != BCM2835_LOCK_OK)
+    {
+        /* The lock is not held here, the count goes into the stats the next time it is */
+        __atomic_fetch_add(&Ctrl->LockTimeouts, 1, __ATOMIC_RELAXED);
+        BCM2835_BUS_AccountWait(BCM2835_SPI_DevBus(dev), (uint32)(BCM2835_LIB_GetTimeUs() - StartUs), true);
+        return (LockStatus == BCM2835_LOCK_ERR_TIMEOUT) ? BCM2835_SPI_ERR_TIMEOUT : BCM2835_SPI_ERR_OS;
+    }
+
+    GrantUs = BCM2835_LIB_GetTimeUs();
+    BCM2835_BUS_AccountWait(BCM2835_SPI_DevBus(dev), (uint32)(GrantUs - StartUs), false);
+
+    BCM2835_SPI_FoldTimeouts(Ctrl);
+    BCM2835_SPI_Apply(Ctrl, dev);
+
+    if (dev->controller == BCM2835_SPI_CTRL_SPI0)
+    {
+        bcm2835_spi_transfer_segments(segs, count);
+    }
+    else
+    {
+        bcm2835_aux_spi_transfer_segments(segs, count);
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        Bytes += segs[i].len;
+    }
+
+    Ctrl->Stats.Transactions++;
+    Ctrl->Stats.Bytes += Bytes;
+    Ctrl->Stats.BusTimeUs += BCM2835_LIB_GetTimeUs() - GrantUs;
+    if (GrantUs - StartUs > Ctrl->Stats.MaxWaitUs)
+    {
+        Ctrl->Stats.MaxWaitUs = (uint32)(GrantUs - StartUs);
+    }
+
+    bcm2835_lock_release(&Ctrl->Lock);
+
+    return BCM2835_SPI_OK;
+}
+
+static void BCM2835_SPI_WorkerLoop(uint8 Controller)
+{
+    BCM2835_SPI_Ctrl_t    *Ctrl = &BCM2835_SPI_Ctrl[Controller];
+    bcm2835_spi_request_t *Req;
+    size_t                 Copied;
+
+    if (CFE_ES_RegisterChildTask() != CFE_SUCCESS)
+    {
+        Ctrl->WorkerRunning = false;
+        return;
+    }
+
+    while (OS_QueueGet(Ctrl->Queue, &Req, sizeof(Req), &Copied, OS_PEND) == OS_SUCCESS)
+    {
+        if (Copied != sizeof(Req) || Req == NULL)
+        {
+            continue;
+        }
+
+        Req->result = BCM2835_SPI_Run(Req->dev, Req->segs, Req->count, BCM2835_SPI_PEND_FOREVER);
+        OS_BinSemGive(Req->done);
+    }
+
+    Ctrl->WorkerRunning = false;
+    CFE_ES_ExitChildTask();
+}
+
+static void BCM2835_SPI_Worker0(void)
+{
+    BCM2835_SPI_WorkerLoop(BCM2835_SPI_CTRL_SPI0);
+}
+
+static void BCM2835_SPI_Worker1(void)
+{
+    BCM2835_SPI_WorkerLoop(BCM2835_SPI_CTRL_AUX);
+}
+
+/*************************************************************************
+** Internal Functions
+*************************************************************************/
+
+int32 BCM2835_SPI_DevInit(void)
+{
+    uint32 Controller;
+
+    memset(BCM2835_SPI_Ctrl, 0, sizeof(BCM2835_SPI_Ctrl));
+
+    for (Controller = 0; Controller < BCM2835_SPI_CTRL_COUNT; Controller++)
+    {
+        bcm2835_lock_init(&BCM2835_SPI_Ctrl[Controller].Lock);
+        BCM2835_SPI_Ctrl[Controller].Initialized = true;
+    }
+
+    return CFE_SUCCESS;
+}
+
+bcm2835_lock_t *BCM2835_SPI_DevLock(uint8 Controller)
+{
+    if (Controller >= BCM2835_SPI_CTRL_COUNT || !BCM2835_SPI_Ctrl[Controller].Initialized)
+    {
+        return NULL;
+    }
+
+    return &BCM2835_SPI_Ctrl[Controller].Lock;
+}
+
+/*************************************************************************
+** Public Functions
+*************************************************************************/
+
+int32_t bcm2835_spi_device_init(bcm2835_spi_device_t *dev, uint8_t controller, uint8_t chip_select, uint8_t mode,
+                                uint32_t speed_hz)
+{
+    if (dev == NULL || controller >= BCM2835_SPI_CTRL_COUNT)
+    {
+        return BCM2835_SPI_ERR_INVALID;
+    }
+
+    dev->controller  = controller;
+    dev->chip_select = chip_select;
+    dev->mode        = mode;
+    dev->bit_order   = BCM2835_SPI_BIT_ORDER_MSBFIRST;
+    dev->speed_hz    = speed_hz;
+
+    return BCM2835_SPI_DevSupported(dev) ? BCM2835_SPI_OK : BCM2835_SPI_ERR_INVALID;
+}
+
+int32_t bcm2835_spi_device_transfer(const bcm2835_spi_device_t *dev, const bcm2835_spi_seg_t *segs, uint32_t count,
+                                    int32_t timeout_ms)
+{
+    return BCM2835_SPI_Run(dev, segs, count, timeout_ms);
+}
+
+int32_t bcm2835_spi_worker_start(uint8_t controller, uint32_t priority)
+{
+    static void (*const Entry[BCM2835_SPI_CTRL_COUNT])(void) = {BCM2835_SPI_Worker0, BCM2835_SPI_Worker1};
+
+    BCM2835_SPI_Ctrl_t *Ctrl;
+    char                Name[OS_MAX_API_NAME];
+
+    if (controller >= BCM2835_SPI_CTRL_COUNT || !BCM2835_SPI_Ctrl[controller].Initialized)
+    {
+        return BCM2835_SPI_ERR_INVALID;
+    }
+
+    Ctrl = &BCM2835_SPI_Ctrl[controller];
+    if (Ctrl->WorkerRunning)
+    {
+        return BCM2835_SPI_OK;
+    }
+
+    if (Ctrl->Queue == OS_OBJECT_ID_UNDEFINED)
+    {
+        snprintf(Name, sizeof(Name), "spi_queue_%u", (unsigned int)controller);
+        if (OS_QueueCreate(&Ctrl->Queue, Name, BCM2835_SPI_WORKER_QUEUE_DEPTH, sizeof(bcm2835_spi_request_t *), 0) !=
+            OS_SUCCESS)
+        {
+            Ctrl->Queue = OS_OBJECT_ID_UNDEFINED;
+            return BCM2835_SPI_ERR_OS;
+        }
+    }
+
+    Ctrl->WorkerRunning = true;
+
+    snprintf(Name, sizeof(Name), "SPI_WORKER_%u", (unsigned int)controller);
+    if (CFE_ES_CreateChildTask(&Ctrl->WorkerId, Name, Entry[controller], CFE_ES_TASK_STACK_ALLOCATE,
+                               BCM2835_SPI_WORKER_STACK_SIZE, priority, 0) != CFE_SUCCESS)
+    {
+        Ctrl->WorkerRunning = false;
+        return BCM2835_SPI_ERR_OS;
+    }
+
+    return BCM2835_SPI_OK;
+}
+
+int32_t bcm2835_spi_request_init(bcm2835_spi_request_t *req, const char *name)
+{
+    if (req == NULL || name == NULL)
+    {
+        return BCM2835_SPI_ERR_INVALID;
+    }
+
+    memset(req, 0, sizeof(*req));
+    req->status = BCM2835_SPI_OK;
+
+    if (OS_BinSemCreate(&req->done, name, OS_SEM_EMPTY, 0) != OS_SUCCESS)
+    {
+        return BCM2835_SPI_ERR_OS;
+    }
+
+    return BCM2835_SPI_OK;
+}
+
+int32_t bcm2835_spi_submit(bcm2835_spi_request_t *req, const bcm2835_spi_device_t *dev, const bcm2835_spi_seg_t *segs,
+                           uint32_t count)
+{
+    BCM2835_SPI_Ctrl_t *Ctrl;
+
+    if (req == NULL || dev == NULL || dev->controller >= BCM2835_SPI_CTRL_COUNT || req->status == BCM2835_SPI_PENDING)
+    {
+        return BCM2835_SPI_ERR_INVALID;
+    }
+
+    Ctrl = &BCM2835_SPI_Ctrl[dev->controller];
+    if (!Ctrl->WorkerRunning)
+    {
+        return BCM2835_SPI_ERR_INVALID;
+    }
+
+    req->dev    = dev;
+    req->segs   = segs;
+    req->count  = count;
+    req->status = BCM2835_SPI_PENDING;
+
+    if (OS_QueuePut(Ctrl->Queue, &req, sizeof(req), 0) != OS_SUCCESS)
+    {
+        req->status = BCM2835_SPI_OK;
+        return BCM2835_SPI_ERR_FULL;
+    }
+
+    return BCM2835_SPI_OK;
+}
+
+int32_t bcm2835_spi_request_wait(bcm2835_spi_request_t *req, int32_t timeout_ms)
+{
+    int32 OsStatus;
+
+    if (req == NULL)
+    {
+        return BCM2835_SPI_ERR_INVALID;
+    }
+
+    if (req->status != BCM2835_SPI_PENDING)
+    {
+        /* Not submitted, or already collected */
+        return req->status;
+    }
+
+    if (timeout_ms < 0)
+    {
+        OsStatus = OS_BinSemTake(req->done);
+    }
+    else
+    {
+        OsStatus = OS_BinSemTimedWait(req->done, (uint32)timeout_ms);
+    }
+
+    if (OsStatus != OS_SUCCESS)
+    {
+        return BCM2835_SPI_ERR_TIMEOUT;
+    }
+
+    req->status = req->result;
+
+    return req->status;
+}
+
+int32_t bcm2835_spi_get_stats(uint8_t controller, bcm2835_spi_stats_t *stats)
+{
+    if (controller >= BCM2835_SPI_CTRL_COUNT || !BCM2835_SPI_Ctrl[controller].Initialized || stats == NULL)
+    {
+        return BCM2835_SPI_ERR_INVALID;
+    }
+
+    bcm2835_lock_acquire(&BCM2835_SPI_Ctrl[controller].Lock, BCM2835_LOCK_PEND_FOREVER);
+    BCM2835_SPI_FoldTimeouts(&BCM2835_SPI_Ctrl[controller]);
+    *stats = BCM2835_SPI_Ctrl[controller].Stats;
+    bcm2835_lock_release(&BCM2835_SPI_Ctrl[controller].Lock);
+
+    return BCM2835_SPI_OK;
+}
+
+/************************/
+/*  End of File Comment */
+/************************/
@@ -0,0 +1,397 @@
+/*************************************************************************
+**
+**      GSC-18128-1, "Core Flight Executive Version 6.7"
+**
+**      Copyright (c) 2006-2019 United States Government as represented by
+**      the Administrator of the National Aeronautics and Space Administration.
+**      All Rights Reserved.
+**
+**      Licensed under the Apache License, Version 2.0 (the "License");
+**      you may not use this file except in compliance with the License.
+**      You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**      Unless required by applicable law or agreed to in writing, software
+**      distributed under the License is distributed on an "AS IS" BASIS,
+**      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**      See the License for the specific language governing permissions and
+**      limitations under the License.
+**
+** File: bcm2835_spi_dma.c
+**
+** Purpose:
+**  DMA engine path of the SPI0 bulk transfers.
+**
+** Notes:
+**  One DMA channel feeds the TX FIFO (DREQ 6) and another drains the RX
+**  FIFO (DREQ 7), with the SPI0 controller in DMA mode (DMAEN | ADCS).
+**  In that mode the first word written to the FIFO sets DLEN and CS[7:0],
+**  so the TX stream is that header word followed by the data.
+**  The buffers are DMA memory from BCM2835_DMA_MemAlloc (bcm2835_dma.c);
+**  every page gets its own control block in the chain.
+**  Layout: page 0 holds the control blocks, then the TX and RX buffers.
+**
+*************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <sys/mman.h>
+
+#include "bcm2835_lib_internal.h"
+
+/*************************************************************************
+** Macro Definitions
+*************************************************************************/
+
+/* Pages of one buffer: header word plus the longest transfer */
+#define BCM2835_SPI_DMA_BUF_PAGES   ((BCM2835_SPI_DMA_MAX_LEN + 4 + BCM2835_PAGE_SIZE - 1) / BCM2835_PAGE_SIZE)
+
+/* Control block page, TX buffer, RX buffer */
+#define BCM2835_SPI_DMA_PAGES       (1 + 2 * BCM2835_SPI_DMA_BUF_PAGES)
+#define BCM2835_SPI_DMA_TX_PAGE     1
+#define BCM2835_SPI_DMA_RX_PAGE     (1 + BCM2835_SPI_DMA_BUF_PAGES)
+
+/* SPI0 FIFO as seen by the DMA engine */
+#define BCM2835_SPI_DMA_FIFO_BUS    (BCM2835_PERI_BUS_BASE + BCM2835_SPI0_BASE + BCM2835_SPI0_FIFO)
+
+/* Slack added to the nominal transfer time before giving up */
+#define BCM2835_SPI_DMA_SLACK_US    10000
+
+/* Poll interval once the nominal transfer time has elapsed */
+#define BCM2835_SPI_DMA_POLL_NS     20000
+
+/*************************************************************************
+** Type Definitions
+*************************************************************************/
+
+typedef struct
+{
+    bool     Ready;
+    uint8    TxChannel;
+    uint8    RxChannel;
+    uint32   Threshold;
+
+    BCM2835_DMA_Mem_t Mem;
+
+    uint8_t *Virt[BCM2835_SPI_DMA_PAGES];  /* uncached views of the pages of Mem */
+    uint32_t Bus[BCM2835_SPI_DMA_PAGES];   /* their bus addresses */
+} BCM2835_SPI_Dma_t;
+
+/*************************************************************************
+** Local Data
+*************************************************************************/
+
+static BCM2835_SPI_Dma_t BCM2835_SPI_Dma = { .Threshold = BCM2835_SPI_DMA_THRESHOLD };
+
+/*************************************************************************
+** Local Functions
+*************************************************************************/
+
+/* Builds the control blocks moving Len bytes between the buffer starting at
+** FirstPage and the SPI0 FIFO, one per page, starting at control block Cb.
+** Returns the number of control blocks used.
+*/
+static uint32 BCM2835_SPI_DmaChain(uint32 Cb, uint32 FirstPage, uint32 Len, bool ToFifo)
+{
+    bcm2835_dma_cb_t *Cbs = (bcm2835_dma_cb_t *)BCM2835_SPI_Dma.Virt[0];
+    uint32            Count = 0;
+    uint32            Chunk;
+
+    while (Len > 0)
+    {
+        bcm2835_dma_cb_t *Block = &Cbs[Cb + Count];
+
+        Chunk = (Len > BCM2835_PAGE_SIZE) ? BCM2835_PAGE_SIZE : Len;
+
+        if (ToFifo)
+        {
+            Block->ti        = BCM2835_DMA_TI_PERMAP(BCM2835_DMA_DREQ_SPI0_TX) | BCM2835_DMA_TI_DEST_DREQ |
+                               BCM2835_DMA_TI_SRC_INC | BCM2835_DMA_TI_WAIT_RESP;
+            Block->source_ad = BCM2835_SPI_Dma.Bus[FirstPage + Count];
+            Block->dest_ad   = BCM2835_SPI_DMA_FIFO_BUS;
+        }
+        else
+        {
+            Block->ti        = BCM2835_DMA_TI_PERMAP(BCM2835_DMA_DREQ_SPI0_RX) | BCM2835_DMA_TI_SRC_DREQ |
+                               BCM2835_DMA_TI_DEST_INC | BCM2835_DMA_TI_WAIT_RESP;
+            Block->source_ad = BCM2835_SPI_DMA_FIFO_BUS;
+            Block->dest_ad   = BCM2835_SPI_Dma.Bus[FirstPage + Count];
+        }
+        Block->txfr_len  = Chunk;
+        Block->stride    = 0;
+        Block->nextconbk = 0;
+
+        if (Count > 0)
+        {
+            Cbs[Cb + Count - 1].nextconbk = BCM2835_SPI_Dma.Bus[0] + (Cb + Count) * sizeof(bcm2835_dma_cb_t);
+        }
+
+        Len -= Chunk;
+        Count++;
+    }
+
+    return Count;
+}
+
+/* Copies Len bytes from Src (zeros if NULL) into the buffer starting at FirstPage, Offset */
+static void BCM2835_SPI_DmaCopyIn(uint32 FirstPage, uint32 Offset, const char *Src, uint32 Len, const uint8_t *Reverse)
+{
+    uint32 Page = FirstPage + Offset / BCM2835_PAGE_SIZE;
+    uint32 Pos  = Offset % BCM2835_PAGE_SIZE;
+    uint32 Chunk;
+    uint32 i;
+
+    while (Len > 0)
+    {
+        Chunk = BCM2835_PAGE_SIZE - Pos;
+        if (Chunk > Len)
+        {
+            Chunk = Len;
+        }
+
+        if (Src == NULL)
+        {
+            memset(BCM2835_SPI_Dma.Virt[Page] + Pos, 0, Chunk);
+        }
+        else if (Reverse == NULL)
+        {
+            memcpy(BCM2835_SPI_Dma.Virt[Page] + Pos, Src, Chunk);
+        }
+        else
+        {
+            for (i = 0; i < Chunk; i++)
+            {
+                BCM2835_SPI_Dma.Virt[Page][Pos + i] = Reverse[(uint8_t)Src[i]];
+            }
+        }
+
+        if (Src != NULL)
+        {
+            Src += Chunk;
+        }
+        Len -= Chunk;
+        Page++;
+        Pos = 0;
+    }
+}
+
+/* Copies Len bytes out of the buffer starting at FirstPage, Offset into Dst */
+static void BCM2835_SPI_DmaCopyOut(char *Dst, uint32 FirstPage, uint32 Offset, uint32 Len, const uint8_t *Reverse)
+{
+    uint32 Page = FirstPage + Offset / BCM2835_PAGE_SIZE;
+    uint32 Pos  = Offset % BCM2835_PAGE_SIZE;
+    uint32 Chunk;
+    uint32 i;
+
+    while (Len > 0)
+    {
+        Chunk = BCM2835_PAGE_SIZE - Pos;
+        if (Chunk > Len)
+        {
+            Chunk = Len;
+        }
+
+        if (Reverse == NULL)
+        {
+            memcpy(Dst, BCM2835_SPI_Dma.Virt[Page] + Pos, Chunk);
+        }
+        else
+        {
+            for (i = 0; i < Chunk; i++)
+            {
+                Dst[i] = Reverse[BCM2835_SPI_Dma.Virt[Page][Pos + i]];
+            }
+        }
+
+        Dst += Chunk;
+        Len -= Chunk;
+        Page++;
+        Pos = 0;
+    }
+}
+
+/*************************************************************************
+** Internal Functions
+*************************************************************************/
+
+uint8_t BCM2835_SPI_DmaTransfer(const bcm2835_spi_seg_t *segs, uint32_t count, const uint8_t *reverse)
+{
+    volatile uint32_t *cs = bcm2835_spi0 + BCM2835_SPI0_CS/4;
+    volatile uint32_t *clk = bcm2835_spi0 + BCM2835_SPI0_CLK/4;
+    volatile uint32_t *rx_cs;
+    struct timespec    ts;
+    uint32_t           csval;
+    uint32_t           header;
+    uint32_t           divider;
+    uint32_t           len = 0;
+    uint32_t           offset;
+    uint32_t           i;
+    uint32             TxCbs;
+    uint64             NominalUs;
+    uint64             DeadlineUs;
+    bool               Failed = false;
+
+    if (!BCM2835_SPI_Dma.Ready)
+    {
+        return 0;
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        if (segs[i].len > BCM2835_SPI_DMA_MAX_LEN - len)
+        {
+            return 0;
+        }
+        len += segs[i].len;
+    }
+
+    if (len < BCM2835_SPI_Dma.Threshold)
+    {
+        return 0;
+    }
+
+    rx_cs = BCM2835_DMA_Reg(BCM2835_SPI_Dma.RxChannel, BCM2835_DMA_CS);
+
+    bcm2835_memory_barrier();
+    csval   = bcm2835_peri_read_nb(cs);
+    divider = bcm2835_peri_read_nb(clk) & 0xFFFF;
+
+    /* TX stream: DLEN and CS[7:0] (chip select, mode, TA), then the data.
+    ** Both streams move whole FIFO words.
+    */
+    header = (len << 16) | (csval & (BCM2835_SPI0_CS_CSPOL | BCM2835_SPI0_CS_CPOL |
+                                     BCM2835_SPI0_CS_CPHA | BCM2835_SPI0_CS_CS)) | BCM2835_SPI0_CS_TA;
+    memcpy(BCM2835_SPI_Dma.Virt[BCM2835_SPI_DMA_TX_PAGE], &header, sizeof(header));
+    for (i = 0, offset = sizeof(header); i < count; offset += segs[i].len, i++)
+    {
+        BCM2835_SPI_DmaCopyIn(BCM2835_SPI_DMA_TX_PAGE, offset, segs[i].tx, segs[i].len, reverse);
+    }
+
+    TxCbs = BCM2835_SPI_DmaChain(0, BCM2835_SPI_DMA_TX_PAGE, (sizeof(header) + len + 3) & ~3U, true);
+    BCM2835_SPI_DmaChain(TxCbs, BCM2835_SPI_DMA_RX_PAGE, (len + 3) & ~3U, false);
+
+    /* Control blocks and data must be in memory before the engine starts */
+    bcm2835_memory_barrier();
+
+    /* Clear the FIFOs and enter DMA mode; ADCS drops TA and CS when DLEN is done */
+    bcm2835_peri_write_nb(cs, (csval & ~(BCM2835_SPI0_CS_TA | BCM2835_SPI0_CS_DMAEN | BCM2835_SPI0_CS_ADCS)) |
+                              BCM2835_SPI0_CS_CLEAR | BCM2835_SPI0_CS_DMAEN | BCM2835_SPI0_CS_ADCS);
+    bcm2835_memory_barrier();
+
+    /* RX first, so nothing is lost once TX starts clocking */
+    BCM2835_DMA_Start(BCM2835_SPI_Dma.RxChannel, BCM2835_SPI_Dma.Bus[0] + TxCbs * sizeof(bcm2835_dma_cb_t));
+    BCM2835_DMA_Start(BCM2835_SPI_Dma.TxChannel, BCM2835_SPI_Dma.Bus[0]);
+    bcm2835_memory_barrier();
+
+    /* Sleep through the nominal transfer time, then poll the end of the RX chain */
+    if (divider == 0)
+    {
+        divider = 65536;
+    }
+    NominalUs  = ((uint64)len * 8 * divider) / (BCM2835_CORE_CLK_HZ / 1000000) + 1;
+    DeadlineUs = BCM2835_LIB_GetTimeUs() + 2 * NominalUs + BCM2835_SPI_DMA_SLACK_US;
+
+    ts.tv_sec  = NominalUs / 1000000;
+    ts.tv_nsec = (NominalUs % 1000000) * 1000;
+    nanosleep(&ts, NULL);
+
+    ts.tv_sec  = 0;
+    ts.tv_nsec = BCM2835_SPI_DMA_POLL_NS;
+    while (bcm2835_peri_read(rx_cs) & BCM2835_DMA_CS_ACTIVE)
+    {
+        if ((bcm2835_peri_read(rx_cs) & BCM2835_DMA_CS_ERROR) || BCM2835_LIB_GetTimeUs() > DeadlineUs)
+        {
+            Failed = true;
+            break;
+        }
+        nanosleep(&ts, NULL);
+    }
+
+    if (Failed)
+    {
+        BCM2835_DMA_Reset(BCM2835_SPI_Dma.TxChannel);
+        BCM2835_DMA_Reset(BCM2835_SPI_Dma.RxChannel);
+        fprintf(stderr, "bcm2835_spi: DMA transfer of %u bytes did not complete, retrying it polled\n",
+                (unsigned)len);
+    }
+
+    /* Back to polled mode */
+    bcm2835_memory_barrier();
+    bcm2835_peri_write_nb(cs, csval & ~(BCM2835_SPI0_CS_TA | BCM2835_SPI0_CS_DMAEN | BCM2835_SPI0_CS_ADCS));
+    bcm2835_memory_barrier();
+
+    /* The chip select has been released, so the caller can redo the whole transaction polled */
+    if (Failed)
+    {
+        return 0;
+    }
+
+    for (i = 0, offset = 0; i < count; offset += segs[i].len, i++)
+    {
+        if (segs[i].rx != NULL)
+        {
+            BCM2835_SPI_DmaCopyOut(segs[i].rx, BCM2835_SPI_DMA_RX_PAGE, offset, segs[i].len, reverse);
+        }
+    }
+
+    return 1;
+}
+
+/*************************************************************************
+** Public Functions
+*************************************************************************/
+
+int bcm2835_spi_dma_begin(uint8_t tx_channel, uint8_t rx_channel)
+{
+    if (BCM2835_DEBUG || !BCM2835_LIB_MapRegion(BCM2835_REGBASE_DMA) || !BCM2835_LIB_MapRegion(BCM2835_REGBASE_SPI0))
+    {
+        return 0; /* bcm2835_init() failed, or not root */
+    }
+
+    if (tx_channel >= BCM2835_DMA_CHANNELS || rx_channel >= BCM2835_DMA_CHANNELS || tx_channel == rx_channel)
+    {
+        return 0;
+    }
+
+    bcm2835_spi_dma_end();
+
+    BCM2835_SPI_Dma.Mem.Virt = BCM2835_SPI_Dma.Virt;
+    BCM2835_SPI_Dma.Mem.Bus  = BCM2835_SPI_Dma.Bus;
+    if (!BCM2835_DMA_MemAlloc(&BCM2835_SPI_Dma.Mem, BCM2835_SPI_DMA_PAGES, "bcm2835_spi_dma_begin"))
+    {
+        return 0;
+    }
+
+    BCM2835_SPI_Dma.TxChannel = tx_channel;
+    BCM2835_SPI_Dma.RxChannel = rx_channel;
+
+    BCM2835_DMA_Enable(tx_channel);
+    BCM2835_DMA_Enable(rx_channel);
+
+    BCM2835_SPI_Dma.Ready = true;
+
+    return 1;
+}
+
+void bcm2835_spi_dma_end(void)
+{
+    if (BCM2835_SPI_Dma.Ready)
+    {
+        BCM2835_DMA_Reset(BCM2835_SPI_Dma.TxChannel);
+        BCM2835_DMA_Reset(BCM2835_SPI_Dma.RxChannel);
+        BCM2835_SPI_Dma.Ready = false;
+    }
+
+    BCM2835_DMA_MemFree(&BCM2835_SPI_Dma.Mem);
+}
+
+void bcm2835_spi_dma_set_threshold(uint32_t len)
+{
+    BCM2835_SPI_Dma.Threshold = len;
+}
+
+/************************/
+/*  End of File Comment */
+/************************/
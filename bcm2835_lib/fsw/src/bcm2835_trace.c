@@ -0,0 +1,384 @@
+/*************************************************************************
+**
+**      GSC-18128-1, "Core Flight Executive Version 6.7"
+**
+**      Copyright (c) 2006-2019 United States Government as represented by
+**      the Administrator of the National Aeronautics and Space Administration.
+**      All Rights Reserved.
+**
+**      Licensed under the Apache License, Version 2.0 (the "License");
+**      you may not use this file except in compliance with the License.
+**      You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**      Unless required by applicable law or agreed to in writing, software
+**      distributed under the License is distributed on an "AS IS" BASIS,
+**      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**      See the License for the specific language governing permissions and
+**      limitations under the License.
+**
+** File: bcm2835_trace.c
+**
+** Purpose:
+**  Bus transaction trace: a lock-free ring of fixed-size records, its
+**  binary dump, and the replay that serves as the simulated bus backend.
+**
+** Notes:
+**  Writers claim a slot by incrementing the head and publish it by
+**  storing its sequence number last; the sequence is zeroed while the
+**  slot is being written. A reader keeps a record only if the sequence
+**  it expects is seen both before and after the copy, so a slot
+**  rewritten during the copy is dropped rather than torn.
+**
+*************************************************************************/
+
+#include <string.h>
+#include <time.h>
+#include <sys/mman.h>
+
+#include "bcm2835_lib_internal.h"
+
+/*************************************************************************
+** Macro Definitions
+*************************************************************************/
+
+#define BCM2835_TRACE_MASK (BCM2835_TRACE_DEPTH - 1)
+
+#if (BCM2835_TRACE_DEPTH & BCM2835_TRACE_MASK) != 0
+#error BCM2835_TRACE_DEPTH must be a power of 2
+#endif
+
+/* The last part of a replayed transaction is spun, nanosleep may overshoot by this much */
+#define BCM2835_TRACE_SPIN_US 200
+
+/*************************************************************************
+** Local Data
+*************************************************************************/
+
+static bcm2835_trace_rec_t BCM2835_TRACE_Ring[BCM2835_TRACE_DEPTH];
+static uint32              BCM2835_TRACE_Head;
+static uint8               BCM2835_TRACE_Enabled = 1;
+static uint8               BCM2835_TRACE_Clock   = BCM2835_TRACE_CLOCK_MONOTONIC;
+
+/* Dump buffer, under BCM2835_TRACE_DumpLock so that the file is written without BCM2835_TRACE_Lock */
+static osal_id_t           BCM2835_TRACE_DumpLock;
+static bcm2835_trace_rec_t BCM2835_TRACE_Copy[BCM2835_TRACE_DEPTH];
+
+/* Replay state, under BCM2835_TRACE_Lock */
+static osal_id_t           BCM2835_TRACE_Lock;
+static bcm2835_trace_rec_t BCM2835_TRACE_ReplayRecs[BCM2835_TRACE_DEPTH];
+static uint32              BCM2835_TRACE_ReplayCount;
+static uint32              BCM2835_TRACE_ReplayPos;
+static uint32              BCM2835_TRACE_ReplayHits;
+static uint32              BCM2835_TRACE_ReplayMisses;
+
+/*************************************************************************
+** Local Functions
+*************************************************************************/
+
+static uint32 BCM2835_TRACE_Caller(void)
+{
+    return (uint32)OS_ObjectIdToInteger(OS_TaskGetId());
+}
+
+/* Controller of the bus statistics, see bcm2835Bus */
+static uint8 BCM2835_TRACE_Bus(uint8 Kind, uint8 Controller)
+{
+    if (Kind == BCM2835_TRACE_SPI0)
+    {
+        return BCM2835_BUS_SPI0;
+    }
+    if (Kind == BCM2835_TRACE_AUX_SPI)
+    {
+        return BCM2835_BUS_AUX_SPI;
+    }
+
+    /* bcm2835I2CBus matches BCM2835_BUS_I2C0 and BCM2835_BUS_I2C1 */
+    return Controller;
+}
+
+/* Copy the bytes of the record: received ones if any, else the sent ones */
+static void BCM2835_TRACE_SetData(bcm2835_trace_rec_t *Rec, const void *Tx, uint32 TxLen, const void *Rx,
+                                  uint32 RxLen)
+{
+    const void *Src = (RxLen != 0) ? Rx : Tx;
+    uint32      Len = (RxLen != 0) ? RxLen : TxLen;
+
+    memset(Rec->data, 0, sizeof(Rec->data));
+    if (Src != NULL)
+    {
+        memcpy(Rec->data, Src, (Len < BCM2835_TRACE_DATA) ? Len : BCM2835_TRACE_DATA);
+    }
+}
+
+/*************************************************************************
+** Internal Functions
+*************************************************************************/
+
+int32 BCM2835_TRACE_Init(void)
+{
+    if (OS_MutSemCreate(&BCM2835_TRACE_Lock, "bus_trace_lock", 0) != OS_SUCCESS ||
+        OS_MutSemCreate(&BCM2835_TRACE_DumpLock, "bus_trace_dump", 0) != OS_SUCCESS)
+    {
+        OS_printf("BCM2835 Lib: bus trace lock not created.\n");
+        return CFE_STATUS_NOT_IMPLEMENTED;
+    }
+
+    /* One page, mapped now so that recording never has to */
+    if (!BCM2835_DEBUG && BCM2835_LIB_MapRegion(BCM2835_REGBASE_ST))
+    {
+        BCM2835_TRACE_Clock = BCM2835_TRACE_CLOCK_ST;
+    }
+
+    return CFE_SUCCESS;
+}
+
+uint32 BCM2835_TRACE_Now(void)
+{
+    if (BCM2835_TRACE_Clock == BCM2835_TRACE_CLOCK_ST && bcm2835_st != MAP_FAILED)
+    {
+        return bcm2835_peri_read(bcm2835_st + BCM2835_ST_CLO / 4);
+    }
+
+    return (uint32)BCM2835_LIB_GetTimeUs();
+}
+
+void BCM2835_TRACE_Record(uint8 Kind, uint8 Controller, uint8 Address, uint32 Len, const void *Tx, uint32 TxLen,
+                          const void *Rx, uint32 RxLen, uint32 StartUs, uint8 Status)
+{
+    bcm2835_trace_rec_t *Rec;
+    uint32               Seq;
+    uint32               Now;
+
+    Now = BCM2835_TRACE_Now();
+
+    BCM2835_BUS_Account(BCM2835_TRACE_Bus(Kind, Controller), Address, Len, Now - StartUs, Status);
+
+    if (!__atomic_load_n(&BCM2835_TRACE_Enabled, __ATOMIC_RELAXED))
+    {
+        return;
+    }
+
+    Seq = __atomic_add_fetch(&BCM2835_TRACE_Head, 1, __ATOMIC_RELAXED);
+    Rec = &BCM2835_TRACE_Ring[(Seq - 1) & BCM2835_TRACE_MASK];
+
+    /* Mark the slot busy before its contents change */
+    __atomic_store_n(&Rec->seq, 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    Rec->timestamp_us = StartUs;
+    Rec->duration_us  = Now - StartUs;
+    Rec->caller       = BCM2835_TRACE_Caller();
+    Rec->len          = (Len > 0xFFFF) ? 0xFFFF : (uint16)Len;
+    Rec->kind         = Kind;
+    Rec->controller   = Controller;
+    Rec->address      = Address;
+    Rec->reg          = (Tx != NULL && TxLen != 0) ? ((const uint8 *)Tx)[0] : 0;
+    Rec->status       = Status;
+    Rec->spare        = 0;
+    BCM2835_TRACE_SetData(Rec, Tx, TxLen, Rx, RxLen);
+
+    __atomic_store_n(&Rec->seq, Seq, __ATOMIC_RELEASE);
+}
+
+uint8 BCM2835_TRACE_Replay(uint8 Kind, uint8 Controller, uint8 Address, uint32 Len, const void *Tx, uint32 TxLen,
+                           void *Rx, uint32 RxLen)
+{
+    const bcm2835_trace_rec_t *Rec;
+    bcm2835_trace_rec_t        Match;
+    uint32                     Start   = BCM2835_TRACE_Now();
+    uint64                     StartUs = BCM2835_LIB_GetTimeUs();
+    uint8                      Reg     = (Tx != NULL && TxLen != 0) ? ((const uint8 *)Tx)[0] : 0;
+    bool                       Found   = false;
+    struct timespec            Sleep;
+    uint64                     Elapsed;
+    uint32                     i;
+
+    memset(&Match, 0, sizeof(Match));
+
+    OS_MutSemTake(BCM2835_TRACE_Lock);
+    for (i = 0; i < BCM2835_TRACE_REPLAY_WINDOW && i < BCM2835_TRACE_ReplayCount; i++)
+    {
+        Rec = &BCM2835_TRACE_ReplayRecs[(BCM2835_TRACE_ReplayPos + i) % BCM2835_TRACE_ReplayCount];
+        if (Rec->kind == Kind && Rec->controller == Controller && Rec->address == Address && Rec->reg == Reg)
+        {
+            Match                   = *Rec;
+            BCM2835_TRACE_ReplayPos = (BCM2835_TRACE_ReplayPos + i + 1) % BCM2835_TRACE_ReplayCount;
+            Found                   = true;
+            break;
+        }
+    }
+    if (Found)
+    {
+        BCM2835_TRACE_ReplayHits++;
+    }
+    else
+    {
+        BCM2835_TRACE_ReplayMisses++;
+    }
+    OS_MutSemGive(BCM2835_TRACE_Lock);
+
+    if (Rx != NULL)
+    {
+        memset(Rx, 0, RxLen);
+        memcpy(Rx, Match.data, (RxLen < BCM2835_TRACE_DATA) ? RxLen : BCM2835_TRACE_DATA);
+    }
+
+    /* Take as long as the captured transaction did: sleep most of it, spin the rest */
+    Elapsed = BCM2835_LIB_GetTimeUs() - StartUs;
+    if (Elapsed + BCM2835_TRACE_SPIN_US < Match.duration_us)
+    {
+        Sleep.tv_sec  = (Match.duration_us - Elapsed - BCM2835_TRACE_SPIN_US) / 1000000;
+        Sleep.tv_nsec = ((Match.duration_us - Elapsed - BCM2835_TRACE_SPIN_US) % 1000000) * 1000;
+        nanosleep(&Sleep, NULL);
+    }
+
+    while (BCM2835_LIB_GetTimeUs() - StartUs < Match.duration_us)
+    {
+    }
+
+    BCM2835_TRACE_Record(Kind, Controller, Address, Len, Tx, TxLen, Rx, RxLen, Start, Match.status);
+
+    return Match.status;
+}
+
+/*************************************************************************
+** Public Functions
+*************************************************************************/
+
+void bcm2835_trace_enable(uint8_t enable)
+{
+    __atomic_store_n(&BCM2835_TRACE_Enabled, (uint8)(enable != 0), __ATOMIC_RELAXED);
+}
+
+uint32_t bcm2835_trace_snapshot(bcm2835_trace_rec_t *recs, uint32_t max)
+{
+    const bcm2835_trace_rec_t *Rec;
+    uint32                     Head  = __atomic_load_n(&BCM2835_TRACE_Head, __ATOMIC_ACQUIRE);
+    uint32                     Avail = (Head < BCM2835_TRACE_DEPTH) ? Head : BCM2835_TRACE_DEPTH;
+    uint32                     Count = 0;
+    uint32                     Seq;
+
+    /* The newest max records when they do not all fit */
+    if (Avail > max)
+    {
+        Avail = max;
+    }
+
+    for (Seq = Head - Avail + 1; Seq != Head + 1; Seq++)
+    {
+        Rec = &BCM2835_TRACE_Ring[(Seq - 1) & BCM2835_TRACE_MASK];
+
+        if (__atomic_load_n(&Rec->seq, __ATOMIC_ACQUIRE) != Seq)
+        {
+            continue;
+        }
+
+        recs[Count] = *Rec;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+        if (__atomic_load_n(&Rec->seq, __ATOMIC_RELAXED) == Seq && recs[Count].seq == Seq)
+        {
+            Count++;
+        }
+    }
+
+    return Count;
+}
+
+int32_t bcm2835_trace_dump(const char *path)
+{
+    bcm2835_trace_file_hdr_t Hdr;
+    osal_id_t                Fd;
+    int32                    Result;
+    uint32                   Count;
+    int32                    Bytes;
+
+    if (OS_OpenCreate(&Fd, path, OS_FILE_FLAG_CREATE | OS_FILE_FLAG_TRUNCATE, OS_WRITE_ONLY) != OS_SUCCESS)
+    {
+        return -1;
+    }
+
+    /* The snapshot needs no lock, BCM2835_TRACE_DumpLock only keeps two dumps from sharing the buffer */
+    OS_MutSemTake(BCM2835_TRACE_DumpLock);
+
+    Count = bcm2835_trace_snapshot(BCM2835_TRACE_Copy, BCM2835_TRACE_DEPTH);
+
+    memset(&Hdr, 0, sizeof(Hdr));
+    Hdr.magic    = BCM2835_TRACE_MAGIC;
+    Hdr.version  = BCM2835_TRACE_VERSION;
+    Hdr.rec_size = sizeof(bcm2835_trace_rec_t);
+    Hdr.count    = Count;
+    Hdr.clock    = BCM2835_TRACE_Clock;
+
+    Bytes  = (int32)(Count * sizeof(bcm2835_trace_rec_t));
+    Result = (int32)Count;
+    if (OS_write(Fd, &Hdr, sizeof(Hdr)) != (int32)sizeof(Hdr)
+        || (Bytes != 0 && OS_write(Fd, BCM2835_TRACE_Copy, Bytes) != Bytes))
+    {
+        Result = -1;
+    }
+
+    OS_MutSemGive(BCM2835_TRACE_DumpLock);
+
+    OS_close(Fd);
+
+    return Result;
+}
+
+int32_t bcm2835_trace_replay_load(const char *path)
+{
+    bcm2835_trace_file_hdr_t Hdr;
+    osal_id_t                Fd;
+    int32                    Result = -1;
+    uint32                   Count;
+    int32                    Bytes;
+
+    if (OS_OpenCreate(&Fd, path, OS_FILE_FLAG_NONE, OS_READ_ONLY) != OS_SUCCESS)
+    {
+        return -1;
+    }
+
+    OS_MutSemTake(BCM2835_TRACE_Lock);
+
+    BCM2835_TRACE_ReplayCount = 0;
+    BCM2835_TRACE_ReplayPos   = 0;
+
+    if (OS_read(Fd, &Hdr, sizeof(Hdr)) == (int32)sizeof(Hdr) && Hdr.magic == BCM2835_TRACE_MAGIC
+        && Hdr.version == BCM2835_TRACE_VERSION && Hdr.rec_size == sizeof(bcm2835_trace_rec_t))
+    {
+        Count = (Hdr.count < BCM2835_TRACE_DEPTH) ? Hdr.count : BCM2835_TRACE_DEPTH;
+        Bytes = (int32)(Count * sizeof(bcm2835_trace_rec_t));
+
+        if (Bytes == 0 || OS_read(Fd, BCM2835_TRACE_ReplayRecs, Bytes) == Bytes)
+        {
+            BCM2835_TRACE_ReplayCount = Count;
+            Result                    = (int32)Count;
+        }
+    }
+
+    OS_MutSemGive(BCM2835_TRACE_Lock);
+
+    OS_close(Fd);
+
+    return Result;
+}
+
+void bcm2835_trace_get_stats(bcm2835_trace_stats_t *stats)
+{
+    uint32 Head = __atomic_load_n(&BCM2835_TRACE_Head, __ATOMIC_RELAXED);
+
+    stats->Recorded    = Head;
+    stats->Overwritten = (Head > BCM2835_TRACE_DEPTH) ? Head - BCM2835_TRACE_DEPTH : 0;
+
+    OS_MutSemTake(BCM2835_TRACE_Lock);
+    stats->ReplayLoaded = BCM2835_TRACE_ReplayCount;
+    stats->ReplayHits   = BCM2835_TRACE_ReplayHits;
+    stats->ReplayMisses = BCM2835_TRACE_ReplayMisses;
+    OS_MutSemGive(BCM2835_TRACE_Lock);
+}
+
+/************************/
+/*  End of File Comment */
+/************************/
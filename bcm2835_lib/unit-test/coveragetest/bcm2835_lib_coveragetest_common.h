@@ -0,0 +1,61 @@
+/*
+**  GSC-18128-1, "Core Flight Executive Version 6.7"
+**
+**  Copyright (c) 2006-2019 United States Government as represented by
+**  the Administrator of the National Aeronautics and Space Administration.
+**  All Rights Reserved.
+**
+**  Licensed under the Apache License, Version 2.0 (the "License");
+**  you may not use this file except in compliance with the License.
+**  You may obtain a copy of the License at
+**
+**    http://www.apache.org/licenses/LICENSE-2.0
+**
+**  Unless required by applicable law or agreed to in writing, software
+**  distributed under the License is distributed on an "AS IS" BASIS,
+**  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**  See the License for the specific language governing permissions and
+**  limitations under the License.
+*/
+
+/*
+** File: bcm2835_lib_coveragetest_common.h
+**
+** Purpose:
+** Common definitions for all bcm2835_lib coverage tests
+*/
+
+#ifndef BCM2835_LIB_COVERAGETEST_COMMON_H
+#define BCM2835_LIB_COVERAGETEST_COMMON_H
+
+/*
+ * Includes
+ */
+
+#include "utassert.h"
+#include "uttest.h"
+#include "utstubs.h"
+
+/*
+ * Use the public API/definitions from CFE and BCM2835 LIB
+ */
+#include "cfe.h"
+#include "bcm2835_lib_internal.h"
+
+/*
+ * Macro to add a test case to the list of tests to execute
+ * This just simplifies the use of UtTest_Add()
+ */
+#define ADD_TEST(test) UtTest_Add((Test_##test), Bcm2835_UT_Setup, Bcm2835_UT_TearDown, #test)
+
+/*
+ * Setup function prior to every test
+ */
+void Bcm2835_UT_Setup(void);
+
+/*
+ * Teardown function after every test
+ */
+void Bcm2835_UT_TearDown(void);
+
+#endif /* BCM2835_LIB_COVERAGETEST_COMMON_H */
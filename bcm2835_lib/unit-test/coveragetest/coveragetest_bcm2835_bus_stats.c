@@ -0,0 +1,288 @@
+/*
+**  GSC-18128-1, "Core Flight Executive Version 6.7"
+**
+**  Copyright (c) 2006-2019 United States Government as represented by
+**  the Administrator of the National Aeronautics and Space Administration.
+**  All Rights Reserved.
+**
+**  Licensed under the Apache License, Version 2.0 (the "License");
+**  you may not use this file except in compliance with the License.
+**  You may obtain a copy of the License at
+**
+**    http://www.apache.org/licenses/LICENSE-2.0
+**
+**  Unless required by applicable law or agreed to in writing, software
+**  distributed under the License is distributed on an "AS IS" BASIS,
+**  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**  See the License for the specific language governing permissions and
+**  limitations under the License.
+*/
+
+/*
+** File: coveragetest_bcm2835_bus_stats.c
+**
+** Purpose:
+** Coverage Unit Test cases for the bus statistics of the BCM2835 library
+**
+** Notes:
+** The counters are cleared before every test case, but a device entry is
+** never released, so the device table fills up over the test cases. The
+** test case that fills it runs last.
+*/
+
+/*
+ * Includes
+ */
+
+#include "bcm2835_lib_coveragetest_common.h"
+
+/*
+ * Statistics read by the test cases, too large for the stack
+ */
+static bcm2835_bus_stats_t UT_BusStats;
+
+/*
+ * Lock returned for every controller, see BCM2835_I2C_SchedLock
+ */
+static bcm2835_lock_t UT_BusStats_Lock;
+
+/*
+ * The controller locks, which are in bcm2835_i2c_sched.c and bcm2835_spi_dev.c.
+ * A non-zero return code makes them return NULL, as for a controller without a lock.
+ */
+bcm2835_lock_t *BCM2835_I2C_SchedLock(uint8 Bus)
+{
+    UT_Stub_RegisterContextGenericArg(UT_KEY(BCM2835_I2C_SchedLock), Bus);
+
+    return (UT_DEFAULT_IMPL(BCM2835_I2C_SchedLock) == 0) ? &UT_BusStats_Lock : NULL;
+}
+
+bcm2835_lock_t *BCM2835_SPI_DevLock(uint8 Controller)
+{
+    UT_Stub_RegisterContextGenericArg(UT_KEY(BCM2835_SPI_DevLock), Controller);
+
+    return (UT_DEFAULT_IMPL(BCM2835_SPI_DevLock) == 0) ? &UT_BusStats_Lock : NULL;
+}
+
+/*
+ * The lock statistics, which are in bcm2835_lock.c
+ */
+void bcm2835_lock_get_stats(bcm2835_lock_t *lock, bcm2835_lock_stats_t *stats, uint8_t reset)
+{
+    UT_DEFAULT_IMPL(bcm2835_lock_get_stats);
+
+    *stats = lock->Stats;
+}
+
+/*
+ * Entry of a device in UT_BusStats, NULL if it is not there
+ */
+static const bcm2835_bus_dev_stats_t *UT_BusStats_FindDev(uint8 Bus, uint8 Address)
+{
+    uint32 i;
+
+    for (i = 0; i < UT_BusStats.Devices; i++)
+    {
+        if (UT_BusStats.Dev[i].Bus == Bus && UT_BusStats.Dev[i].Address == Address)
+        {
+            return &UT_BusStats.Dev[i];
+        }
+    }
+
+    return NULL;
+}
+
+/*
+**********************************************************************************
+**          TEST CASE FUNCTIONS
+**********************************************************************************
+*/
+
+void Test_BCM2835_BUS_Account(void)
+{
+    /*
+     * Test Case For:
+     * void BCM2835_BUS_Account(...)
+     */
+    const bcm2835_bus_dev_stats_t *Dev;
+    const bcm2835_bus_dev_stats_t *Other;
+
+    BCM2835_BUS_Account(BCM2835_BUS_I2C1, 0x68, 7, 0, 0);
+    BCM2835_BUS_Account(BCM2835_BUS_I2C1, 0x68, 7, 3, 0);
+    BCM2835_BUS_Account(BCM2835_BUS_I2C1, 0x68, 7, 100, BCM2835_I2C_REASON_ERROR_NACK);
+    BCM2835_BUS_Account(BCM2835_BUS_I2C1, 0x68, 1, 0x80000000, 0);
+    BCM2835_BUS_Account(BCM2835_BUS_SPI0, 0x68, 4, 10, 0);
+
+    bcm2835_bus_get_stats(&UT_BusStats, 0);
+
+    Dev = UT_BusStats_FindDev(BCM2835_BUS_I2C1, 0x68);
+    UtAssert_True(Dev != NULL, "I2C device tracked");
+    UtAssert_True(Dev->Transactions == 4 && Dev->Errors == 1, "transactions (%lu) and errors (%lu)",
+                  (unsigned long)Dev->Transactions, (unsigned long)Dev->Errors);
+    UtAssert_True(Dev->Bytes == 15, "bytes of the successful transactions (%lu)", (unsigned long)Dev->Bytes);
+    UtAssert_True(Dev->MaxUs == 0x80000000 && Dev->TotalUs == 0x80000067, "max and total time");
+
+    /* Bin 0 is 0 us, bin n from 2^(n-1) us, the last bin all longer ones */
+    UtAssert_True(Dev->Hist[0] == 1 && Dev->Hist[2] == 1 && Dev->Hist[7] == 1 &&
+                      Dev->Hist[BCM2835_BUS_HIST_BINS - 1] == 1,
+                  "histogram");
+
+    /* The same address on another controller is another device */
+    Other = UT_BusStats_FindDev(BCM2835_BUS_SPI0, 0x68);
+    UtAssert_True(Other != NULL && Other->Transactions == 1 && Other->Bytes == 4 && Other->Hist[4] == 1,
+                  "SPI device tracked");
+    UtAssert_True(UT_BusStats.Untracked == 0, "all tracked");
+}
+
+void Test_BCM2835_BUS_AccountWait(void)
+{
+    /*
+     * Test Case For:
+     * void BCM2835_BUS_AccountWait(uint8 Bus, uint32 WaitUs, bool TimedOut)
+     */
+    BCM2835_BUS_AccountWait(BCM2835_BUS_AUX_SPI, 0, false);
+    BCM2835_BUS_AccountWait(BCM2835_BUS_AUX_SPI, 40, false);
+    BCM2835_BUS_AccountWait(BCM2835_BUS_AUX_SPI, 500, true);
+    BCM2835_BUS_AccountWait(BCM2835_BUS_COUNT, 500, true);
+
+    bcm2835_bus_get_stats(&UT_BusStats, 0);
+
+    UtAssert_True(UT_BusStats.Lock[BCM2835_BUS_AUX_SPI].Waits == 3 &&
+                      UT_BusStats.Lock[BCM2835_BUS_AUX_SPI].Timeouts == 1,
+                  "waits (%lu) and timeouts (%lu)", (unsigned long)UT_BusStats.Lock[BCM2835_BUS_AUX_SPI].Waits,
+                  (unsigned long)UT_BusStats.Lock[BCM2835_BUS_AUX_SPI].Timeouts);
+    UtAssert_True(UT_BusStats.Lock[BCM2835_BUS_AUX_SPI].TotalUs == 540 &&
+                      UT_BusStats.Lock[BCM2835_BUS_AUX_SPI].MaxUs == 500,
+                  "total and longest wait");
+    UtAssert_True(UT_BusStats.Lock[BCM2835_BUS_AUX_SPI].Hist[0] == 1 &&
+                      UT_BusStats.Lock[BCM2835_BUS_AUX_SPI].Hist[6] == 1 &&
+                      UT_BusStats.Lock[BCM2835_BUS_AUX_SPI].Hist[9] == 1,
+                  "histogram");
+
+    /* Unknown controllers are ignored */
+    UtAssert_True(UT_BusStats.Lock[BCM2835_BUS_I2C0].Waits == 0 && UT_BusStats.Lock[BCM2835_BUS_I2C1].Waits == 0 &&
+                      UT_BusStats.Lock[BCM2835_BUS_SPI0].Waits == 0,
+                  "other controllers untouched");
+}
+
+void Test_bcm2835_bus_get_stats(void)
+{
+    /*
+     * Test Case For:
+     * void bcm2835_bus_get_stats(bcm2835_bus_stats_t *stats, uint8_t reset)
+     */
+    const bcm2835_bus_dev_stats_t *Dev;
+    uint32                         Devices;
+
+    BCM2835_BUS_Account(BCM2835_BUS_I2C0, 0x0C, 2, 20, 0);
+    BCM2835_BUS_AccountWait(BCM2835_BUS_I2C0, 20, false);
+
+    /* A plain read leaves the counters */
+    bcm2835_bus_get_stats(&UT_BusStats, 0);
+    bcm2835_bus_get_stats(&UT_BusStats, 1);
+    Dev = UT_BusStats_FindDev(BCM2835_BUS_I2C0, 0x0C);
+    UtAssert_True(Dev != NULL && Dev->Transactions == 1 && Dev->Hist[5] == 1, "read without reset");
+    UtAssert_True(UT_BusStats.Lock[BCM2835_BUS_I2C0].Waits == 1, "waits read without reset");
+    Devices = UT_BusStats.Devices;
+
+    /* A reset clears the counters but keeps the devices in place */
+    bcm2835_bus_get_stats(&UT_BusStats, 0);
+    Dev = UT_BusStats_FindDev(BCM2835_BUS_I2C0, 0x0C);
+    UtAssert_True(UT_BusStats.Devices == Devices && Dev != NULL, "device kept");
+    UtAssert_True(Dev->Transactions == 0 && Dev->TotalUs == 0 && Dev->MaxUs == 0 && Dev->Hist[5] == 0,
+                  "device counters cleared");
+    UtAssert_True(UT_BusStats.Lock[BCM2835_BUS_I2C0].Waits == 0 && UT_BusStats.Lock[BCM2835_BUS_I2C0].MaxUs == 0,
+                  "lock counters cleared");
+
+    /* The devices are listed in order of first use */
+    UtAssert_True(UT_BusStats.Dev[0].Bus == BCM2835_BUS_I2C1 && UT_BusStats.Dev[0].Address == 0x68,
+                  "first device");
+}
+
+void Test_bcm2835_bus_get_lock_stats(void)
+{
+    /*
+     * Test Case For:
+     * int bcm2835_bus_get_lock_stats(uint8_t bus, bcm2835_lock_stats_t *stats, uint8_t reset)
+     */
+    bcm2835_lock_stats_t Stats;
+    uint8                Bus;
+
+    UT_BusStats_Lock.Stats.Acquisitions = 5;
+
+    for (Bus = 0; Bus < BCM2835_BUS_COUNT; Bus++)
+    {
+        memset(&Stats, 0, sizeof(Stats));
+        UtAssert_True(bcm2835_bus_get_lock_stats(Bus, &Stats, 0) == 1 && Stats.Acquisitions == 5, "bus %u lock",
+                      (unsigned int)Bus);
+    }
+
+    /* The I2C buses have the scheduler lock, the SPI ones the controller lock */
+    UtAssert_True(UT_GetStubCount(UT_KEY(BCM2835_I2C_SchedLock)) == 2 &&
+                      UT_GetStubCount(UT_KEY(BCM2835_SPI_DevLock)) == 2,
+                  "locks looked up");
+
+    UtAssert_True(bcm2835_bus_get_lock_stats(BCM2835_BUS_COUNT, &Stats, 0) == 0, "unknown bus");
+
+    UT_SetDeferredRetcode(UT_KEY(BCM2835_SPI_DevLock), 1, 1);
+    UtAssert_True(bcm2835_bus_get_lock_stats(BCM2835_BUS_SPI0, &Stats, 0) == 0, "controller without a lock");
+    UtAssert_True(UT_GetStubCount(UT_KEY(bcm2835_lock_get_stats)) == BCM2835_BUS_COUNT, "only locks read");
+}
+
+void Test_BCM2835_BUS_Account_Full(void)
+{
+    /*
+     * Test Case For:
+     * void BCM2835_BUS_Account(...) when every device entry is taken
+     */
+    uint32 Address;
+
+    for (Address = 0; Address < BCM2835_BUS_STATS_DEVICES; Address++)
+    {
+        BCM2835_BUS_Account(BCM2835_BUS_AUX_SPI, (uint8)Address, 1, 1, 0);
+    }
+
+    bcm2835_bus_get_stats(&UT_BusStats, 0);
+    UtAssert_True(UT_BusStats.Devices == BCM2835_BUS_STATS_DEVICES, "table full (%lu)",
+                  (unsigned long)UT_BusStats.Devices);
+
+    /* Three entries were taken by the earlier test cases, the last three devices are only counted */
+    UtAssert_True(UT_BusStats.Untracked == 3, "untracked (%lu)",
+                  (unsigned long)UT_BusStats.Untracked);
+
+    /* A device with an entry is still tracked */
+    BCM2835_BUS_Account(BCM2835_BUS_I2C1, 0x68, 1, 1, 0);
+    bcm2835_bus_get_stats(&UT_BusStats, 1);
+    UtAssert_True(UT_BusStats_FindDev(BCM2835_BUS_I2C1, 0x68)->Transactions == 1, "known device tracked");
+    UtAssert_True(UT_BusStats.Untracked == 3, "untracked unchanged");
+
+    bcm2835_bus_get_stats(&UT_BusStats, 0);
+    UtAssert_True(UT_BusStats.Untracked == 0, "untracked reset");
+}
+
+/*
+ * Setup function prior to every test
+ */
+void Bcm2835_UT_Setup(void)
+{
+    UT_ResetState(0);
+
+    bcm2835_bus_get_stats(&UT_BusStats, 1);
+}
+
+/*
+ * Teardown function after every test
+ */
+void Bcm2835_UT_TearDown(void) {}
+
+/*
+ * Register the test cases to execute with the unit test tool
+ */
+void UtTest_Setup(void)
+{
+    ADD_TEST(BCM2835_BUS_Account);
+    ADD_TEST(BCM2835_BUS_AccountWait);
+    ADD_TEST(bcm2835_bus_get_stats);
+    ADD_TEST(bcm2835_bus_get_lock_stats);
+    ADD_TEST(BCM2835_BUS_Account_Full);
+}
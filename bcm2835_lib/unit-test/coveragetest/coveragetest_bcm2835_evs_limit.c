@@ -0,0 +1,234 @@
+/*
+**  GSC-18128-1, "Core Flight Executive Version 6.7"
+**
+**  Copyright (c) 2006-2019 United States Government as represented by
+**  the Administrator of the National Aeronautics and Space Administration.
+**  All Rights Reserved.
+**
+**  Licensed under the Apache License, Version 2.0 (the "License");
+**  you may not use this file except in compliance with the License.
+**  You may obtain a copy of the License at
+**
+**    http://www.apache.org/licenses/LICENSE-2.0
+**
+**  Unless required by applicable law or agreed to in writing, software
+**  distributed under the License is distributed on an "AS IS" BASIS,
+**  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**  See the License for the specific language governing permissions and
+**  limitations under the License.
+*/
+
+/*
+** File: coveragetest_bcm2835_evs_limit.c
+**
+** Purpose:
+** Coverage Unit Test cases for the rate limited events of the BCM2835 library
+**
+** Notes:
+** The times returned by CFE_TIME_GetTime are set by each test case,
+** init reads the first and flush the next.
+*/
+
+/*
+ * Includes
+ */
+
+#include "bcm2835_lib_coveragetest_common.h"
+
+#define UT_EVS_LIMIT_EID 3 /* An ID tracked by the limiter */
+
+/*
+ * Events sent with an ID
+ */
+typedef struct
+{
+    uint16 EventID;
+    uint32 MatchCount;
+} UT_EvsLimit_CheckEvent_t;
+
+/*
+ * Hook function of CFE_EVS_SendEvent that counts the events of an ID
+ */
+static int32 UT_EvsLimit_CheckEvent_Hook(void *UserObj, int32 StubRetcode, uint32 CallCount,
+                                         const UT_StubContext_t *Context, va_list va)
+{
+    UT_EvsLimit_CheckEvent_t *State = UserObj;
+
+    if (Context->ArgCount > 0 && UT_Hook_GetArgValueByName(Context, "EventID", uint16) == State->EventID)
+    {
+        ++State->MatchCount;
+    }
+
+    return 0;
+}
+
+/*
+ * Sets the seconds returned by the next calls of CFE_TIME_GetTime
+ */
+static void UT_EvsLimit_SetTimes(CFE_TIME_SysTime_t *Times, uint32 Count, uint32 Start, uint32 Step)
+{
+    uint32 i;
+
+    memset(Times, 0, Count * sizeof(*Times));
+    for (i = 0; i < Count; i++)
+    {
+        Times[i].Seconds = Start + i * Step;
+    }
+
+    UT_SetDataBuffer(UT_KEY(CFE_TIME_GetTime), Times, Count * sizeof(*Times), false);
+}
+
+static void UT_EvsLimit_CheckEvent_Setup(UT_EvsLimit_CheckEvent_t *Evt, uint16 EventID)
+{
+    memset(Evt, 0, sizeof(*Evt));
+    Evt->EventID = EventID;
+    UT_SetVaHookFunction(UT_KEY(CFE_EVS_SendEvent), UT_EvsLimit_CheckEvent_Hook, Evt);
+}
+
+/*
+**********************************************************************************
+**          TEST CASE FUNCTIONS
+**********************************************************************************
+*/
+
+void Test_bcm2835_evs_limit_init(void)
+{
+    /*
+     * Test Case For:
+     * void bcm2835_evs_limit_init(...)
+     */
+    bcm2835_evs_limit_t Lim;
+    CFE_TIME_SysTime_t  Times[1];
+
+    UT_EvsLimit_SetTimes(Times, 1, 100, 0);
+
+    memset(&Lim, 0xFF, sizeof(Lim));
+    bcm2835_evs_limit_init(&Lim, "UT", 2, 60);
+
+    UtAssert_True(Lim.Burst == 2 && Lim.WindowS == 60, "burst and window set");
+    UtAssert_True(Lim.Entry[UT_EVS_LIMIT_EID].Sent == 0 && Lim.Entry[UT_EVS_LIMIT_EID].Suppressed == 0,
+                  "counts cleared");
+
+    /* The first window starts now, not at the first flush */
+    UtAssert_True(UT_GetStubCount(UT_KEY(CFE_TIME_GetTime)) == 1, "CFE_TIME_GetTime() called");
+    UtAssert_True(Lim.WindowStart == 100, "window starts at init (%lu)", (unsigned long)Lim.WindowStart);
+}
+
+void Test_bcm2835_evs_limit_check(void)
+{
+    /*
+     * Test Case For:
+     * int bcm2835_evs_limit_check(...)
+     */
+    bcm2835_evs_limit_t Lim;
+
+    bcm2835_evs_limit_init(&Lim, "UT", 2, 60);
+
+    UtAssert_True(bcm2835_evs_limit_check(&Lim, UT_EVS_LIMIT_EID, CFE_EVS_EventType_ERROR) == 1, "1st sent");
+    UtAssert_True(bcm2835_evs_limit_check(&Lim, UT_EVS_LIMIT_EID, CFE_EVS_EventType_ERROR) == 1, "2nd sent");
+    UtAssert_True(bcm2835_evs_limit_check(&Lim, UT_EVS_LIMIT_EID, CFE_EVS_EventType_ERROR) == 0, "3rd suppressed");
+    UtAssert_True(Lim.Entry[UT_EVS_LIMIT_EID].Suppressed == 1, "suppressed event counted (%lu)",
+                  (unsigned long)Lim.Entry[UT_EVS_LIMIT_EID].Suppressed);
+
+    /* The burst is per ID */
+    UtAssert_True(bcm2835_evs_limit_check(&Lim, UT_EVS_LIMIT_EID + 1, CFE_EVS_EventType_ERROR) == 1,
+                  "other ID sent");
+
+    /* IDs beyond the table are never limited */
+    UtAssert_True(bcm2835_evs_limit_check(&Lim, BCM2835_EVS_LIMIT_IDS, CFE_EVS_EventType_ERROR) == 1,
+                  "untracked ID sent");
+}
+
+void Test_bcm2835_evs_limit_send(void)
+{
+    /*
+     * Test Case For:
+     * void bcm2835_evs_limit_send(...)
+     */
+    bcm2835_evs_limit_t      Lim;
+    UT_EvsLimit_CheckEvent_t EventTest;
+    int                      i;
+
+    bcm2835_evs_limit_init(&Lim, "UT", 2, 60);
+    UT_EvsLimit_CheckEvent_Setup(&EventTest, UT_EVS_LIMIT_EID);
+
+    for (i = 0; i < 5; i++)
+    {
+        bcm2835_evs_limit_send(&Lim, UT_EVS_LIMIT_EID, CFE_EVS_EventType_ERROR, "UT event %d", i);
+    }
+
+    UtAssert_True(EventTest.MatchCount == 2, "burst of events sent (%u)", (unsigned int)EventTest.MatchCount);
+    UtAssert_True(Lim.Entry[UT_EVS_LIMIT_EID].Suppressed == 3, "rest counted (%lu)",
+                  (unsigned long)Lim.Entry[UT_EVS_LIMIT_EID].Suppressed);
+}
+
+void Test_bcm2835_evs_limit_flush(void)
+{
+    /*
+     * Test Case For:
+     * void bcm2835_evs_limit_flush(...)
+     */
+    bcm2835_evs_limit_t      Lim;
+    UT_EvsLimit_CheckEvent_t EventTest;
+    CFE_TIME_SysTime_t       Times[2];
+    int                      i;
+
+    /* The window is not over: nothing is reported and the counts are kept */
+    UT_EvsLimit_SetTimes(Times, 2, 100, 59);
+    bcm2835_evs_limit_init(&Lim, "UT", 1, 60);
+    for (i = 0; i < 3; i++)
+    {
+        bcm2835_evs_limit_check(&Lim, UT_EVS_LIMIT_EID, CFE_EVS_EventType_ERROR);
+    }
+
+    bcm2835_evs_limit_flush(&Lim);
+
+    UtAssert_True(UT_GetStubCount(UT_KEY(CFE_EVS_SendEvent)) == 0, "no summary inside the window");
+    UtAssert_True(Lim.Entry[UT_EVS_LIMIT_EID].Suppressed == 2, "counts kept (%lu)",
+                  (unsigned long)Lim.Entry[UT_EVS_LIMIT_EID].Suppressed);
+
+    /* The window is over: one summary per ID with suppressed events */
+    UT_EvsLimit_SetTimes(Times, 2, 100, 60);
+    bcm2835_evs_limit_init(&Lim, "UT", 1, 60);
+    for (i = 0; i < 3; i++)
+    {
+        bcm2835_evs_limit_check(&Lim, UT_EVS_LIMIT_EID, CFE_EVS_EventType_ERROR);
+    }
+    bcm2835_evs_limit_check(&Lim, UT_EVS_LIMIT_EID + 1, CFE_EVS_EventType_ERROR);
+
+    UT_EvsLimit_CheckEvent_Setup(&EventTest, UT_EVS_LIMIT_EID);
+    bcm2835_evs_limit_flush(&Lim);
+
+    UtAssert_True(EventTest.MatchCount == 1, "summary of the ID sent (%u)", (unsigned int)EventTest.MatchCount);
+    UtAssert_True(UT_GetStubCount(UT_KEY(CFE_EVS_SendEvent)) == 1, "no summary of the ID with nothing suppressed");
+
+    /* A new window starts with the full burst */
+    UtAssert_True(Lim.WindowStart == 160, "new window starts at the flush (%lu)", (unsigned long)Lim.WindowStart);
+    UtAssert_True(Lim.Entry[UT_EVS_LIMIT_EID].Suppressed == 0, "counts reset");
+    UtAssert_True(bcm2835_evs_limit_check(&Lim, UT_EVS_LIMIT_EID, CFE_EVS_EventType_ERROR) == 1,
+                  "sent in the new window");
+}
+
+/*
+ * Setup function prior to every test
+ */
+void Bcm2835_UT_Setup(void)
+{
+    UT_ResetState(0);
+}
+
+/*
+ * Teardown function after every test
+ */
+void Bcm2835_UT_TearDown(void) {}
+
+/*
+ * Register the test cases to execute with the unit test tool
+ */
+void UtTest_Setup(void)
+{
+    ADD_TEST(bcm2835_evs_limit_init);
+    ADD_TEST(bcm2835_evs_limit_check);
+    ADD_TEST(bcm2835_evs_limit_send);
+    ADD_TEST(bcm2835_evs_limit_flush);
+}
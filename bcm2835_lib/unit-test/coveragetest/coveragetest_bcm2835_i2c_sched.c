@@ -0,0 +1,500 @@
+/*
+**  GSC-18128-1, "Core Flight Executive Version 6.7"
+**
+**  Copyright (c) 2006-2019 United States Government as represented by
+**  the Administrator of the National Aeronautics and Space Administration.
+**  All Rights Reserved.
+**
+**  Licensed under the Apache License, Version 2.0 (the "License");
+**  you may not use this file except in compliance with the License.
+**  You may obtain a copy of the License at
+**
+**    http://www.apache.org/licenses/LICENSE-2.0
+**
+**  Unless required by applicable law or agreed to in writing, software
+**  distributed under the License is distributed on an "AS IS" BASIS,
+**  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**  See the License for the specific language governing permissions and
+**  limitations under the License.
+*/
+
+/*
+** File: coveragetest_bcm2835_i2c_sched.c
+**
+** Purpose:
+** Coverage Unit Test cases for the I2C bus scheduler of the BCM2835 library
+**
+** Notes:
+** The tests run in a single task. A client blocked on its wake semaphore
+** is simulated by a hook function of OS_BinSemTake, which runs what the
+** other tasks would do while it waits. The waits nest, so the clients
+** must be granted in the reverse order they started waiting.
+**
+** The scheduler time is set by each test case, see BCM2835_LIB_GetTimeUs.
+*/
+
+/*
+ * Includes
+ */
+
+#include "bcm2835_lib_coveragetest_common.h"
+
+/*
+ * A client id that no registration returns
+ */
+#define UT_I2CSCHED_INVALID_ID (BCM2835_I2C_BUS_COUNT * BCM2835_I2C_SCHED_MAX_CLIENTS)
+
+/*
+ * Scheduler time returned by BCM2835_LIB_GetTimeUs
+ */
+static uint64 UT_I2CSched_NowUs;
+
+/*
+ * Lock waits accounted as timed out, see BCM2835_BUS_AccountWait
+ */
+static uint32 UT_I2CSched_WaitTimeouts;
+
+/*
+ * Clients that wait for the bus while a holder owns it
+ */
+typedef struct
+{
+    uint32 Holder;
+    uint32 Waiters[BCM2835_I2C_SCHED_MAX_CLIENTS];
+    uint32 NumWaiters;
+    uint32 Granted[BCM2835_I2C_SCHED_MAX_CLIENTS];
+    uint32 NumGranted;
+} UT_I2CSched_Queue_t;
+
+/*
+ * The time source of the library, which is in bcm2835_lib.c
+ */
+uint64 BCM2835_LIB_GetTimeUs(void)
+{
+    return UT_I2CSched_NowUs;
+}
+
+/*
+ * The bus statistics, which are in bcm2835_bus_stats.c
+ */
+void BCM2835_BUS_AccountWait(uint8 Bus, uint32 WaitUs, bool TimedOut)
+{
+    UT_DEFAULT_IMPL(BCM2835_BUS_AccountWait);
+
+    if (TimedOut)
+    {
+        UT_I2CSched_WaitTimeouts++;
+    }
+}
+
+/*
+ * The bus lock, which is in bcm2835_lock.c
+ */
+void bcm2835_lock_init(bcm2835_lock_t *lock)
+{
+    UT_DEFAULT_IMPL(bcm2835_lock_init);
+}
+
+int32_t bcm2835_lock_acquire(bcm2835_lock_t *lock, int32_t timeout_us)
+{
+    return UT_DEFAULT_IMPL(bcm2835_lock_acquire);
+}
+
+void bcm2835_lock_release(bcm2835_lock_t *lock)
+{
+    UT_DEFAULT_IMPL(bcm2835_lock_release);
+}
+
+/*
+ * Registers a client, which must succeed
+ */
+static uint32 UT_I2CSched_Register(uint8 Bus, const char *Name, uint8 Priority, uint32 PeriodUs, uint32 DeadlineUs)
+{
+    uint32 ClientId = UT_I2CSCHED_INVALID_ID;
+
+    UtAssert_True(bcm2835_i2c_sched_register(Bus, Name, Priority, PeriodUs, DeadlineUs, &ClientId) ==
+                      BCM2835_I2C_SCHED_OK,
+                  "%s registered (%lu)", Name, (unsigned long)ClientId);
+
+    return ClientId;
+}
+
+/*
+ * Hook function of OS_BinSemTake for the waiting clients
+ *
+ * While waiter N is blocked, waiter N + 1 requests the bus. Once all of
+ * them wait, the holder releases it. Each waiter that gets the bus is
+ * recorded and releases it before its wait returns.
+ */
+static int32 UT_I2CSched_WaitHook(void *UserObj, int32 StubRetcode, uint32 CallCount,
+                                  const UT_StubContext_t *Context)
+{
+    UT_I2CSched_Queue_t *Queue = UserObj;
+    uint32               Next;
+
+    if (CallCount < Queue->NumWaiters)
+    {
+        Next = Queue->Waiters[CallCount];
+        if (bcm2835_i2c_sched_acquire(Next, BCM2835_I2C_SCHED_PEND_FOREVER) == BCM2835_I2C_SCHED_OK)
+        {
+            Queue->Granted[Queue->NumGranted++] = Next;
+            bcm2835_i2c_sched_release(Next);
+        }
+    }
+    else if (CallCount == Queue->NumWaiters)
+    {
+        bcm2835_i2c_sched_release(Queue->Holder);
+    }
+
+    return StubRetcode;
+}
+
+/*
+ * Hook function of OS_BinSemTake where the holder yields while a client waits
+ */
+static int32 UT_I2CSched_YieldHook(void *UserObj, int32 StubRetcode, uint32 CallCount,
+                                   const UT_StubContext_t *Context)
+{
+    UT_I2CSched_Queue_t *Queue = UserObj;
+
+    /* The second call is the wait of the holder itself, which returns at once */
+    if (CallCount == 1)
+    {
+        UtAssert_True(bcm2835_i2c_sched_yield(Queue->Holder) == BCM2835_I2C_SCHED_OK, "holder yields");
+    }
+
+    return StubRetcode;
+}
+
+/*
+**********************************************************************************
+**          TEST CASE FUNCTIONS
+**********************************************************************************
+*/
+
+void Test_BCM2835_I2C_SchedInit(void)
+{
+    /*
+     * Test Case For:
+     * int32 BCM2835_I2C_SchedInit(void)
+     */
+    UtAssert_True(BCM2835_I2C_SchedInit() == CFE_SUCCESS, "BCM2835_I2C_SchedInit() nominal");
+
+    /* Once by the setup and once here */
+    UtAssert_True(UT_GetStubCount(UT_KEY(bcm2835_lock_init)) == 2 * BCM2835_I2C_BUS_COUNT, "locks initialized");
+}
+
+void Test_BCM2835_I2C_SchedLock(void)
+{
+    /*
+     * Test Case For:
+     * bcm2835_lock_t *BCM2835_I2C_SchedLock(uint8 Bus)
+     */
+    UtAssert_True(BCM2835_I2C_SchedLock(BCM2835_I2C_BUS_BSC0) != NULL, "BSC0 lock");
+    UtAssert_True(BCM2835_I2C_SchedLock(BCM2835_I2C_BUS_BSC1) != BCM2835_I2C_SchedLock(BCM2835_I2C_BUS_BSC0),
+                  "one lock per bus");
+    UtAssert_True(BCM2835_I2C_SchedLock(BCM2835_I2C_BUS_COUNT) == NULL, "unknown bus");
+}
+
+void Test_bcm2835_i2c_sched_register(void)
+{
+    /*
+     * Test Case For:
+     * int32_t bcm2835_i2c_sched_register(...)
+     */
+    uint32 ClientId;
+    uint32 i;
+
+    UtAssert_True(bcm2835_i2c_sched_register(BCM2835_I2C_BUS_BSC1, NULL, 0, 1000, 0, &ClientId) ==
+                      BCM2835_I2C_SCHED_ERR_INVALID,
+                  "NULL name rejected");
+    UtAssert_True(bcm2835_i2c_sched_register(BCM2835_I2C_BUS_BSC1, "UT", 0, 1000, 0, NULL) ==
+                      BCM2835_I2C_SCHED_ERR_INVALID,
+                  "NULL client id rejected");
+
+    /* The slot is not taken when its semaphore cannot be created */
+    UT_SetDeferredRetcode(UT_KEY(OS_BinSemCreate), 1, OS_ERROR);
+    UtAssert_True(bcm2835_i2c_sched_register(BCM2835_I2C_BUS_BSC1, "UT", 0, 1000, 0, &ClientId) ==
+                      BCM2835_I2C_SCHED_ERR_OS,
+                  "semaphore error");
+
+    UtAssert_True(bcm2835_i2c_sched_register(BCM2835_I2C_BUS_COUNT, "UT", 0, 1000, 0, &ClientId) ==
+                      BCM2835_I2C_SCHED_ERR_INVALID,
+                  "unknown bus rejected");
+
+    /* Each bus has its own clients */
+    for (i = 0; i < BCM2835_I2C_SCHED_MAX_CLIENTS; i++)
+    {
+        ClientId = UT_I2CSched_Register(BCM2835_I2C_BUS_BSC1, "UT", 0, 1000, 0);
+        UtAssert_True(ClientId != UT_I2CSCHED_INVALID_ID, "client %lu", (unsigned long)i);
+    }
+
+    UtAssert_True(bcm2835_i2c_sched_register(BCM2835_I2C_BUS_BSC1, "UT", 0, 1000, 0, &ClientId) ==
+                      BCM2835_I2C_SCHED_ERR_FULL,
+                  "no free slot");
+    UtAssert_True(bcm2835_i2c_sched_register(BCM2835_I2C_BUS_BSC0, "UT", 0, 1000, 0, &ClientId) ==
+                      BCM2835_I2C_SCHED_OK,
+                  "other bus not full");
+
+    /* Unknown ids are rejected by every call */
+    ClientId = UT_I2CSCHED_INVALID_ID;
+    UtAssert_True(bcm2835_i2c_sched_start_job(ClientId) == BCM2835_I2C_SCHED_ERR_INVALID, "start_job invalid id");
+    UtAssert_True(bcm2835_i2c_sched_acquire(ClientId, 0) == BCM2835_I2C_SCHED_ERR_INVALID, "acquire invalid id");
+    UtAssert_True(bcm2835_i2c_sched_release(ClientId) == BCM2835_I2C_SCHED_ERR_INVALID, "release invalid id");
+    UtAssert_True(bcm2835_i2c_sched_yield(ClientId) == BCM2835_I2C_SCHED_ERR_INVALID, "yield invalid id");
+    UtAssert_True(bcm2835_i2c_sched_get_stats(0, NULL) == BCM2835_I2C_SCHED_ERR_INVALID, "get_stats NULL");
+}
+
+void Test_bcm2835_i2c_sched_acquire(void)
+{
+    /*
+     * Test Case For:
+     * int32_t bcm2835_i2c_sched_acquire(...)
+     */
+    bcm2835_i2c_sched_stats_t Stats;
+    uint32                    Holder = UT_I2CSched_Register(BCM2835_I2C_BUS_BSC1, "HOLDER", 0, 1000, 0);
+    uint32                    Other  = UT_I2CSched_Register(BCM2835_I2C_BUS_BSC1, "OTHER", 0, 1000, 0);
+    uint32                    OtherBus;
+
+    /* A free bus is granted at once, and again to its owner */
+    UtAssert_True(bcm2835_i2c_sched_acquire(Holder, 0) == BCM2835_I2C_SCHED_OK, "free bus granted");
+    UtAssert_True(bcm2835_i2c_sched_acquire(Holder, 0) == BCM2835_I2C_SCHED_OK, "owner granted again");
+    UtAssert_True(UT_GetStubCount(UT_KEY(OS_BinSemTake)) == 0, "no wait");
+
+    /* A busy bus is not granted without a wait */
+    UtAssert_True(bcm2835_i2c_sched_acquire(Other, 0) == BCM2835_I2C_SCHED_ERR_TIMEOUT, "busy bus, no wait");
+
+    UT_SetDeferredRetcode(UT_KEY(OS_BinSemTimedWait), 1, OS_SEM_TIMEOUT);
+    UtAssert_True(bcm2835_i2c_sched_acquire(Other, 10) == BCM2835_I2C_SCHED_ERR_TIMEOUT, "busy bus, timeout");
+
+    UT_SetDeferredRetcode(UT_KEY(OS_BinSemTake), 1, OS_ERROR);
+    UtAssert_True(bcm2835_i2c_sched_acquire(Other, BCM2835_I2C_SCHED_PEND_FOREVER) == BCM2835_I2C_SCHED_ERR_OS,
+                  "busy bus, semaphore error");
+
+    bcm2835_i2c_sched_get_stats(Other, &Stats);
+    UtAssert_True(Stats.Timeouts == 3 && Stats.Grants == 0, "timeouts counted (%lu)", (unsigned long)Stats.Timeouts);
+    UtAssert_True(UT_GetStubCount(UT_KEY(BCM2835_BUS_AccountWait)) == 4 && UT_I2CSched_WaitTimeouts == 3,
+                  "lock waits accounted");
+    UtAssert_True(UT_GetStubCount(UT_KEY(bcm2835_lock_acquire)) == UT_GetStubCount(UT_KEY(bcm2835_lock_release)),
+                  "lock released on every path");
+
+    /* The bus is released by its owner only */
+    UtAssert_True(bcm2835_i2c_sched_release(Other) == BCM2835_I2C_SCHED_ERR_NOT_OWNER, "release by other");
+    UtAssert_True(bcm2835_i2c_sched_release(Holder) == BCM2835_I2C_SCHED_OK, "release by owner");
+    UtAssert_True(bcm2835_i2c_sched_acquire(Other, 0) == BCM2835_I2C_SCHED_OK, "released bus granted");
+
+    bcm2835_i2c_sched_get_stats(Holder, &Stats);
+    UtAssert_True(Stats.Grants == 1, "holder granted once (%lu)", (unsigned long)Stats.Grants);
+
+    /* The other bus is arbitrated on its own */
+    OtherBus = UT_I2CSched_Register(BCM2835_I2C_BUS_BSC0, "OTHER_BUS", 0, 1000, 0);
+    UtAssert_True(bcm2835_i2c_sched_acquire(OtherBus, 0) == BCM2835_I2C_SCHED_OK, "other bus granted");
+}
+
+void Test_bcm2835_i2c_sched_EdfOrder(void)
+{
+    /*
+     * Test Case For:
+     * Earliest deadline first grant order of the waiting clients
+     */
+    UT_I2CSched_Queue_t       Queue;
+    bcm2835_i2c_sched_stats_t Stats;
+    uint32                    NoDeadlineLow  = UT_I2CSched_Register(BCM2835_I2C_BUS_BSC1, "NODL_LOW", 20, 0, 0);
+    uint32                    NoDeadlineHigh = UT_I2CSched_Register(BCM2835_I2C_BUS_BSC1, "NODL_HIGH", 0, 0, 0);
+    uint32                    Lax            = UT_I2CSched_Register(BCM2835_I2C_BUS_BSC1, "LAX", 1, 10000, 5000);
+    uint32                    Tight          = UT_I2CSched_Register(BCM2835_I2C_BUS_BSC1, "TIGHT", 5, 10000, 1000);
+    uint32                    i;
+
+    memset(&Queue, 0, sizeof(Queue));
+    Queue.Holder = UT_I2CSched_Register(BCM2835_I2C_BUS_BSC1, "HOLDER", 0, 0, 0);
+
+    UtAssert_True(bcm2835_i2c_sched_acquire(Queue.Holder, 0) == BCM2835_I2C_SCHED_OK, "holder granted");
+
+    /*
+     * The clients start waiting from the least to the most urgent, a FIFO
+     * would grant them in that order. The deadline comes before the priority,
+     * and clients without a deadline come last, by priority.
+     */
+    Queue.Waiters[Queue.NumWaiters++] = NoDeadlineLow;
+    Queue.Waiters[Queue.NumWaiters++] = NoDeadlineHigh;
+    Queue.Waiters[Queue.NumWaiters++] = Lax;
+    Queue.Waiters[Queue.NumWaiters++] = Tight;
+
+    UT_SetHookFunction(UT_KEY(OS_BinSemTake), UT_I2CSched_WaitHook, &Queue);
+
+    UT_I2CSched_NowUs = 100;
+    if (bcm2835_i2c_sched_acquire(Queue.Waiters[0], BCM2835_I2C_SCHED_PEND_FOREVER) == BCM2835_I2C_SCHED_OK)
+    {
+        Queue.Granted[Queue.NumGranted++] = Queue.Waiters[0];
+        bcm2835_i2c_sched_release(Queue.Waiters[0]);
+    }
+
+    UtAssert_True(Queue.NumGranted == 4, "all waiters granted (%lu)", (unsigned long)Queue.NumGranted);
+    UtAssert_True(Queue.Granted[0] == Tight, "1st grant to the earliest deadline");
+    UtAssert_True(Queue.Granted[1] == Lax, "2nd grant to the next deadline");
+    UtAssert_True(Queue.Granted[2] == NoDeadlineHigh, "3rd grant to the higher priority without deadline");
+    UtAssert_True(Queue.Granted[3] == NoDeadlineLow, "4th grant to the lower priority without deadline");
+
+    for (i = 0; i < Queue.NumWaiters; i++)
+    {
+        bcm2835_i2c_sched_get_stats(Queue.Waiters[i], &Stats);
+        UtAssert_True(Stats.Grants == 1 && Stats.Timeouts == 0, "waiter %lu granted once", (unsigned long)i);
+    }
+
+    /* The bus is free again */
+    UtAssert_True(bcm2835_i2c_sched_acquire(Queue.Holder, 0) == BCM2835_I2C_SCHED_OK, "bus free");
+}
+
+void Test_bcm2835_i2c_sched_yield(void)
+{
+    /*
+     * Test Case For:
+     * int32_t bcm2835_i2c_sched_yield(...)
+     */
+    UT_I2CSched_Queue_t       Queue;
+    bcm2835_i2c_sched_stats_t Stats;
+    uint32                    Urgent = UT_I2CSched_Register(BCM2835_I2C_BUS_BSC1, "URGENT", 0, 10000, 1000);
+
+    memset(&Queue, 0, sizeof(Queue));
+    Queue.Holder = UT_I2CSched_Register(BCM2835_I2C_BUS_BSC1, "HOLDER", 0, 0, 0);
+
+    /* Only the owner can yield, and keeps the bus if nobody is more urgent */
+    UtAssert_True(bcm2835_i2c_sched_yield(Queue.Holder) == BCM2835_I2C_SCHED_ERR_NOT_OWNER, "yield by other");
+    UtAssert_True(bcm2835_i2c_sched_acquire(Queue.Holder, 0) == BCM2835_I2C_SCHED_OK, "holder granted");
+    UtAssert_True(bcm2835_i2c_sched_yield(Queue.Holder) == BCM2835_I2C_SCHED_OK, "yield without waiters");
+    UtAssert_True(bcm2835_i2c_sched_acquire(Urgent, 0) == BCM2835_I2C_SCHED_ERR_TIMEOUT, "holder kept the bus");
+
+    /* A more urgent waiter gets the bus, which comes back on its release */
+    UT_SetHookFunction(UT_KEY(OS_BinSemTake), UT_I2CSched_YieldHook, &Queue);
+    UtAssert_True(bcm2835_i2c_sched_acquire(Urgent, BCM2835_I2C_SCHED_PEND_FOREVER) == BCM2835_I2C_SCHED_OK,
+                  "urgent client granted by the yield");
+    UtAssert_True(bcm2835_i2c_sched_release(Urgent) == BCM2835_I2C_SCHED_OK, "urgent client releases");
+    UtAssert_True(bcm2835_i2c_sched_release(Queue.Holder) == BCM2835_I2C_SCHED_OK, "bus back to the holder");
+
+    bcm2835_i2c_sched_get_stats(Queue.Holder, &Stats);
+    UtAssert_True(Stats.Preemptions == 1 && Stats.Grants == 2, "holder preempted (%lu) and granted again (%lu)",
+                  (unsigned long)Stats.Preemptions, (unsigned long)Stats.Grants);
+}
+
+void Test_bcm2835_i2c_sched_DeadlineMiss(void)
+{
+    /*
+     * Test Case For:
+     * Deadline miss count of bcm2835_i2c_sched_start_job/release
+     */
+    bcm2835_i2c_sched_stats_t Stats;
+    uint32                    Client   = UT_I2CSched_Register(BCM2835_I2C_BUS_BSC1, "CLIENT", 0, 2000, 1000);
+    uint32                    Periodic = UT_I2CSched_Register(BCM2835_I2C_BUS_BSC1, "PERIODIC", 0, 2000, 0);
+
+    /* Released before the deadline */
+    UT_I2CSched_NowUs = 0;
+    bcm2835_i2c_sched_start_job(Client);
+    UT_I2CSched_NowUs = 500;
+    bcm2835_i2c_sched_acquire(Client, 0);
+    UT_I2CSched_NowUs = 800;
+    bcm2835_i2c_sched_release(Client);
+
+    bcm2835_i2c_sched_get_stats(Client, &Stats);
+    UtAssert_True(Stats.DeadlineMisses == 0, "job in time");
+
+    /* Released after the deadline */
+    UT_I2CSched_NowUs = 2000;
+    bcm2835_i2c_sched_start_job(Client);
+    UT_I2CSched_NowUs = 2100;
+    bcm2835_i2c_sched_acquire(Client, 0);
+    UT_I2CSched_NowUs = 3500;
+    bcm2835_i2c_sched_release(Client);
+
+    bcm2835_i2c_sched_get_stats(Client, &Stats);
+    UtAssert_True(Stats.DeadlineMisses == 1, "late release missed (%lu)", (unsigned long)Stats.DeadlineMisses);
+    UtAssert_True(Stats.MaxHoldUs == 1400, "hold time (%lu)", (unsigned long)Stats.MaxHoldUs);
+
+    /* A job that never got the bus is missed when the next one starts */
+    UT_I2CSched_NowUs = 4000;
+    bcm2835_i2c_sched_start_job(Client);
+    UT_I2CSched_NowUs = 6000;
+    bcm2835_i2c_sched_start_job(Client);
+    bcm2835_i2c_sched_acquire(Client, 0);
+    bcm2835_i2c_sched_release(Client);
+
+    bcm2835_i2c_sched_get_stats(Client, &Stats);
+    UtAssert_True(Stats.DeadlineMisses == 2, "skipped job missed (%lu)", (unsigned long)Stats.DeadlineMisses);
+    UtAssert_True(Stats.Jobs == 4, "jobs counted (%lu)", (unsigned long)Stats.Jobs);
+
+    /* Without a deadline the period is used, and acquire starts the job */
+    UT_I2CSched_NowUs = 10000;
+    bcm2835_i2c_sched_acquire(Periodic, 0);
+    UT_I2CSched_NowUs = 12500;
+    bcm2835_i2c_sched_release(Periodic);
+
+    bcm2835_i2c_sched_get_stats(Periodic, &Stats);
+    UtAssert_True(Stats.Jobs == 1 && Stats.DeadlineMisses == 1, "period used as deadline (%lu)",
+                  (unsigned long)Stats.DeadlineMisses);
+}
+
+void Test_bcm2835_i2c_sched_set_period(void)
+{
+    /*
+     * Test Case For:
+     * int32_t bcm2835_i2c_sched_set_period(uint32_t client_id, uint32_t period_us, uint32_t deadline_us)
+     */
+    bcm2835_i2c_sched_stats_t Stats;
+    uint32                    Client = UT_I2CSched_Register(BCM2835_I2C_BUS_BSC1, "CLIENT", 0, 10000, 0);
+
+    UtAssert_True(bcm2835_i2c_sched_set_period(UT_I2CSCHED_INVALID_ID, 1000, 0) == BCM2835_I2C_SCHED_ERR_INVALID,
+                  "invalid id");
+
+    /* The next job gets the new deadline */
+    UtAssert_True(bcm2835_i2c_sched_set_period(Client, 2000, 500) == BCM2835_I2C_SCHED_OK, "deadline set");
+    UT_I2CSched_NowUs = 0;
+    bcm2835_i2c_sched_start_job(Client);
+    bcm2835_i2c_sched_acquire(Client, 0);
+    UT_I2CSched_NowUs = 800;
+    bcm2835_i2c_sched_release(Client);
+
+    bcm2835_i2c_sched_get_stats(Client, &Stats);
+    UtAssert_True(Stats.DeadlineMisses == 1, "new deadline (%lu)", (unsigned long)Stats.DeadlineMisses);
+
+    /* Without a deadline the new period is used */
+    UtAssert_True(bcm2835_i2c_sched_set_period(Client, 2000, 0) == BCM2835_I2C_SCHED_OK, "period set");
+    UT_I2CSched_NowUs = 2000;
+    bcm2835_i2c_sched_start_job(Client);
+    bcm2835_i2c_sched_acquire(Client, 0);
+    UT_I2CSched_NowUs = 3500;
+    bcm2835_i2c_sched_release(Client);
+
+    bcm2835_i2c_sched_get_stats(Client, &Stats);
+    UtAssert_True(Stats.DeadlineMisses == 1, "period used as deadline (%lu)", (unsigned long)Stats.DeadlineMisses);
+}
+
+/*
+ * Setup function prior to every test
+ */
+void Bcm2835_UT_Setup(void)
+{
+    UT_ResetState(0);
+
+    UT_I2CSched_NowUs        = 0;
+    UT_I2CSched_WaitTimeouts = 0;
+    BCM2835_I2C_SchedInit();
+}
+
+/*
+ * Teardown function after every test
+ */
+void Bcm2835_UT_TearDown(void) {}
+
+/*
+ * Register the test cases to execute with the unit test tool
+ */
+void UtTest_Setup(void)
+{
+    ADD_TEST(BCM2835_I2C_SchedInit);
+    ADD_TEST(BCM2835_I2C_SchedLock);
+    ADD_TEST(bcm2835_i2c_sched_register);
+    ADD_TEST(bcm2835_i2c_sched_acquire);
+    ADD_TEST(bcm2835_i2c_sched_EdfOrder);
+    ADD_TEST(bcm2835_i2c_sched_yield);
+    ADD_TEST(bcm2835_i2c_sched_DeadlineMiss);
+    ADD_TEST(bcm2835_i2c_sched_set_period);
+}
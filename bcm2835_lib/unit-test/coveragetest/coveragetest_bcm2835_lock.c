@@ -0,0 +1,279 @@
+/*
+**  GSC-18128-1, "Core Flight Executive Version 6.7"
+**
+**  Copyright (c) 2006-2019 United States Government as represented by
+**  the Administrator of the National Aeronautics and Space Administration.
+**  All Rights Reserved.
+**
+**  Licensed under the Apache License, Version 2.0 (the "License");
+**  you may not use this file except in compliance with the License.
+**  You may obtain a copy of the License at
+**
+**    http://www.apache.org/licenses/LICENSE-2.0
+**
+**  Unless required by applicable law or agreed to in writing, software
+**  distributed under the License is distributed on an "AS IS" BASIS,
+**  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**  See the License for the specific language governing permissions and
+**  limitations under the License.
+*/
+
+/*
+** File: coveragetest_bcm2835_lock.c
+**
+** Purpose:
+** Coverage Unit Test cases for the bus lock of the BCM2835 library
+**
+** Notes:
+** The lock is a futex, so it runs on the kernel of the host. The other
+** owner of a contended lock is a thread of the test, which takes the lock,
+** reports that it holds it and releases it after UT_LOCK_HOLD_US or once
+** the test case tells it to.
+*/
+
+/*
+ * Includes
+ */
+
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bcm2835_lib_coveragetest_common.h"
+
+/*
+ * Time the other owner holds the lock, in microseconds
+ */
+#define UT_LOCK_HOLD_US 5000
+
+/*
+ * The other owner of the lock
+ */
+typedef struct
+{
+    pthread_t       Thread;
+    bcm2835_lock_t *Lock;
+    uint32          HoldUs; /* 0 to hold until Release is set */
+    uint32          Held;
+    uint32          Release;
+} UT_Lock_Owner_t;
+
+/*
+ * The time source of the library, which is in bcm2835_lib.c
+ */
+uint64 BCM2835_LIB_GetTimeUs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ((uint64)ts.tv_sec * 1000000) + ((uint64)ts.tv_nsec / 1000);
+}
+
+static void *UT_Lock_OwnerMain(void *Arg)
+{
+    UT_Lock_Owner_t *Owner = Arg;
+
+    bcm2835_lock_acquire(Owner->Lock, BCM2835_LOCK_PEND_FOREVER);
+    __atomic_store_n(&Owner->Held, 1, __ATOMIC_RELEASE);
+
+    if (Owner->HoldUs != 0)
+    {
+        usleep(Owner->HoldUs);
+    }
+    else
+    {
+        while (!__atomic_load_n(&Owner->Release, __ATOMIC_ACQUIRE))
+        {
+            usleep(100);
+        }
+    }
+
+    bcm2835_lock_release(Owner->Lock);
+
+    return NULL;
+}
+
+/*
+ * Starts the other owner and returns once it holds the lock
+ */
+static void UT_Lock_StartOwner(UT_Lock_Owner_t *Owner, bcm2835_lock_t *Lock, uint32 HoldUs)
+{
+    memset(Owner, 0, sizeof(*Owner));
+    Owner->Lock   = Lock;
+    Owner->HoldUs = HoldUs;
+
+    UtAssert_True(pthread_create(&Owner->Thread, NULL, UT_Lock_OwnerMain, Owner) == 0, "owner started");
+
+    while (!__atomic_load_n(&Owner->Held, __ATOMIC_ACQUIRE))
+    {
+        usleep(100);
+    }
+}
+
+static void UT_Lock_StopOwner(UT_Lock_Owner_t *Owner)
+{
+    __atomic_store_n(&Owner->Release, 1, __ATOMIC_RELEASE);
+    pthread_join(Owner->Thread, NULL);
+}
+
+/*
+**********************************************************************************
+**          TEST CASE FUNCTIONS
+**********************************************************************************
+*/
+
+void Test_bcm2835_lock_init(void)
+{
+    /*
+     * Test Case For:
+     * void bcm2835_lock_init(bcm2835_lock_t *lock)
+     */
+    bcm2835_lock_t Lock;
+
+    memset(&Lock, 0xA5, sizeof(Lock));
+    bcm2835_lock_init(&Lock);
+
+    UtAssert_True(Lock.Word == 0 && Lock.Spins == 0, "lock free");
+    UtAssert_True(Lock.Stats.Acquisitions == 0 && Lock.Stats.WaitMaxUs == 0, "stats cleared");
+}
+
+void Test_bcm2835_lock_acquire(void)
+{
+    /*
+     * Test Case For:
+     * int32_t bcm2835_lock_acquire(bcm2835_lock_t *lock, int32_t timeout_us) without contention
+     */
+    bcm2835_lock_t       Lock;
+    bcm2835_lock_stats_t Stats;
+
+    bcm2835_lock_init(&Lock);
+
+    UtAssert_True(bcm2835_lock_acquire(&Lock, 0) == BCM2835_LOCK_OK, "free lock taken");
+    UtAssert_True(Lock.Word != 0, "lock held");
+
+    /* The owner cannot take the lock again */
+    UtAssert_True(bcm2835_lock_acquire(&Lock, 0) == BCM2835_LOCK_ERR_TIMEOUT, "owner polling");
+    UtAssert_True(bcm2835_lock_acquire(&Lock, BCM2835_LOCK_PEND_FOREVER) == BCM2835_LOCK_ERR_OS, "owner waiting");
+
+    bcm2835_lock_release(&Lock);
+    UtAssert_True(Lock.Word == 0, "lock released");
+
+    UtAssert_True(bcm2835_lock_acquire(&Lock, BCM2835_LOCK_PEND_FOREVER) == BCM2835_LOCK_OK, "lock taken again");
+    bcm2835_lock_release(&Lock);
+
+    bcm2835_lock_get_stats(&Lock, &Stats, 0);
+    UtAssert_True(Stats.Acquisitions == 2 && Stats.Contended == 0, "acquisitions (%lu)",
+                  (unsigned long)Stats.Acquisitions);
+    UtAssert_True(Stats.Timeouts == 2, "failed acquisitions (%lu)", (unsigned long)Stats.Timeouts);
+}
+
+void Test_bcm2835_lock_acquire_Timeout(void)
+{
+    /*
+     * Test Case For:
+     * int32_t bcm2835_lock_acquire(bcm2835_lock_t *lock, int32_t timeout_us) on a lock held by another thread
+     */
+    bcm2835_lock_t       Lock;
+    bcm2835_lock_stats_t Stats;
+    UT_Lock_Owner_t      Owner;
+    uint64               StartUs;
+
+    bcm2835_lock_init(&Lock);
+    UT_Lock_StartOwner(&Owner, &Lock, 0);
+
+    /* A try does not wait */
+    UtAssert_True(bcm2835_lock_acquire(&Lock, 0) == BCM2835_LOCK_ERR_TIMEOUT, "try on a held lock");
+
+    /* A timed acquisition waits for the whole timeout */
+    StartUs = BCM2835_LIB_GetTimeUs();
+    UtAssert_True(bcm2835_lock_acquire(&Lock, 2000) == BCM2835_LOCK_ERR_TIMEOUT, "timeout on a held lock");
+    UtAssert_True(BCM2835_LIB_GetTimeUs() - StartUs >= 2000, "waited for the timeout");
+
+    UT_Lock_StopOwner(&Owner);
+
+    UtAssert_True(bcm2835_lock_acquire(&Lock, 0) == BCM2835_LOCK_OK, "released lock taken");
+    bcm2835_lock_release(&Lock);
+
+    bcm2835_lock_get_stats(&Lock, &Stats, 0);
+    UtAssert_True(Stats.Timeouts == 2 && Stats.Contended == 0, "timeouts (%lu)", (unsigned long)Stats.Timeouts);
+    UtAssert_True(Stats.Acquisitions == 2, "acquisitions of both owners");
+}
+
+void Test_bcm2835_lock_acquire_Contended(void)
+{
+    /*
+     * Test Case For:
+     * int32_t bcm2835_lock_acquire(bcm2835_lock_t *lock, int32_t timeout_us) on a lock released while waiting
+     */
+    bcm2835_lock_t       Lock;
+    bcm2835_lock_stats_t Stats;
+    UT_Lock_Owner_t      Owner;
+
+    bcm2835_lock_init(&Lock);
+
+    /* The lock is handed over when its owner releases it */
+    UT_Lock_StartOwner(&Owner, &Lock, UT_LOCK_HOLD_US);
+    UtAssert_True(bcm2835_lock_acquire(&Lock, BCM2835_LOCK_PEND_FOREVER) == BCM2835_LOCK_OK, "pending acquisition");
+    bcm2835_lock_release(&Lock);
+    pthread_join(Owner.Thread, NULL);
+
+    UT_Lock_StartOwner(&Owner, &Lock, UT_LOCK_HOLD_US);
+    UtAssert_True(bcm2835_lock_acquire(&Lock, 10 * UT_LOCK_HOLD_US) == BCM2835_LOCK_OK, "timed acquisition");
+    bcm2835_lock_release(&Lock);
+    pthread_join(Owner.Thread, NULL);
+
+    bcm2835_lock_get_stats(&Lock, &Stats, 0);
+    UtAssert_True(Stats.Contended == 2 && Stats.Timeouts == 0, "contended (%lu)", (unsigned long)Stats.Contended);
+    UtAssert_True(Stats.WaitMaxUs > 0 && Stats.WaitMaxUs <= Stats.WaitTotalUs, "waits (%lu, %lu)",
+                  (unsigned long)Stats.WaitMaxUs, (unsigned long)Stats.WaitTotalUs);
+    UtAssert_True(Stats.HoldMaxUs >= UT_LOCK_HOLD_US, "hold time of the other owner (%lu)",
+                  (unsigned long)Stats.HoldMaxUs);
+    UtAssert_True(Lock.Word == 0, "lock free");
+}
+
+void Test_bcm2835_lock_get_stats(void)
+{
+    /*
+     * Test Case For:
+     * void bcm2835_lock_get_stats(bcm2835_lock_t *lock, bcm2835_lock_stats_t *stats, uint8_t reset)
+     */
+    bcm2835_lock_t       Lock;
+    bcm2835_lock_stats_t Stats;
+
+    bcm2835_lock_init(&Lock);
+    bcm2835_lock_acquire(&Lock, 0);
+    bcm2835_lock_acquire(&Lock, 0);
+    bcm2835_lock_release(&Lock);
+
+    bcm2835_lock_get_stats(&Lock, &Stats, 1);
+    UtAssert_True(Stats.Acquisitions == 1 && Stats.Timeouts == 1, "read with reset");
+
+    bcm2835_lock_get_stats(&Lock, &Stats, 0);
+    UtAssert_True(Stats.Acquisitions == 0 && Stats.Timeouts == 0 && Stats.HoldTotalUs == 0, "stats cleared");
+}
+
+/*
+ * Setup function prior to every test
+ */
+void Bcm2835_UT_Setup(void)
+{
+    UT_ResetState(0);
+}
+
+/*
+ * Teardown function after every test
+ */
+void Bcm2835_UT_TearDown(void) {}
+
+/*
+ * Register the test cases to execute with the unit test tool
+ */
+void UtTest_Setup(void)
+{
+    ADD_TEST(bcm2835_lock_init);
+    ADD_TEST(bcm2835_lock_acquire);
+    ADD_TEST(bcm2835_lock_acquire_Timeout);
+    ADD_TEST(bcm2835_lock_acquire_Contended);
+    ADD_TEST(bcm2835_lock_get_stats);
+}
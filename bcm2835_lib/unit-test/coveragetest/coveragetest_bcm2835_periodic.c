@@ -0,0 +1,202 @@
+/*
+**  GSC-18128-1, "Core Flight Executive Version 6.7"
+**
+**  Copyright (c) 2006-2019 United States Government as represented by
+**  the Administrator of the National Aeronautics and Space Administration.
+**  All Rights Reserved.
+**
+**  Licensed under the Apache License, Version 2.0 (the "License");
+**  you may not use this file except in compliance with the License.
+**  You may obtain a copy of the License at
+**
+**    http://www.apache.org/licenses/LICENSE-2.0
+**
+**  Unless required by applicable law or agreed to in writing, software
+**  distributed under the License is distributed on an "AS IS" BASIS,
+**  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**  See the License for the specific language governing permissions and
+**  limitations under the License.
+*/
+
+/*
+** File: coveragetest_bcm2835_periodic.c
+**
+** Purpose:
+** Coverage Unit Test cases for the periodic wakeup of the BCM2835 library
+**
+** Notes:
+** The periodic wakeup runs on the real CLOCK_MONOTONIC. A caller that is
+** late is simulated by moving the next deadline of the wakeup into the
+** past, relative to the time read by the test case. The periods are long
+** enough for the result not to depend on the scheduling of the test.
+*/
+
+/*
+ * Includes
+ */
+
+#include <time.h>
+
+#include "bcm2835_lib_coveragetest_common.h"
+
+/*
+ * Period used by the test cases, in microseconds
+ */
+#define UT_PERIODIC_PERIOD_US 100000
+
+#define UT_PERIODIC_PERIOD_NS ((uint64)UT_PERIODIC_PERIOD_US * 1000)
+
+/*
+ * Reads CLOCK_MONOTONIC in nanoseconds, as the periodic wakeup does
+ */
+static uint64 UT_Periodic_NowNs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ((uint64)ts.tv_sec * 1000000000ULL) + (uint64)ts.tv_nsec;
+}
+
+/*
+**********************************************************************************
+**          TEST CASE FUNCTIONS
+**********************************************************************************
+*/
+
+void Test_bcm2835_periodic_init(void)
+{
+    /*
+     * Test Case For:
+     * int bcm2835_periodic_init(bcm2835_periodic_t *p, uint32_t period_us)
+     */
+    bcm2835_periodic_t Periodic;
+    uint64             Before;
+
+    UtAssert_True(bcm2835_periodic_init(NULL, UT_PERIODIC_PERIOD_US) == 0, "NULL wakeup rejected");
+    UtAssert_True(bcm2835_periodic_init(&Periodic, 0) == 0, "zero period rejected");
+
+    Before = UT_Periodic_NowNs();
+    UtAssert_True(bcm2835_periodic_init(&Periodic, UT_PERIODIC_PERIOD_US) == 1, "bcm2835_periodic_init() nominal");
+    UtAssert_True(Periodic.PeriodNs == UT_PERIODIC_PERIOD_NS, "period");
+    UtAssert_True(Periodic.NextNs >= Before + UT_PERIODIC_PERIOD_NS, "first deadline one period from now");
+    UtAssert_True(Periodic.SpinMaxNs == BCM2835_PERIODIC_SPIN_MAX_NS, "default spin bound");
+    UtAssert_True(Periodic.Stats.Periods == 0 && Periodic.Stats.SleepMarginNs > 0, "initial stats");
+}
+
+void Test_bcm2835_periodic_wait(void)
+{
+    /*
+     * Test Case For:
+     * uint32_t bcm2835_periodic_wait(bcm2835_periodic_t *p) on time
+     */
+    bcm2835_periodic_t       Periodic;
+    bcm2835_periodic_stats_t Stats;
+    uint64                   Deadline;
+
+    bcm2835_periodic_init(&Periodic, 2000);
+    Deadline = Periodic.NextNs;
+
+    UtAssert_True(bcm2835_periodic_wait(&Periodic) == 0, "nothing skipped");
+    UtAssert_True(UT_Periodic_NowNs() >= Deadline, "woken at the deadline");
+    UtAssert_True(Periodic.NextNs == Deadline + 2000000, "next deadline one period later");
+
+    bcm2835_periodic_get_stats(&Periodic, &Stats);
+    UtAssert_True(Stats.Periods == 1 && Stats.Overruns == 0, "one period");
+    UtAssert_True(Stats.SleepMarginNs <= Periodic.SpinMaxNs, "margin within the spin bound (%lu)",
+                  (unsigned long)Stats.SleepMarginNs);
+
+    /* Without a spin the wakeup sleeps up to the deadline */
+    Periodic.SpinMaxNs = 0;
+    Deadline           = Periodic.NextNs;
+    UtAssert_True(bcm2835_periodic_wait(&Periodic) == 0, "nothing skipped without spin");
+    UtAssert_True(UT_Periodic_NowNs() >= Deadline, "woken at the deadline without spin");
+
+    bcm2835_periodic_get_stats(&Periodic, &Stats);
+    UtAssert_True(Stats.Periods == 2 && Stats.SleepMarginNs == 0, "margin bound by the spin");
+}
+
+void Test_bcm2835_periodic_wait_Late(void)
+{
+    /*
+     * Test Case For:
+     * uint32_t bcm2835_periodic_wait(bcm2835_periodic_t *p) less than a period late
+     */
+    bcm2835_periodic_t       Periodic;
+    bcm2835_periodic_stats_t Stats;
+    uint64                   Deadline;
+
+    bcm2835_periodic_init(&Periodic, UT_PERIODIC_PERIOD_US);
+    Deadline        = UT_Periodic_NowNs() - (UT_PERIODIC_PERIOD_NS / 2);
+    Periodic.NextNs = Deadline;
+
+    /* The deadline is kept, so the next period is shorter */
+    UtAssert_True(bcm2835_periodic_wait(&Periodic) == 0, "nothing skipped");
+    UtAssert_True(Periodic.NextNs == Deadline + UT_PERIODIC_PERIOD_NS, "next deadline one period later");
+
+    bcm2835_periodic_get_stats(&Periodic, &Stats);
+    UtAssert_True(Stats.Periods == 1 && Stats.Overruns == 0, "one period");
+    UtAssert_True(Stats.MaxLatenessNs >= UT_PERIODIC_PERIOD_NS / 2, "lateness (%lu)",
+                  (unsigned long)Stats.MaxLatenessNs);
+    UtAssert_True(Stats.Hist[BCM2835_PERIODIC_HIST_BINS - 1] == 1, "lateness in the last bin");
+}
+
+void Test_bcm2835_periodic_wait_Overrun(void)
+{
+    /*
+     * Test Case For:
+     * uint32_t bcm2835_periodic_wait(bcm2835_periodic_t *p) more than a period late
+     */
+    bcm2835_periodic_t       Periodic;
+    bcm2835_periodic_stats_t Stats;
+    uint64                   Deadline;
+    uint64                   Before;
+    uint32                   Skipped;
+
+    bcm2835_periodic_init(&Periodic, UT_PERIODIC_PERIOD_US);
+    Deadline        = UT_Periodic_NowNs() - (3 * UT_PERIODIC_PERIOD_NS) - (UT_PERIODIC_PERIOD_NS / 2);
+    Periodic.NextNs = Deadline;
+
+    /* The missed deadlines are skipped and the call does not sleep */
+    Before  = UT_Periodic_NowNs();
+    Skipped = bcm2835_periodic_wait(&Periodic);
+    UtAssert_True(Skipped == 3, "three deadlines skipped (%lu)", (unsigned long)Skipped);
+    UtAssert_True(UT_Periodic_NowNs() - Before < UT_PERIODIC_PERIOD_NS / 2, "returned at once");
+    UtAssert_True(Periodic.NextNs == Deadline + (4 * UT_PERIODIC_PERIOD_NS), "next deadline in the future");
+    UtAssert_True(Periodic.NextNs > UT_Periodic_NowNs(), "no burst of wakeups");
+
+    bcm2835_periodic_get_stats(&Periodic, &Stats);
+    UtAssert_True(Stats.Periods == 1 && Stats.Overruns == 3, "overruns (%lu)", (unsigned long)Stats.Overruns);
+    UtAssert_True(Stats.SumLatenessNs >= 3 * UT_PERIODIC_PERIOD_NS, "lateness");
+
+    /* The stats are cleared but the calibration is kept */
+    Periodic.Stats.SleepMarginNs = 1234;
+    bcm2835_periodic_reset_stats(&Periodic);
+    bcm2835_periodic_get_stats(&Periodic, &Stats);
+    UtAssert_True(Stats.Periods == 0 && Stats.Overruns == 0 && Stats.SumLatenessNs == 0, "stats cleared");
+    UtAssert_True(Stats.SleepMarginNs == 1234, "margin kept");
+}
+
+/*
+ * Setup function prior to every test
+ */
+void Bcm2835_UT_Setup(void)
+{
+    UT_ResetState(0);
+}
+
+/*
+ * Teardown function after every test
+ */
+void Bcm2835_UT_TearDown(void) {}
+
+/*
+ * Register the test cases to execute with the unit test tool
+ */
+void UtTest_Setup(void)
+{
+    ADD_TEST(bcm2835_periodic_init);
+    ADD_TEST(bcm2835_periodic_wait);
+    ADD_TEST(bcm2835_periodic_wait_Late);
+    ADD_TEST(bcm2835_periodic_wait_Overrun);
+}
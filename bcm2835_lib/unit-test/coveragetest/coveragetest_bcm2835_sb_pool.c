@@ -0,0 +1,182 @@
+/*
+**  GSC-18128-1, "Core Flight Executive Version 6.7"
+**
+**  Copyright (c) 2006-2019 United States Government as represented by
+**  the Administrator of the National Aeronautics and Space Administration.
+**  All Rights Reserved.
+**
+**  Licensed under the Apache License, Version 2.0 (the "License");
+**  you may not use this file except in compliance with the License.
+**  You may obtain a copy of the License at
+**
+**    http://www.apache.org/licenses/LICENSE-2.0
+**
+**  Unless required by applicable law or agreed to in writing, software
+**  distributed under the License is distributed on an "AS IS" BASIS,
+**  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**  See the License for the specific language governing permissions and
+**  limitations under the License.
+*/
+
+/*
+** File: coveragetest_bcm2835_sb_pool.c
+**
+** Purpose:
+** Coverage Unit Test cases for the Software Bus buffer pool of the BCM2835 library
+**
+** Notes:
+** The buffers are addresses of a local array, returned in turn by the
+** CFE_SB_AllocateMessageBuffer stub. They are never dereferenced.
+*/
+
+/*
+ * Includes
+ */
+
+#include "bcm2835_lib_coveragetest_common.h"
+
+/*
+ * Buffers handed out by the CFE_SB_AllocateMessageBuffer stub
+ */
+static CFE_SB_Buffer_t  UT_SbPool_Bufs[BCM2835_SB_POOL_MAX + 1];
+static CFE_SB_Buffer_t *UT_SbPool_BufPtrs[BCM2835_SB_POOL_MAX + 1];
+
+/*
+**********************************************************************************
+**          TEST CASE FUNCTIONS
+**********************************************************************************
+*/
+
+void Test_bcm2835_sb_pool_init(void)
+{
+    /*
+     * Test Case For:
+     * int bcm2835_sb_pool_init(bcm2835_sb_pool_t *pool, size_t size, uint16_t depth)
+     */
+    bcm2835_sb_pool_t Pool;
+
+    UtAssert_True(bcm2835_sb_pool_init(NULL, 64, 2) == 0, "NULL pool");
+    UtAssert_True(bcm2835_sb_pool_init(&Pool, 0, 2) == 0, "zero size");
+    UtAssert_True(bcm2835_sb_pool_init(&Pool, 64, 0) == 0, "zero depth");
+    UtAssert_True(bcm2835_sb_pool_init(&Pool, 64, BCM2835_SB_POOL_MAX + 1) == 0, "depth too large");
+
+    memset(&Pool, 0xA5, sizeof(Pool));
+    UtAssert_True(bcm2835_sb_pool_init(&Pool, 64, BCM2835_SB_POOL_MAX) == 1, "pool initialised");
+    UtAssert_True(Pool.Size == 64 && Pool.Depth == BCM2835_SB_POOL_MAX, "size and depth");
+    UtAssert_True(Pool.Count == 0, "pool empty");
+    UtAssert_True(UT_GetStubCount(UT_KEY(CFE_SB_AllocateMessageBuffer)) == 0,
+                  "CFE_SB_AllocateMessageBuffer() not called");
+}
+
+void Test_bcm2835_sb_pool_fill(void)
+{
+    /*
+     * Test Case For:
+     * void bcm2835_sb_pool_fill(bcm2835_sb_pool_t *pool)
+     */
+    bcm2835_sb_pool_t Pool;
+
+    bcm2835_sb_pool_init(&Pool, 64, 3);
+
+    /* SB runs out of memory after two buffers */
+    UT_SetDataBuffer(UT_KEY(CFE_SB_AllocateMessageBuffer), UT_SbPool_BufPtrs, 2 * sizeof(CFE_SB_Buffer_t *), false);
+    UT_SetDeferredRetcode(UT_KEY(CFE_SB_AllocateMessageBuffer), 3, CFE_SB_BUF_ALOC_ERR);
+    bcm2835_sb_pool_fill(&Pool);
+    UtAssert_True(Pool.Count == 2, "Pool.Count (%u) == 2", (unsigned int)Pool.Count);
+    UtAssert_True(Pool.Buf[0] == &UT_SbPool_Bufs[0] && Pool.Buf[1] == &UT_SbPool_Bufs[1], "buffers kept");
+    UtAssert_True(UT_GetStubCount(UT_KEY(CFE_SB_AllocateMessageBuffer)) == 3,
+                  "CFE_SB_AllocateMessageBuffer() called 3 times");
+
+    /* the next fill tops the pool up to its depth */
+    UT_SetDataBuffer(UT_KEY(CFE_SB_AllocateMessageBuffer), &UT_SbPool_BufPtrs[2], sizeof(CFE_SB_Buffer_t *), false);
+    bcm2835_sb_pool_fill(&Pool);
+    UtAssert_True(Pool.Count == 3, "Pool.Count (%u) == 3", (unsigned int)Pool.Count);
+    UtAssert_True(UT_GetStubCount(UT_KEY(CFE_SB_AllocateMessageBuffer)) == 4,
+                  "CFE_SB_AllocateMessageBuffer() called once more");
+
+    /* a full pool allocates nothing */
+    bcm2835_sb_pool_fill(&Pool);
+    UtAssert_True(UT_GetStubCount(UT_KEY(CFE_SB_AllocateMessageBuffer)) == 4,
+                  "CFE_SB_AllocateMessageBuffer() not called");
+}
+
+void Test_bcm2835_sb_pool_get(void)
+{
+    /*
+     * Test Case For:
+     * CFE_SB_Buffer_t *bcm2835_sb_pool_get(bcm2835_sb_pool_t *pool)
+     */
+    bcm2835_sb_pool_t Pool;
+
+    bcm2835_sb_pool_init(&Pool, 64, 2);
+    UT_SetDataBuffer(UT_KEY(CFE_SB_AllocateMessageBuffer), UT_SbPool_BufPtrs, 3 * sizeof(CFE_SB_Buffer_t *), false);
+    bcm2835_sb_pool_fill(&Pool);
+
+    /* the buffers of the pool are taken without an allocation */
+    UtAssert_True(bcm2835_sb_pool_get(&Pool) == &UT_SbPool_Bufs[1], "last buffer of the pool");
+    UtAssert_True(bcm2835_sb_pool_get(&Pool) == &UT_SbPool_Bufs[0], "first buffer of the pool");
+    UtAssert_True(UT_GetStubCount(UT_KEY(CFE_SB_AllocateMessageBuffer)) == 2,
+                  "CFE_SB_AllocateMessageBuffer() not called");
+
+    /* an empty pool allocates the buffer */
+    UtAssert_True(bcm2835_sb_pool_get(&Pool) == &UT_SbPool_Bufs[2], "buffer allocated");
+    UtAssert_True(Pool.Count == 0, "pool empty");
+
+    /* NULL once SB has no memory */
+    UT_SetDefaultReturnValue(UT_KEY(CFE_SB_AllocateMessageBuffer), CFE_SB_BUF_ALOC_ERR);
+    UtAssert_True(bcm2835_sb_pool_get(&Pool) == NULL, "no buffer");
+}
+
+void Test_bcm2835_sb_pool_drain(void)
+{
+    /*
+     * Test Case For:
+     * void bcm2835_sb_pool_drain(bcm2835_sb_pool_t *pool)
+     */
+    bcm2835_sb_pool_t Pool;
+
+    bcm2835_sb_pool_init(&Pool, 64, 3);
+    UT_SetDataBuffer(UT_KEY(CFE_SB_AllocateMessageBuffer), UT_SbPool_BufPtrs, 3 * sizeof(CFE_SB_Buffer_t *), false);
+    bcm2835_sb_pool_fill(&Pool);
+
+    bcm2835_sb_pool_drain(&Pool);
+    UtAssert_True(Pool.Count == 0, "pool empty");
+    UtAssert_True(UT_GetStubCount(UT_KEY(CFE_SB_ReleaseMessageBuffer)) == 3,
+                  "CFE_SB_ReleaseMessageBuffer() called 3 times");
+
+    /* an empty pool releases nothing */
+    bcm2835_sb_pool_drain(&Pool);
+    UtAssert_True(UT_GetStubCount(UT_KEY(CFE_SB_ReleaseMessageBuffer)) == 3,
+                  "CFE_SB_ReleaseMessageBuffer() not called");
+}
+
+/*
+ * Setup function prior to every test
+ */
+void Bcm2835_UT_Setup(void)
+{
+    uint32 i;
+
+    UT_ResetState(0);
+
+    for (i = 0; i <= BCM2835_SB_POOL_MAX; i++)
+    {
+        UT_SbPool_BufPtrs[i] = &UT_SbPool_Bufs[i];
+    }
+}
+
+/*
+ * Teardown function after every test
+ */
+void Bcm2835_UT_TearDown(void) {}
+
+/*
+ * Register the test cases to execute with the unit test tool
+ */
+void UtTest_Setup(void)
+{
+    ADD_TEST(bcm2835_sb_pool_init);
+    ADD_TEST(bcm2835_sb_pool_fill);
+    ADD_TEST(bcm2835_sb_pool_get);
+    ADD_TEST(bcm2835_sb_pool_drain);
+}
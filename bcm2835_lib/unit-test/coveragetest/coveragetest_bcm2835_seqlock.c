@@ -0,0 +1,158 @@
+/*
+**  GSC-18128-1, "Core Flight Executive Version 6.7"
+**
+**  Copyright (c) 2006-2019 United States Government as represented by
+**  the Administrator of the National Aeronautics and Space Administration.
+**  All Rights Reserved.
+**
+**  Licensed under the Apache License, Version 2.0 (the "License");
+**  you may not use this file except in compliance with the License.
+**  You may obtain a copy of the License at
+**
+**    http://www.apache.org/licenses/LICENSE-2.0
+**
+**  Unless required by applicable law or agreed to in writing, software
+**  distributed under the License is distributed on an "AS IS" BASIS,
+**  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**  See the License for the specific language governing permissions and
+**  limitations under the License.
+*/
+
+/*
+** File: coveragetest_bcm2835_seqlock.c
+**
+** Purpose:
+** Coverage Unit Test cases for the sequence lock of the BCM2835 library
+**
+** Notes:
+** The tests run in a single task. A write in progress is simulated by
+** setting an odd sequence, which only the writer does otherwise.
+*/
+
+/*
+ * Includes
+ */
+
+#include "bcm2835_lib_coveragetest_common.h"
+
+/*
+ * A latest-value cache as the apps use it
+ */
+typedef struct
+{
+    uint32 Seq;
+    int16  Value[3];
+} UT_Bcm2835_Value_t;
+
+/*
+**********************************************************************************
+**          TEST CASE FUNCTIONS
+**********************************************************************************
+*/
+
+void Test_bcm2835_seqlock_read_empty(void)
+{
+    /*
+     * Test Case For:
+     * int bcm2835_seqlock_read(...) before any write
+     */
+    bcm2835_seqlock_t  Lock;
+    UT_Bcm2835_Value_t Cache;
+    UT_Bcm2835_Value_t Copy;
+
+    memset(&Cache, 0, sizeof(Cache));
+    bcm2835_seqlock_init(&Lock);
+
+    UtAssert_True(bcm2835_seqlock_read(&Lock, &Cache, &Copy, sizeof(Copy), 8) == 0, "no value before the first write");
+}
+
+void Test_bcm2835_seqlock_write_read(void)
+{
+    /*
+     * Test Case For:
+     * void bcm2835_seqlock_write(...)
+     * int bcm2835_seqlock_read(...)
+     */
+    bcm2835_seqlock_t  Lock;
+    UT_Bcm2835_Value_t Cache;
+    UT_Bcm2835_Value_t Sample;
+    UT_Bcm2835_Value_t Copy;
+
+    bcm2835_seqlock_init(&Lock);
+
+    Sample.Seq      = 1;
+    Sample.Value[0] = 100;
+    Sample.Value[1] = -200;
+    Sample.Value[2] = 300;
+    bcm2835_seqlock_write(&Lock, &Cache, &Sample, sizeof(Sample));
+
+    memset(&Copy, 0, sizeof(Copy));
+    UtAssert_True(bcm2835_seqlock_read(&Lock, &Cache, &Copy, sizeof(Copy), 1) == 1, "value read in one try");
+    UtAssert_True(memcmp(&Copy, &Sample, sizeof(Copy)) == 0, "copy matches the value written");
+
+    /* A later write replaces the value */
+    Sample.Seq      = 2;
+    Sample.Value[0] = 101;
+    bcm2835_seqlock_write(&Lock, &Cache, &Sample, sizeof(Sample));
+
+    UtAssert_True(bcm2835_seqlock_read(&Lock, &Cache, &Copy, sizeof(Copy), 1) == 1, "second value read");
+    UtAssert_True(Copy.Seq == 2 && Copy.Value[0] == 101, "copy is the second value (%lu, %d)",
+                  (unsigned long)Copy.Seq, (int)Copy.Value[0]);
+}
+
+void Test_bcm2835_seqlock_read_busy(void)
+{
+    /*
+     * Test Case For:
+     * int bcm2835_seqlock_read(...) while a write is in progress
+     */
+    bcm2835_seqlock_t  Lock;
+    UT_Bcm2835_Value_t Cache;
+    UT_Bcm2835_Value_t Sample;
+    UT_Bcm2835_Value_t Copy;
+
+    bcm2835_seqlock_init(&Lock);
+
+    memset(&Sample, 0, sizeof(Sample));
+    Sample.Seq = 1;
+    bcm2835_seqlock_write(&Lock, &Cache, &Sample, sizeof(Sample));
+
+    /* The writer has made the sequence odd and not finished its copy */
+    Lock.Seq++;
+    Cache.Seq = 2;
+
+    memset(&Copy, 0, sizeof(Copy));
+    UtAssert_True(bcm2835_seqlock_read(&Lock, &Cache, &Copy, sizeof(Copy), 8) == 0, "no copy during a write");
+    UtAssert_True(Copy.Seq == 0, "half-written value not copied (%lu)", (unsigned long)Copy.Seq);
+
+    /* The write completes */
+    Lock.Seq++;
+    UtAssert_True(bcm2835_seqlock_read(&Lock, &Cache, &Copy, sizeof(Copy), 8) == 1, "copy once the write is over");
+    UtAssert_True(Copy.Seq == 2, "copy is the new value (%lu)", (unsigned long)Copy.Seq);
+
+    /* No tries, no copy */
+    UtAssert_True(bcm2835_seqlock_read(&Lock, &Cache, &Copy, sizeof(Copy), 0) == 0, "no copy without tries");
+}
+
+/*
+ * Setup function prior to every test
+ */
+void Bcm2835_UT_Setup(void)
+{
+    UT_ResetState(0);
+}
+
+/*
+ * Teardown function after every test
+ */
+void Bcm2835_UT_TearDown(void) {}
+
+/*
+ * Register the test cases to execute with the unit test tool
+ */
+void UtTest_Setup(void)
+{
+    ADD_TEST(bcm2835_seqlock_read_empty);
+    ADD_TEST(bcm2835_seqlock_write_read);
+    ADD_TEST(bcm2835_seqlock_read_busy);
+}
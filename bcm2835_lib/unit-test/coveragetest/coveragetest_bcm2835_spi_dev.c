@@ -0,0 +1,436 @@
+/*
+**  GSC-18128-1, "Core Flight Executive Version 6.7"
+**
+**  Copyright (c) 2006-2019 United States Government as represented by
+**  the Administrator of the National Aeronautics and Space Administration.
+**  All Rights Reserved.
+**
+**  Licensed under the Apache License, Version 2.0 (the "License");
+**  you may not use this file except in compliance with the License.
+**  You may obtain a copy of the License at
+**
+**    http://www.apache.org/licenses/LICENSE-2.0
+**
+**  Unless required by applicable law or agreed to in writing, software
+**  distributed under the License is distributed on an "AS IS" BASIS,
+**  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**  See the License for the specific language governing permissions and
+**  limitations under the License.
+*/
+
+/*
+** File: coveragetest_bcm2835_spi_dev.c
+**
+** Purpose:
+** Coverage Unit Test cases for the SPI device handles of the BCM2835 library
+**
+** Notes:
+** The register level SPI functions of bcm2835_lib.c are replaced by the
+** stubs below, which only count their calls. The worker task is run in
+** the test task: its entry point is taken from CFE_ES_CreateChildTask and
+** called once the requests are in the queue.
+**
+** Every call to BCM2835_LIB_GetTimeUs advances the time by
+** UT_SpiDev_StepUs, so a transaction waits and runs for one step each.
+*/
+
+/*
+ * Includes
+ */
+
+#include "bcm2835_lib_coveragetest_common.h"
+
+/*
+ * Time returned by BCM2835_LIB_GetTimeUs and its increment per call
+ */
+static uint64 UT_SpiDev_NowUs;
+static uint64 UT_SpiDev_StepUs;
+
+/*
+ * Entry point of the last worker task created
+ */
+static CFE_ES_ChildTaskMainFuncPtr_t UT_SpiDev_WorkerEntry;
+
+/*
+ * Lock waits accounted as timed out, see BCM2835_BUS_AccountWait
+ */
+static uint32 UT_SpiDev_WaitTimeouts;
+
+/*
+ * Timeout of the last lock acquisition, see bcm2835_lock_acquire
+ */
+static int32 UT_SpiDev_LockTimeoutUs;
+
+/*
+ * The time source of the library, which is in bcm2835_lib.c
+ */
+uint64 BCM2835_LIB_GetTimeUs(void)
+{
+    UT_SpiDev_NowUs += UT_SpiDev_StepUs;
+
+    return UT_SpiDev_NowUs;
+}
+
+/*
+ * The bus statistics, which are in bcm2835_bus_stats.c
+ */
+void BCM2835_BUS_AccountWait(uint8 Bus, uint32 WaitUs, bool TimedOut)
+{
+    UT_DEFAULT_IMPL(BCM2835_BUS_AccountWait);
+
+    if (TimedOut)
+    {
+        UT_SpiDev_WaitTimeouts++;
+    }
+}
+
+/*
+ * The controller locks, which are in bcm2835_lock.c
+ */
+void bcm2835_lock_init(bcm2835_lock_t *lock)
+{
+    UT_DEFAULT_IMPL(bcm2835_lock_init);
+}
+
+int32_t bcm2835_lock_acquire(bcm2835_lock_t *lock, int32_t timeout_us)
+{
+    UT_SpiDev_LockTimeoutUs = timeout_us;
+
+    return UT_DEFAULT_IMPL(bcm2835_lock_acquire);
+}
+
+void bcm2835_lock_release(bcm2835_lock_t *lock)
+{
+    UT_DEFAULT_IMPL(bcm2835_lock_release);
+}
+
+/*
+ * Register level functions of bcm2835_lib.c
+ */
+void bcm2835_spi_chipSelect(uint8_t cs)
+{
+    UT_DEFAULT_IMPL(bcm2835_spi_chipSelect);
+}
+
+void bcm2835_spi_setDataMode(uint8_t mode)
+{
+    UT_DEFAULT_IMPL(bcm2835_spi_setDataMode);
+}
+
+void bcm2835_spi_setBitOrder(uint8_t order)
+{
+    UT_DEFAULT_IMPL(bcm2835_spi_setBitOrder);
+}
+
+void bcm2835_spi_set_speed_hz(uint32_t speed_hz)
+{
+    UT_DEFAULT_IMPL(bcm2835_spi_set_speed_hz);
+}
+
+void bcm2835_spi_transfer_segments(const bcm2835_spi_seg_t *segs, uint32_t count)
+{
+    UT_DEFAULT_IMPL(bcm2835_spi_transfer_segments);
+}
+
+void bcm2835_aux_spi_setClockDivider(uint16_t divider)
+{
+    UT_DEFAULT_IMPL(bcm2835_aux_spi_setClockDivider);
+}
+
+uint16_t bcm2835_aux_spi_CalcClockDivider(uint32_t speed_hz)
+{
+    return UT_DEFAULT_IMPL(bcm2835_aux_spi_CalcClockDivider);
+}
+
+void bcm2835_aux_spi_transfer_segments(const bcm2835_spi_seg_t *segs, uint32_t count)
+{
+    UT_DEFAULT_IMPL(bcm2835_aux_spi_transfer_segments);
+}
+
+/*
+ * Hook function of CFE_ES_CreateChildTask that keeps the worker entry point
+ */
+static int32 UT_SpiDev_CreateChildTaskHook(void *UserObj, int32 StubRetcode, uint32 CallCount,
+                                           const UT_StubContext_t *Context)
+{
+    UT_SpiDev_WorkerEntry = UT_Hook_GetArgValueByName(Context, "FunctionPtr", CFE_ES_ChildTaskMainFuncPtr_t);
+
+    return StubRetcode;
+}
+
+/*
+**********************************************************************************
+**          TEST CASE FUNCTIONS
+**********************************************************************************
+*/
+
+void Test_BCM2835_SPI_DevInit(void)
+{
+    /*
+     * Test Case For:
+     * int32 BCM2835_SPI_DevInit(void)
+     */
+    UtAssert_True(BCM2835_SPI_DevInit() == CFE_SUCCESS, "BCM2835_SPI_DevInit() nominal");
+
+    /* Each controller has its own lock */
+    UtAssert_True(BCM2835_SPI_DevLock(BCM2835_SPI_CTRL_SPI0) != NULL, "SPI0 lock");
+    UtAssert_True(BCM2835_SPI_DevLock(BCM2835_SPI_CTRL_AUX) != BCM2835_SPI_DevLock(BCM2835_SPI_CTRL_SPI0),
+                  "AUX lock");
+    UtAssert_True(BCM2835_SPI_DevLock(BCM2835_SPI_CTRL_COUNT) == NULL, "unknown controller");
+}
+
+void Test_bcm2835_spi_device_init(void)
+{
+    /*
+     * Test Case For:
+     * int32_t bcm2835_spi_device_init(...)
+     */
+    bcm2835_spi_device_t Dev;
+
+    UtAssert_True(bcm2835_spi_device_init(NULL, BCM2835_SPI_CTRL_SPI0, BCM2835_SPI_CS0, BCM2835_SPI_MODE0, 1000000) ==
+                      BCM2835_SPI_ERR_INVALID,
+                  "NULL handle rejected");
+    UtAssert_True(bcm2835_spi_device_init(&Dev, BCM2835_SPI_CTRL_COUNT, BCM2835_SPI_CS0, BCM2835_SPI_MODE0,
+                                          1000000) == BCM2835_SPI_ERR_INVALID,
+                  "unknown controller rejected");
+
+    UtAssert_True(bcm2835_spi_device_init(&Dev, BCM2835_SPI_CTRL_SPI0, BCM2835_SPI_CS1, BCM2835_SPI_MODE3, 500000) ==
+                      BCM2835_SPI_OK,
+                  "SPI0 device");
+    UtAssert_True(Dev.controller == BCM2835_SPI_CTRL_SPI0 && Dev.chip_select == BCM2835_SPI_CS1 &&
+                      Dev.mode == BCM2835_SPI_MODE3 && Dev.bit_order == BCM2835_SPI_BIT_ORDER_MSBFIRST &&
+                      Dev.speed_hz == 500000,
+                  "SPI0 settings");
+
+    /* The AUX controller only supports CE2 and mode 0 */
+    UtAssert_True(bcm2835_spi_device_init(&Dev, BCM2835_SPI_CTRL_AUX, BCM2835_SPI_CS2, BCM2835_SPI_MODE0, 500000) ==
+                      BCM2835_SPI_OK,
+                  "AUX device");
+    UtAssert_True(bcm2835_spi_device_init(&Dev, BCM2835_SPI_CTRL_AUX, BCM2835_SPI_CS0, BCM2835_SPI_MODE0, 500000) ==
+                      BCM2835_SPI_ERR_INVALID,
+                  "AUX chip select rejected");
+    UtAssert_True(bcm2835_spi_device_init(&Dev, BCM2835_SPI_CTRL_AUX, BCM2835_SPI_CS2, BCM2835_SPI_MODE1, 500000) ==
+                      BCM2835_SPI_ERR_INVALID,
+                  "AUX mode rejected");
+
+    /* A handle changed to an unsupported bit order is rejected by the transactions */
+    bcm2835_spi_device_init(&Dev, BCM2835_SPI_CTRL_AUX, BCM2835_SPI_CS2, BCM2835_SPI_MODE0, 500000);
+    Dev.bit_order = BCM2835_SPI_BIT_ORDER_LSBFIRST;
+    UtAssert_True(bcm2835_spi_device_transfer(&Dev, NULL, 0, 0) == BCM2835_SPI_ERR_INVALID,
+                  "AUX bit order rejected");
+}
+
+void Test_bcm2835_spi_device_transfer(void)
+{
+    /*
+     * Test Case For:
+     * int32_t bcm2835_spi_device_transfer(...)
+     */
+    bcm2835_spi_device_t Dev;
+    bcm2835_spi_device_t Aux;
+    bcm2835_spi_stats_t  Stats;
+    bcm2835_spi_seg_t    Segs[2] = {{NULL, NULL, 3}, {NULL, NULL, 5}};
+
+    bcm2835_spi_device_init(&Dev, BCM2835_SPI_CTRL_SPI0, BCM2835_SPI_CS0, BCM2835_SPI_MODE0, 1000000);
+    bcm2835_spi_device_init(&Aux, BCM2835_SPI_CTRL_AUX, BCM2835_SPI_CS2, BCM2835_SPI_MODE0, 1000000);
+
+    UtAssert_True(bcm2835_spi_device_transfer(NULL, Segs, 2, 0) == BCM2835_SPI_ERR_INVALID, "NULL handle rejected");
+    UtAssert_True(bcm2835_spi_device_transfer(&Dev, NULL, 2, 0) == BCM2835_SPI_ERR_INVALID,
+                  "NULL segments rejected");
+
+    /* The settings are only written when they change */
+    UT_SpiDev_StepUs = 10;
+    UtAssert_True(bcm2835_spi_device_transfer(&Dev, Segs, 2, 0) == BCM2835_SPI_OK, "first transaction");
+    UtAssert_True(UT_SpiDev_LockTimeoutUs == 0, "lock polled");
+    UtAssert_True(bcm2835_spi_device_transfer(&Dev, Segs, 1, BCM2835_SPI_PEND_FOREVER) == BCM2835_SPI_OK,
+                  "second transaction");
+    UtAssert_True(UT_SpiDev_LockTimeoutUs == BCM2835_LOCK_PEND_FOREVER, "lock pending");
+    UtAssert_True(UT_GetStubCount(UT_KEY(bcm2835_spi_chipSelect)) == 1, "settings applied once");
+    UtAssert_True(UT_GetStubCount(UT_KEY(bcm2835_spi_transfer_segments)) == 2, "SPI0 transactions");
+    UtAssert_True(UT_GetStubCount(UT_KEY(bcm2835_lock_release)) == 2, "lock released");
+
+    Dev.speed_hz = 2000000;
+    bcm2835_spi_device_transfer(&Dev, Segs, 2, 0);
+    UtAssert_True(UT_GetStubCount(UT_KEY(bcm2835_spi_set_speed_hz)) == 2, "new speed applied");
+
+    /* The AUX controller keeps its own settings and stats */
+    UtAssert_True(bcm2835_spi_device_transfer(&Aux, Segs, 2, 0) == BCM2835_SPI_OK, "AUX transaction");
+    UtAssert_True(UT_GetStubCount(UT_KEY(bcm2835_aux_spi_setClockDivider)) == 1, "AUX settings applied");
+    UtAssert_True(UT_GetStubCount(UT_KEY(bcm2835_aux_spi_transfer_segments)) == 1, "AUX transaction run");
+
+    UtAssert_True(bcm2835_spi_get_stats(BCM2835_SPI_CTRL_SPI0, &Stats) == BCM2835_SPI_OK, "SPI0 stats");
+    UtAssert_True(Stats.Transactions == 3 && Stats.Bytes == 19, "SPI0 transactions (%lu) and bytes (%lu)",
+                  (unsigned long)Stats.Transactions, (unsigned long)Stats.Bytes);
+    UtAssert_True(Stats.BusTimeUs == 30 && Stats.MaxWaitUs == 10, "SPI0 bus time (%lu) and wait (%lu)",
+                  (unsigned long)Stats.BusTimeUs, (unsigned long)Stats.MaxWaitUs);
+
+    bcm2835_spi_get_stats(BCM2835_SPI_CTRL_AUX, &Stats);
+    UtAssert_True(Stats.Transactions == 1 && Stats.Bytes == 8, "AUX stats");
+
+    UtAssert_True(bcm2835_spi_get_stats(BCM2835_SPI_CTRL_COUNT, &Stats) == BCM2835_SPI_ERR_INVALID,
+                  "unknown controller stats");
+    UtAssert_True(bcm2835_spi_get_stats(BCM2835_SPI_CTRL_SPI0, NULL) == BCM2835_SPI_ERR_INVALID, "NULL stats");
+}
+
+void Test_bcm2835_spi_device_transfer_Timeout(void)
+{
+    /*
+     * Test Case For:
+     * int32_t bcm2835_spi_device_transfer(...) when the controller is busy
+     */
+    bcm2835_spi_device_t Dev;
+    bcm2835_spi_stats_t  Stats;
+    bcm2835_spi_seg_t    Seg = {NULL, NULL, 4};
+
+    bcm2835_spi_device_init(&Dev, BCM2835_SPI_CTRL_SPI0, BCM2835_SPI_CS0, BCM2835_SPI_MODE0, 1000000);
+
+    UT_SetDeferredRetcode(UT_KEY(bcm2835_lock_acquire), 1, BCM2835_LOCK_ERR_TIMEOUT);
+    UtAssert_True(bcm2835_spi_device_transfer(&Dev, &Seg, 1, 5) == BCM2835_SPI_ERR_TIMEOUT, "lock timeout");
+    UtAssert_True(UT_SpiDev_LockTimeoutUs == 5000, "timeout in microseconds (%ld)", (long)UT_SpiDev_LockTimeoutUs);
+    UT_SetDeferredRetcode(UT_KEY(bcm2835_lock_acquire), 1, BCM2835_LOCK_ERR_OS);
+    UtAssert_True(bcm2835_spi_device_transfer(&Dev, &Seg, 1, 0x7FFFFFFF) == BCM2835_SPI_ERR_OS, "lock error");
+    UtAssert_True(UT_SpiDev_LockTimeoutUs == BCM2835_LOCK_PEND_FOREVER, "timeout beyond the lock range");
+
+    /* Nothing was run and the lock is not released by the callers that did not get it */
+    UtAssert_True(UT_GetStubCount(UT_KEY(bcm2835_spi_transfer_segments)) == 0, "no transaction");
+    UtAssert_True(UT_GetStubCount(UT_KEY(bcm2835_lock_release)) == 0, "lock not released");
+    UtAssert_True(UT_GetStubCount(UT_KEY(BCM2835_BUS_AccountWait)) == 2 && UT_SpiDev_WaitTimeouts == 2,
+                  "lock waits accounted");
+
+    /* The timeouts are counted into the stats once the lock is held */
+    bcm2835_spi_get_stats(BCM2835_SPI_CTRL_SPI0, &Stats);
+    UtAssert_True(Stats.Timeouts == 2 && Stats.Transactions == 0, "timeouts (%lu)", (unsigned long)Stats.Timeouts);
+    bcm2835_spi_get_stats(BCM2835_SPI_CTRL_SPI0, &Stats);
+    UtAssert_True(Stats.Timeouts == 2, "timeouts counted once");
+}
+
+void Test_bcm2835_spi_worker_start(void)
+{
+    /*
+     * Test Case For:
+     * int32_t bcm2835_spi_worker_start(uint8_t controller, uint32_t priority)
+     */
+    UtAssert_True(bcm2835_spi_worker_start(BCM2835_SPI_CTRL_COUNT, 50) == BCM2835_SPI_ERR_INVALID,
+                  "unknown controller rejected");
+
+    UT_SetDeferredRetcode(UT_KEY(OS_QueueCreate), 1, OS_ERROR);
+    UtAssert_True(bcm2835_spi_worker_start(BCM2835_SPI_CTRL_SPI0, 50) == BCM2835_SPI_ERR_OS, "queue error");
+
+    UT_SetDeferredRetcode(UT_KEY(CFE_ES_CreateChildTask), 1, CFE_ES_ERR_CHILD_TASK_CREATE);
+    UtAssert_True(bcm2835_spi_worker_start(BCM2835_SPI_CTRL_SPI0, 50) == BCM2835_SPI_ERR_OS, "task error");
+
+    /* The queue of the failed start is reused, and a running worker is not started again */
+    UtAssert_True(bcm2835_spi_worker_start(BCM2835_SPI_CTRL_SPI0, 50) == BCM2835_SPI_OK, "worker started");
+    UtAssert_True(bcm2835_spi_worker_start(BCM2835_SPI_CTRL_SPI0, 50) == BCM2835_SPI_OK, "worker running");
+    UtAssert_True(UT_GetStubCount(UT_KEY(OS_QueueCreate)) == 2, "queue created once");
+    UtAssert_True(UT_GetStubCount(UT_KEY(CFE_ES_CreateChildTask)) == 2, "task created once");
+}
+
+void Test_bcm2835_spi_submit(void)
+{
+    /*
+     * Test Case For:
+     * int32_t bcm2835_spi_request_init(...)
+     * int32_t bcm2835_spi_submit(...)
+     * int32_t bcm2835_spi_request_wait(...)
+     */
+    bcm2835_spi_device_t  Dev;
+    bcm2835_spi_request_t Req;
+    bcm2835_spi_request_t Busy;
+    bcm2835_spi_request_t *Queued[2];
+    bcm2835_spi_seg_t     Seg = {NULL, NULL, 6};
+
+    bcm2835_spi_device_init(&Dev, BCM2835_SPI_CTRL_SPI0, BCM2835_SPI_CS0, BCM2835_SPI_MODE0, 1000000);
+
+    UtAssert_True(bcm2835_spi_request_init(NULL, "UT") == BCM2835_SPI_ERR_INVALID, "NULL request rejected");
+    UT_SetDeferredRetcode(UT_KEY(OS_BinSemCreate), 1, OS_ERROR);
+    UtAssert_True(bcm2835_spi_request_init(&Req, "UT") == BCM2835_SPI_ERR_OS, "semaphore error");
+    UtAssert_True(bcm2835_spi_request_init(&Req, "UT") == BCM2835_SPI_OK, "request init");
+    UtAssert_True(bcm2835_spi_request_init(&Busy, "UT_BUSY") == BCM2835_SPI_OK, "request init");
+
+    /* Nothing is queued before the worker runs */
+    UtAssert_True(bcm2835_spi_submit(&Req, &Dev, &Seg, 1) == BCM2835_SPI_ERR_INVALID, "no worker");
+    UtAssert_True(bcm2835_spi_request_wait(&Req, 0) == BCM2835_SPI_OK, "not submitted");
+
+    UT_SetHookFunction(UT_KEY(CFE_ES_CreateChildTask), UT_SpiDev_CreateChildTaskHook, NULL);
+    bcm2835_spi_worker_start(BCM2835_SPI_CTRL_SPI0, 50);
+
+    UT_SetDeferredRetcode(UT_KEY(OS_QueuePut), 1, OS_QUEUE_FULL);
+    UtAssert_True(bcm2835_spi_submit(&Req, &Dev, &Seg, 1) == BCM2835_SPI_ERR_FULL, "queue full");
+    UtAssert_True(Req.status == BCM2835_SPI_OK, "request not pending");
+
+    UtAssert_True(bcm2835_spi_submit(&Req, &Dev, &Seg, 1) == BCM2835_SPI_OK, "request queued");
+    UtAssert_True(bcm2835_spi_submit(&Req, &Dev, &Seg, 1) == BCM2835_SPI_ERR_INVALID, "pending request rejected");
+    UtAssert_True(bcm2835_spi_submit(&Busy, &Dev, &Seg, 1) == BCM2835_SPI_OK, "request queued");
+
+    UT_SetDeferredRetcode(UT_KEY(OS_BinSemTimedWait), 1, OS_SEM_TIMEOUT);
+    UtAssert_True(bcm2835_spi_request_wait(&Req, 0) == BCM2835_SPI_ERR_TIMEOUT, "still pending");
+
+    /* The worker runs both requests and ends when its queue is empty */
+    Queued[0] = &Req;
+    Queued[1] = &Busy;
+    UT_SetDataBuffer(UT_KEY(OS_QueueGet), Queued, sizeof(Queued), false);
+    UtAssert_True(UT_SpiDev_WorkerEntry != NULL, "worker entry point");
+    UT_SpiDev_WorkerEntry();
+
+    UtAssert_True(UT_GetStubCount(UT_KEY(bcm2835_spi_transfer_segments)) == 2, "requests run");
+    UtAssert_True(UT_GetStubCount(UT_KEY(CFE_ES_ExitChildTask)) == 1, "worker exited");
+    UtAssert_True(bcm2835_spi_request_wait(&Req, BCM2835_SPI_PEND_FOREVER) == BCM2835_SPI_OK, "request done");
+    UtAssert_True(bcm2835_spi_request_wait(&Req, 0) == BCM2835_SPI_OK, "request collected");
+
+    /* A worker that exited takes no more requests */
+    UtAssert_True(bcm2835_spi_submit(&Req, &Dev, &Seg, 1) == BCM2835_SPI_ERR_INVALID, "worker stopped");
+}
+
+void Test_bcm2835_spi_worker_RegisterError(void)
+{
+    /*
+     * Test Case For:
+     * The worker task when it cannot register with ES
+     */
+    UT_SetHookFunction(UT_KEY(CFE_ES_CreateChildTask), UT_SpiDev_CreateChildTaskHook, NULL);
+    bcm2835_spi_worker_start(BCM2835_SPI_CTRL_AUX, 50);
+
+    UT_SetDeferredRetcode(UT_KEY(CFE_ES_RegisterChildTask), 1, CFE_ES_ERR_RESOURCEID_NOT_VALID);
+    UT_SpiDev_WorkerEntry();
+
+    UtAssert_True(UT_GetStubCount(UT_KEY(OS_QueueGet)) == 0, "queue not read");
+
+    /* It can be started again */
+    UtAssert_True(bcm2835_spi_worker_start(BCM2835_SPI_CTRL_AUX, 50) == BCM2835_SPI_OK, "worker restarted");
+    UtAssert_True(UT_GetStubCount(UT_KEY(CFE_ES_CreateChildTask)) == 2, "task created again");
+}
+
+/*
+ * Setup function prior to every test
+ */
+void Bcm2835_UT_Setup(void)
+{
+    UT_ResetState(0);
+
+    UT_SpiDev_NowUs         = 0;
+    UT_SpiDev_StepUs        = 0;
+    UT_SpiDev_WorkerEntry   = NULL;
+    UT_SpiDev_WaitTimeouts  = 0;
+    UT_SpiDev_LockTimeoutUs = 0;
+    BCM2835_SPI_DevInit();
+}
+
+/*
+ * Teardown function after every test
+ */
+void Bcm2835_UT_TearDown(void) {}
+
+/*
+ * Register the test cases to execute with the unit test tool
+ */
+void UtTest_Setup(void)
+{
+    ADD_TEST(BCM2835_SPI_DevInit);
+    ADD_TEST(bcm2835_spi_device_init);
+    ADD_TEST(bcm2835_spi_device_transfer);
+    ADD_TEST(bcm2835_spi_device_transfer_Timeout);
+    ADD_TEST(bcm2835_spi_worker_start);
+    ADD_TEST(bcm2835_spi_submit);
+    ADD_TEST(bcm2835_spi_worker_RegisterError);
+}
@@ -0,0 +1,403 @@
+/*
+**  GSC-18128-1, "Core Flight Executive Version 6.7"
+**
+**  Copyright (c) 2006-2019 United States Government as represented by
+**  the Administrator of the National Aeronautics and Space Administration.
+**  All Rights Reserved.
+**
+**  Licensed under the Apache License, Version 2.0 (the "License");
+**  you may not use this file except in compliance with the License.
+**  You may obtain a copy of the License at
+**
+**    http://www.apache.org/licenses/LICENSE-2.0
+**
+**  Unless required by applicable law or agreed to in writing, software
+**  distributed under the License is distributed on an "AS IS" BASIS,
+**  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**  See the License for the specific language governing permissions and
+**  limitations under the License.
+*/
+
+/*
+** File: coveragetest_bcm2835_trace.c
+**
+** Purpose:
+** Coverage Unit Test cases for the bus trace of the BCM2835 library
+**
+** Notes:
+** The ring cannot be cleared, so the test cases compare the sequence
+** numbers and counters with the values read at their start rather than
+** assume an empty trace. Trace files are written into and read from
+** UT_Trace_File through the data buffers of the OS_write and OS_read
+** stubs.
+**
+** Every call to BCM2835_LIB_GetTimeUs advances the time by one
+** microsecond, so a replayed transaction spins for as many calls as its
+** recorded duration. The System Timer is not mapped until the last test.
+*/
+
+/*
+ * Includes
+ */
+
+#include <sys/mman.h>
+
+#include "bcm2835_lib_coveragetest_common.h"
+
+/*
+ * Contents of a trace file with a full ring
+ */
+typedef struct
+{
+    bcm2835_trace_file_hdr_t Hdr;
+    bcm2835_trace_rec_t      Recs[BCM2835_TRACE_DEPTH];
+} UT_Trace_File_t;
+
+/*
+ * Time returned by BCM2835_LIB_GetTimeUs
+ */
+static uint64 UT_Trace_NowUs;
+
+/*
+ * Trace file and snapshot buffers, too large for the stack
+ */
+static UT_Trace_File_t     UT_Trace_File;
+static bcm2835_trace_rec_t UT_Trace_Recs[BCM2835_TRACE_DEPTH];
+
+/*
+ * The System Timer mapping of bcm2835_lib.c
+ */
+volatile uint32_t *bcm2835_st = MAP_FAILED;
+
+/*
+ * The time source of the library, which is in bcm2835_lib.c
+ */
+uint64 BCM2835_LIB_GetTimeUs(void)
+{
+    return ++UT_Trace_NowUs;
+}
+
+/*
+ * The region mapping of bcm2835_lib.c, which fails unless a test case sets its return value
+ */
+int BCM2835_LIB_MapRegion(uint8_t regbase)
+{
+    return UT_DEFAULT_IMPL(BCM2835_LIB_MapRegion);
+}
+
+/*
+ * The bus statistics, which are in bcm2835_bus_stats.c
+ */
+void BCM2835_BUS_Account(uint8 Bus, uint8 Address, uint32 Len, uint32 DurationUs, uint8 Status)
+{
+    UT_DEFAULT_IMPL(BCM2835_BUS_Account);
+}
+
+/*
+ * Number of transactions recorded so far
+ */
+static uint32 UT_Trace_Recorded(void)
+{
+    bcm2835_trace_stats_t Stats;
+
+    bcm2835_trace_get_stats(&Stats);
+
+    return Stats.Recorded;
+}
+
+/*
+ * Makes a replay record
+ */
+static void UT_Trace_SetRec(bcm2835_trace_rec_t *Rec, uint8 Address, uint8 Reg, uint8 Status, uint8 FirstByte)
+{
+    uint32 i;
+
+    memset(Rec, 0, sizeof(*Rec));
+    Rec->kind        = BCM2835_TRACE_I2C_READ_REG;
+    Rec->controller  = BCM2835_I2C_BUS_BSC1;
+    Rec->address     = Address;
+    Rec->reg         = Reg;
+    Rec->status      = Status;
+    Rec->duration_us = 20;
+    for (i = 0; i < BCM2835_TRACE_DATA; i++)
+    {
+        Rec->data[i] = (uint8)(FirstByte + i);
+    }
+}
+
+/*
+**********************************************************************************
+**          TEST CASE FUNCTIONS
+**********************************************************************************
+*/
+
+void Test_BCM2835_TRACE_Init(void)
+{
+    /*
+     * Test Case For:
+     * int32 BCM2835_TRACE_Init(void)
+     */
+    UtAssert_True(BCM2835_TRACE_Init() == CFE_SUCCESS, "BCM2835_TRACE_Init() nominal");
+
+    UT_SetDeferredRetcode(UT_KEY(OS_MutSemCreate), 2, OS_ERROR);
+    UtAssert_True(BCM2835_TRACE_Init() == CFE_STATUS_NOT_IMPLEMENTED, "BCM2835_TRACE_Init() lock error");
+}
+
+void Test_BCM2835_TRACE_Record(void)
+{
+    /*
+     * Test Case For:
+     * void BCM2835_TRACE_Record(...)
+     */
+    const uint8 Tx[2] = {0x3B, 0x80};
+    const uint8 Rx[6] = {1, 2, 3, 4, 5, 6};
+    uint32      Head  = UT_Trace_Recorded();
+    uint32      Start;
+
+    Start = BCM2835_TRACE_Now();
+    BCM2835_TRACE_Record(BCM2835_TRACE_I2C_READ_REG, BCM2835_I2C_BUS_BSC1, 0x68, 7, Tx, 1, Rx, sizeof(Rx), Start,
+                         BCM2835_I2C_REASON_OK);
+
+    UtAssert_True(bcm2835_trace_snapshot(UT_Trace_Recs, 1) == 1, "newest record");
+    UtAssert_True(UT_Trace_Recs[0].seq == Head + 1, "sequence (%lu)", (unsigned long)UT_Trace_Recs[0].seq);
+    UtAssert_True(UT_Trace_Recs[0].kind == BCM2835_TRACE_I2C_READ_REG &&
+                      UT_Trace_Recs[0].controller == BCM2835_I2C_BUS_BSC1 && UT_Trace_Recs[0].address == 0x68 &&
+                      UT_Trace_Recs[0].reg == 0x3B && UT_Trace_Recs[0].len == 7,
+                  "transaction");
+    UtAssert_True(UT_Trace_Recs[0].timestamp_us == Start && UT_Trace_Recs[0].duration_us == 1, "timing");
+    UtAssert_True(UT_Trace_Recs[0].caller != 0, "calling task");
+    UtAssert_True(memcmp(UT_Trace_Recs[0].data, Rx, sizeof(Rx)) == 0 && UT_Trace_Recs[0].data[6] == 0,
+                  "received bytes kept");
+
+    /* Without received bytes the sent ones are kept, and the length saturates */
+    BCM2835_TRACE_Record(BCM2835_TRACE_SPI0, 0, BCM2835_SPI_CS0, 0x12345, Tx, sizeof(Tx), NULL, 0, Start, 0);
+    bcm2835_trace_snapshot(UT_Trace_Recs, 1);
+    UtAssert_True(memcmp(UT_Trace_Recs[0].data, Tx, sizeof(Tx)) == 0, "sent bytes kept");
+    UtAssert_True(UT_Trace_Recs[0].len == 0xFFFF, "length saturated");
+
+    BCM2835_TRACE_Record(BCM2835_TRACE_SPI0, 0, BCM2835_SPI_CS0, 4, NULL, 0, NULL, 0, Start, 0);
+    bcm2835_trace_snapshot(UT_Trace_Recs, 1);
+    UtAssert_True(UT_Trace_Recs[0].reg == 0 && UT_Trace_Recs[0].data[0] == 0, "no bytes");
+
+    /* Nothing is recorded while disabled, but the bus statistics still count the transaction */
+    bcm2835_trace_enable(0);
+    BCM2835_TRACE_Record(BCM2835_TRACE_SPI0, 0, BCM2835_SPI_CS0, 4, Tx, 1, NULL, 0, Start, 0);
+    UtAssert_True(UT_Trace_Recorded() == Head + 3, "disabled");
+    UtAssert_True(UT_GetStubCount(UT_KEY(BCM2835_BUS_Account)) == 4, "transactions accounted");
+}
+
+void Test_bcm2835_trace_snapshot_Wrap(void)
+{
+    /*
+     * Test Case For:
+     * uint32_t bcm2835_trace_snapshot(bcm2835_trace_rec_t *recs, uint32_t max) after the ring wraps
+     */
+    bcm2835_trace_stats_t Stats;
+    uint32                Head = UT_Trace_Recorded();
+    uint32                Count;
+    uint32                i;
+    uint8                 Tx;
+
+    for (i = 0; i < BCM2835_TRACE_DEPTH + 3; i++)
+    {
+        Tx = (uint8)i;
+        BCM2835_TRACE_Record(BCM2835_TRACE_I2C_WRITE, BCM2835_I2C_BUS_BSC1, 0x68, 1, &Tx, 1, NULL, 0, 0, 0);
+    }
+    Head += BCM2835_TRACE_DEPTH + 3;
+
+    /* Only the newest records are left, oldest first */
+    Count = bcm2835_trace_snapshot(UT_Trace_Recs, BCM2835_TRACE_DEPTH);
+    UtAssert_True(Count == BCM2835_TRACE_DEPTH, "full ring (%lu)", (unsigned long)Count);
+    UtAssert_True(UT_Trace_Recs[0].seq == Head - BCM2835_TRACE_DEPTH + 1, "oldest record");
+    UtAssert_True(UT_Trace_Recs[BCM2835_TRACE_DEPTH - 1].seq == Head, "newest record");
+    UtAssert_True(UT_Trace_Recs[BCM2835_TRACE_DEPTH - 1].reg == (uint8)(BCM2835_TRACE_DEPTH + 2), "newest data");
+    for (i = 1; i < Count && UT_Trace_Recs[i].seq == UT_Trace_Recs[i - 1].seq + 1; i++)
+    {
+    }
+    UtAssert_True(i == Count, "records in order");
+
+    Count = bcm2835_trace_snapshot(UT_Trace_Recs, 2);
+    UtAssert_True(Count == 2 && UT_Trace_Recs[0].seq == Head - 1 && UT_Trace_Recs[1].seq == Head,
+                  "newest two records");
+
+    bcm2835_trace_get_stats(&Stats);
+    UtAssert_True(Stats.Recorded == Head && Stats.Overwritten == Head - BCM2835_TRACE_DEPTH, "overwritten (%lu)",
+                  (unsigned long)Stats.Overwritten);
+}
+
+void Test_bcm2835_trace_dump(void)
+{
+    /*
+     * Test Case For:
+     * int32_t bcm2835_trace_dump(const char *path)
+     * int32_t bcm2835_trace_replay_load(const char *path)
+     */
+    bcm2835_trace_stats_t Stats;
+    uint32                Expected;
+    uint8                 Tx = 0x75;
+
+    BCM2835_TRACE_Record(BCM2835_TRACE_I2C_READ_REG, BCM2835_I2C_BUS_BSC1, 0x68, 2, &Tx, 1, NULL, 0, 0, 0);
+    Expected = bcm2835_trace_snapshot(UT_Trace_Recs, BCM2835_TRACE_DEPTH);
+
+    UT_SetDefaultReturnValue(UT_KEY(OS_OpenCreate), OS_ERROR);
+    UtAssert_True(bcm2835_trace_dump("/ram/trace.bin") == -1, "dump not opened");
+    UtAssert_True(bcm2835_trace_replay_load("/ram/trace.bin") == -1, "load not opened");
+    UT_ClearDefaultReturnValue(UT_KEY(OS_OpenCreate));
+
+    UT_SetDeferredRetcode(UT_KEY(OS_write), 2, OS_ERROR);
+    UtAssert_True(bcm2835_trace_dump("/ram/trace.bin") == -1, "write error");
+    UtAssert_True(UT_GetStubCount(UT_KEY(OS_close)) == 1, "file closed");
+
+    /* Round trip through the file */
+    memset(&UT_Trace_File, 0, sizeof(UT_Trace_File));
+    UT_SetDataBuffer(UT_KEY(OS_write), &UT_Trace_File, sizeof(UT_Trace_File), false);
+    UtAssert_True(bcm2835_trace_dump("/ram/trace.bin") == (int32)Expected, "records written");
+    UtAssert_True(UT_Trace_File.Hdr.magic == BCM2835_TRACE_MAGIC &&
+                      UT_Trace_File.Hdr.version == BCM2835_TRACE_VERSION &&
+                      UT_Trace_File.Hdr.rec_size == sizeof(bcm2835_trace_rec_t) &&
+                      UT_Trace_File.Hdr.count == Expected &&
+                      UT_Trace_File.Hdr.clock == BCM2835_TRACE_CLOCK_MONOTONIC,
+                  "file header");
+    UtAssert_True(memcmp(UT_Trace_File.Recs, UT_Trace_Recs, Expected * sizeof(bcm2835_trace_rec_t)) == 0,
+                  "file records");
+
+    UT_SetDataBuffer(UT_KEY(OS_read), &UT_Trace_File, sizeof(UT_Trace_File), false);
+    UtAssert_True(bcm2835_trace_replay_load("/ram/trace.bin") == (int32)Expected, "records loaded");
+    bcm2835_trace_get_stats(&Stats);
+    UtAssert_True(Stats.ReplayLoaded == Expected, "replay loaded (%lu)", (unsigned long)Stats.ReplayLoaded);
+
+    /* A file of another format or cut short loads nothing */
+    UT_Trace_File.Hdr.magic = 0;
+    UT_SetDataBuffer(UT_KEY(OS_read), &UT_Trace_File, sizeof(UT_Trace_File), false);
+    UtAssert_True(bcm2835_trace_replay_load("/ram/trace.bin") == -1, "bad magic");
+    bcm2835_trace_get_stats(&Stats);
+    UtAssert_True(Stats.ReplayLoaded == 0, "previous replay dropped");
+
+    UT_Trace_File.Hdr.magic = BCM2835_TRACE_MAGIC;
+    UT_SetDataBuffer(UT_KEY(OS_read), &UT_Trace_File, sizeof(UT_Trace_File.Hdr) + sizeof(bcm2835_trace_rec_t),
+                     false);
+    UtAssert_True(bcm2835_trace_replay_load("/ram/trace.bin") == -1, "file cut short");
+
+    /* An empty trace is a valid file */
+    UT_Trace_File.Hdr.count = 0;
+    UT_SetDataBuffer(UT_KEY(OS_read), &UT_Trace_File, sizeof(UT_Trace_File.Hdr), false);
+    UtAssert_True(bcm2835_trace_replay_load("/ram/trace.bin") == 0, "empty trace");
+}
+
+void Test_BCM2835_TRACE_Replay(void)
+{
+    /*
+     * Test Case For:
+     * uint8 BCM2835_TRACE_Replay(...)
+     */
+    bcm2835_trace_stats_t Stats;
+    uint8                 Reg  = 0x3B;
+    uint8                 Rx[BCM2835_TRACE_DATA + 2];
+    uint32                Head = UT_Trace_Recorded();
+
+    memset(&UT_Trace_File, 0, sizeof(UT_Trace_File));
+    UT_Trace_File.Hdr.magic    = BCM2835_TRACE_MAGIC;
+    UT_Trace_File.Hdr.version  = BCM2835_TRACE_VERSION;
+    UT_Trace_File.Hdr.rec_size = sizeof(bcm2835_trace_rec_t);
+    UT_Trace_File.Hdr.count    = 3;
+    UT_Trace_SetRec(&UT_Trace_File.Recs[0], 0x68, 0x3B, BCM2835_I2C_REASON_OK, 10);
+    UT_Trace_SetRec(&UT_Trace_File.Recs[1], 0x0C, 0x3B, BCM2835_I2C_REASON_ERROR_NACK, 20);
+    UT_Trace_SetRec(&UT_Trace_File.Recs[2], 0x68, 0x3B, BCM2835_I2C_REASON_OK, 30);
+    UT_SetDataBuffer(UT_KEY(OS_read), &UT_Trace_File, sizeof(UT_Trace_File.Hdr) + 3 * sizeof(bcm2835_trace_rec_t),
+                     false);
+    UtAssert_True(bcm2835_trace_replay_load("/ram/trace.bin") == 3, "replay loaded");
+
+    /* The next matching record is served, skipping the others */
+    memset(Rx, 0xFF, sizeof(Rx));
+    UtAssert_True(BCM2835_TRACE_Replay(BCM2835_TRACE_I2C_READ_REG, BCM2835_I2C_BUS_BSC1, 0x0C, 7, &Reg, 1, Rx,
+                                       sizeof(Rx)) == BCM2835_I2C_REASON_ERROR_NACK,
+                  "recorded status");
+    UtAssert_True(Rx[0] == 20 && Rx[BCM2835_TRACE_DATA - 1] == 27 && Rx[BCM2835_TRACE_DATA] == 0,
+                  "recorded data");
+
+    UtAssert_True(BCM2835_TRACE_Replay(BCM2835_TRACE_I2C_READ_REG, BCM2835_I2C_BUS_BSC1, 0x68, 7, &Reg, 1, Rx,
+                                       sizeof(Rx)) == BCM2835_I2C_REASON_OK,
+                  "next match");
+    UtAssert_True(Rx[0] == 30, "data of the record after the last match (%u)", (unsigned int)Rx[0]);
+
+    /* The search wraps to the start of the trace */
+    BCM2835_TRACE_Replay(BCM2835_TRACE_I2C_READ_REG, BCM2835_I2C_BUS_BSC1, 0x68, 7, &Reg, 1, Rx, sizeof(Rx));
+    UtAssert_True(Rx[0] == 10, "search wrapped (%u)", (unsigned int)Rx[0]);
+
+    /* Without a match the transaction succeeds with zeros */
+    Reg = 0x75;
+    memset(Rx, 0xFF, sizeof(Rx));
+    UtAssert_True(BCM2835_TRACE_Replay(BCM2835_TRACE_I2C_READ_REG, BCM2835_I2C_BUS_BSC1, 0x68, 1, &Reg, 1, Rx, 1) ==
+                      BCM2835_I2C_REASON_OK,
+                  "no match");
+    UtAssert_True(Rx[0] == 0 && Rx[1] == 0xFF, "zero data");
+
+    bcm2835_trace_get_stats(&Stats);
+    UtAssert_True(Stats.ReplayHits == 3 && Stats.ReplayMisses == 1, "hits (%lu) and misses (%lu)",
+                  (unsigned long)Stats.ReplayHits, (unsigned long)Stats.ReplayMisses);
+
+    /* Replayed transactions are traced as well, taking as long as the captured ones */
+    UtAssert_True(UT_Trace_Recorded() == Head + 4, "replay recorded");
+    bcm2835_trace_snapshot(UT_Trace_Recs, 4);
+    UtAssert_True(UT_Trace_Recs[0].status == BCM2835_I2C_REASON_ERROR_NACK && UT_Trace_Recs[0].data[0] == 20,
+                  "replayed record");
+    UtAssert_True(UT_Trace_Recs[0].duration_us >= 20, "replayed duration (%lu)",
+                  (unsigned long)UT_Trace_Recs[0].duration_us);
+}
+
+void Test_BCM2835_TRACE_Now(void)
+{
+    /*
+     * Test Case For:
+     * uint32 BCM2835_TRACE_Now(void) on the System Timer
+     */
+    uint32 Timer[BCM2835_ST_CHI / 4 + 1];
+
+    memset(Timer, 0, sizeof(Timer));
+    Timer[BCM2835_ST_CLO / 4] = 123456;
+    bcm2835_st                = Timer;
+
+    UT_SetDefaultReturnValue(UT_KEY(BCM2835_LIB_MapRegion), 1);
+    BCM2835_TRACE_Init();
+
+    if (BCM2835_DEBUG)
+    {
+        /* The System Timer is never used without the hardware */
+        UtAssert_True(BCM2835_TRACE_Now() == (uint32)(UT_Trace_NowUs + 1), "CLOCK_MONOTONIC");
+    }
+    else
+    {
+        UtAssert_True(BCM2835_TRACE_Now() == 123456, "System Timer");
+    }
+
+    bcm2835_st = MAP_FAILED;
+}
+
+/*
+ * Setup function prior to every test
+ */
+void Bcm2835_UT_Setup(void)
+{
+    UT_ResetState(0);
+
+    BCM2835_TRACE_Init();
+    bcm2835_trace_enable(1);
+}
+
+/*
+ * Teardown function after every test
+ */
+void Bcm2835_UT_TearDown(void) {}
+
+/*
+ * Register the test cases to execute with the unit test tool
+ */
+void UtTest_Setup(void)
+{
+    ADD_TEST(BCM2835_TRACE_Init);
+    ADD_TEST(BCM2835_TRACE_Record);
+    ADD_TEST(bcm2835_trace_snapshot_Wrap);
+    ADD_TEST(bcm2835_trace_dump);
+    ADD_TEST(BCM2835_TRACE_Replay);
+    ADD_TEST(BCM2835_TRACE_Now);
+}
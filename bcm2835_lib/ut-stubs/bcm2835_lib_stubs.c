@@ -0,0 +1,283 @@
+/*
+**  GSC-18128-1, "Core Flight Executive Version 6.7"
+**
+**  Copyright (c) 2006-2019 United States Government as represented by
+**  the Administrator of the National Aeronautics and Space Administration.
+**  All Rights Reserved.
+**
+**  Licensed under the Apache License, Version 2.0 (the "License");
+**  you may not use this file except in compliance with the License.
+**  You may obtain a copy of the License at
+**
+**    http://www.apache.org/licenses/LICENSE-2.0
+**
+**  Unless required by applicable law or agreed to in writing, software
+**  distributed under the License is distributed on an "AS IS" BASIS,
+**  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**  See the License for the specific language governing permissions and
+**  limitations under the License.
+*/
+
+/*
+** File: bcm2835_lib_stubs.c
+**
+** Purpose:
+** Unit test stubs for the BCM2835 library
+**
+** Notes:
+** Only the functions called by the apps are stubbed: the I2C bus
+** scheduler, the periodic wakeup, the sequence lock, the rate limited
+** events, the bus trace, the bus statistics and the Software Bus buffer
+** pool.
+** The register level functions are only called by the device libraries,
+** which are replaced by their own stubs.
+**
+** Functions with output parameters copy them from the data buffer of
+** the stub, if the test case set one.
+*/
+
+/*
+ * The stub functions always share the same API header file as the
+ * main FSW code does.  This should define the same functions
+ * with the same parameters.
+ */
+#include "bcm2835_lib.h"
+
+#include <stdarg.h>
+#include <string.h>
+
+/*
+ * The "utstubs.h" provides the generic stub framework from UT Assert
+ */
+#include "utstubs.h"
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* I2C bus scheduler stubs                                         */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+int32_t bcm2835_i2c_sched_register(uint8_t bus, const char *name, uint8_t priority, uint32_t period_us,
+                                   uint32_t deadline_us, uint32_t *client_id)
+{
+    int32_t status;
+
+    UT_Stub_RegisterContextGenericArg(UT_KEY(bcm2835_i2c_sched_register), bus);
+    UT_Stub_RegisterContextGenericArg(UT_KEY(bcm2835_i2c_sched_register), period_us);
+    UT_Stub_RegisterContextGenericArg(UT_KEY(bcm2835_i2c_sched_register), deadline_us);
+
+    status = UT_DEFAULT_IMPL(bcm2835_i2c_sched_register);
+    if (status == BCM2835_I2C_SCHED_OK)
+    {
+        *client_id = 0;
+        UT_Stub_CopyToLocal(UT_KEY(bcm2835_i2c_sched_register), client_id, sizeof(*client_id));
+    }
+
+    return status;
+
+} /* End bcm2835_i2c_sched_register */
+
+int32_t bcm2835_i2c_sched_set_period(uint32_t client_id, uint32_t period_us, uint32_t deadline_us)
+{
+    UT_Stub_RegisterContextGenericArg(UT_KEY(bcm2835_i2c_sched_set_period), client_id);
+    UT_Stub_RegisterContextGenericArg(UT_KEY(bcm2835_i2c_sched_set_period), period_us);
+    UT_Stub_RegisterContextGenericArg(UT_KEY(bcm2835_i2c_sched_set_period), deadline_us);
+
+    return UT_DEFAULT_IMPL(bcm2835_i2c_sched_set_period);
+
+} /* End bcm2835_i2c_sched_set_period */
+
+int32_t bcm2835_i2c_sched_start_job(uint32_t client_id)
+{
+    return UT_DEFAULT_IMPL(bcm2835_i2c_sched_start_job);
+} /* End bcm2835_i2c_sched_start_job */
+
+int32_t bcm2835_i2c_sched_acquire(uint32_t client_id, int32_t timeout_ms)
+{
+    UT_Stub_RegisterContextGenericArg(UT_KEY(bcm2835_i2c_sched_acquire), timeout_ms);
+
+    return UT_DEFAULT_IMPL(bcm2835_i2c_sched_acquire);
+
+} /* End bcm2835_i2c_sched_acquire */
+
+int32_t bcm2835_i2c_sched_release(uint32_t client_id)
+{
+    return UT_DEFAULT_IMPL(bcm2835_i2c_sched_release);
+} /* End bcm2835_i2c_sched_release */
+
+int32_t bcm2835_i2c_sched_yield(uint32_t client_id)
+{
+    return UT_DEFAULT_IMPL(bcm2835_i2c_sched_yield);
+} /* End bcm2835_i2c_sched_yield */
+
+int32_t bcm2835_i2c_sched_get_stats(uint32_t client_id, bcm2835_i2c_sched_stats_t *stats)
+{
+    int32_t status;
+
+    status = UT_DEFAULT_IMPL(bcm2835_i2c_sched_get_stats);
+
+    memset(stats, 0, sizeof(*stats));
+    UT_Stub_CopyToLocal(UT_KEY(bcm2835_i2c_sched_get_stats), stats, sizeof(*stats));
+
+    return status;
+
+} /* End bcm2835_i2c_sched_get_stats */
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* Periodic wakeup stubs                                           */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+int bcm2835_periodic_init(bcm2835_periodic_t *p, uint32_t period_us)
+{
+    UT_Stub_RegisterContextGenericArg(UT_KEY(bcm2835_periodic_init), period_us);
+
+    /* Succeeds (1) unless the test case sets another value */
+    return UT_DEFAULT_IMPL_RC(bcm2835_periodic_init, 1);
+
+} /* End bcm2835_periodic_init */
+
+uint32_t bcm2835_periodic_wait(bcm2835_periodic_t *p)
+{
+    return UT_DEFAULT_IMPL(bcm2835_periodic_wait);
+} /* End bcm2835_periodic_wait */
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* Sequence lock stubs                                             */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void bcm2835_seqlock_init(bcm2835_seqlock_t *lock)
+{
+    UT_DEFAULT_IMPL(bcm2835_seqlock_init);
+} /* End bcm2835_seqlock_init */
+
+void bcm2835_seqlock_write(bcm2835_seqlock_t *lock, void *value, const void *src, uint32_t size)
+{
+    UT_DEFAULT_IMPL(bcm2835_seqlock_write);
+
+    /* A test case can capture the values written with a data buffer */
+    UT_Stub_CopyFromLocal(UT_KEY(bcm2835_seqlock_write), src, size);
+
+} /* End bcm2835_seqlock_write */
+
+int bcm2835_seqlock_read(const bcm2835_seqlock_t *lock, const void *value, void *dst, uint32_t size, uint32_t tries)
+{
+    int status;
+
+    /* No value was written (0) unless the test case sets another value */
+    status = UT_DEFAULT_IMPL(bcm2835_seqlock_read);
+    if (status != 0)
+    {
+        UT_Stub_CopyToLocal(UT_KEY(bcm2835_seqlock_read), dst, size);
+    }
+
+    return status;
+
+} /* End bcm2835_seqlock_read */
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* Rate limited event stubs                                        */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void bcm2835_evs_limit_init(bcm2835_evs_limit_t *lim, const char *name, uint16_t burst, uint32_t window_s)
+{
+    UT_DEFAULT_IMPL(bcm2835_evs_limit_init);
+} /* End bcm2835_evs_limit_init */
+
+int bcm2835_evs_limit_check(bcm2835_evs_limit_t *lim, uint16_t event_id, uint16_t event_type)
+{
+    UT_Stub_RegisterContextGenericArg(UT_KEY(bcm2835_evs_limit_check), event_id);
+    UT_Stub_RegisterContextGenericArg(UT_KEY(bcm2835_evs_limit_check), event_type);
+
+    /* Sends (1) unless the test case sets another value */
+    return UT_DEFAULT_IMPL_RC(bcm2835_evs_limit_check, 1);
+
+} /* End bcm2835_evs_limit_check */
+
+void bcm2835_evs_limit_send(bcm2835_evs_limit_t *lim, uint16_t event_id, uint16_t event_type, const char *spec, ...)
+{
+    va_list va;
+
+    /*
+     * The arguments are registered as in the CFE_EVS_SendEvent stub,
+     * so a hook function can check the event ID and format.
+     */
+    UT_Stub_RegisterContextGenericArg(UT_KEY(bcm2835_evs_limit_send), event_id);
+    UT_Stub_RegisterContextGenericArg(UT_KEY(bcm2835_evs_limit_send), event_type);
+    UT_Stub_RegisterContextGenericArg(UT_KEY(bcm2835_evs_limit_send), spec);
+
+    va_start(va, spec);
+    UT_DEFAULT_IMPL_VARARGS(bcm2835_evs_limit_send, va);
+    va_end(va);
+
+} /* End bcm2835_evs_limit_send */
+
+void bcm2835_evs_limit_flush(bcm2835_evs_limit_t *lim)
+{
+    UT_DEFAULT_IMPL(bcm2835_evs_limit_flush);
+} /* End bcm2835_evs_limit_flush */
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* Bus trace and statistics stubs                                  */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+int32_t bcm2835_trace_dump(const char *path)
+{
+    return UT_DEFAULT_IMPL(bcm2835_trace_dump);
+} /* End bcm2835_trace_dump */
+
+int32_t bcm2835_trace_replay_load(const char *path)
+{
+    return UT_DEFAULT_IMPL(bcm2835_trace_replay_load);
+} /* End bcm2835_trace_replay_load */
+
+void bcm2835_bus_get_stats(bcm2835_bus_stats_t *stats, uint8_t reset)
+{
+    UT_Stub_RegisterContextGenericArg(UT_KEY(bcm2835_bus_get_stats), reset);
+
+    UT_DEFAULT_IMPL(bcm2835_bus_get_stats);
+
+    memset(stats, 0, sizeof(*stats));
+    UT_Stub_CopyToLocal(UT_KEY(bcm2835_bus_get_stats), stats, sizeof(*stats));
+
+} /* End bcm2835_bus_get_stats */
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* Software Bus buffer pool stubs                                  */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+int bcm2835_sb_pool_init(bcm2835_sb_pool_t *pool, size_t size, uint16_t depth)
+{
+    UT_Stub_RegisterContextGenericArg(UT_KEY(bcm2835_sb_pool_init), size);
+    UT_Stub_RegisterContextGenericArg(UT_KEY(bcm2835_sb_pool_init), depth);
+
+    /* Succeeds (1) unless the test case sets another value */
+    return UT_DEFAULT_IMPL_RC(bcm2835_sb_pool_init, 1);
+
+} /* End bcm2835_sb_pool_init */
+
+void bcm2835_sb_pool_fill(bcm2835_sb_pool_t *pool)
+{
+    UT_DEFAULT_IMPL(bcm2835_sb_pool_fill);
+} /* End bcm2835_sb_pool_fill */
+
+CFE_SB_Buffer_t *bcm2835_sb_pool_get(bcm2835_sb_pool_t *pool)
+{
+    CFE_SB_Buffer_t *Buf = NULL;
+
+    UT_DEFAULT_IMPL(bcm2835_sb_pool_get);
+
+    /* NULL, as with no SB memory, unless the test case set a buffer */
+    UT_Stub_CopyToLocal(UT_KEY(bcm2835_sb_pool_get), &Buf, sizeof(Buf));
+
+    return Buf;
+
+} /* End bcm2835_sb_pool_get */
+
+void bcm2835_sb_pool_drain(bcm2835_sb_pool_t *pool)
+{
+    UT_DEFAULT_IMPL(bcm2835_sb_pool_drain);
+} /* End bcm2835_sb_pool_drain */
@@ -29,6 +29,7 @@
 #ifndef GPS_APP_PERFIDS_H
 #define GPS_APP_PERFIDS_H
 
-#define GPS_APP_PERF_ID 96
+#define GPS_APP_PERF_ID     96
+#define GPS_APP_ACQ_PERF_ID 97
 
 #endif /* GPS_APP_PERFIDS_H */
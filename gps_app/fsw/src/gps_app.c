@@ -94,8 +94,8 @@ void GPS_APP_Main(void)
         }
         else
         {
-            CFE_EVS_SendEvent(GPS_APP_PIPE_ERR_EID, CFE_EVS_EventType_ERROR,
-                              "GPS APP: SB Pipe Read Error, App Will Exit");
+            bcm2835_evs_limit_send(&GPS_APP_Data.EventLimit, GPS_APP_PIPE_ERR_EID, CFE_EVS_EventType_ERROR,
+                                   "GPS APP: SB Pipe Read Error, App Will Exit");
 
             GPS_APP_Data.RunStatus = CFE_ES_RunStatus_APP_ERROR;
         }
@@ -106,6 +106,8 @@ void GPS_APP_Main(void)
     */
     CFE_ES_PerfLogExit(GPS_APP_PERF_ID);
 
+    bcm2835_sb_pool_drain(&GPS_APP_Data.BufPool);
+
     CFE_ES_ExitApp(GPS_APP_Data.RunStatus);
 
 } /* End of GPS_APP_Main() */
@@ -152,6 +154,8 @@ int32 GPS_APP_Init(void)
     GPS_APP_Data.EventFilters[5].Mask    = 0x0000;
     GPS_APP_Data.EventFilters[6].EventID = GPS_APP_PIPE_ERR_EID;
     GPS_APP_Data.EventFilters[6].Mask    = 0x0000;
+    GPS_APP_Data.EventFilters[7].EventID = GPS_APP_ACQ_ERR_EID;
+    GPS_APP_Data.EventFilters[7].Mask    = 0x0000;
 
     /*
     ** Register the events
@@ -163,10 +167,13 @@ int32 GPS_APP_Init(void)
         return (status);
     }
 
+    bcm2835_evs_limit_init(&GPS_APP_Data.EventLimit, "GPS", GPS_APP_EVS_BURST, GPS_APP_EVS_WINDOW_S);
+
     /*
-    ** Initialize housekeeping packet (clear user data area).
+    ** Allocate the housekeeping packet buffers ahead.
     */
-    CFE_MSG_Init(&GPS_APP_Data.HkTlm.TlmHeader.Msg, GPS_APP_HK_TLM_MID, sizeof(GPS_APP_Data.HkTlm));
+    bcm2835_sb_pool_init(&GPS_APP_Data.BufPool, sizeof(GPS_APP_HkTlm_t), GPS_APP_BUF_POOL_DEPTH);
+    bcm2835_sb_pool_fill(&GPS_APP_Data.BufPool);
 
     /*
     ** Create Software Bus message pipe.
@@ -215,9 +222,43 @@ int32 GPS_APP_Init(void)
         status = CFE_TBL_Load(GPS_APP_Data.TblHandles[0], CFE_TBL_SRC_FILE, GPS_APP_TABLE_FILE);
     }
 
+    /*
+    ** Register with the I2C bus scheduler
+    */
+    status = bcm2835_i2c_sched_register(NODEMCU_I2C_BUS, "GPS_APP", GPS_APP_I2C_PRIORITY, GPS_APP_I2C_PERIOD_US,
+                                        GPS_APP_I2C_DEADLINE_US, &GPS_APP_Data.I2CClientId);
+    if (status != BCM2835_I2C_SCHED_OK)
+    {
+        CFE_ES_WriteToSysLog("GPS App: Error Registering I2C client, RC = %ld\n", (long)status);
+
+        return (status);
+    }
+
+    nodemcu_set_i2c_client(GPS_APP_Data.I2CClientId);
+
+    /* Find the fastest clock the NodeMCU reliably supports */
+    if (bcm2835_i2c_sched_acquire(GPS_APP_Data.I2CClientId, BCM2835_I2C_SCHED_PEND_FOREVER) == BCM2835_I2C_SCHED_OK)
+    {
+        nodemcu_negotiate_i2c();
+        bcm2835_i2c_sched_release(GPS_APP_Data.I2CClientId);
+    }
+
+    /*
+    ** Start reading fixes; from here on only the acquisition task uses the bus
+    */
+    status = CFE_ES_CreateChildTask(&GPS_APP_Data.AcqTaskId, GPS_APP_ACQ_TASK_NAME, GPS_APP_AcqTask,
+                                    CFE_ES_TASK_STACK_ALLOCATE, GPS_APP_ACQ_STACK_SIZE, GPS_APP_ACQ_PRIORITY, 0);
+    if (status != CFE_SUCCESS)
+    {
+        CFE_EVS_SendEvent(GPS_APP_ACQ_ERR_EID, CFE_EVS_EventType_ERROR,
+                          "GPS App: Error creating acquisition task, RC = 0x%08lX", (unsigned long)status);
+
+        return (status);
+    }
+
     CFE_EVS_SendEvent(GPS_APP_STARTUP_INF_EID, CFE_EVS_EventType_INFORMATION, "GPS App Initialized.%s",
                       GPS_APP_VERSION_STRING);
-                      
+
 
     return (CFE_SUCCESS);
 
@@ -248,8 +289,8 @@ void GPS_APP_ProcessCommandPacket(CFE_SB_Buffer_t *SBBufPtr)
             break;
 
         default:
-            CFE_EVS_SendEvent(GPS_APP_INVALID_MSGID_ERR_EID, CFE_EVS_EventType_ERROR,
-                              "GPS: invalid command packet,MID = 0x%x", (unsigned int)CFE_SB_MsgIdToValue(MsgId));
+            bcm2835_evs_limit_send(&GPS_APP_Data.EventLimit, GPS_APP_INVALID_MSGID_ERR_EID, CFE_EVS_EventType_ERROR,
+                                   "GPS: invalid command packet,MID = 0x%x", (unsigned int)CFE_SB_MsgIdToValue(MsgId));
             break;
     }
 
@@ -319,33 +360,68 @@ void GPS_APP_ProcessGroundCommand(CFE_SB_Buffer_t *SBBufPtr)
 /* * * * * * * * * * * * * * * * * * * * * * * *  * * * * * * *  * *  * * * * */
 int32 GPS_APP_ReportHousekeeping(const CFE_MSG_CommandHeader_t *Msg)
 {
-    int i;
-        
-    if(OS_MutSemTake(i2c_mutexvar) != OS_SUCCESS){
-        OS_printf("GPS APP: I2C Busy. \n");
-        return CFE_SUCCESS;
-    }
+    int                        i;
+    CFE_SB_Buffer_t           *Buf;
+    GPS_APP_HkTlm_t           *HkTlm;
+    GPS_APP_Fix_t              Fix;
+    uint32                     FixAgeMs;
+    bcm2835_i2c_sched_stats_t  I2CStats;
+    bcm2835_i2c_device_stats_t DevStats;
 
-    GPS_APP_Data.Time = nodemcu_gettime();
-    GPS_APP_Data.XPos = nodemcu_getxpos();
-    GPS_APP_Data.YPos = nodemcu_getypos();
-    GPS_APP_Data.ZPos = nodemcu_getzpos();
-      
     /*
-    ** Get command execution counters...
+    ** The bus belongs to the acquisition task, report its latest fix
+    ** whatever its age...
     */
-    GPS_APP_Data.HkTlm.Payload.CommandErrorCounter = GPS_APP_Data.ErrCounter;
-    GPS_APP_Data.HkTlm.Payload.CommandCounter      = GPS_APP_Data.CmdCounter;
-    GPS_APP_Data.HkTlm.Payload.Time                = GPS_APP_Data.Time;
-    GPS_APP_Data.HkTlm.Payload.XPos                = GPS_APP_Data.XPos;
-    GPS_APP_Data.HkTlm.Payload.YPos                = GPS_APP_Data.YPos;
-    GPS_APP_Data.HkTlm.Payload.ZPos                = GPS_APP_Data.ZPos;
+    if (!GPS_APP_CacheGet(&Fix, &FixAgeMs))
+    {
+        memset(&Fix, 0, sizeof(Fix));
+        FixAgeMs = GPS_APP_FIX_AGE_NONE;
+    }
+
+    bcm2835_i2c_sched_get_stats(GPS_APP_Data.I2CClientId, &I2CStats);
+    nodemcu_get_i2c_stats(&DevStats);
 
     /*
-    ** Send housekeeping telemetry packet...
+    ** Build the packet in an SB buffer, which SB takes over when sent...
     */
-    CFE_SB_TimeStampMsg(&GPS_APP_Data.HkTlm.TlmHeader.Msg);
-    CFE_SB_TransmitMsg(&GPS_APP_Data.HkTlm.TlmHeader.Msg, true);
+    Buf = bcm2835_sb_pool_get(&GPS_APP_Data.BufPool);
+    if (Buf == NULL)
+    {
+        OS_printf("GPS APP: No SB buffer for HK. \n");
+    }
+    else
+    {
+        HkTlm = (GPS_APP_HkTlm_t *)Buf;
+        CFE_MSG_Init(&HkTlm->TlmHeader.Msg, GPS_APP_HK_TLM_MID, sizeof(*HkTlm));
+
+        /*
+        ** Get command execution counters...
+        */
+        HkTlm->Payload.CommandErrorCounter = GPS_APP_Data.ErrCounter;
+        HkTlm->Payload.CommandCounter      = GPS_APP_Data.CmdCounter;
+        HkTlm->Payload.I2CDeadlineMisses   = (uint16)I2CStats.DeadlineMisses;
+        HkTlm->Payload.I2CErrors           = (uint16)DevStats.Errors;
+        HkTlm->Payload.I2CTransactions     = DevStats.Transactions;
+        HkTlm->Payload.I2CBusTimeUs        = (uint32)DevStats.BusTimeUs;
+        HkTlm->Payload.I2CSpeedHz          = nodemcu_get_i2c_speed();
+        HkTlm->Payload.Time                = Fix.Time;
+        HkTlm->Payload.XPos                = Fix.XPos;
+        HkTlm->Payload.YPos                = Fix.YPos;
+        HkTlm->Payload.ZPos                = Fix.ZPos;
+        HkTlm->Payload.FixAgeMs            = FixAgeMs;
+        HkTlm->Payload.FixesBusBusy        = __atomic_load_n(&GPS_APP_Data.FixesBusBusy, __ATOMIC_RELAXED);
+
+        /*
+        ** Send housekeeping telemetry packet...
+        */
+        CFE_SB_TimeStampMsg(&HkTlm->TlmHeader.Msg);
+        if (CFE_SB_TransmitBuffer(Buf, true) != CFE_SUCCESS)
+        {
+            CFE_SB_ReleaseMessageBuffer(Buf);
+        }
+
+        bcm2835_sb_pool_fill(&GPS_APP_Data.BufPool);
+    }
 
     /*
     ** Manage any pending table loads, validations, etc.
@@ -354,19 +430,109 @@ int32 GPS_APP_ReportHousekeeping(const CFE_MSG_CommandHeader_t *Msg)
     {
         CFE_TBL_Manage(GPS_APP_Data.TblHandles[i]);
     }
-    
-    CFE_EVS_SendEvent(GPS_APP_STARTUP_INF_EID, CFE_EVS_EventType_INFORMATION, "GPS App: Report HK Done. Time: %.2f. XPos: %.2f. Ypos: %.2f. ZPos: %.2f",
-                      GPS_APP_Data.Time, GPS_APP_Data.XPos, GPS_APP_Data.YPos, GPS_APP_Data.ZPos);
-                      
-    if(OS_MutSemGive(i2c_mutexvar) != OS_SUCCESS){
-        OS_printf("GPS APP: Cannot give mutex. \n");
-        return CFE_SUCCESS;
-    }
+
+    /* Report the events counted in the window, if it is over */
+    bcm2835_evs_limit_flush(&GPS_APP_Data.EventLimit);
 
     return CFE_SUCCESS;
 
 } /* End of GPS_APP_ReportHousekeeping() */
 
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  GPS_APP_AcqTask                                                    */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Entry point of the acquisition child task. Reads a fix every       */
+/*         period, independently of the HK schedule.                          */
+/*                                                                            */
+/* * * * * * * * * * * * * * * * * * * * * * * *  * * * * * * *  * *  * * * * */
+void GPS_APP_AcqTask(void)
+{
+    bcm2835_periodic_t Timer;
+
+    if (CFE_ES_RegisterChildTask() != CFE_SUCCESS)
+    {
+        CFE_ES_ExitChildTask();
+        return;
+    }
+
+    bcm2835_periodic_init(&Timer, GPS_APP_ACQ_PERIOD_US);
+
+    while (GPS_APP_Data.RunStatus == CFE_ES_RunStatus_APP_RUN)
+    {
+        bcm2835_periodic_wait(&Timer);
+
+        CFE_ES_PerfLogEntry(GPS_APP_ACQ_PERF_ID);
+        GPS_APP_AcqFix();
+        CFE_ES_PerfLogExit(GPS_APP_ACQ_PERF_ID);
+    }
+
+    CFE_ES_ExitChildTask();
+
+} /* End of GPS_APP_AcqTask() */
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  GPS_APP_AcqFix                                                     */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Reads one fix into the cache. The bus is held for the register     */
+/*         reads only; a fix whose bus grant times out is skipped and the     */
+/*         cache keeps the previous one.                                      */
+/*                                                                            */
+/* * * * * * * * * * * * * * * * * * * * * * * *  * * * * * * *  * *  * * * * */
+void GPS_APP_AcqFix(void)
+{
+    GPS_APP_Fix_t Fix;
+
+    bcm2835_i2c_sched_start_job(GPS_APP_Data.I2CClientId);
+
+    if (bcm2835_i2c_sched_acquire(GPS_APP_Data.I2CClientId, GPS_APP_I2C_TIMEOUT_MS) != BCM2835_I2C_SCHED_OK)
+    {
+        __atomic_fetch_add(&GPS_APP_Data.FixesBusBusy, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    Fix.ReadTime = CFE_TIME_GetTime();
+    Fix.Time     = nodemcu_gettime();
+    Fix.XPos     = nodemcu_getxpos();
+    Fix.YPos     = nodemcu_getypos();
+    Fix.ZPos     = nodemcu_getzpos();
+
+    /* Back off the clock if the reads had errors */
+    nodemcu_revalidate_i2c();
+
+    bcm2835_i2c_sched_release(GPS_APP_Data.I2CClientId);
+
+    bcm2835_seqlock_write(&GPS_APP_Data.CacheLock, &GPS_APP_Data.Cache, &Fix, sizeof(Fix));
+
+} /* End of GPS_APP_AcqFix() */
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  GPS_APP_CacheGet                                                   */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Copies the latest fix and its age, without a lock: the copy is     */
+/*         retried if the acquisition task wrote the cache meanwhile. Returns */
+/*         false if there is no fix yet, or no consistent copy in             */
+/*         GPS_APP_CACHE_TRIES tries.                                         */
+/*                                                                            */
+/* * * * * * * * * * * * * * * * * * * * * * * *  * * * * * * *  * *  * * * * */
+bool GPS_APP_CacheGet(GPS_APP_Fix_t *Fix, uint32 *AgeMs)
+{
+    CFE_TIME_SysTime_t Age;
+
+    if (!bcm2835_seqlock_read(&GPS_APP_Data.CacheLock, &GPS_APP_Data.Cache, Fix, sizeof(*Fix), GPS_APP_CACHE_TRIES))
+    {
+        return false;
+    }
+
+    Age    = CFE_TIME_Subtract(CFE_TIME_GetTime(), Fix->ReadTime);
+    *AgeMs = Age.Seconds * 1000 + CFE_TIME_Sub2MicroSecs(Age.Subseconds) / 1000;
+
+    return true;
+
+} /* End of GPS_APP_CacheGet() */
+
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
 /*                                                                            */
 /* GPS_APP_Noop -- GPS NOOP commands                                        */
@@ -398,6 +564,8 @@ int32 GPS_APP_ResetCounters(const GPS_APP_ResetCountersCmd_t *Msg)
     GPS_APP_Data.CmdCounter = 0;
     GPS_APP_Data.ErrCounter = 0;
 
+    __atomic_store_n(&GPS_APP_Data.FixesBusBusy, 0, __ATOMIC_RELAXED);
+
     CFE_EVS_SendEvent(GPS_APP_COMMANDRST_INF_EID, CFE_EVS_EventType_INFORMATION, "GPS: RESET command");
 
     return CFE_SUCCESS;
@@ -464,10 +632,10 @@ bool GPS_APP_VerifyCmdLength(CFE_MSG_Message_t *MsgPtr, size_t ExpectedLength)
         CFE_MSG_GetMsgId(MsgPtr, &MsgId);
         CFE_MSG_GetFcnCode(MsgPtr, &FcnCode);
 
-        CFE_EVS_SendEvent(GPS_APP_LEN_ERR_EID, CFE_EVS_EventType_ERROR,
-                          "Invalid Msg length: ID = 0x%X,  CC = %u, Len = %u, Expected = %u",
-                          (unsigned int)CFE_SB_MsgIdToValue(MsgId), (unsigned int)FcnCode, (unsigned int)ActualLength,
-                          (unsigned int)ExpectedLength);
+        bcm2835_evs_limit_send(&GPS_APP_Data.EventLimit, GPS_APP_LEN_ERR_EID, CFE_EVS_EventType_ERROR,
+                               "Invalid Msg length: ID = 0x%X,  CC = %u, Len = %u, Expected = %u",
+                               (unsigned int)CFE_SB_MsgIdToValue(MsgId), (unsigned int)FcnCode,
+                               (unsigned int)ActualLength, (unsigned int)ExpectedLength);
 
         result = false;
 
@@ -39,6 +39,7 @@
 #include "cfe_es.h"
 
 #include "gpsnodemcu_lib.h"
+#include "bcm2835_lib.h"
 
 #include "gps_app_perfids.h"
 #include "gps_app_msgids.h"
@@ -55,6 +56,25 @@
 #define GPS_APP_TABLE_OUT_OF_RANGE_ERR_CODE -1
 
 #define GPS_APP_TBL_ELEMENT_1_MAX 10
+
+/* Acquisition child task */
+#define GPS_APP_ACQ_TASK_NAME  "GPS_ACQ"
+#define GPS_APP_ACQ_STACK_SIZE 16384
+#define GPS_APP_ACQ_PRIORITY   70      /* Above the main task, below the IMU acquisition */
+#define GPS_APP_ACQ_PERIOD_US  1000000 /* Fix rate of the NodeMCU */
+
+/* I2C bus scheduler parameters (see bcm2835_i2c_sched_register) */
+#define GPS_APP_I2C_PRIORITY    20                    /* Tie-break priority, lower is more important */
+#define GPS_APP_I2C_PERIOD_US   GPS_APP_ACQ_PERIOD_US /* Read period of the acquisition task */
+#define GPS_APP_I2C_DEADLINE_US 0                     /* Relative deadline of each read cycle, 0 uses the period */
+#define GPS_APP_I2C_TIMEOUT_MS  1000                  /* Maximum wait for the bus, one period */
+
+#define GPS_APP_BUF_POOL_DEPTH 2 /* SB buffers allocated ahead for housekeeping packets */
+#define GPS_APP_CACHE_TRIES    8 /* Reads of the latest fix cache before giving up */
+
+/* Rate limit of the events that can repeat (see bcm2835_evs_limit_init) */
+#define GPS_APP_EVS_BURST    4  /* Events of an ID sent in a window, the next are counted */
+#define GPS_APP_EVS_WINDOW_S 60 /* Length of the window */
 /************************************************************************
 ** Type Definitions
 *************************************************************************/
@@ -69,16 +89,26 @@ typedef struct
     */
     uint8 CmdCounter;
     uint8 ErrCounter;
-    
-    double Time;
-    double XPos;
-    double YPos;
-    double ZPos;
-    
+
+    /*
+    ** I2C bus scheduler client...
+    */
+    uint32 I2CClientId;
+
+    /*
+    ** Acquisition child task, the only user of the bus after init. The
+    ** latest fix is written under a sequence lock, see bcm2835_seqlock_write.
+    */
+    CFE_ES_TaskId_t   AcqTaskId;
+    uint32            FixesBusBusy;
+    bcm2835_seqlock_t CacheLock;
+    GPS_APP_Fix_t     Cache;
+
     /*
-    ** Housekeeping telemetry packet...
+    ** SB buffers allocated ahead for the housekeeping packet, which is
+    ** built in place and sent without a copy
     */
-    GPS_APP_HkTlm_t HkTlm;
+    bcm2835_sb_pool_t BufPool;
 
     /*
     ** Run Status variable used in the main processing loop
@@ -99,6 +129,11 @@ typedef struct
     CFE_EVS_BinFilter_t EventFilters[GPS_APP_EVENT_COUNTS];
     CFE_TBL_Handle_t    TblHandles[GPS_APP_NUMBER_OF_TABLES];
 
+    /*
+    ** Rate limiter of the events that can repeat, main task only
+    */
+    bcm2835_evs_limit_t EventLimit;
+
 } GPS_APP_Data_t;
 
 /****************************************************************************/
@@ -117,6 +152,9 @@ int32 GPS_APP_ResetCounters(const GPS_APP_ResetCountersCmd_t *Msg);
 int32 GPS_APP_Process(const GPS_APP_ProcessCmd_t *Msg);
 int32 GPS_APP_Noop(const GPS_APP_NoopCmd_t *Msg);
 void  GPS_APP_GetCrc(const char *TableName);
+void  GPS_APP_AcqTask(void);
+void  GPS_APP_AcqFix(void);
+bool  GPS_APP_CacheGet(GPS_APP_Fix_t *Fix, uint32 *AgeMs);
 
 int32 GPS_APP_TblValidationFunc(void *TblData);
 
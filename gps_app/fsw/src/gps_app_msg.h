@@ -59,9 +59,27 @@ typedef GPS_APP_NoArgsCmd_t GPS_APP_ProcessCmd_t;
 
 /*************************************************************************/
 /*
-** Type definition (GPS App housekeeping)
+** Type definition (GPS App fix, as read from the NodeMCU)
 */
 
+typedef struct
+{
+    CFE_TIME_SysTime_t ReadTime; /**< \brief Time the fix was read */
+    double             Time;     /**< \brief GPS time of the fix */
+    double             XPos;
+    double             YPos;
+    double             ZPos;
+} GPS_APP_Fix_t;
+
+/*************************************************************************/
+/*
+** Type definition (GPS App housekeeping). Time to ZPos are the latest fix
+** and FixAgeMs its age when the packet was built, GPS_APP_FIX_AGE_NONE if
+** there is no fix.
+*/
+
+#define GPS_APP_FIX_AGE_NONE 0xFFFFFFFF
+
 typedef struct
 {
     uint8   CommandErrorCounter;
@@ -70,7 +88,13 @@ typedef struct
     double  XPos;
     double  YPos;
     double  ZPos;
-    uint8   spare[2];
+    uint16  I2CDeadlineMisses;
+    uint16  I2CErrors;
+    uint32  I2CTransactions;
+    uint32  I2CBusTimeUs;
+    uint32  I2CSpeedHz;
+    uint32  FixAgeMs;
+    uint32  FixesBusBusy; /**< \brief Fixes not read because the bus was not granted in a period */
 } GPS_APP_HkTlm_Payload_t;
 
 typedef struct
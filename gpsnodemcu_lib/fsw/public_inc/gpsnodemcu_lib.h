@@ -11,6 +11,7 @@
 #define GPSNODEMCU_H
 
 #include "cfe.h"
+#include "bcm2835_lib.h"
 
 // -------------------------------------------------------------- PUBLIC MACROS 
 /**
@@ -19,10 +20,32 @@
  */
 
 /**
- * \defgroup i2c speed. BAUDRATE
+ * \defgroup i2c speed. Clock used before and when the negotiation fails, and the
+ * highest clock tried by nodemcu_negotiate_i2c
  * \{
  */
-#define BAUDRATE             10000
+#define NODEMCU_I2C_SPEED            10000
+#define NODEMCU_I2C_SPEED_MAX        BCM2835_I2C_SPEED_FAST
+#define NODEMCU_I2C_SPEED_TRIALS     4
+/** \} */
+
+/**
+ * \defgroup i2c client. Value of the scheduler client before nodemcu_set_i2c_client
+ * is called; no yield is done between registers
+ * \{
+ */
+#define NODEMCU_I2C_NO_CLIENT        0xFFFFFFFFU
+/** \} */
+
+/**
+ * \defgroup i2c_bus BSC controller the NodeMCU is wired to (see bcm2835I2CBus)
+ * Wire it to BCM2835_I2C_BUS_BSC0 to keep the slow GPS reads off the IMU bus.
+ * \{
+ */
+#ifndef NODEMCU_I2C_BUS
+#define NODEMCU_I2C_BUS      BCM2835_I2C_BUS_BSC1
+#endif
+/** \} */
 
 /**
  * \defgroup i2c_registers NodeMCU as GPS I2C register
@@ -31,6 +54,7 @@
 #define NODEMCU_SLAVE_ADDRESS                   0x08  //Device address 
 
 #define NODEMCU_WHOAMI                          0x10  //Identification register. Shall return 0x08
+#define NODEMCU_WHOAMI_VALUE                    0x08  //Expected identification
 
 #define NODEMCU_TIME_REG_B0                     0x11  //Register to access time byte0
 #define NODEMCU_TIME_REG_B1                     0x12  //Register to access time byte1
@@ -103,6 +127,15 @@ void nodemcu_readregister(uint8_t slaveaddress, char registertoread, char *rxBuf
  * @description This function initializes click configuration structure to init state.
  * @note All used pins will be set to unconnected state.
  */
+/**
+ * @brief Set the I2C scheduler client of the caller
+ *
+ * @param client_id       Id returned by bcm2835_i2c_sched_register for the task reading the NodeMCU.
+ *
+ * @description Function sets the client that yields the bus between registers.
+ */
+void nodemcu_set_i2c_client(uint32_t client_id);
+
 double nodemcu_gettime(void);
 
 double nodemcu_getxpos(void);
@@ -111,6 +144,38 @@ double nodemcu_getypos(void);
 
 double nodemcu_getzpos(void);
 
+/**
+ * @brief Get the I2C statistics of the NodeMCU
+ *
+ * @param stats           Statistics of the NodeMCU I2C device handle.
+ *
+ * @description Function copies the transfer statistics for telemetry.
+ */
+void nodemcu_get_i2c_stats(bcm2835_i2c_device_stats_t *stats);
+
+/**
+ * @brief Negotiate the I2C clock of the NodeMCU
+ *
+ * @description Function finds the highest clock at which the WHOAMI register reads back
+ * reliably. The caller must own the I2C bus.
+ */
+void nodemcu_negotiate_i2c(void);
+
+/**
+ * @brief Revalidate the I2C clock of the NodeMCU
+ *
+ * @description Function backs off the clock after transfer errors or a failed WHOAMI.
+ * Meant to be called periodically while the caller owns the I2C bus.
+ */
+void nodemcu_revalidate_i2c(void);
+
+/**
+ * @brief Get the I2C clock of the NodeMCU
+ *
+ * @returns               Clock in Hz
+ */
+uint32 nodemcu_get_i2c_speed(void);
+
 /**
  * @brief Initialize library on cFS
  *
@@ -32,15 +32,53 @@
 
 #include "cfe.h"
 
+// ------------------------------------------------------------------ VARIABLES
+
+// I2C handle of the NodeMCU, holds its address, clock and statistics
+static bcm2835_i2c_device_t nodemcu_device;
+
+// I2C scheduler client that owns the bus while the registers are read
+static uint32_t nodemcu_client_id = NODEMCU_I2C_NO_CLIENT;
+
+// ----------------------------------------------- PRIVATE FUNCTION DEFINITIONS
+
+// Verify the NodeMCU answers its WHOAMI twice at the current clock
+static uint8_t nodemcu_verify(bcm2835_i2c_device_t *dev, void *arg){
+
+    char reg = NODEMCU_WHOAMI;
+    char rxBuffer[2] = {0};
+
+    if (bcm2835_i2c_device_write(dev, &reg, 1) != BCM2835_I2C_REASON_OK ||
+        bcm2835_i2c_device_read(dev, &rxBuffer[0], 1) != BCM2835_I2C_REASON_OK ||
+        bcm2835_i2c_device_write(dev, &reg, 1) != BCM2835_I2C_REASON_OK ||
+        bcm2835_i2c_device_read(dev, &rxBuffer[1], 1) != BCM2835_I2C_REASON_OK){
+        return 0;
+    }
+
+    return (rxBuffer[0] == NODEMCU_WHOAMI_VALUE && rxBuffer[1] == NODEMCU_WHOAMI_VALUE);
+
+}
+
 // ------------------------------------------------ PUBLIC FUNCTION DEFINITIONS
 void nodemcu_readregister(uint8_t slaveaddress, char registertoread, char *rxBuffer, ssize_t length){
     
-    // Set slave address in the i2c
-    bcm2835_i2c_setSlaveAddress(slaveaddress);
+    // The address is only written to the controller when it changes
+    nodemcu_device.address = slaveaddress;
     
     // Write the register and read the number of bytes expected
-    bcm2835_i2c_write(&registertoread,1);
-    bcm2835_i2c_read(rxBuffer,length);
+    bcm2835_i2c_device_write(&nodemcu_device, &registertoread,1);
+    bcm2835_i2c_device_read(&nodemcu_device, rxBuffer,length);
+
+    // Each register is a complete transaction, let a more urgent I2C client in
+    if (nodemcu_client_id != NODEMCU_I2C_NO_CLIENT){
+        bcm2835_i2c_sched_yield(nodemcu_client_id);
+    }
+
+}
+
+void nodemcu_set_i2c_client(uint32_t client_id){
+
+    nodemcu_client_id = client_id;
 
 }
 
@@ -135,6 +173,32 @@ double nodemcu_getzpos(void){
 
 
 
+void nodemcu_get_i2c_stats(bcm2835_i2c_device_stats_t *stats){
+
+    *stats = nodemcu_device.stats;
+
+}
+
+void nodemcu_negotiate_i2c(void){
+
+    nodemcu_device.address = NODEMCU_SLAVE_ADDRESS;
+    bcm2835_i2c_device_negotiate(&nodemcu_device, NODEMCU_I2C_SPEED_MAX, NODEMCU_I2C_SPEED_TRIALS, nodemcu_verify, NULL);
+
+}
+
+void nodemcu_revalidate_i2c(void){
+
+    nodemcu_device.address = NODEMCU_SLAVE_ADDRESS;
+    bcm2835_i2c_device_revalidate(&nodemcu_device, nodemcu_verify, NULL);
+
+}
+
+uint32 nodemcu_get_i2c_speed(void){
+
+    return nodemcu_device.baudrate;
+
+}
+
 // Function of initialization for the cFS
 int32 GPSNODEMCU_LIB_Init(void)
 {
@@ -147,12 +211,20 @@ int32 GPSNODEMCU_LIB_Init(void)
     // Definition of class and variables
     char            RxBuffer[1] = {0};
     
+    // Initialize the i2c of the NodeMCU bus
+    if(!bcm2835_i2c_bus_begin(NODEMCU_I2C_BUS)){
+        OS_printf("GPSNODEMCU Lib: I2C begin failed \n");
+        return CFE_STATUS_NOT_IMPLEMENTED;
+    } 
+    
+    // The NodeMCU bridge only supports a slow clock, kept in its own handle
+    bcm2835_i2c_device_init(&nodemcu_device, NODEMCU_I2C_BUS, NODEMCU_SLAVE_ADDRESS, NODEMCU_I2C_SPEED);
         
     // Read the WHO AM I register
     nodemcu_readregister (NODEMCU_SLAVE_ADDRESS, NODEMCU_WHOAMI, RxBuffer, 1);
     
     // Check for the expected value
-    if (RxBuffer[0] != 0x08){
+    if (RxBuffer[0] != NODEMCU_WHOAMI_VALUE){
         OS_printf("GPSNODEMCU Lib not implemented. NodeMCU not found. Response: %c. ", RxBuffer[0]);
         return CFE_STATUS_NOT_IMPLEMENTED;
     }
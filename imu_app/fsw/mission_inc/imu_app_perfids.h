@@ -29,6 +29,8 @@
 #ifndef IMU_APP_PERFIDS_H
 #define IMU_APP_PERFIDS_H
 
-#define IMU_APP_PERF_ID 91
+#define IMU_APP_PERF_ID     91
+#define IMU_APP_ACQ_PERF_ID 92
+#define IMU_APP_FFT_PERF_ID 93
 
 #endif /* IMU_APP_PERFIDS_H */
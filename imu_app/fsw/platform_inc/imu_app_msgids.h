@@ -36,5 +36,8 @@
 #define IMU_APP_SEND_HK_MID 0x1883
 /* V1 Telemetry Message IDs must be 0x08xx */
 #define IMU_APP_HK_TLM_MID 0x0883
+#define IMU_APP_BUS_TLM_MID 0x0886
+#define IMU_APP_BATCH_TLM_MID 0x0887
+#define IMU_APP_SPECTRUM_TLM_MID 0x0888
 
 #endif /* SAMPLE_APP_MSGIDS_H */
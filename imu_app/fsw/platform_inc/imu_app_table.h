@@ -29,6 +29,22 @@
 #ifndef IMU_APP_TABLE_H
 #define IMU_APP_TABLE_H
 
+/*
+** Content of the batch packets. Only the sensors needed for the selected
+** content are read; ATTITUDE reads the accelerometer and magnetometer.
+*/
+#define IMU_APP_CONTENT_ACCEL    0x0001 /* Accel_x, Accel_y, Accel_z */
+#define IMU_APP_CONTENT_GYRO     0x0002 /* Gyro_x, Gyro_y, Gyro_z */
+#define IMU_APP_CONTENT_MAG      0x0004 /* Mag_x, Mag_y, Mag_z */
+#define IMU_APP_CONTENT_TEMP     0x0008 /* Temp */
+#define IMU_APP_CONTENT_ATTITUDE 0x0010 /* Roll, Pitch, Heading */
+#define IMU_APP_CONTENT_ALL      0x001F
+
+/*
+** Vibration spectrum bands
+*/
+#define IMU_APP_FFT_BANDS 8
+
 /*
 ** Table structure
 */
@@ -36,6 +52,12 @@ typedef struct
 {
     uint16 Int1;
     uint16 Int2;
+    uint16 SampleRateHz;    /* Rate of the acquisition task, 10 to 1000 */
+    uint16 SamplesPerBatch; /* Samples in each batch packet, 1 to IMU_APP_BATCH_MAX */
+    uint16 Content;         /* IMU_APP_CONTENT_* bits, the spectrum needs ACCEL */
+    uint16 FftWindow;       /* Samples per spectrum block, a power of 2 up to IMU_APP_FFT_MAX, 0 disables */
+    uint16 FftBlocks;       /* Blocks averaged in each spectrum packet */
+    uint16 BandEdgesHz[IMU_APP_FFT_BANDS + 1]; /* Increasing, up to half the sample rate */
 
 } IMU_APP_Table_t;
 
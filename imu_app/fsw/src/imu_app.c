@@ -28,12 +28,17 @@
 /*
 ** Include Files:
 */
+#include <math.h>
+#include <string.h>
+
 #include "osconfig.h"
 
 #include "imu_app_events.h"
 #include "imu_app_version.h"
 #include "imu_app.h"
 #include "imu_app_table.h"
+#include "imu_app_stats.h"
+#include "imu_app_fft.h"
 
 #include "mpu9dof_lib.h"
 #include "bcm2835_lib.h"
@@ -92,8 +97,8 @@ void IMU_APP_Main(void)
         }
         else
         {
-            CFE_EVS_SendEvent(IMU_APP_PIPE_ERR_EID, CFE_EVS_EventType_ERROR,
-                              "IMU APP: SB Pipe Read Error, App Will Exit");
+            bcm2835_evs_limit_send(&IMU_APP_Data.EventLimit, IMU_APP_PIPE_ERR_EID, CFE_EVS_EventType_ERROR,
+                                   "IMU APP: SB Pipe Read Error, App Will Exit");
 
             IMU_APP_Data.RunStatus = CFE_ES_RunStatus_APP_ERROR;
         }
@@ -115,7 +120,8 @@ void IMU_APP_Main(void)
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
 int32 IMU_APP_Init(void)
 {
-    int32 status;
+    int32         status;
+    mpu9dof_cfg_t Mpu9dofCfg;
 
     IMU_APP_Data.RunStatus = CFE_ES_RunStatus_APP_RUN;
 
@@ -150,6 +156,12 @@ int32 IMU_APP_Init(void)
     IMU_APP_Data.EventFilters[5].Mask    = 0x0000;
     IMU_APP_Data.EventFilters[6].EventID = IMU_APP_PIPE_ERR_EID;
     IMU_APP_Data.EventFilters[6].Mask    = 0x0000;
+    IMU_APP_Data.EventFilters[7].EventID = IMU_APP_TRACE_INF_EID;
+    IMU_APP_Data.EventFilters[7].Mask    = 0x0000;
+    IMU_APP_Data.EventFilters[8].EventID = IMU_APP_TRACE_ERR_EID;
+    IMU_APP_Data.EventFilters[8].Mask    = 0x0000;
+    IMU_APP_Data.EventFilters[9].EventID = IMU_APP_ACQ_ERR_EID;
+    IMU_APP_Data.EventFilters[9].Mask    = 0x0000;
 
     /*
     ** Register the events
@@ -161,10 +173,13 @@ int32 IMU_APP_Init(void)
         return (status);
     }
 
+    bcm2835_evs_limit_init(&IMU_APP_Data.EventLimit, "IMU", IMU_APP_EVS_BURST, IMU_APP_EVS_WINDOW_S);
+
     /*
-    ** Initialize housekeeping packet (clear user data area).
+    ** Initialize telemetry packets (clear user data area).
     */
     CFE_MSG_Init(&IMU_APP_Data.HkTlm.TlmHeader.Msg, IMU_APP_HK_TLM_MID, sizeof(IMU_APP_Data.HkTlm));
+    CFE_MSG_Init(&IMU_APP_Data.BusTlm.TlmHeader.Msg, IMU_APP_BUS_TLM_MID, sizeof(IMU_APP_Data.BusTlm));
 
     /*
     ** Create Software Bus message pipe.
@@ -213,12 +228,70 @@ int32 IMU_APP_Init(void)
         status = CFE_TBL_Load(IMU_APP_Data.TblHandles[0], CFE_TBL_SRC_FILE, IMU_APP_TABLE_FILE);
     }
 
+    IMU_APP_LoadAcqConfig();
+
+    /*
+    ** Register with the I2C bus scheduler, one job per sample
+    */
+    status = bcm2835_i2c_sched_register(MPU9DOF_I2C_BUS, "IMU_APP", IMU_APP_I2C_PRIORITY,
+                                        1000000 / IMU_APP_Data.SampleRateHz, IMU_APP_I2C_DEADLINE_US,
+                                        &IMU_APP_Data.I2CClientId);
+    if (status != BCM2835_I2C_SCHED_OK)
+    {
+        CFE_ES_WriteToSysLog("IMU App: Error Registering I2C client, RC = %ld\n", (long)status);
+
+        return (status);
+    }
+
+    IMU_APP_Data.I2CPeriodUs = 1000000 / IMU_APP_Data.SampleRateHz;
+
     CFE_EVS_SendEvent(IMU_APP_STARTUP_INF_EID, CFE_EVS_EventType_INFORMATION, "IMU App Initialized.%s",
                       IMU_APP_VERSION_STRING);
                       
     /* Initialize the mpu9dof class to acquire from the IMU */
-    IMU_APP_Data.mpu9dof.slave_address =         MPU9DOF_XLG_I2C_ADDR_0;
-    IMU_APP_Data.mpu9dof.magnetometer_address =  MPU9DOF_M_I2C_ADDR_0;
+    mpu9dof_cfg_setup(&Mpu9dofCfg);
+    mpu9dof_init(&IMU_APP_Data.mpu9dof, &Mpu9dofCfg);
+
+    /* Find the fastest clock the sensor reliably supports */
+    if (bcm2835_i2c_sched_acquire(IMU_APP_Data.I2CClientId, BCM2835_I2C_SCHED_PEND_FOREVER) == BCM2835_I2C_SCHED_OK)
+    {
+        mpu9dof_negotiate_i2c(&IMU_APP_Data.mpu9dof);
+        bcm2835_i2c_sched_release(IMU_APP_Data.I2CClientId);
+    }
+
+    CFE_ES_WriteToSysLog("IMU App: I2C clock %lu Hz (accel/gyro), %lu Hz (mag)\n",
+                         (unsigned long)IMU_APP_Data.mpu9dof.xlg.baudrate,
+                         (unsigned long)IMU_APP_Data.mpu9dof.mag.baudrate);
+
+    status = IMU_APP_StatsInit();
+    if (status != OS_SUCCESS)
+    {
+        CFE_ES_WriteToSysLog("IMU App: Error creating statistics lock, RC = %ld\n", (long)status);
+
+        return (status);
+    }
+
+    /*
+    ** Start sampling; from here on only the acquisition task uses the bus
+    */
+    status = CFE_ES_CreateChildTask(&IMU_APP_Data.AcqTaskId, IMU_APP_ACQ_TASK_NAME, IMU_APP_AcqTask,
+                                    CFE_ES_TASK_STACK_ALLOCATE, IMU_APP_ACQ_STACK_SIZE, IMU_APP_ACQ_PRIORITY, 0);
+    if (status != CFE_SUCCESS)
+    {
+        CFE_EVS_SendEvent(IMU_APP_ACQ_ERR_EID, CFE_EVS_EventType_ERROR,
+                          "IMU App: Error creating acquisition task, RC = 0x%08lX", (unsigned long)status);
+
+        return (status);
+    }
+
+    status = IMU_APP_FftInit();
+    if (status != CFE_SUCCESS)
+    {
+        CFE_EVS_SendEvent(IMU_APP_ACQ_ERR_EID, CFE_EVS_EventType_ERROR,
+                          "IMU App: Error creating spectrum task, RC = 0x%08lX", (unsigned long)status);
+
+        return (status);
+    }
 
     return (CFE_SUCCESS);
 
@@ -249,8 +322,8 @@ void IMU_APP_ProcessCommandPacket(CFE_SB_Buffer_t *SBBufPtr)
             break;
 
         default:
-            CFE_EVS_SendEvent(IMU_APP_INVALID_MSGID_ERR_EID, CFE_EVS_EventType_ERROR,
-                              "IMU: invalid command packet,MID = 0x%x", (unsigned int)CFE_SB_MsgIdToValue(MsgId));
+            bcm2835_evs_limit_send(&IMU_APP_Data.EventLimit, IMU_APP_INVALID_MSGID_ERR_EID, CFE_EVS_EventType_ERROR,
+                                   "IMU: invalid command packet,MID = 0x%x", (unsigned int)CFE_SB_MsgIdToValue(MsgId));
             break;
     }
 
@@ -298,6 +371,22 @@ void IMU_APP_ProcessGroundCommand(CFE_SB_Buffer_t *SBBufPtr)
 
             break;
 
+        case IMU_APP_TRACE_DUMP_CC:
+            if (IMU_APP_VerifyCmdLength(&SBBufPtr->Msg, sizeof(IMU_APP_TraceDumpCmd_t)))
+            {
+                IMU_APP_TraceDump((IMU_APP_TraceDumpCmd_t *)SBBufPtr);
+            }
+
+            break;
+
+        case IMU_APP_TRACE_REPLAY_CC:
+            if (IMU_APP_VerifyCmdLength(&SBBufPtr->Msg, sizeof(IMU_APP_TraceReplayCmd_t)))
+            {
+                IMU_APP_TraceReplay((IMU_APP_TraceReplayCmd_t *)SBBufPtr);
+            }
+
+            break;
+
         /* default case already found during FC vs length test */
         default:
             CFE_EVS_SendEvent(IMU_APP_COMMAND_ERR_EID, CFE_EVS_EventType_ERROR,
@@ -320,25 +409,58 @@ void IMU_APP_ProcessGroundCommand(CFE_SB_Buffer_t *SBBufPtr)
 /* * * * * * * * * * * * * * * * * * * * * * * *  * * * * * * *  * *  * * * * */
 int32 IMU_APP_ReportHousekeeping(const CFE_MSG_CommandHeader_t *Msg)
 {
-    int i;
-    
-    if(OS_MutSemTake(i2c_mutexvar) != OS_SUCCESS){
-        OS_printf("IMU APP: I2C Busy. \n");
-        return CFE_SUCCESS;
+    int                        i;
+    IMU_APP_Sample_t           Sample;
+    int16_t                   *Latest = IMU_APP_Data.HkTlm.Payload.Latest;
+    bcm2835_i2c_sched_stats_t  I2CStats;
+    bcm2835_i2c_device_stats_t DevStats;
+
+    /*
+    ** The bus belongs to the acquisition task, report the statistics of
+    ** its samples since the last HK and start a new window
+    */
+    IMU_APP_StatsTake(IMU_APP_Data.HkTlm.Payload.Stats);
+
+    /*
+    ** Report the latest sample of the cache, whatever its age...
+    */
+    if (!IMU_APP_CacheGet(&Sample, &IMU_APP_Data.HkTlm.Payload.SampleAgeMs))
+    {
+        memset(&Sample, 0, sizeof(Sample));
+        IMU_APP_Data.HkTlm.Payload.SampleAgeMs = IMU_APP_SAMPLE_AGE_NONE;
     }
-    
-    /* Get the acceleration values */
-    mpu9dof_read_accel ( &IMU_APP_Data.mpu9dof, &IMU_APP_Data.Accel_x, &IMU_APP_Data.Accel_y, &IMU_APP_Data.Accel_z );
-    
+
+    Latest[IMU_APP_CH_ACCEL_X] = Sample.Accel_x;
+    Latest[IMU_APP_CH_ACCEL_Y] = Sample.Accel_y;
+    Latest[IMU_APP_CH_ACCEL_Z] = Sample.Accel_z;
+    Latest[IMU_APP_CH_GYRO_X]  = Sample.Gyro_x;
+    Latest[IMU_APP_CH_GYRO_Y]  = Sample.Gyro_y;
+    Latest[IMU_APP_CH_GYRO_Z]  = Sample.Gyro_z;
+    Latest[IMU_APP_CH_MAG_X]   = Sample.Mag_x;
+    Latest[IMU_APP_CH_MAG_Y]   = Sample.Mag_y;
+    Latest[IMU_APP_CH_MAG_Z]   = Sample.Mag_z;
+    Latest[IMU_APP_CH_TEMP]    = Sample.Temp;
+
+    bcm2835_i2c_sched_get_stats(IMU_APP_Data.I2CClientId, &I2CStats);
+    mpu9dof_get_i2c_stats(&IMU_APP_Data.mpu9dof, &DevStats);
 
     /*
     ** Get command execution counters...
     */
     IMU_APP_Data.HkTlm.Payload.CommandErrorCounter = IMU_APP_Data.ErrCounter;
     IMU_APP_Data.HkTlm.Payload.CommandCounter      = IMU_APP_Data.CmdCounter;
-    IMU_APP_Data.HkTlm.Payload.Accel_x             = IMU_APP_Data.Accel_x;
-    IMU_APP_Data.HkTlm.Payload.Accel_y             = IMU_APP_Data.Accel_y;
-    IMU_APP_Data.HkTlm.Payload.Accel_z             = IMU_APP_Data.Accel_z;
+    IMU_APP_Data.HkTlm.Payload.I2CDeadlineMisses   = (uint16)I2CStats.DeadlineMisses;
+    IMU_APP_Data.HkTlm.Payload.I2CErrors           = (uint16)DevStats.Errors;
+    IMU_APP_Data.HkTlm.Payload.I2CTransactions     = DevStats.Transactions;
+    IMU_APP_Data.HkTlm.Payload.I2CBusTimeUs        = (uint32)DevStats.BusTimeUs;
+    IMU_APP_Data.HkTlm.Payload.I2CSpeedHz          = IMU_APP_Data.mpu9dof.xlg.baudrate;
+    IMU_APP_Data.HkTlm.Payload.SampleRateHz        = IMU_APP_Data.SampleRateHz;
+    IMU_APP_Data.HkTlm.Payload.SamplesAcquired     = __atomic_load_n(&IMU_APP_Data.SamplesAcquired, __ATOMIC_RELAXED);
+    IMU_APP_Data.HkTlm.Payload.SamplesMissed       = __atomic_load_n(&IMU_APP_Data.SamplesMissed, __ATOMIC_RELAXED);
+    IMU_APP_Data.HkTlm.Payload.SamplesBusBusy      = __atomic_load_n(&IMU_APP_Data.SamplesBusBusy, __ATOMIC_RELAXED);
+    IMU_APP_Data.HkTlm.Payload.SamplesFailed       = __atomic_load_n(&IMU_APP_Data.SamplesFailed, __ATOMIC_RELAXED);
+    IMU_APP_Data.HkTlm.Payload.BatchesSent         = __atomic_load_n(&IMU_APP_Data.BatchesSent, __ATOMIC_RELAXED);
+    IMU_APP_Data.HkTlm.Payload.BatchesLost         = __atomic_load_n(&IMU_APP_Data.BatchesLost, __ATOMIC_RELAXED);
 
     /*
     ** Send housekeeping telemetry packet...
@@ -346,6 +468,13 @@ int32 IMU_APP_ReportHousekeeping(const CFE_MSG_CommandHeader_t *Msg)
     CFE_SB_TimeStampMsg(&IMU_APP_Data.HkTlm.TlmHeader.Msg);
     CFE_SB_TransmitMsg(&IMU_APP_Data.HkTlm.TlmHeader.Msg, true);
 
+    /*
+    ** Send the bus statistics of the last period and start a new one...
+    */
+    bcm2835_bus_get_stats(&IMU_APP_Data.BusTlm.Payload, 1);
+    CFE_SB_TimeStampMsg(&IMU_APP_Data.BusTlm.TlmHeader.Msg);
+    CFE_SB_TransmitMsg(&IMU_APP_Data.BusTlm.TlmHeader.Msg, true);
+
     /*
     ** Manage any pending table loads, validations, etc.
     */
@@ -353,14 +482,12 @@ int32 IMU_APP_ReportHousekeeping(const CFE_MSG_CommandHeader_t *Msg)
     {
         CFE_TBL_Manage(IMU_APP_Data.TblHandles[i]);
     }
-    
-    CFE_EVS_SendEvent(IMU_APP_STARTUP_INF_EID, CFE_EVS_EventType_INFORMATION, "IMU App: Report HK Done. Accel X: %d. Accel Y: %d. Accel Z: %d.",
-                      IMU_APP_Data.Accel_x, IMU_APP_Data.Accel_y, IMU_APP_Data.Accel_z);
-                      
-    if(OS_MutSemGive(i2c_mutexvar) != OS_SUCCESS){
-        OS_printf("IMU APP: Cannot give mutex. \n");
-        return CFE_SUCCESS;
-    }
+
+    /* The acquisition task picks up a new rate on its next period */
+    IMU_APP_LoadAcqConfig();
+
+    /* Report the events counted in the window, if it is over */
+    bcm2835_evs_limit_flush(&IMU_APP_Data.EventLimit);
 
     return CFE_SUCCESS;
 
@@ -397,6 +524,9 @@ int32 IMU_APP_ResetCounters(const IMU_APP_ResetCountersCmd_t *Msg)
     IMU_APP_Data.CmdCounter = 0;
     IMU_APP_Data.ErrCounter = 0;
 
+    /* The sample counters belong to the acquisition task, which clears them */
+    __atomic_store_n(&IMU_APP_Data.AcqResetCounters, true, __ATOMIC_RELAXED);
+
     CFE_EVS_SendEvent(IMU_APP_COMMANDRST_INF_EID, CFE_EVS_EventType_INFORMATION, "IMU: RESET command");
 
     return CFE_SUCCESS;
@@ -441,6 +571,528 @@ int32 IMU_APP_Process(const IMU_APP_ProcessCmd_t *Msg)
 
 } /* End of IMU_APP_ProcessCC */
 
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  IMU_APP_TraceDump                                                   */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Writes the I2C/SPI transaction trace of the BCM2835 Lib to a file. */
+/*                                                                            */
+/* * * * * * * * * * * * * * * * * * * * * * * *  * * * * * * *  * *  * * * * */
+int32 IMU_APP_TraceDump(const IMU_APP_TraceDumpCmd_t *Msg)
+{
+    char  Filename[OS_MAX_PATH_LEN];
+    int32 Count;
+
+    strncpy(Filename, Msg->Payload.Filename, sizeof(Filename) - 1);
+    Filename[sizeof(Filename) - 1] = '\0';
+
+    Count = bcm2835_trace_dump(Filename);
+    if (Count < 0)
+    {
+        IMU_APP_Data.ErrCounter++;
+        CFE_EVS_SendEvent(IMU_APP_TRACE_ERR_EID, CFE_EVS_EventType_ERROR, "IMU: bus trace not written to %s",
+                          Filename);
+        return CFE_STATUS_EXTERNAL_RESOURCE_FAIL;
+    }
+
+    IMU_APP_Data.CmdCounter++;
+    CFE_EVS_SendEvent(IMU_APP_TRACE_INF_EID, CFE_EVS_EventType_INFORMATION, "IMU: %d bus trace records written to %s",
+                      (int)Count, Filename);
+
+    return CFE_SUCCESS;
+
+} /* End of IMU_APP_TraceDump() */
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  IMU_APP_TraceReplay                                                 */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Loads a bus trace written by IMU_APP_TraceDump. In simulation      */
+/*         builds of the BCM2835 Lib the bus transactions replay it.          */
+/*                                                                            */
+/* * * * * * * * * * * * * * * * * * * * * * * *  * * * * * * *  * *  * * * * */
+int32 IMU_APP_TraceReplay(const IMU_APP_TraceReplayCmd_t *Msg)
+{
+    char  Filename[OS_MAX_PATH_LEN];
+    int32 Count;
+
+    strncpy(Filename, Msg->Payload.Filename, sizeof(Filename) - 1);
+    Filename[sizeof(Filename) - 1] = '\0';
+
+    Count = bcm2835_trace_replay_load(Filename);
+    if (Count < 0)
+    {
+        IMU_APP_Data.ErrCounter++;
+        CFE_EVS_SendEvent(IMU_APP_TRACE_ERR_EID, CFE_EVS_EventType_ERROR, "IMU: no bus trace loaded from %s",
+                          Filename);
+        return CFE_STATUS_EXTERNAL_RESOURCE_FAIL;
+    }
+
+    IMU_APP_Data.CmdCounter++;
+    CFE_EVS_SendEvent(IMU_APP_TRACE_INF_EID, CFE_EVS_EventType_INFORMATION, "IMU: %d bus trace records loaded from %s",
+                      (int)Count, Filename);
+
+    return CFE_SUCCESS;
+
+} /* End of IMU_APP_TraceReplay() */
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  IMU_APP_AcqTask                                                    */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Entry point of the acquisition child task. Samples the IMU at the  */
+/*         table rate, independently of the HK schedule.                      */
+/*                                                                            */
+/* * * * * * * * * * * * * * * * * * * * * * * *  * * * * * * *  * *  * * * * */
+void IMU_APP_AcqTask(void)
+{
+    bcm2835_periodic_t Timer;
+    uint16             RateHz = 0;
+    uint16             NewRateHz;
+    uint16             Content;
+    uint32             TimeoutMs = 0;
+    uint32             Skipped;
+
+    if (CFE_ES_RegisterChildTask() != CFE_SUCCESS)
+    {
+        CFE_ES_ExitChildTask();
+        return;
+    }
+
+    bcm2835_sb_pool_init(&IMU_APP_Data.BufPool, IMU_APP_BATCH_SIZE(IMU_APP_BATCH_MAX, IMU_APP_BATCH_CHANNELS_MAX),
+                         IMU_APP_BUF_POOL_DEPTH);
+    bcm2835_sb_pool_fill(&IMU_APP_Data.BufPool);
+
+    while (IMU_APP_Data.RunStatus == CFE_ES_RunStatus_APP_RUN)
+    {
+        NewRateHz = __atomic_load_n(&IMU_APP_Data.SampleRateHz, __ATOMIC_RELAXED);
+        if (NewRateHz != RateHz)
+        {
+            RateHz = NewRateHz;
+            bcm2835_periodic_init(&Timer, 1000000 / RateHz);
+
+            /* Wait for the bus at most one period, a later sample is a missed one */
+            TimeoutMs = 1000 / RateHz;
+        }
+
+        Content = __atomic_load_n(&IMU_APP_Data.Content, __ATOMIC_RELAXED);
+        if (Content != IMU_APP_Data.AcqPlan.Content)
+        {
+            IMU_APP_AcqCompile(Content, &IMU_APP_Data.AcqPlan);
+
+            /* The batch being filled has the layout of the old content */
+            if (IMU_APP_Data.Batch != NULL)
+            {
+                CFE_SB_ReleaseMessageBuffer(IMU_APP_Data.Batch);
+                IMU_APP_Data.Batch = NULL;
+                __atomic_fetch_add(&IMU_APP_Data.BatchesLost, 1, __ATOMIC_RELAXED);
+            }
+        }
+
+        Skipped = bcm2835_periodic_wait(&Timer);
+
+        CFE_ES_PerfLogEntry(IMU_APP_ACQ_PERF_ID);
+
+        if (__atomic_exchange_n(&IMU_APP_Data.AcqResetCounters, false, __ATOMIC_RELAXED))
+        {
+            __atomic_store_n(&IMU_APP_Data.SamplesAcquired, 0, __ATOMIC_RELAXED);
+            __atomic_store_n(&IMU_APP_Data.SamplesMissed, 0, __ATOMIC_RELAXED);
+            __atomic_store_n(&IMU_APP_Data.SamplesBusBusy, 0, __ATOMIC_RELAXED);
+            __atomic_store_n(&IMU_APP_Data.SamplesFailed, 0, __ATOMIC_RELAXED);
+            __atomic_store_n(&IMU_APP_Data.BatchesSent, 0, __ATOMIC_RELAXED);
+            __atomic_store_n(&IMU_APP_Data.BatchesLost, 0, __ATOMIC_RELAXED);
+        }
+
+        __atomic_fetch_add(&IMU_APP_Data.SamplesMissed, Skipped, __ATOMIC_RELAXED);
+
+        IMU_APP_AcqSample(TimeoutMs);
+
+        CFE_ES_PerfLogExit(IMU_APP_ACQ_PERF_ID);
+    }
+
+    /* Return the unsent batch and the pool to SB */
+    if (IMU_APP_Data.Batch != NULL)
+    {
+        CFE_SB_ReleaseMessageBuffer(IMU_APP_Data.Batch);
+        IMU_APP_Data.Batch = NULL;
+    }
+    bcm2835_sb_pool_drain(&IMU_APP_Data.BufPool);
+
+    CFE_ES_ExitChildTask();
+
+} /* End of IMU_APP_AcqTask() */
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  IMU_APP_AcqSpan                                                    */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Extends the motion burst of a plan over Len registers from Reg.    */
+/*                                                                            */
+/* * * * * * * * * * * * * * * * * * * * * * * *  * * * * * * *  * *  * * * * */
+static void IMU_APP_AcqSpan(IMU_APP_AcqPlan_t *Plan, uint8 Reg, uint8 Len)
+{
+    uint8 End = Plan->MotionReg + Plan->MotionLen;
+
+    if (Plan->MotionLen == 0)
+    {
+        Plan->MotionReg = Reg;
+        Plan->MotionLen = Len;
+        return;
+    }
+
+    if (Reg + Len > End)
+    {
+        End = Reg + Len;
+    }
+    if (Reg < Plan->MotionReg)
+    {
+        Plan->MotionReg = Reg;
+    }
+    Plan->MotionLen = End - Plan->MotionReg;
+
+} /* End of IMU_APP_AcqSpan() */
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  IMU_APP_AcqCompile                                                 */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Compiles the bus transactions of each sample from the content of   */
+/*         the batch packets. Accel, temperature and gyro are consecutive     */
+/*         registers and are read in a single burst over the ones needed;     */
+/*         a register in between that is not needed costs 2 bytes, less      */
+/*         than a second transaction. The magnetometer is a separate device.  */
+/*                                                                            */
+/* * * * * * * * * * * * * * * * * * * * * * * *  * * * * * * *  * *  * * * * */
+void IMU_APP_AcqCompile(uint16 Content, IMU_APP_AcqPlan_t *Plan)
+{
+    memset(Plan, 0, sizeof(*Plan));
+
+    Plan->Content = Content;
+    Plan->Reads   = Content;
+    if (Content & IMU_APP_CONTENT_ATTITUDE)
+    {
+        Plan->Reads |= IMU_APP_CONTENT_ACCEL | IMU_APP_CONTENT_MAG;
+    }
+
+    if (Plan->Reads & IMU_APP_CONTENT_ACCEL)
+    {
+        IMU_APP_AcqSpan(Plan, MPU9DOF_ACCEL_XOUT_H, 6);
+    }
+    if (Plan->Reads & IMU_APP_CONTENT_TEMP)
+    {
+        IMU_APP_AcqSpan(Plan, MPU9DOF_TEMP_OUT_H, 2);
+    }
+    if (Plan->Reads & IMU_APP_CONTENT_GYRO)
+    {
+        IMU_APP_AcqSpan(Plan, MPU9DOF_GYRO_XOUT_H, 6);
+    }
+
+    Plan->ReadMag = (Plan->Reads & IMU_APP_CONTENT_MAG) != 0;
+
+} /* End of IMU_APP_AcqCompile() */
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  IMU_APP_AcqValue                                                   */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Decodes a big endian value of the motion burst, 0 if its sensor    */
+/*         is not read.                                                       */
+/*                                                                            */
+/* * * * * * * * * * * * * * * * * * * * * * * *  * * * * * * *  * *  * * * * */
+static int16_t IMU_APP_AcqValue(const IMU_APP_AcqPlan_t *Plan, const uint8 *Burst, uint16 Sensor, uint8 Reg)
+{
+    const uint8 *Value = &Burst[Reg - Plan->MotionReg];
+
+    if ((Plan->Reads & Sensor) == 0)
+    {
+        return 0;
+    }
+
+    return (int16_t)((Value[0] << 8) | Value[1]);
+
+} /* End of IMU_APP_AcqValue() */
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  IMU_APP_AcqSample                                                  */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Reads one sample into the ring, following the acquisition plan,   */
+/*         and adds it to the batch and the statistics. Called from the       */
+/*         acquisition task only, the single writer of the ring.              */
+/*                                                                            */
+/* * * * * * * * * * * * * * * * * * * * * * * *  * * * * * * *  * *  * * * * */
+void IMU_APP_AcqSample(uint32 TimeoutMs)
+{
+    const IMU_APP_AcqPlan_t *Plan   = &IMU_APP_Data.AcqPlan;
+    uint32                   Head   = IMU_APP_Data.RingHead;
+    IMU_APP_Sample_t        *Sample = &IMU_APP_Data.Ring[Head & (IMU_APP_ACQ_RING_DEPTH - 1)];
+    uint8                    Burst[MPU9DOF_GYRO_ZOUT_L - MPU9DOF_ACCEL_XOUT_H + 1];
+    uint8                    Reason = BCM2835_I2C_REASON_OK;
+    uint16                   Flags  = 0;
+
+    bcm2835_i2c_sched_start_job(IMU_APP_Data.I2CClientId);
+
+    if (bcm2835_i2c_sched_acquire(IMU_APP_Data.I2CClientId, (int32)TimeoutMs) != BCM2835_I2C_SCHED_OK)
+    {
+        __atomic_fetch_add(&IMU_APP_Data.SamplesBusBusy, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    Sample->Time = CFE_TIME_GetTime();
+
+    /* The motion registers of the plan in one burst, the magnetometer when it has converted */
+    if (Plan->MotionLen != 0)
+    {
+        Reason = mpu9dof_read_burst(&IMU_APP_Data.mpu9dof, Plan->MotionReg, Burst, Plan->MotionLen);
+    }
+    if (Reason == BCM2835_I2C_REASON_OK && Plan->ReadMag &&
+        mpu9dof_read_mag_ready(&IMU_APP_Data.mpu9dof, IMU_APP_Data.Mag))
+    {
+        Flags = IMU_APP_SAMPLE_MAG_NEW;
+    }
+
+    /* Back off the clock if the reads had errors, about once a second */
+    if (++IMU_APP_Data.AcqCycles >= IMU_APP_Data.SampleRateHz)
+    {
+        IMU_APP_Data.AcqCycles = 0;
+        mpu9dof_revalidate_i2c(&IMU_APP_Data.mpu9dof);
+    }
+
+    bcm2835_i2c_sched_release(IMU_APP_Data.I2CClientId);
+
+    if (Reason != BCM2835_I2C_REASON_OK)
+    {
+        __atomic_fetch_add(&IMU_APP_Data.SamplesFailed, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    Sample->Seq     = Head;
+    Sample->Accel_x = IMU_APP_AcqValue(Plan, Burst, IMU_APP_CONTENT_ACCEL, MPU9DOF_ACCEL_XOUT_H);
+    Sample->Accel_y = IMU_APP_AcqValue(Plan, Burst, IMU_APP_CONTENT_ACCEL, MPU9DOF_ACCEL_XOUT_H + 2);
+    Sample->Accel_z = IMU_APP_AcqValue(Plan, Burst, IMU_APP_CONTENT_ACCEL, MPU9DOF_ACCEL_XOUT_H + 4);
+    Sample->Gyro_x  = IMU_APP_AcqValue(Plan, Burst, IMU_APP_CONTENT_GYRO, MPU9DOF_GYRO_XOUT_H);
+    Sample->Gyro_y  = IMU_APP_AcqValue(Plan, Burst, IMU_APP_CONTENT_GYRO, MPU9DOF_GYRO_XOUT_H + 2);
+    Sample->Gyro_z  = IMU_APP_AcqValue(Plan, Burst, IMU_APP_CONTENT_GYRO, MPU9DOF_GYRO_XOUT_H + 4);
+    Sample->Temp    = IMU_APP_AcqValue(Plan, Burst, IMU_APP_CONTENT_TEMP, MPU9DOF_TEMP_OUT_H);
+    Sample->Mag_x   = Plan->ReadMag ? IMU_APP_Data.Mag[0] : 0;
+    Sample->Mag_y   = Plan->ReadMag ? IMU_APP_Data.Mag[1] : 0;
+    Sample->Mag_z   = Plan->ReadMag ? IMU_APP_Data.Mag[2] : 0;
+    Sample->Flags   = Flags;
+    Sample->Content = Plan->Reads;
+
+    IMU_APP_AcqAttitude(Sample);
+
+    /* Readers see the slot complete once the head passes it */
+    __atomic_store_n(&IMU_APP_Data.RingHead, Head + 1, __ATOMIC_RELEASE);
+    __atomic_fetch_add(&IMU_APP_Data.SamplesAcquired, 1, __ATOMIC_RELAXED);
+
+    bcm2835_seqlock_write(&IMU_APP_Data.CacheLock, &IMU_APP_Data.Cache, Sample, sizeof(*Sample));
+
+    IMU_APP_StatsAdd(Sample);
+    IMU_APP_BatchAdd(Sample);
+
+} /* End of IMU_APP_AcqSample() */
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  IMU_APP_AcqAngle                                                   */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Converts radians in [-pi, pi] to a binary angle.                   */
+/*                                                                            */
+/* * * * * * * * * * * * * * * * * * * * * * * *  * * * * * * *  * *  * * * * */
+static int16_t IMU_APP_AcqAngle(float Rad)
+{
+    float Bam = roundf(Rad * (32768.0f / (float)M_PI));
+
+    return (Bam >= 32767.0f) ? 32767 : (int16_t)Bam;
+
+} /* End of IMU_APP_AcqAngle() */
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  IMU_APP_AcqAttitude                                                */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Sets Roll, Pitch and Heading of a sample if its content has them,  */
+/*         0 otherwise. The magnetometer axes are X = accel Y, Y = accel X    */
+/*         and Z = -accel Z; they are turned into the accel frame first.      */
+/*                                                                            */
+/* * * * * * * * * * * * * * * * * * * * * * * *  * * * * * * *  * *  * * * * */
+void IMU_APP_AcqAttitude(IMU_APP_Sample_t *Sample)
+{
+    float Roll;
+    float Pitch;
+    float SinRoll;
+    float CosRoll;
+    float SinPitch;
+    float CosPitch;
+    float Bx = Sample->Mag_y;
+    float By = Sample->Mag_x;
+    float Bz = -(float)Sample->Mag_z;
+
+    if ((Sample->Content & IMU_APP_CONTENT_ATTITUDE) == 0)
+    {
+        Sample->Roll    = 0;
+        Sample->Pitch   = 0;
+        Sample->Heading = 0;
+        return;
+    }
+
+    Roll    = atan2f(Sample->Accel_y, Sample->Accel_z);
+    SinRoll = sinf(Roll);
+    CosRoll = cosf(Roll);
+
+    Pitch    = atan2f(-Sample->Accel_x, Sample->Accel_y * SinRoll + Sample->Accel_z * CosRoll);
+    SinPitch = sinf(Pitch);
+    CosPitch = cosf(Pitch);
+
+    Sample->Roll    = IMU_APP_AcqAngle(Roll);
+    Sample->Pitch   = IMU_APP_AcqAngle(Pitch);
+    Sample->Heading = IMU_APP_AcqAngle(atan2f(Bz * SinRoll - By * CosRoll,
+                                              Bx * CosPitch + By * SinPitch * SinRoll + Bz * SinPitch * CosRoll));
+
+} /* End of IMU_APP_AcqAttitude() */
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  IMU_APP_BatchAdd                                                   */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Stores a sample in the batch packet, which is filled in place in   */
+/*         an SB buffer of the pool and sent without a copy once it holds     */
+/*         SamplesPerBatch samples. A sample that finds no buffer is in the   */
+/*         ring only.                                                         */
+/*                                                                            */
+/* * * * * * * * * * * * * * * * * * * * * * * *  * * * * * * *  * *  * * * * */
+void IMU_APP_BatchAdd(const IMU_APP_Sample_t *Sample)
+{
+    IMU_APP_BatchTlm_t *Batch;
+    CFE_TIME_SysTime_t  Delta;
+    uint32             *DeltaUs;
+    int16_t            *Value;
+    uint16              Count;
+    uint16              Content;
+    uint16              i;
+
+    if (IMU_APP_Data.Batch == NULL)
+    {
+        Count = __atomic_load_n(&IMU_APP_Data.SamplesPerBatch, __ATOMIC_RELAXED);
+
+        IMU_APP_Data.Batch = bcm2835_sb_pool_get(&IMU_APP_Data.BufPool);
+        if (IMU_APP_Data.Batch == NULL)
+        {
+            __atomic_fetch_add(&IMU_APP_Data.BatchesLost, 1, __ATOMIC_RELAXED);
+            return;
+        }
+
+        Content = IMU_APP_Data.AcqPlan.Content;
+
+        Batch = (IMU_APP_BatchTlm_t *)IMU_APP_Data.Batch;
+        CFE_MSG_Init(&Batch->TlmHeader.Msg, IMU_APP_BATCH_TLM_MID,
+                     IMU_APP_BATCH_SIZE(Count, IMU_APP_BATCH_CHANNELS(Content)));
+        CFE_MSG_SetMsgTime(&Batch->TlmHeader.Msg, Sample->Time);
+
+        Batch->Payload.BaseTime = Sample->Time;
+        Batch->Payload.FirstSeq = Sample->Seq;
+        Batch->Payload.Count    = Count;
+        Batch->Payload.RateHz   = IMU_APP_Data.SampleRateHz;
+        Batch->Payload.Content  = Content;
+        Batch->Payload.Spare    = 0;
+        IMU_APP_Data.BatchFill = 0;
+    }
+
+    Batch   = (IMU_APP_BatchTlm_t *)IMU_APP_Data.Batch;
+    Count   = Batch->Payload.Count;
+    Content = Batch->Payload.Content;
+    i       = IMU_APP_Data.BatchFill;
+
+    DeltaUs = (uint32 *)(Batch + 1);
+    Value   = (int16_t *)(DeltaUs + Count) + i;
+
+    Delta      = CFE_TIME_Subtract(Sample->Time, Batch->Payload.BaseTime);
+    DeltaUs[i] = Delta.Seconds * 1000000 + CFE_TIME_Sub2MicroSecs(Delta.Subseconds);
+
+    /* Value walks down the arrays of the content, Count apart */
+    if (Content & IMU_APP_CONTENT_ACCEL)
+    {
+        Value[0 * Count] = Sample->Accel_x;
+        Value[1 * Count] = Sample->Accel_y;
+        Value[2 * Count] = Sample->Accel_z;
+        Value += 3 * Count;
+    }
+    if (Content & IMU_APP_CONTENT_GYRO)
+    {
+        Value[0 * Count] = Sample->Gyro_x;
+        Value[1 * Count] = Sample->Gyro_y;
+        Value[2 * Count] = Sample->Gyro_z;
+        Value += 3 * Count;
+    }
+    if (Content & IMU_APP_CONTENT_MAG)
+    {
+        Value[0 * Count] = Sample->Mag_x;
+        Value[1 * Count] = Sample->Mag_y;
+        Value[2 * Count] = Sample->Mag_z;
+        Value += 3 * Count;
+    }
+    if (Content & IMU_APP_CONTENT_TEMP)
+    {
+        Value[0] = Sample->Temp;
+        Value += Count;
+    }
+    if (Content & IMU_APP_CONTENT_ATTITUDE)
+    {
+        Value[0 * Count] = Sample->Roll;
+        Value[1 * Count] = Sample->Pitch;
+        Value[2 * Count] = Sample->Heading;
+    }
+
+    if (++IMU_APP_Data.BatchFill < Count)
+    {
+        return;
+    }
+
+    if (CFE_SB_TransmitBuffer(IMU_APP_Data.Batch, true) == CFE_SUCCESS)
+    {
+        __atomic_fetch_add(&IMU_APP_Data.BatchesSent, 1, __ATOMIC_RELAXED);
+    }
+    else
+    {
+        CFE_SB_ReleaseMessageBuffer(IMU_APP_Data.Batch);
+        __atomic_fetch_add(&IMU_APP_Data.BatchesLost, 1, __ATOMIC_RELAXED);
+    }
+
+    IMU_APP_Data.Batch = NULL;
+
+    /* SB owns the sent buffer, allocate its replacement before it is needed */
+    bcm2835_sb_pool_fill(&IMU_APP_Data.BufPool);
+
+} /* End of IMU_APP_BatchAdd() */
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  IMU_APP_CacheGet                                                   */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Copies the latest sample and its age, without a lock: the copy is  */
+/*         retried if the acquisition task wrote the cache meanwhile. Returns */
+/*         false if there is no sample yet, or no consistent copy in          */
+/*         IMU_APP_CACHE_TRIES tries.                                         */
+/*                                                                            */
+/* * * * * * * * * * * * * * * * * * * * * * * *  * * * * * * *  * *  * * * * */
+bool IMU_APP_CacheGet(IMU_APP_Sample_t *Sample, uint32 *AgeMs)
+{
+    CFE_TIME_SysTime_t Age;
+
+    if (!bcm2835_seqlock_read(&IMU_APP_Data.CacheLock, &IMU_APP_Data.Cache, Sample, sizeof(*Sample),
+                              IMU_APP_CACHE_TRIES))
+    {
+        return false;
+    }
+
+    Age    = CFE_TIME_Subtract(CFE_TIME_GetTime(), Sample->Time);
+    *AgeMs = Age.Seconds * 1000 + CFE_TIME_Sub2MicroSecs(Age.Subseconds) / 1000;
+
+    return true;
+
+} /* End of IMU_APP_CacheGet() */
+
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
 /*                                                                            */
 /* IMU_APP_VerifyCmdLength() -- Verify command packet length                   */
@@ -463,10 +1115,10 @@ bool IMU_APP_VerifyCmdLength(CFE_MSG_Message_t *MsgPtr, size_t ExpectedLength)
         CFE_MSG_GetMsgId(MsgPtr, &MsgId);
         CFE_MSG_GetFcnCode(MsgPtr, &FcnCode);
 
-        CFE_EVS_SendEvent(IMU_APP_LEN_ERR_EID, CFE_EVS_EventType_ERROR,
-                          "Invalid Msg length: ID = 0x%X,  CC = %u, Len = %u, Expected = %u",
-                          (unsigned int)CFE_SB_MsgIdToValue(MsgId), (unsigned int)FcnCode, (unsigned int)ActualLength,
-                          (unsigned int)ExpectedLength);
+        bcm2835_evs_limit_send(&IMU_APP_Data.EventLimit, IMU_APP_LEN_ERR_EID, CFE_EVS_EventType_ERROR,
+                               "Invalid Msg length: ID = 0x%X,  CC = %u, Len = %u, Expected = %u",
+                               (unsigned int)CFE_SB_MsgIdToValue(MsgId), (unsigned int)FcnCode,
+                               (unsigned int)ActualLength, (unsigned int)ExpectedLength);
 
         result = false;
 
@@ -496,11 +1148,66 @@ int32 IMU_APP_TblValidationFunc(void *TblData)
         /* First element is out of range, return an appropriate error code */
         ReturnCode = IMU_APP_TABLE_OUT_OF_RANGE_ERR_CODE;
     }
+    else if (TblDataPtr->SampleRateHz < IMU_APP_SAMPLE_RATE_MIN || TblDataPtr->SampleRateHz > IMU_APP_SAMPLE_RATE_MAX)
+    {
+        ReturnCode = IMU_APP_TABLE_OUT_OF_RANGE_ERR_CODE;
+    }
+    else if (TblDataPtr->SamplesPerBatch == 0 || TblDataPtr->SamplesPerBatch > IMU_APP_BATCH_MAX)
+    {
+        ReturnCode = IMU_APP_TABLE_OUT_OF_RANGE_ERR_CODE;
+    }
+    else if (TblDataPtr->Content == 0 || (TblDataPtr->Content & ~IMU_APP_CONTENT_ALL) != 0)
+    {
+        ReturnCode = IMU_APP_TABLE_OUT_OF_RANGE_ERR_CODE;
+    }
+    else if (!IMU_APP_FftValidTable(TblDataPtr))
+    {
+        ReturnCode = IMU_APP_TABLE_OUT_OF_RANGE_ERR_CODE;
+    }
 
     return ReturnCode;
 
 } /* End of IMU_APP_TBLValidationFunc() */
 
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* IMU_APP_LoadAcqConfig -- Publish the sample rate, batch size  */
+/* and content of the table to the acquisition task, or the        */
+/* defaults if the table is not available                          */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void IMU_APP_LoadAcqConfig(void)
+{
+    int32            status;
+    uint16           RateHz  = IMU_APP_SAMPLE_RATE_DEF;
+    uint16           Batch   = IMU_APP_BATCH_DEF;
+    uint16           Content = IMU_APP_CONTENT_DEF;
+    IMU_APP_Table_t *TblPtr;
+
+    status = CFE_TBL_GetAddress((void *)&TblPtr, IMU_APP_Data.TblHandles[0]);
+    if (status >= CFE_SUCCESS)
+    {
+        RateHz  = TblPtr->SampleRateHz;
+        Batch   = TblPtr->SamplesPerBatch;
+        Content = TblPtr->Content;
+
+        CFE_TBL_ReleaseAddress(IMU_APP_Data.TblHandles[0]);
+    }
+
+    __atomic_store_n(&IMU_APP_Data.SampleRateHz, RateHz, __ATOMIC_RELAXED);
+    __atomic_store_n(&IMU_APP_Data.SamplesPerBatch, Batch, __ATOMIC_RELAXED);
+    __atomic_store_n(&IMU_APP_Data.Content, Content, __ATOMIC_RELAXED);
+
+    /* Keep the scheduler period in step with the rate once registered */
+    if (IMU_APP_Data.I2CPeriodUs != 0 && IMU_APP_Data.I2CPeriodUs != 1000000U / RateHz &&
+        bcm2835_i2c_sched_set_period(IMU_APP_Data.I2CClientId, 1000000U / RateHz, IMU_APP_I2C_DEADLINE_US) ==
+            BCM2835_I2C_SCHED_OK)
+    {
+        IMU_APP_Data.I2CPeriodUs = 1000000U / RateHz;
+    }
+
+} /* End of IMU_APP_LoadAcqConfig */
+
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 /*                                                                 */
 /* IMU_APP_GetCrc -- Output CRC                                     */
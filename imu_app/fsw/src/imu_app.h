@@ -39,9 +39,11 @@
 #include "cfe_es.h"
 
 #include "mpu9dof_lib.h"
+#include "bcm2835_lib.h"
 
 #include "imu_app_perfids.h"
 #include "imu_app_msgids.h"
+#include "imu_app_table.h"
 #include "imu_app_msg.h"
 
 /***********************************************************************/
@@ -55,10 +57,50 @@
 #define IMU_APP_TABLE_OUT_OF_RANGE_ERR_CODE -1
 
 #define IMU_APP_TBL_ELEMENT_1_MAX 10
+
+#define IMU_APP_SAMPLE_RATE_MIN 10   /* Hz */
+#define IMU_APP_SAMPLE_RATE_MAX 1000 /* Hz */
+#define IMU_APP_SAMPLE_RATE_DEF 100  /* Hz, used while no table is loaded */
+
+#define IMU_APP_BATCH_MAX 50 /* Samples in a batch packet */
+#define IMU_APP_BATCH_DEF 25 /* Used while no table is loaded */
+
+#define IMU_APP_CONTENT_DEF (IMU_APP_CONTENT_ACCEL | IMU_APP_CONTENT_GYRO) /* Used while no table is loaded */
+
+#define IMU_APP_FFT_MIN 64  /* Samples in a spectrum block */
+#define IMU_APP_FFT_MAX 512
+
+/* Acquisition child task */
+#define IMU_APP_ACQ_TASK_NAME  "IMU_ACQ"
+#define IMU_APP_ACQ_STACK_SIZE 16384
+#define IMU_APP_ACQ_PRIORITY   60  /* Above the main task, which only handles commands */
+#define IMU_APP_ACQ_RING_DEPTH 1024 /* Samples kept, a power of 2 above IMU_APP_FFT_MAX */
+#define IMU_APP_BUF_POOL_DEPTH 4   /* SB buffers allocated ahead for batch packets */
+#define IMU_APP_CACHE_TRIES    8   /* Reads of the latest sample cache before giving up */
+
+/* Rate limit of the events that can repeat (see bcm2835_evs_limit_init) */
+#define IMU_APP_EVS_BURST    4  /* Events of an ID sent in a window, the next are counted */
+#define IMU_APP_EVS_WINDOW_S 60 /* Length of the window */
+
+/* I2C bus scheduler parameters (see bcm2835_i2c_sched_register) */
+#define IMU_APP_I2C_PRIORITY    10   /* Tie-break priority, lower is more important */
+#define IMU_APP_I2C_DEADLINE_US 1000 /* Relative deadline of each sample, the period at the maximum rate */
 /************************************************************************
 ** Type Definitions
 *************************************************************************/
 
+/*
+** Acquisition plan, compiled from the table content by IMU_APP_AcqCompile
+*/
+typedef struct
+{
+    uint16 Content;   /* IMU_APP_CONTENT_* of the batch packets */
+    uint16 Reads;     /* IMU_APP_CONTENT_* read for each sample, Content and what ATTITUDE needs */
+    uint8  MotionReg; /* First register of the accel, temperature and gyro burst */
+    uint8  MotionLen; /* Registers in the burst, 0 if none is read */
+    bool   ReadMag;
+} IMU_APP_AcqPlan_t;
+
 /*
 ** Global Data
 */
@@ -69,17 +111,67 @@ typedef struct
     */
     uint8 CmdCounter;
     uint8 ErrCounter;
+
+    /*
+    ** I2C bus scheduler client...
+    */
+    uint32 I2CClientId;
+    uint32 I2CPeriodUs; /* Period registered with the scheduler, 0 until registered */
     
     mpu9dof_t mpu9dof;
-    int16_t Accel_x;
-    int16_t Accel_y;
-    int16_t Accel_z;
-    
+
+    /*
+    ** Acquisition child task. The ring and counters are written by the
+    ** task only; RingHead is the number of samples written so far. The
+    ** rate, batch size and content are set from the table by the main task.
+    */
+    CFE_ES_TaskId_t     AcqTaskId;
+    uint16           SampleRateHz;
+    uint16           SamplesPerBatch;
+    uint16           Content;
+    IMU_APP_AcqPlan_t AcqPlan;
+    bool             AcqResetCounters;
+    uint32           SamplesAcquired;
+    uint32           SamplesMissed;
+    uint32           SamplesBusBusy;
+    uint32           SamplesFailed;
+    uint32           BatchesSent;
+    uint32           BatchesLost;
+    uint32           AcqCycles;
+    int16_t          Mag[3];
+    uint32           RingHead;
+    IMU_APP_Sample_t Ring[IMU_APP_ACQ_RING_DEPTH];
+
+    /*
+    ** Latest sample, written by the acquisition task under a sequence
+    ** lock, see bcm2835_seqlock_write
+    */
+    bcm2835_seqlock_t CacheLock;
+    IMU_APP_Sample_t  Cache;
+
+    /*
+    ** Batch packet being filled by the acquisition task, NULL if none,
+    ** and the number of samples stored in it
+    */
+    CFE_SB_Buffer_t *Batch;
+    uint16           BatchFill;
+
+    /*
+    ** SB buffers allocated ahead by the acquisition task, each large
+    ** enough for a batch of IMU_APP_BATCH_MAX samples of all the content
+    */
+    bcm2835_sb_pool_t BufPool;
+
     /*
     ** Housekeeping telemetry packet...
     */
     IMU_APP_HkTlm_t HkTlm;
 
+    /*
+    ** Bus statistics telemetry packet, sent with housekeeping...
+    */
+    IMU_APP_BusTlm_t BusTlm;
+
     /*
     ** Run Status variable used in the main processing loop
     */
@@ -99,6 +191,11 @@ typedef struct
     CFE_EVS_BinFilter_t EventFilters[IMU_APP_EVENT_COUNTS];
     CFE_TBL_Handle_t    TblHandles[IMU_APP_NUMBER_OF_TABLES];
 
+    /*
+    ** Rate limiter of the events that can repeat, main task only
+    */
+    bcm2835_evs_limit_t EventLimit;
+
 } IMU_APP_Data_t;
 
 /****************************************************************************/
@@ -116,6 +213,15 @@ int32 IMU_APP_ReportHousekeeping(const CFE_MSG_CommandHeader_t *Msg);
 int32 IMU_APP_ResetCounters(const IMU_APP_ResetCountersCmd_t *Msg);
 int32 IMU_APP_Process(const IMU_APP_ProcessCmd_t *Msg);
 int32 IMU_APP_Noop(const IMU_APP_NoopCmd_t *Msg);
+int32 IMU_APP_TraceDump(const IMU_APP_TraceDumpCmd_t *Msg);
+int32 IMU_APP_TraceReplay(const IMU_APP_TraceReplayCmd_t *Msg);
+void  IMU_APP_AcqTask(void);
+void  IMU_APP_AcqCompile(uint16 Content, IMU_APP_AcqPlan_t *Plan);
+void  IMU_APP_AcqSample(uint32 TimeoutMs);
+void  IMU_APP_AcqAttitude(IMU_APP_Sample_t *Sample);
+void  IMU_APP_BatchAdd(const IMU_APP_Sample_t *Sample);
+bool  IMU_APP_CacheGet(IMU_APP_Sample_t *Sample, uint32 *AgeMs);
+void  IMU_APP_LoadAcqConfig(void);
 void  IMU_APP_GetCrc(const char *TableName);
 
 int32 IMU_APP_TblValidationFunc(void *TblData);
@@ -37,7 +37,10 @@
 #define IMU_APP_INVALID_MSGID_ERR_EID 5
 #define IMU_APP_LEN_ERR_EID           6
 #define IMU_APP_PIPE_ERR_EID          7
+#define IMU_APP_TRACE_INF_EID         8
+#define IMU_APP_TRACE_ERR_EID         9
+#define IMU_APP_ACQ_ERR_EID           10
 
-#define IMU_APP_EVENT_COUNTS 7
+#define IMU_APP_EVENT_COUNTS 10
 
 #endif /* IMU_APP_EVENTS_H */
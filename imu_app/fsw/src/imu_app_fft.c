@@ -0,0 +1,490 @@
+/*******************************************************************************
+**
+**      GSC-18128-1, "Core Flight Executive Version 6.7"
+**
+**      Copyright (c) 2006-2019 United States Government as represented by
+**      the Administrator of the National Aeronautics and Space Administration.
+**      All Rights Reserved.
+**
+**      Licensed under the Apache License, Version 2.0 (the "License");
+**      you may not use this file except in compliance with the License.
+**      You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**      Unless required by applicable law or agreed to in writing, software
+**      distributed under the License is distributed on an "AS IS" BASIS,
+**      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**      See the License for the specific language governing permissions and
+**      limitations under the License.
+**
+** File: imu_app_fft.c
+**
+** Purpose:
+**   Vibration spectrum of the accelerometer. A low priority child task
+**   takes consecutive blocks of FftWindow samples from the acquisition
+**   ring, removes the mean, applies a Hann window and averages the power
+**   spectra of FftBlocks blocks, then publishes the energy of each table
+**   band and the peak frequency of each axis.
+**
+**   A real block of N samples is transformed as a complex FFT of N/2
+**   points (even samples real, odd samples imaginary) followed by one
+**   split pass. The complex FFT is an in-place radix-2 decimation in time
+**   on separate real and imaginary arrays; the twiddles of each stage are
+**   stored contiguously, so the inner loop is unit stride. The tables are
+**   rebuilt only when the window size changes.
+**
+*******************************************************************************/
+
+/*
+** Include Files:
+*/
+#include <math.h>
+#include <string.h>
+
+#include "imu_app_events.h"
+#include "imu_app_fft.h"
+
+/*
+** Global data of the app
+*/
+extern IMU_APP_Data_t IMU_APP_Data;
+
+/*
+** Spectrum configuration, from the table
+*/
+typedef struct
+{
+    uint16 Window;
+    uint16 Blocks;
+    uint16 BandEdgesHz[IMU_APP_FFT_BANDS + 1];
+} IMU_APP_FftCfg_t;
+
+/*
+** Local data, used by the spectrum task only
+*/
+static float  IMU_APP_FftBlock[3][IMU_APP_FFT_MAX];
+static float  IMU_APP_FftRe[IMU_APP_FFT_MAX / 2];
+static float  IMU_APP_FftIm[IMU_APP_FFT_MAX / 2];
+static float  IMU_APP_FftPower[3][IMU_APP_FFT_MAX / 2 + 1]; /* Sum over the blocks of the packet */
+static float  IMU_APP_FftHann[IMU_APP_FFT_MAX];
+static float  IMU_APP_FftStageCos[IMU_APP_FFT_MAX / 2]; /* Stage of span 2h at [h - 1, 2h - 1) */
+static float  IMU_APP_FftStageSin[IMU_APP_FFT_MAX / 2];
+static float  IMU_APP_FftSplitCos[IMU_APP_FFT_MAX / 2];
+static float  IMU_APP_FftSplitSin[IMU_APP_FFT_MAX / 2];
+static uint16 IMU_APP_FftBitRev[IMU_APP_FFT_MAX / 2];
+static uint16 IMU_APP_FftPlanWindow;
+static float  IMU_APP_FftScale;
+
+static IMU_APP_SpectrumTlm_t IMU_APP_SpectrumTlm;
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  IMU_APP_FftInit                                                    */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Creates the spectrum task. It idles while the table disables it.   */
+/*                                                                            */
+/* * * * * * * * * * * * * * * * * * * * * * * *  * * * * * * *  * *  * * * * */
+int32 IMU_APP_FftInit(void)
+{
+    CFE_ES_TaskId_t TaskId;
+
+    CFE_MSG_Init(&IMU_APP_SpectrumTlm.TlmHeader.Msg, IMU_APP_SPECTRUM_TLM_MID, sizeof(IMU_APP_SpectrumTlm));
+
+    return CFE_ES_CreateChildTask(&TaskId, IMU_APP_FFT_TASK_NAME, IMU_APP_FftTask, CFE_ES_TASK_STACK_ALLOCATE,
+                                  IMU_APP_FFT_STACK_SIZE, IMU_APP_FFT_PRIORITY, 0);
+
+} /* End of IMU_APP_FftInit() */
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  IMU_APP_FftValidTable                                              */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Checks the spectrum fields of a table: the window is 0 or a power  */
+/*         of 2 in range, the content reads the accelerometer, and the band   */
+/*         edges increase up to the Nyquist frequency of the sample rate.     */
+/*                                                                            */
+/* * * * * * * * * * * * * * * * * * * * * * * *  * * * * * * *  * *  * * * * */
+bool IMU_APP_FftValidTable(const IMU_APP_Table_t *TblPtr)
+{
+    uint16 b;
+
+    if (TblPtr->FftWindow == 0)
+    {
+        return true;
+    }
+
+    if (TblPtr->FftWindow < IMU_APP_FFT_MIN || TblPtr->FftWindow > IMU_APP_FFT_MAX ||
+        (TblPtr->FftWindow & (TblPtr->FftWindow - 1)) != 0 || TblPtr->FftBlocks == 0 ||
+        (TblPtr->Content & (IMU_APP_CONTENT_ACCEL | IMU_APP_CONTENT_ATTITUDE)) == 0)
+    {
+        return false;
+    }
+
+    for (b = 0; b < IMU_APP_FFT_BANDS; b++)
+    {
+        if (TblPtr->BandEdgesHz[b] >= TblPtr->BandEdgesHz[b + 1])
+        {
+            return false;
+        }
+    }
+
+    return (TblPtr->BandEdgesHz[IMU_APP_FFT_BANDS] <= TblPtr->SampleRateHz / 2);
+
+} /* End of IMU_APP_FftValidTable() */
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  IMU_APP_FftGetCfg                                                  */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Reads the spectrum configuration of the table. Returns false if    */
+/*         the table is not available or disables the spectrum.               */
+/*                                                                            */
+/* * * * * * * * * * * * * * * * * * * * * * * *  * * * * * * *  * *  * * * * */
+static bool IMU_APP_FftGetCfg(IMU_APP_FftCfg_t *Cfg)
+{
+    IMU_APP_Table_t *TblPtr;
+
+    if (CFE_TBL_GetAddress((void *)&TblPtr, IMU_APP_Data.TblHandles[0]) < CFE_SUCCESS)
+    {
+        return false;
+    }
+
+    Cfg->Window = TblPtr->FftWindow;
+    Cfg->Blocks = TblPtr->FftBlocks;
+    memcpy(Cfg->BandEdgesHz, TblPtr->BandEdgesHz, sizeof(Cfg->BandEdgesHz));
+
+    CFE_TBL_ReleaseAddress(IMU_APP_Data.TblHandles[0]);
+
+    return (Cfg->Window != 0);
+
+} /* End of IMU_APP_FftGetCfg() */
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  IMU_APP_FftPlan                                                    */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Builds the window, bit reversal and twiddle tables of a block of   */
+/*         N samples, N a power of 2 up to IMU_APP_FFT_MAX.                   */
+/*                                                                            */
+/* * * * * * * * * * * * * * * * * * * * * * * *  * * * * * * *  * *  * * * * */
+void IMU_APP_FftPlan(uint16 N)
+{
+    uint16 M = N / 2;
+    uint16 Bits;
+    uint16 h;
+    uint16 i;
+    uint16 j;
+    uint16 r;
+    double SumW2 = 0;
+
+    for (Bits = 0; (1u << Bits) < M; Bits++)
+    {
+    }
+
+    for (i = 0; i < M; i++)
+    {
+        for (r = 0, j = 0; j < Bits; j++)
+        {
+            r |= ((i >> j) & 1) << (Bits - 1 - j);
+        }
+        IMU_APP_FftBitRev[i] = r;
+    }
+
+    /* Butterflies of span 2h use W(2h)^j = exp(-i pi j / h) */
+    for (h = 1; h < M; h <<= 1)
+    {
+        for (j = 0; j < h; j++)
+        {
+            IMU_APP_FftStageCos[h - 1 + j] = (float)cos(M_PI * j / h);
+            IMU_APP_FftStageSin[h - 1 + j] = (float)-sin(M_PI * j / h);
+        }
+    }
+
+    /* The split pass uses W(N)^k */
+    for (i = 0; i < M; i++)
+    {
+        IMU_APP_FftSplitCos[i] = (float)cos(2 * M_PI * i / N);
+        IMU_APP_FftSplitSin[i] = (float)-sin(2 * M_PI * i / N);
+    }
+
+    /* Periodic Hann */
+    for (i = 0; i < N; i++)
+    {
+        IMU_APP_FftHann[i] = (float)(0.5 - 0.5 * cos(2 * M_PI * i / N));
+        SumW2 += IMU_APP_FftHann[i] * IMU_APP_FftHann[i];
+    }
+
+    /* Parseval, corrected for the power of the window: the bins sum to the mean square */
+    IMU_APP_FftScale      = (float)(1.0 / (N * SumW2));
+    IMU_APP_FftPlanWindow = N;
+
+} /* End of IMU_APP_FftPlan() */
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  IMU_APP_FftComplex                                                 */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         In-place complex FFT of M points already in bit-reversed order.    */
+/*                                                                            */
+/* * * * * * * * * * * * * * * * * * * * * * * *  * * * * * * *  * *  * * * * */
+static void IMU_APP_FftComplex(float *Re, float *Im, uint16 M)
+{
+    const float *Wr;
+    const float *Wi;
+    float       *Ar;
+    float       *Ai;
+    float       *Br;
+    float       *Bi;
+    float        Tr;
+    float        Ti;
+    uint16       h;
+    uint16       i;
+    uint16       j;
+
+    for (h = 1; h < M; h <<= 1)
+    {
+        Wr = &IMU_APP_FftStageCos[h - 1];
+        Wi = &IMU_APP_FftStageSin[h - 1];
+
+        for (i = 0; i < M; i += 2 * h)
+        {
+            Ar = &Re[i];
+            Ai = &Im[i];
+            Br = &Re[i + h];
+            Bi = &Im[i + h];
+
+            for (j = 0; j < h; j++)
+            {
+                Tr = Br[j] * Wr[j] - Bi[j] * Wi[j];
+                Ti = Br[j] * Wi[j] + Bi[j] * Wr[j];
+
+                Br[j] = Ar[j] - Tr;
+                Bi[j] = Ai[j] - Ti;
+                Ar[j] += Tr;
+                Ai[j] += Ti;
+            }
+        }
+    }
+
+} /* End of IMU_APP_FftComplex() */
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  IMU_APP_FftAddPower                                                */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Adds the one-sided power spectrum of a block, bins 0 to N/2, to    */
+/*         Power.                                                             */
+/*                                                                            */
+/* * * * * * * * * * * * * * * * * * * * * * * *  * * * * * * *  * *  * * * * */
+void IMU_APP_FftAddPower(const float *x, uint16 N, float *Power)
+{
+    uint16 M    = N / 2;
+    float  Mean = 0;
+    float  Er;
+    float  Ei;
+    float  Or;
+    float  Oi;
+    float  Xr;
+    float  Xi;
+    uint16 k;
+
+    for (k = 0; k < N; k++)
+    {
+        Mean += x[k];
+    }
+    Mean /= N;
+
+    /* Pack the even samples as real and the odd as imaginary parts, bit reversed */
+    for (k = 0; k < M; k++)
+    {
+        IMU_APP_FftRe[IMU_APP_FftBitRev[k]] = (x[2 * k] - Mean) * IMU_APP_FftHann[2 * k];
+        IMU_APP_FftIm[IMU_APP_FftBitRev[k]] = (x[2 * k + 1] - Mean) * IMU_APP_FftHann[2 * k + 1];
+    }
+
+    IMU_APP_FftComplex(IMU_APP_FftRe, IMU_APP_FftIm, M);
+
+    /* Split Z into the spectra of the even (E) and odd (O) samples: X = E + W(N)^k O */
+    Xr = IMU_APP_FftRe[0] + IMU_APP_FftIm[0];
+    Xi = IMU_APP_FftRe[0] - IMU_APP_FftIm[0];
+    Power[0] += Xr * Xr * IMU_APP_FftScale;
+    Power[M] += Xi * Xi * IMU_APP_FftScale;
+
+    for (k = 1; k < M; k++)
+    {
+        Er = 0.5f * (IMU_APP_FftRe[k] + IMU_APP_FftRe[M - k]);
+        Ei = 0.5f * (IMU_APP_FftIm[k] - IMU_APP_FftIm[M - k]);
+        Or = 0.5f * (IMU_APP_FftIm[k] + IMU_APP_FftIm[M - k]);
+        Oi = -0.5f * (IMU_APP_FftRe[k] - IMU_APP_FftRe[M - k]);
+
+        Xr = Er + IMU_APP_FftSplitCos[k] * Or - IMU_APP_FftSplitSin[k] * Oi;
+        Xi = Ei + IMU_APP_FftSplitCos[k] * Oi + IMU_APP_FftSplitSin[k] * Or;
+
+        /* Both halves of the two-sided spectrum */
+        Power[k] += 2 * (Xr * Xr + Xi * Xi) * IMU_APP_FftScale;
+    }
+
+} /* End of IMU_APP_FftAddPower() */
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  IMU_APP_FftPublish                                                 */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Sends the band energies and peaks of the averaged spectra.         */
+/*                                                                            */
+/* * * * * * * * * * * * * * * * * * * * * * * *  * * * * * * *  * *  * * * * */
+static void IMU_APP_FftPublish(const IMU_APP_FftCfg_t *Cfg, uint16 RateHz, uint16 Skipped)
+{
+    IMU_APP_SpectrumTlm_Payload_t *Payload = &IMU_APP_SpectrumTlm.Payload;
+    uint16                         N       = Cfg->Window;
+    uint16                         M       = N / 2;
+    float                          Norm    = 1.0f / Cfg->Blocks;
+    uint32                         Lo;
+    uint32                         Hi;
+    uint16                         Axis;
+    uint16                         b;
+    uint16                         k;
+
+    Payload->Window  = N;
+    Payload->Blocks  = Cfg->Blocks;
+    Payload->RateHz  = RateHz;
+    Payload->Skipped = Skipped;
+
+    for (Axis = 0; Axis < 3; Axis++)
+    {
+        /* Bin k is at k * RateHz / N Hz */
+        for (b = 0; b < IMU_APP_FFT_BANDS; b++)
+        {
+            Lo = ((uint32)Cfg->BandEdgesHz[b] * N + RateHz - 1) / RateHz;
+            Hi = ((uint32)Cfg->BandEdgesHz[b + 1] * N + RateHz - 1) / RateHz;
+            if (Hi > (uint32)M + 1)
+            {
+                Hi = M + 1;
+            }
+
+            Payload->Energy[Axis][b] = 0;
+            for (k = Lo; k < Hi; k++)
+            {
+                Payload->Energy[Axis][b] += IMU_APP_FftPower[Axis][k];
+            }
+            Payload->Energy[Axis][b] *= Norm;
+        }
+
+        Payload->PeakHz[Axis]     = 0;
+        Payload->PeakEnergy[Axis] = 0;
+        for (k = 1; k <= M; k++)
+        {
+            if (IMU_APP_FftPower[Axis][k] * Norm > Payload->PeakEnergy[Axis])
+            {
+                Payload->PeakEnergy[Axis] = IMU_APP_FftPower[Axis][k] * Norm;
+                Payload->PeakHz[Axis]     = (float)k * RateHz / N;
+            }
+        }
+    }
+
+    CFE_SB_TimeStampMsg(&IMU_APP_SpectrumTlm.TlmHeader.Msg);
+    CFE_SB_TransmitMsg(&IMU_APP_SpectrumTlm.TlmHeader.Msg, true);
+
+} /* End of IMU_APP_FftPublish() */
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  IMU_APP_FftTask                                                    */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Entry point of the spectrum task. Blocks are consecutive; if the   */
+/*         task falls so far behind that the ring overwrites a block, it      */
+/*         restarts at the newest samples and counts the block as skipped.    */
+/*                                                                            */
+/* * * * * * * * * * * * * * * * * * * * * * * *  * * * * * * *  * *  * * * * */
+void IMU_APP_FftTask(void)
+{
+    IMU_APP_FftCfg_t        Cfg;
+    const IMU_APP_Sample_t *Sample;
+    uint32                  Next = 0;
+    uint32                  Head;
+    uint16                  RateHz;
+    uint16                  PlanRateHz = 0;
+    uint16                  Blocks     = 0;
+    uint16                  Skipped    = 0;
+    uint16                  i;
+
+    if (CFE_ES_RegisterChildTask() != CFE_SUCCESS)
+    {
+        CFE_ES_ExitChildTask();
+        return;
+    }
+
+    while (IMU_APP_Data.RunStatus == CFE_ES_RunStatus_APP_RUN)
+    {
+        if (!IMU_APP_FftGetCfg(&Cfg))
+        {
+            IMU_APP_FftPlanWindow = 0;
+            OS_TaskDelay(1000);
+            continue;
+        }
+
+        RateHz = __atomic_load_n(&IMU_APP_Data.SampleRateHz, __ATOMIC_RELAXED);
+        Head   = __atomic_load_n(&IMU_APP_Data.RingHead, __ATOMIC_ACQUIRE);
+
+        /* A new window or rate starts a new average */
+        if (Cfg.Window != IMU_APP_FftPlanWindow || RateHz != PlanRateHz)
+        {
+            IMU_APP_FftPlan(Cfg.Window);
+            memset(IMU_APP_FftPower, 0, sizeof(IMU_APP_FftPower));
+            PlanRateHz = RateHz;
+            Blocks     = 0;
+            Next       = Head;
+        }
+
+        if (Head - Next < Cfg.Window)
+        {
+            OS_TaskDelay((Cfg.Window - (Head - Next)) * 1000 / RateHz + 1);
+            continue;
+        }
+
+        if (Head - Next > (uint32)(IMU_APP_ACQ_RING_DEPTH - Cfg.Window))
+        {
+            Skipped++;
+            Next = Head - Cfg.Window;
+        }
+
+        for (i = 0; i < Cfg.Window; i++)
+        {
+            Sample = &IMU_APP_Data.Ring[(Next + i) & (IMU_APP_ACQ_RING_DEPTH - 1)];
+
+            IMU_APP_FftBlock[0][i] = Sample->Accel_x;
+            IMU_APP_FftBlock[1][i] = Sample->Accel_y;
+            IMU_APP_FftBlock[2][i] = Sample->Accel_z;
+        }
+
+        /* The slot being written is the one at the head, discard the block if it reached it */
+        if (__atomic_load_n(&IMU_APP_Data.RingHead, __ATOMIC_ACQUIRE) - Next >= IMU_APP_ACQ_RING_DEPTH)
+        {
+            Skipped++;
+            Next = __atomic_load_n(&IMU_APP_Data.RingHead, __ATOMIC_ACQUIRE);
+            continue;
+        }
+
+        Next += Cfg.Window;
+
+        CFE_ES_PerfLogEntry(IMU_APP_FFT_PERF_ID);
+
+        for (i = 0; i < 3; i++)
+        {
+            IMU_APP_FftAddPower(IMU_APP_FftBlock[i], Cfg.Window, IMU_APP_FftPower[i]);
+        }
+
+        if (++Blocks >= Cfg.Blocks)
+        {
+            IMU_APP_FftPublish(&Cfg, RateHz, Skipped);
+            memset(IMU_APP_FftPower, 0, sizeof(IMU_APP_FftPower));
+            Blocks  = 0;
+            Skipped = 0;
+        }
+
+        CFE_ES_PerfLogExit(IMU_APP_FFT_PERF_ID);
+    }
+
+    CFE_ES_ExitChildTask();
+
+} /* End of IMU_APP_FftTask() */
@@ -0,0 +1,53 @@
+/*******************************************************************************
+**
+**      GSC-18128-1, "Core Flight Executive Version 6.7"
+**
+**      Copyright (c) 2006-2019 United States Government as represented by
+**      the Administrator of the National Aeronautics and Space Administration.
+**      All Rights Reserved.
+**
+**      Licensed under the Apache License, Version 2.0 (the "License");
+**      you may not use this file except in compliance with the License.
+**      You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**      Unless required by applicable law or agreed to in writing, software
+**      distributed under the License is distributed on an "AS IS" BASIS,
+**      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**      See the License for the specific language governing permissions and
+**      limitations under the License.
+**
+*******************************************************************************/
+
+/**
+ * @file
+ *
+ * Vibration spectrum stage of the IMU application
+ */
+
+#ifndef IMU_APP_FFT_H
+#define IMU_APP_FFT_H
+
+#include "imu_app.h"
+
+/***********************************************************************/
+#define IMU_APP_FFT_TASK_NAME  "IMU_FFT"
+#define IMU_APP_FFT_STACK_SIZE 16384
+#define IMU_APP_FFT_PRIORITY   120 /* Below the main task, spectra are not time critical */
+
+/****************************************************************************/
+/*
+** Function prototypes.
+**
+** IMU_APP_FftPlan and IMU_APP_FftAddPower are internal to the spectrum
+** task and share its tables. They are only exported so that the unit
+** test can call them.
+*/
+int32 IMU_APP_FftInit(void);
+void  IMU_APP_FftTask(void);
+bool  IMU_APP_FftValidTable(const IMU_APP_Table_t *TblPtr);
+void  IMU_APP_FftPlan(uint16 N);
+void  IMU_APP_FftAddPower(const float *x, uint16 N, float *Power);
+
+#endif /* IMU_APP_FFT_H */
@@ -35,6 +35,8 @@
 #define IMU_APP_NOOP_CC           0
 #define IMU_APP_RESET_COUNTERS_CC 1
 #define IMU_APP_PROCESS_CC        2
+#define IMU_APP_TRACE_DUMP_CC     3
+#define IMU_APP_TRACE_REPLAY_CC   4
 
 /*************************************************************************/
 
@@ -59,17 +61,82 @@ typedef IMU_APP_NoArgsCmd_t IMU_APP_ProcessCmd_t;
 
 /*************************************************************************/
 /*
-** Type definition (IMU App housekeeping)
+** Type definition (bus trace file commands)
 */
+typedef struct
+{
+    char Filename[OS_MAX_PATH_LEN]; /**< \brief OSAL path of the trace file */
+} IMU_APP_TraceFile_Payload_t;
+
+typedef struct
+{
+    CFE_MSG_CommandHeader_t     CmdHeader; /**< \brief Command header */
+    IMU_APP_TraceFile_Payload_t Payload;   /**< \brief Command payload */
+} IMU_APP_TraceFileCmd_t;
+
+/*
+** The dump writes the bus trace of bcm2835_lib to the file, the replay
+** loads a dump to drive the simulated bus backend
+*/
+typedef IMU_APP_TraceFileCmd_t IMU_APP_TraceDumpCmd_t;
+typedef IMU_APP_TraceFileCmd_t IMU_APP_TraceReplayCmd_t;
+
+/*************************************************************************/
+/*
+** Type definition (statistics of one IMU channel over the HK period, in
+** raw sensor counts)
+*/
+
+#define IMU_APP_CH_ACCEL_X 0
+#define IMU_APP_CH_ACCEL_Y 1
+#define IMU_APP_CH_ACCEL_Z 2
+#define IMU_APP_CH_GYRO_X  3
+#define IMU_APP_CH_GYRO_Y  4
+#define IMU_APP_CH_GYRO_Z  5
+#define IMU_APP_CH_MAG_X   6
+#define IMU_APP_CH_MAG_Y   7
+#define IMU_APP_CH_MAG_Z   8
+#define IMU_APP_CH_TEMP    9
+
+#define IMU_APP_STATS_CHANNELS 10
+
+typedef struct
+{
+    uint32  Count;    /**< \brief Samples in the period, Min to Variance are 0 if none */
+    float   Mean;     /**< \brief Mean */
+    float   Variance; /**< \brief Sample variance */
+    int16_t Min;      /**< \brief Minimum */
+    int16_t Max;      /**< \brief Maximum */
+} IMU_APP_ChannelStats_t;
+
+/*************************************************************************/
+/*
+** Type definition (IMU App housekeeping). Latest holds the newest sample,
+** indexed like Stats, and SampleAgeMs its age when the packet was built;
+** IMU_APP_SAMPLE_AGE_NONE if there is no sample.
+*/
+
+#define IMU_APP_SAMPLE_AGE_NONE 0xFFFFFFFF
 
 typedef struct
 {
-    uint8   CommandErrorCounter;
-    uint8   CommandCounter;
-    int16_t Accel_x;
-    int16_t Accel_y;
-    int16_t Accel_z;
-    uint8   spare[2];
+    uint8                  CommandErrorCounter;
+    uint8                  CommandCounter;
+    uint16                 SampleRateHz;
+    uint16                 I2CDeadlineMisses;
+    uint16                 I2CErrors;
+    uint32                 I2CTransactions;
+    uint32                 I2CBusTimeUs;
+    uint32                 I2CSpeedHz;
+    uint32                 SamplesAcquired;
+    uint32                 SamplesMissed;
+    uint32                 SamplesBusBusy;
+    uint32                 SamplesFailed;
+    uint32                 BatchesSent;
+    uint32                 BatchesLost;
+    uint32                 SampleAgeMs;
+    int16_t                Latest[IMU_APP_STATS_CHANNELS];
+    IMU_APP_ChannelStats_t Stats[IMU_APP_STATS_CHANNELS]; /**< \brief Indexed by IMU_APP_CH_ACCEL_X ... */
 } IMU_APP_HkTlm_Payload_t;
 
 typedef struct
@@ -78,4 +145,118 @@ typedef struct
     IMU_APP_HkTlm_Payload_t Payload;   /**< \brief Telemetry payload */
 } IMU_APP_HkTlm_t;
 
+/*************************************************************************/
+/*
+** Type definition (IMU App bus statistics, the figures of every I2C and
+** SPI device of the BCM2835 Lib since the previous packet)
+*/
+
+typedef struct
+{
+    CFE_MSG_TelemetryHeader_t TlmHeader; /**< \brief Telemetry header */
+    bcm2835_bus_stats_t       Payload;   /**< \brief Telemetry payload */
+} IMU_APP_BusTlm_t;
+
+/*************************************************************************/
+/*
+** Type definition (IMU App sample, one per period of the acquisition task).
+** Only the values of the table content are read, the others are 0. The
+** magnetometer converts slower than the sample rate: Mag_x to Mag_z keep
+** the last measurement, IMU_APP_SAMPLE_MAG_NEW flags a new one.
+**
+** Roll, Pitch and Heading are binary angles, 32768 = 180 degrees. Roll
+** and pitch are the tilt of the accelerometer from gravity, heading the
+** tilt compensated magnetic heading, without hard or soft iron correction.
+*/
+
+#define IMU_APP_SAMPLE_MAG_NEW 0x0001
+
+typedef struct
+{
+    CFE_TIME_SysTime_t Time;  /**< \brief Time the sample was read */
+    uint32             Seq;   /**< \brief Sample number since the app started */
+    int16_t            Accel_x;
+    int16_t            Accel_y;
+    int16_t            Accel_z;
+    int16_t            Gyro_x;
+    int16_t            Gyro_y;
+    int16_t            Gyro_z;
+    int16_t            Mag_x;
+    int16_t            Mag_y;
+    int16_t            Mag_z;
+    int16_t            Temp;    /**< \brief Raw temperature */
+    int16_t            Roll;
+    int16_t            Pitch;
+    int16_t            Heading;
+    uint16             Flags;   /**< \brief IMU_APP_SAMPLE_MAG_NEW */
+    uint16             Content; /**< \brief IMU_APP_CONTENT_* of the sample */
+} IMU_APP_Sample_t;
+
+/*************************************************************************/
+/*
+** Type definition (IMU App sample batch). The payload is followed by
+** Count sample times and then one array of Count values per channel of
+** Content, in this order:
+**
+**     uint32  DeltaUs[Count];  time of each sample after BaseTime
+**     int16_t Accel_x[Count];  Accel_y[Count];  Accel_z[Count];   if ACCEL
+**     int16_t Gyro_x[Count];   Gyro_y[Count];   Gyro_z[Count];    if GYRO
+**     int16_t Mag_x[Count];    Mag_y[Count];    Mag_z[Count];     if MAG
+**     int16_t Temp[Count];                                        if TEMP
+**     int16_t Roll[Count];     Pitch[Count];    Heading[Count];   if ATTITUDE
+**
+** The packet length is IMU_APP_BATCH_SIZE(Count, IMU_APP_BATCH_CHANNELS(Content)).
+*/
+
+#define IMU_APP_BATCH_CHANNELS_MAX 13
+
+typedef struct
+{
+    CFE_TIME_SysTime_t BaseTime; /**< \brief Time of the first sample */
+    uint32             FirstSeq; /**< \brief Seq of the first sample, later ones may be missing */
+    uint16             Count;    /**< \brief Samples in the batch */
+    uint16             RateHz;   /**< \brief Sample rate when the batch started */
+    uint16             Content;  /**< \brief IMU_APP_CONTENT_* arrays that follow */
+    uint16             Spare;
+} IMU_APP_BatchTlm_Payload_t;
+
+typedef struct
+{
+    CFE_MSG_TelemetryHeader_t  TlmHeader; /**< \brief Telemetry header */
+    IMU_APP_BatchTlm_Payload_t Payload;   /**< \brief Telemetry payload */
+} IMU_APP_BatchTlm_t;
+
+#define IMU_APP_BATCH_CHANNELS(Content)                                                      \
+    ((((Content)&IMU_APP_CONTENT_ACCEL) ? 3 : 0) + (((Content)&IMU_APP_CONTENT_GYRO) ? 3 : 0) + \
+     (((Content)&IMU_APP_CONTENT_MAG) ? 3 : 0) + (((Content)&IMU_APP_CONTENT_TEMP) ? 1 : 0) +   \
+     (((Content)&IMU_APP_CONTENT_ATTITUDE) ? 3 : 0))
+
+#define IMU_APP_BATCH_SIZE(Count, Channels) \
+    (sizeof(IMU_APP_BatchTlm_t) + (Count) * (sizeof(uint32) + (Channels) * sizeof(int16_t)))
+
+/*************************************************************************/
+/*
+** Type definition (IMU App vibration spectrum of the accelerometer, the
+** mean over Blocks blocks of Window samples). Energies are the mean
+** square of each band, in raw counts squared, with the mean of each
+** block removed; the bands are the BandEdgesHz of the table.
+*/
+
+typedef struct
+{
+    uint16 Window; /**< \brief Samples per block */
+    uint16 Blocks; /**< \brief Blocks averaged */
+    uint16 RateHz; /**< \brief Sample rate */
+    uint16 Skipped; /**< \brief Blocks overwritten in the ring before they were processed */
+    float  Energy[3][IMU_APP_FFT_BANDS]; /**< \brief Band energy of accel X, Y and Z */
+    float  PeakHz[3];                    /**< \brief Frequency of the strongest bin above DC */
+    float  PeakEnergy[3];                /**< \brief Energy of that bin */
+} IMU_APP_SpectrumTlm_Payload_t;
+
+typedef struct
+{
+    CFE_MSG_TelemetryHeader_t     TlmHeader; /**< \brief Telemetry header */
+    IMU_APP_SpectrumTlm_Payload_t Payload;   /**< \brief Telemetry payload */
+} IMU_APP_SpectrumTlm_t;
+
 #endif /* IMU_APP_MSG_H */
@@ -0,0 +1,227 @@
+/*******************************************************************************
+**
+**      GSC-18128-1, "Core Flight Executive Version 6.7"
+**
+**      Copyright (c) 2006-2019 United States Government as represented by
+**      the Administrator of the National Aeronautics and Space Administration.
+**      All Rights Reserved.
+**
+**      Licensed under the Apache License, Version 2.0 (the "License");
+**      you may not use this file except in compliance with the License.
+**      You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**      Unless required by applicable law or agreed to in writing, software
+**      distributed under the License is distributed on an "AS IS" BASIS,
+**      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**      See the License for the specific language governing permissions and
+**      limitations under the License.
+**
+** File: imu_app_stats.c
+**
+** Purpose:
+**   Per-channel statistics of the IMU samples over a reporting window:
+**   count, minimum, maximum, and mean and variance by Welford's method,
+**   which updates in O(1) per sample without keeping the samples and
+**   without the cancellation of a sum of squares.
+**
+**   The acquisition task accumulates into its own accumulators without
+**   a lock and merges them into the window once per batch of samples,
+**   so the lock is taken once per batch instead of once per sample.
+**   Samples not yet merged when the window is taken go to the next one.
+**
+*******************************************************************************/
+
+/*
+** Include Files:
+*/
+#include <string.h>
+
+#include "imu_app_events.h"
+#include "imu_app_stats.h"
+
+/*
+** Global data of the app
+*/
+extern IMU_APP_Data_t IMU_APP_Data;
+
+/*
+** Local data
+*/
+static osal_id_t       IMU_APP_StatsLock;
+static IMU_APP_Accum_t IMU_APP_Accum[IMU_APP_STATS_CHANNELS]; /* Window, under IMU_APP_StatsLock */
+static IMU_APP_Accum_t IMU_APP_Local[IMU_APP_STATS_CHANNELS]; /* Acquisition task only */
+static uint16          IMU_APP_LocalSamples;
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  IMU_APP_StatsInit                                                  */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Creates the lock of the accumulators and starts the first window.  */
+/*                                                                            */
+/* * * * * * * * * * * * * * * * * * * * * * * *  * * * * * * *  * *  * * * * */
+int32 IMU_APP_StatsInit(void)
+{
+    memset(IMU_APP_Accum, 0, sizeof(IMU_APP_Accum));
+    memset(IMU_APP_Local, 0, sizeof(IMU_APP_Local));
+    IMU_APP_LocalSamples = 0;
+
+    return OS_MutSemCreate(&IMU_APP_StatsLock, "IMU_STATS", 0);
+
+} /* End of IMU_APP_StatsInit() */
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  IMU_APP_StatsUpdate                                                */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Adds a value to the accumulator of a channel.                      */
+/*                                                                            */
+/* * * * * * * * * * * * * * * * * * * * * * * *  * * * * * * *  * *  * * * * */
+void IMU_APP_StatsUpdate(IMU_APP_Accum_t *Accum, int16_t Value)
+{
+    double Delta = Value - Accum->Mean;
+
+    if (Accum->Count == 0 || Value < Accum->Min)
+    {
+        Accum->Min = Value;
+    }
+    if (Accum->Count == 0 || Value > Accum->Max)
+    {
+        Accum->Max = Value;
+    }
+
+    Accum->Count++;
+    Accum->Mean += Delta / Accum->Count;
+    Accum->M2 += Delta * (Value - Accum->Mean);
+
+} /* End of IMU_APP_StatsUpdate() */
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  IMU_APP_StatsMerge                                                 */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Adds the values of accumulator From to Into, as if they had been   */
+/*         added one by one (Chan et al. pairwise combination).               */
+/*                                                                            */
+/* * * * * * * * * * * * * * * * * * * * * * * *  * * * * * * *  * *  * * * * */
+void IMU_APP_StatsMerge(IMU_APP_Accum_t *Into, const IMU_APP_Accum_t *From)
+{
+    double Delta;
+    uint32 Count;
+
+    if (From->Count == 0)
+    {
+        return;
+    }
+
+    if (Into->Count == 0)
+    {
+        *Into = *From;
+        return;
+    }
+
+    Count = Into->Count + From->Count;
+    Delta = From->Mean - Into->Mean;
+
+    Into->Mean += Delta * From->Count / Count;
+    Into->M2 += From->M2 + Delta * Delta * ((double)Into->Count * From->Count / Count);
+    Into->Count = Count;
+
+    if (From->Min < Into->Min)
+    {
+        Into->Min = From->Min;
+    }
+    if (From->Max > Into->Max)
+    {
+        Into->Max = From->Max;
+    }
+
+} /* End of IMU_APP_StatsMerge() */
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  IMU_APP_StatsAdd                                                   */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Adds a sample to the window. A channel only counts the samples     */
+/*         that read its sensor, the magnetometer channels the samples that   */
+/*         carry a new magnetometer measurement.                              */
+/*                                                                            */
+/* * * * * * * * * * * * * * * * * * * * * * * *  * * * * * * *  * *  * * * * */
+void IMU_APP_StatsAdd(const IMU_APP_Sample_t *Sample)
+{
+    IMU_APP_Accum_t *Accum = IMU_APP_Local;
+    uint32           i;
+
+    if (Sample->Content & IMU_APP_CONTENT_ACCEL)
+    {
+        IMU_APP_StatsUpdate(&Accum[IMU_APP_CH_ACCEL_X], Sample->Accel_x);
+        IMU_APP_StatsUpdate(&Accum[IMU_APP_CH_ACCEL_Y], Sample->Accel_y);
+        IMU_APP_StatsUpdate(&Accum[IMU_APP_CH_ACCEL_Z], Sample->Accel_z);
+    }
+
+    if (Sample->Content & IMU_APP_CONTENT_GYRO)
+    {
+        IMU_APP_StatsUpdate(&Accum[IMU_APP_CH_GYRO_X], Sample->Gyro_x);
+        IMU_APP_StatsUpdate(&Accum[IMU_APP_CH_GYRO_Y], Sample->Gyro_y);
+        IMU_APP_StatsUpdate(&Accum[IMU_APP_CH_GYRO_Z], Sample->Gyro_z);
+    }
+
+    if (Sample->Content & IMU_APP_CONTENT_TEMP)
+    {
+        IMU_APP_StatsUpdate(&Accum[IMU_APP_CH_TEMP], Sample->Temp);
+    }
+
+    if (Sample->Flags & IMU_APP_SAMPLE_MAG_NEW)
+    {
+        IMU_APP_StatsUpdate(&Accum[IMU_APP_CH_MAG_X], Sample->Mag_x);
+        IMU_APP_StatsUpdate(&Accum[IMU_APP_CH_MAG_Y], Sample->Mag_y);
+        IMU_APP_StatsUpdate(&Accum[IMU_APP_CH_MAG_Z], Sample->Mag_z);
+    }
+
+    /* Hand the accumulators over once per batch */
+    if (++IMU_APP_LocalSamples < __atomic_load_n(&IMU_APP_Data.SamplesPerBatch, __ATOMIC_RELAXED))
+    {
+        return;
+    }
+
+    OS_MutSemTake(IMU_APP_StatsLock);
+    for (i = 0; i < IMU_APP_STATS_CHANNELS; i++)
+    {
+        IMU_APP_StatsMerge(&IMU_APP_Accum[i], &Accum[i]);
+    }
+    OS_MutSemGive(IMU_APP_StatsLock);
+
+    memset(IMU_APP_Local, 0, sizeof(IMU_APP_Local));
+    IMU_APP_LocalSamples = 0;
+
+} /* End of IMU_APP_StatsAdd() */
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  IMU_APP_StatsTake                                                  */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Reports the statistics of the window and starts a new one. The     */
+/*         variance is the sample variance, 0 with fewer than 2 samples.      */
+/*                                                                            */
+/* * * * * * * * * * * * * * * * * * * * * * * *  * * * * * * *  * *  * * * * */
+void IMU_APP_StatsTake(IMU_APP_ChannelStats_t Stats[IMU_APP_STATS_CHANNELS])
+{
+    IMU_APP_Accum_t Window[IMU_APP_STATS_CHANNELS];
+    uint32          i;
+
+    OS_MutSemTake(IMU_APP_StatsLock);
+    memcpy(Window, IMU_APP_Accum, sizeof(Window));
+    memset(IMU_APP_Accum, 0, sizeof(IMU_APP_Accum));
+    OS_MutSemGive(IMU_APP_StatsLock);
+
+    for (i = 0; i < IMU_APP_STATS_CHANNELS; i++)
+    {
+        Stats[i].Count    = Window[i].Count;
+        Stats[i].Mean     = (float)Window[i].Mean;
+        Stats[i].Variance = (Window[i].Count > 1) ? (float)(Window[i].M2 / (Window[i].Count - 1)) : 0.0f;
+        Stats[i].Min      = Window[i].Min;
+        Stats[i].Max      = Window[i].Max;
+    }
+
+} /* End of IMU_APP_StatsTake() */
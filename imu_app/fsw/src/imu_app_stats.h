@@ -0,0 +1,60 @@
+/*******************************************************************************
+**
+**      GSC-18128-1, "Core Flight Executive Version 6.7"
+**
+**      Copyright (c) 2006-2019 United States Government as represented by
+**      the Administrator of the National Aeronautics and Space Administration.
+**      All Rights Reserved.
+**
+**      Licensed under the Apache License, Version 2.0 (the "License");
+**      you may not use this file except in compliance with the License.
+**      You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**      Unless required by applicable law or agreed to in writing, software
+**      distributed under the License is distributed on an "AS IS" BASIS,
+**      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**      See the License for the specific language governing permissions and
+**      limitations under the License.
+**
+*******************************************************************************/
+
+/**
+ * @file
+ *
+ * Streaming sample statistics stage of the IMU application
+ */
+
+#ifndef IMU_APP_STATS_H
+#define IMU_APP_STATS_H
+
+#include "imu_app.h"
+
+/*
+** Accumulator of one channel
+*/
+typedef struct
+{
+    uint32  Count;
+    double  Mean;
+    double  M2; /* Sum of squared deviations from the mean */
+    int16_t Min;
+    int16_t Max;
+} IMU_APP_Accum_t;
+
+/****************************************************************************/
+/*
+** Function prototypes.
+**
+** IMU_APP_StatsAdd is called by the acquisition task for every sample,
+** IMU_APP_StatsTake by the main task once per reporting window.
+** IMU_APP_StatsUpdate and IMU_APP_StatsMerge only touch their arguments.
+*/
+int32 IMU_APP_StatsInit(void);
+void  IMU_APP_StatsAdd(const IMU_APP_Sample_t *Sample);
+void  IMU_APP_StatsTake(IMU_APP_ChannelStats_t Stats[IMU_APP_STATS_CHANNELS]);
+void  IMU_APP_StatsUpdate(IMU_APP_Accum_t *Accum, int16_t Value);
+void  IMU_APP_StatsMerge(IMU_APP_Accum_t *Into, const IMU_APP_Accum_t *From);
+
+#endif /* IMU_APP_STATS_H */
@@ -27,7 +27,7 @@
 ** The following is an example of the declaration statement that defines the desired
 ** contents of the table image.
 */
-IMU_APP_Table_t ImuAppTable = {1, 2};
+IMU_APP_Table_t ImuAppTable = {1, 2, 100, 25, IMU_APP_CONTENT_ALL, 256, 4, {1, 2, 4, 6, 10, 15, 20, 30, 50}};
 
 /*
 ** The macro below identifies:
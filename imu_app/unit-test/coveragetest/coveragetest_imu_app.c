@@ -38,11 +38,12 @@
  * Includes
  */
 
-#include "imu_lib.h"
 #include "imu_app_coveragetest_common.h"
 #include "ut_imu_app.h"
+#include "imu_app_stats.h"
 
-/* to get the IMU_LIB_Function() declaration */
+/* to get the bcm2835_i2c_sched_*() declarations */
+#include "bcm2835_lib.h"
 
 typedef struct
 {
@@ -125,6 +126,73 @@ static void UT_CheckEvent_Setup(UT_CheckEvent_t *Evt, uint16 ExpectedEvent, cons
     UT_SetVaHookFunction(UT_KEY(CFE_EVS_SendEvent), UT_CheckEvent_Hook, Evt);
 }
 
+/*
+ * Hook function to check for a specific event sent through the
+ * rate limiter of the BCM2835 Lib, which is called instead of
+ * CFE_EVS_SendEvent for the events that can repeat.
+ */
+static int32 UT_CheckLimitedEvent_Hook(void *UserObj, int32 StubRetcode, uint32 CallCount,
+                                       const UT_StubContext_t *Context, va_list va)
+{
+    UT_CheckEvent_t *State = UserObj;
+    uint16           EventId;
+    const char *     Spec;
+
+    if (Context->ArgCount > 0)
+    {
+        EventId = UT_Hook_GetArgValueByName(Context, "event_id", uint16);
+        Spec    = UT_Hook_GetArgValueByName(Context, "spec", const char *);
+        if (EventId == State->ExpectedEvent &&
+            (State->ExpectedFormat == NULL || (Spec != NULL && strcmp(Spec, State->ExpectedFormat) == 0)))
+        {
+            ++State->MatchCount;
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * Helper function to set up for checking a rate limited event
+ * This attaches the hook function to bcm2835_evs_limit_send
+ */
+static void UT_CheckLimitedEvent_Setup(UT_CheckEvent_t *Evt, uint16 ExpectedEvent, const char *ExpectedFormat)
+{
+    memset(Evt, 0, sizeof(*Evt));
+    Evt->ExpectedEvent  = ExpectedEvent;
+    Evt->ExpectedFormat = ExpectedFormat;
+    UT_SetVaHookFunction(UT_KEY(bcm2835_evs_limit_send), UT_CheckLimitedEvent_Hook, Evt);
+}
+/*
+ * Helper function to fill a table that passes validation
+ */
+static void UT_Imu_ValidTable(IMU_APP_Table_t *TblPtr)
+{
+    memset(TblPtr, 0, sizeof(*TblPtr));
+    TblPtr->SampleRateHz    = IMU_APP_SAMPLE_RATE_DEF;
+    TblPtr->SamplesPerBatch = IMU_APP_BATCH_DEF;
+    TblPtr->Content         = IMU_APP_CONTENT_DEF;
+}
+
+/*
+ * Hook function of bcm2835_periodic_wait that runs the acquisition task for
+ * two periods, with a new sample rate and content from the second one
+ */
+static int32 UT_Imu_AcqWaitHook(void *UserObj, int32 StubRetcode, uint32 CallCount, const UT_StubContext_t *Context)
+{
+    if (CallCount == 1)
+    {
+        IMU_APP_Data.SampleRateHz = 200;
+        IMU_APP_Data.Content      = IMU_APP_CONTENT_ACCEL;
+    }
+    else
+    {
+        IMU_APP_Data.RunStatus = CFE_ES_RunStatus_APP_EXIT;
+    }
+
+    return StubRetcode;
+}
+
 /*
 **********************************************************************************
 **          TEST CASE FUNCTIONS
@@ -219,7 +287,7 @@ void Test_IMU_APP_Main(void)
      */
     UT_SetDeferredRetcode(UT_KEY(CFE_ES_RunLoop), 1, true);
     UT_SetDeferredRetcode(UT_KEY(CFE_SB_ReceiveBuffer), 1, CFE_SB_PIPE_RD_ERR);
-    UT_CheckEvent_Setup(&EventTest, IMU_APP_PIPE_ERR_EID, "IMU APP: SB Pipe Read Error, App Will Exit");
+    UT_CheckLimitedEvent_Setup(&EventTest, IMU_APP_PIPE_ERR_EID, "IMU APP: SB Pipe Read Error, App Will Exit");
 
     /*
      * Invoke again
@@ -239,9 +307,27 @@ void Test_IMU_APP_Init(void)
      * Test Case For:
      * int32 IMU_APP_Init( void )
      */
+    UT_CheckEvent_t EventTest;
 
-    /* nominal case should return CFE_SUCCESS */
+    /* nominal case should return CFE_SUCCESS, and report the I2C clock in syslog */
     UT_TEST_FUNCTION_RC(IMU_APP_Init(), CFE_SUCCESS);
+    UtAssert_True(UT_GetStubCount(UT_KEY(CFE_ES_WriteToSysLog)) == 1, "CFE_ES_WriteToSysLog() called");
+    UtAssert_True(UT_GetStubCount(UT_KEY(bcm2835_evs_limit_init)) == 1, "bcm2835_evs_limit_init() called");
+    UtAssert_True(UT_GetStubCount(UT_KEY(mpu9dof_init)) == 1, "mpu9dof_init() called");
+    UtAssert_True(UT_GetStubCount(UT_KEY(mpu9dof_negotiate_i2c)) == 1, "mpu9dof_negotiate_i2c() called");
+    UtAssert_True(UT_GetStubCount(UT_KEY(CFE_ES_CreateChildTask)) == 2, "CFE_ES_CreateChildTask() called twice");
+    UtAssert_True(IMU_APP_Data.SampleRateHz == IMU_APP_SAMPLE_RATE_DEF,
+                  "IMU_APP_Data.SampleRateHz (%u) == IMU_APP_SAMPLE_RATE_DEF",
+                  (unsigned int)IMU_APP_Data.SampleRateHz);
+    UtAssert_True(IMU_APP_Data.I2CPeriodUs == 1000000 / IMU_APP_SAMPLE_RATE_DEF,
+                  "IMU_APP_Data.I2CPeriodUs (%lu) == 1000000 / IMU_APP_SAMPLE_RATE_DEF",
+                  (unsigned long)IMU_APP_Data.I2CPeriodUs);
+
+    /* the clock is not negotiated without the bus */
+    UT_SetDeferredRetcode(UT_KEY(bcm2835_i2c_sched_acquire), 1, BCM2835_I2C_SCHED_ERR_OS);
+    UT_TEST_FUNCTION_RC(IMU_APP_Init(), CFE_SUCCESS);
+    UtAssert_True(UT_GetStubCount(UT_KEY(mpu9dof_negotiate_i2c)) == 1, "mpu9dof_negotiate_i2c() not called");
+    UtAssert_True(UT_GetStubCount(UT_KEY(CFE_ES_WriteToSysLog)) == 2, "CFE_ES_WriteToSysLog() called");
 
     /* trigger a failure for each of the sub-calls,
      * and confirm a write to syslog for each.
@@ -249,23 +335,41 @@ void Test_IMU_APP_Init(void)
      * is _not_ reset between these test cases. */
     UT_SetDeferredRetcode(UT_KEY(CFE_EVS_Register), 1, CFE_EVS_INVALID_PARAMETER);
     UT_TEST_FUNCTION_RC(IMU_APP_Init(), CFE_EVS_INVALID_PARAMETER);
-    UtAssert_True(UT_GetStubCount(UT_KEY(CFE_ES_WriteToSysLog)) == 1, "CFE_ES_WriteToSysLog() called");
+    UtAssert_True(UT_GetStubCount(UT_KEY(CFE_ES_WriteToSysLog)) == 3, "CFE_ES_WriteToSysLog() called");
 
     UT_SetDeferredRetcode(UT_KEY(CFE_SB_CreatePipe), 1, CFE_SB_BAD_ARGUMENT);
     UT_TEST_FUNCTION_RC(IMU_APP_Init(), CFE_SB_BAD_ARGUMENT);
-    UtAssert_True(UT_GetStubCount(UT_KEY(CFE_ES_WriteToSysLog)) == 2, "CFE_ES_WriteToSysLog() called");
+    UtAssert_True(UT_GetStubCount(UT_KEY(CFE_ES_WriteToSysLog)) == 4, "CFE_ES_WriteToSysLog() called");
 
     UT_SetDeferredRetcode(UT_KEY(CFE_SB_Subscribe), 1, CFE_SB_BAD_ARGUMENT);
     UT_TEST_FUNCTION_RC(IMU_APP_Init(), CFE_SB_BAD_ARGUMENT);
-    UtAssert_True(UT_GetStubCount(UT_KEY(CFE_ES_WriteToSysLog)) == 3, "CFE_ES_WriteToSysLog() called");
+    UtAssert_True(UT_GetStubCount(UT_KEY(CFE_ES_WriteToSysLog)) == 5, "CFE_ES_WriteToSysLog() called");
 
     UT_SetDeferredRetcode(UT_KEY(CFE_SB_Subscribe), 2, CFE_SB_BAD_ARGUMENT);
     UT_TEST_FUNCTION_RC(IMU_APP_Init(), CFE_SB_BAD_ARGUMENT);
-    UtAssert_True(UT_GetStubCount(UT_KEY(CFE_ES_WriteToSysLog)) == 4, "CFE_ES_WriteToSysLog() called");
+    UtAssert_True(UT_GetStubCount(UT_KEY(CFE_ES_WriteToSysLog)) == 6, "CFE_ES_WriteToSysLog() called");
 
     UT_SetDeferredRetcode(UT_KEY(CFE_TBL_Register), 1, CFE_TBL_ERR_INVALID_OPTIONS);
     UT_TEST_FUNCTION_RC(IMU_APP_Init(), CFE_TBL_ERR_INVALID_OPTIONS);
-    UtAssert_True(UT_GetStubCount(UT_KEY(CFE_ES_WriteToSysLog)) == 5, "CFE_ES_WriteToSysLog() called");
+    UtAssert_True(UT_GetStubCount(UT_KEY(CFE_ES_WriteToSysLog)) == 7, "CFE_ES_WriteToSysLog() called");
+
+    UT_SetDeferredRetcode(UT_KEY(bcm2835_i2c_sched_register), 1, BCM2835_I2C_SCHED_ERR_FULL);
+    UT_TEST_FUNCTION_RC(IMU_APP_Init(), BCM2835_I2C_SCHED_ERR_FULL);
+    UtAssert_True(UT_GetStubCount(UT_KEY(CFE_ES_WriteToSysLog)) == 8, "CFE_ES_WriteToSysLog() called");
+
+    /* the I2C clock is reported before the statistics lock is created */
+    UT_SetDeferredRetcode(UT_KEY(OS_MutSemCreate), 1, OS_ERROR);
+    UT_TEST_FUNCTION_RC(IMU_APP_Init(), OS_ERROR);
+    UtAssert_True(UT_GetStubCount(UT_KEY(CFE_ES_WriteToSysLog)) == 10, "CFE_ES_WriteToSysLog() called twice");
+
+    /* the child task failures send an event instead, for the acquisition then the spectrum task */
+    UT_CheckEvent_Setup(&EventTest, IMU_APP_ACQ_ERR_EID, NULL);
+    UT_SetDeferredRetcode(UT_KEY(CFE_ES_CreateChildTask), 1, CFE_ES_ERR_CHILD_TASK_CREATE);
+    UT_TEST_FUNCTION_RC(IMU_APP_Init(), CFE_ES_ERR_CHILD_TASK_CREATE);
+    UT_SetDeferredRetcode(UT_KEY(CFE_ES_CreateChildTask), 2, CFE_ES_ERR_CHILD_TASK_CREATE);
+    UT_TEST_FUNCTION_RC(IMU_APP_Init(), CFE_ES_ERR_CHILD_TASK_CREATE);
+    UtAssert_True(EventTest.MatchCount == 2, "IMU_APP_ACQ_ERR_EID generated (%u)",
+                  (unsigned int)EventTest.MatchCount);
 }
 
 void Test_IMU_APP_ProcessCommandPacket(void)
@@ -286,7 +390,7 @@ void Test_IMU_APP_ProcessCommandPacket(void)
     UT_CheckEvent_t   EventTest;
 
     memset(&TestMsg, 0, sizeof(TestMsg));
-    UT_CheckEvent_Setup(&EventTest, IMU_APP_INVALID_MSGID_ERR_EID, "IMU: invalid command packet,MID = 0x%x");
+    UT_CheckLimitedEvent_Setup(&EventTest, IMU_APP_INVALID_MSGID_ERR_EID, "IMU: invalid command packet,MID = 0x%x");
 
     /*
      * The CFE_MSG_GetMsgId() stub uses a data buffer to hold the
@@ -312,7 +416,7 @@ void Test_IMU_APP_ProcessCommandPacket(void)
     /*
      * Confirm that the event was generated only _once_
      */
-    UtAssert_True(EventTest.MatchCount == 1, "IMU_APP_COMMAND_ERR_EID generated (%u)",
+    UtAssert_True(EventTest.MatchCount == 1, "IMU_APP_INVALID_MSGID_ERR_EID generated (%u)",
                   (unsigned int)EventTest.MatchCount);
 }
 
@@ -332,6 +436,8 @@ void Test_IMU_APP_ProcessGroundCommand(void)
         IMU_APP_NoopCmd_t          Noop;
         IMU_APP_ResetCountersCmd_t Reset;
         IMU_APP_ProcessCmd_t       Process;
+        IMU_APP_TraceDumpCmd_t     TraceDump;
+        IMU_APP_TraceReplayCmd_t   TraceReplay;
     } TestMsg;
     UT_CheckEvent_t EventTest;
 
@@ -381,6 +487,26 @@ void Test_IMU_APP_ProcessGroundCommand(void)
 
     IMU_APP_ProcessGroundCommand(&TestMsg.SBBuf);
 
+    /* test dispatch of TRACE_DUMP */
+    FcnCode = IMU_APP_TRACE_DUMP_CC;
+    Size    = sizeof(TestMsg.TraceDump);
+    UT_SetDataBuffer(UT_KEY(CFE_MSG_GetFcnCode), &FcnCode, sizeof(FcnCode), false);
+    UT_SetDataBuffer(UT_KEY(CFE_MSG_GetSize), &Size, sizeof(Size), false);
+
+    IMU_APP_ProcessGroundCommand(&TestMsg.SBBuf);
+
+    UtAssert_True(UT_GetStubCount(UT_KEY(bcm2835_trace_dump)) == 1, "bcm2835_trace_dump() called");
+
+    /* test dispatch of TRACE_REPLAY */
+    FcnCode = IMU_APP_TRACE_REPLAY_CC;
+    Size    = sizeof(TestMsg.TraceReplay);
+    UT_SetDataBuffer(UT_KEY(CFE_MSG_GetFcnCode), &FcnCode, sizeof(FcnCode), false);
+    UT_SetDataBuffer(UT_KEY(CFE_MSG_GetSize), &Size, sizeof(Size), false);
+
+    IMU_APP_ProcessGroundCommand(&TestMsg.SBBuf);
+
+    UtAssert_True(UT_GetStubCount(UT_KEY(bcm2835_trace_replay_load)) == 1, "bcm2835_trace_replay_load() called");
+
     /* test an invalid CC */
     FcnCode = 1000;
     UT_SetDataBuffer(UT_KEY(CFE_MSG_GetFcnCode), &FcnCode, sizeof(FcnCode), false);
@@ -400,35 +526,135 @@ void Test_IMU_APP_ReportHousekeeping(void)
      * Test Case For:
      * void IMU_APP_ReportHousekeeping( const CFE_SB_CmdHdr_t *Msg )
      */
-    CFE_MSG_Message_t *MsgSend;
-    CFE_MSG_Message_t *MsgTimestamp;
+    CFE_MSG_Message_t *MsgSend[2];
+    CFE_MSG_Message_t *MsgTimestamp[2];
     CFE_SB_MsgId_t     MsgId = CFE_SB_ValueToMsgId(IMU_APP_SEND_HK_MID);
+    IMU_APP_Sample_t   Sample;
+
+    /* The statistics of the samples of the acquisition task are reported */
+    memset(&Sample, 0, sizeof(Sample));
+    IMU_APP_StatsInit();
+    IMU_APP_Data.SamplesPerBatch = 1;
+    Sample.Content               = IMU_APP_CONTENT_ACCEL;
+    Sample.Accel_x               = 7;
+    IMU_APP_StatsAdd(&Sample);
+    Sample.Accel_x = 9;
+    IMU_APP_StatsAdd(&Sample);
 
     /* Set message id to return so IMU_APP_Housekeeping will be called */
     UT_SetDataBuffer(UT_KEY(CFE_MSG_GetMsgId), &MsgId, sizeof(MsgId), false);
 
-    /* Set up to capture send message address */
-    UT_SetDataBuffer(UT_KEY(CFE_SB_TransmitMsg), &MsgSend, sizeof(MsgSend), false);
+    /* Set up to capture send message addresses, HK then bus statistics */
+    UT_SetDataBuffer(UT_KEY(CFE_SB_TransmitMsg), MsgSend, sizeof(MsgSend), false);
 
-    /* Set up to capture timestamp message address */
-    UT_SetDataBuffer(UT_KEY(CFE_SB_TimeStampMsg), &MsgTimestamp, sizeof(MsgTimestamp), false);
+    /* Set up to capture timestamp message addresses */
+    UT_SetDataBuffer(UT_KEY(CFE_SB_TimeStampMsg), MsgTimestamp, sizeof(MsgTimestamp), false);
 
     /* Call unit under test, NULL pointer confirms command access is through APIs */
     IMU_APP_ProcessCommandPacket((CFE_SB_Buffer_t *)NULL);
 
-    /* Confirm message sent*/
-    UtAssert_True(UT_GetStubCount(UT_KEY(CFE_SB_TransmitMsg)) == 1, "CFE_SB_TransmitMsg() called once");
-    UtAssert_True(MsgSend == &IMU_APP_Data.HkTlm.TlmHeader.Msg, "CFE_SB_TransmitMsg() address matches expected");
+    /* Confirm messages sent */
+    UtAssert_True(UT_GetStubCount(UT_KEY(CFE_SB_TransmitMsg)) == 2, "CFE_SB_TransmitMsg() called twice");
+    UtAssert_True(MsgSend[0] == &IMU_APP_Data.HkTlm.TlmHeader.Msg, "CFE_SB_TransmitMsg() HK address matches");
+    UtAssert_True(MsgSend[1] == &IMU_APP_Data.BusTlm.TlmHeader.Msg, "CFE_SB_TransmitMsg() bus address matches");
+
+    /* Confirm timestamp msg addresses */
+    UtAssert_True(UT_GetStubCount(UT_KEY(CFE_SB_TimeStampMsg)) == 2, "CFE_SB_TimeStampMsg() called twice");
+    UtAssert_True(MsgTimestamp[0] == &IMU_APP_Data.HkTlm.TlmHeader.Msg,
+                  "CFE_SB_TimeStampMsg() HK address matches");
+    UtAssert_True(MsgTimestamp[1] == &IMU_APP_Data.BusTlm.TlmHeader.Msg,
+                  "CFE_SB_TimeStampMsg() bus address matches");
+
+    /*
+     * Confirm that the bus statistics were read and reset
+     */
+    UtAssert_True(UT_GetStubCount(UT_KEY(bcm2835_bus_get_stats)) == 1, "bcm2835_bus_get_stats() called");
 
-    /* Confirm timestamp msg address */
-    UtAssert_True(UT_GetStubCount(UT_KEY(CFE_SB_TimeStampMsg)) == 1, "CFE_SB_TimeStampMsg() called once");
-    UtAssert_True(MsgTimestamp == &IMU_APP_Data.HkTlm.TlmHeader.Msg,
-                  "CFE_SB_TimeStampMsg() adress matches expected");
+    /* No sample in the cache yet */
+    UtAssert_True(IMU_APP_Data.HkTlm.Payload.SampleAgeMs == IMU_APP_SAMPLE_AGE_NONE,
+                  "IMU_APP_Data.HkTlm.Payload.SampleAgeMs (%lu) == IMU_APP_SAMPLE_AGE_NONE",
+                  (unsigned long)IMU_APP_Data.HkTlm.Payload.SampleAgeMs);
+    UtAssert_True(IMU_APP_Data.HkTlm.Payload.Latest[IMU_APP_CH_ACCEL_X] == 0, "no latest value");
 
     /*
      * Confirm that the CFE_TBL_Manage() call was done
      */
     UtAssert_True(UT_GetStubCount(UT_KEY(CFE_TBL_Manage)) == 1, "CFE_TBL_Manage() called");
+
+    /*
+     * Confirm that the counted events were reported
+     */
+    UtAssert_True(UT_GetStubCount(UT_KEY(bcm2835_evs_limit_flush)) == 1, "bcm2835_evs_limit_flush() called");
+
+    /*
+     * Confirm that the sensor was not read, the bus belongs to the acquisition task
+     */
+    UtAssert_True(UT_GetStubCount(UT_KEY(bcm2835_i2c_sched_acquire)) == 0, "bcm2835_i2c_sched_acquire() not called");
+    UtAssert_True(UT_GetStubCount(UT_KEY(mpu9dof_read_accel)) == 0, "mpu9dof_read_accel() not called");
+    UtAssert_True(IMU_APP_Data.HkTlm.Payload.Stats[IMU_APP_CH_ACCEL_X].Count == 2 &&
+                      IMU_APP_Data.HkTlm.Payload.Stats[IMU_APP_CH_ACCEL_X].Mean == 8,
+                  "window statistics reported (%lu, %f)",
+                  (unsigned long)IMU_APP_Data.HkTlm.Payload.Stats[IMU_APP_CH_ACCEL_X].Count,
+                  (double)IMU_APP_Data.HkTlm.Payload.Stats[IMU_APP_CH_ACCEL_X].Mean);
+    UtAssert_True(IMU_APP_Data.HkTlm.Payload.Stats[IMU_APP_CH_ACCEL_X].Min == 7 &&
+                      IMU_APP_Data.HkTlm.Payload.Stats[IMU_APP_CH_ACCEL_X].Max == 9,
+                  "window minimum and maximum");
+
+    /* The next window starts empty, the latest sample of the cache is reported */
+    Sample.Accel_x = 5;
+    Sample.Temp    = 40;
+    UT_SetDeferredRetcode(UT_KEY(bcm2835_seqlock_read), 1, 1);
+    UT_SetDataBuffer(UT_KEY(bcm2835_seqlock_read), &Sample, sizeof(Sample), false);
+    IMU_APP_ReportHousekeeping(NULL);
+    UtAssert_True(IMU_APP_Data.HkTlm.Payload.Stats[IMU_APP_CH_ACCEL_X].Count == 0, "new window is empty");
+    UtAssert_True(IMU_APP_Data.HkTlm.Payload.Latest[IMU_APP_CH_ACCEL_X] == 5 &&
+                      IMU_APP_Data.HkTlm.Payload.Latest[IMU_APP_CH_TEMP] == 40,
+                  "latest values reported");
+    UtAssert_True(IMU_APP_Data.HkTlm.Payload.SampleAgeMs != IMU_APP_SAMPLE_AGE_NONE, "sample age reported");
+}
+
+void Test_IMU_APP_ReportHousekeeping_Stats(void)
+{
+    /*
+     * Test Case For:
+     * void IMU_APP_ReportHousekeeping( const CFE_SB_CmdHdr_t *Msg ) statistics
+     */
+    bcm2835_i2c_sched_stats_t  I2CStats;
+    bcm2835_i2c_device_stats_t DevStats;
+
+    memset(&I2CStats, 0, sizeof(I2CStats));
+    I2CStats.DeadlineMisses = 3;
+    UT_SetDataBuffer(UT_KEY(bcm2835_i2c_sched_get_stats), &I2CStats, sizeof(I2CStats), false);
+
+    memset(&DevStats, 0, sizeof(DevStats));
+    DevStats.Errors       = 2;
+    DevStats.Transactions = 40;
+    UT_SetDataBuffer(UT_KEY(mpu9dof_get_i2c_stats), &DevStats, sizeof(DevStats), false);
+
+    /* Counters of the acquisition task */
+    IMU_APP_Data.SamplesAcquired = 20;
+    IMU_APP_Data.SamplesMissed   = 4;
+    IMU_APP_Data.SamplesBusBusy  = 1;
+    IMU_APP_Data.SamplesFailed   = 2;
+
+    IMU_APP_Data.BatchesSent     = 6;
+    IMU_APP_Data.BatchesLost     = 1;
+
+    UT_TEST_FUNCTION_RC(IMU_APP_ReportHousekeeping(NULL), CFE_SUCCESS);
+
+    UtAssert_True(UT_GetStubCount(UT_KEY(CFE_SB_TransmitMsg)) == 2, "CFE_SB_TransmitMsg() called twice");
+    UtAssert_True(IMU_APP_Data.HkTlm.Payload.SamplesAcquired == 20 && IMU_APP_Data.HkTlm.Payload.SamplesMissed == 4 &&
+                      IMU_APP_Data.HkTlm.Payload.SamplesBusBusy == 1 && IMU_APP_Data.HkTlm.Payload.SamplesFailed == 2,
+                  "sample counters reported");
+    UtAssert_True(IMU_APP_Data.HkTlm.Payload.I2CDeadlineMisses == 3,
+                  "IMU_APP_Data.HkTlm.Payload.I2CDeadlineMisses (%u) == 3",
+                  (unsigned int)IMU_APP_Data.HkTlm.Payload.I2CDeadlineMisses);
+    UtAssert_True(IMU_APP_Data.HkTlm.Payload.I2CErrors == 2 && IMU_APP_Data.HkTlm.Payload.I2CTransactions == 40,
+                  "I2C device statistics reported (%u, %lu)", (unsigned int)IMU_APP_Data.HkTlm.Payload.I2CErrors,
+                  (unsigned long)IMU_APP_Data.HkTlm.Payload.I2CTransactions);
+    UtAssert_True(IMU_APP_Data.HkTlm.Payload.BatchesSent == 6 && IMU_APP_Data.HkTlm.Payload.BatchesLost == 1,
+                  "batch counters reported (%lu, %lu)", (unsigned long)IMU_APP_Data.HkTlm.Payload.BatchesSent,
+                  (unsigned long)IMU_APP_Data.HkTlm.Payload.BatchesLost);
 }
 
 void Test_IMU_APP_NoopCmd(void)
@@ -467,8 +693,12 @@ void Test_IMU_APP_ResetCounters(void)
 
     UT_CheckEvent_Setup(&EventTest, IMU_APP_COMMANDRST_INF_EID, "IMU: RESET command");
 
+    IMU_APP_Data.AcqResetCounters = false;
     UT_TEST_FUNCTION_RC(IMU_APP_ResetCounters(&TestMsg), CFE_SUCCESS);
 
+    /* The sample counters are cleared by the acquisition task */
+    UtAssert_True(IMU_APP_Data.AcqResetCounters, "sample counters reset requested");
+
     /*
      * Confirm that the event was generated
      */
@@ -492,6 +722,7 @@ void Test_IMU_APP_ProcessCC(void)
     /* Provide some table data for the IMU_APP_Process() function to use */
     TestTblData.Int1 = 40;
     TestTblData.Int2 = 50;
+    UT_ClearDefaultReturnValue(UT_KEY(CFE_TBL_GetAddress));
     UT_SetDataBuffer(UT_KEY(CFE_TBL_GetAddress), &TblPtr, sizeof(TblPtr), false);
     UT_TEST_FUNCTION_RC(IMU_APP_Process(&TestMsg), CFE_SUCCESS);
 
@@ -500,12 +731,6 @@ void Test_IMU_APP_ProcessCC(void)
      */
     UtAssert_True(UT_GetStubCount(UT_KEY(CFE_TBL_GetAddress)) == 1, "CFE_TBL_GetAddress() called");
 
-    /*
-     * Confirm that the IMU_LIB_Function() call was done
-     * NOTE: This stub is provided by the IMU_lib library
-     */
-    UtAssert_True(UT_GetStubCount(UT_KEY(IMU_LIB_Function)) == 1, "IMU_LIB_Function() called");
-
     /*
      * Configure the CFE_TBL_GetAddress function to return an error
      * Exercise the error return path
@@ -514,6 +739,418 @@ void Test_IMU_APP_ProcessCC(void)
     UT_TEST_FUNCTION_RC(IMU_APP_Process(&TestMsg), CFE_TBL_ERR_UNREGISTERED);
 }
 
+void Test_IMU_APP_TraceDump(void)
+{
+    /*
+     * Test Case For:
+     * int32 IMU_APP_TraceDump( const IMU_APP_TraceDumpCmd_t *Msg )
+     */
+    IMU_APP_TraceDumpCmd_t TestMsg;
+    UT_CheckEvent_t        EventTest;
+
+    memset(&TestMsg, 0, sizeof(TestMsg));
+    IMU_APP_Data.CmdCounter = 0;
+    IMU_APP_Data.ErrCounter = 0;
+
+    UT_CheckEvent_Setup(&EventTest, IMU_APP_TRACE_INF_EID, NULL);
+    UT_SetDefaultReturnValue(UT_KEY(bcm2835_trace_dump), 3);
+    UT_TEST_FUNCTION_RC(IMU_APP_TraceDump(&TestMsg), CFE_SUCCESS);
+    UtAssert_True(EventTest.MatchCount == 1, "IMU_APP_TRACE_INF_EID generated (%u)",
+                  (unsigned int)EventTest.MatchCount);
+    UtAssert_True(IMU_APP_Data.CmdCounter == 1, "IMU_APP_Data.CmdCounter (%u) == 1",
+                  (unsigned int)IMU_APP_Data.CmdCounter);
+
+    UT_CheckEvent_Setup(&EventTest, IMU_APP_TRACE_ERR_EID, NULL);
+    UT_SetDefaultReturnValue(UT_KEY(bcm2835_trace_dump), -1);
+    UT_TEST_FUNCTION_RC(IMU_APP_TraceDump(&TestMsg), CFE_STATUS_EXTERNAL_RESOURCE_FAIL);
+    UtAssert_True(EventTest.MatchCount == 1, "IMU_APP_TRACE_ERR_EID generated (%u)",
+                  (unsigned int)EventTest.MatchCount);
+    UtAssert_True(IMU_APP_Data.ErrCounter == 1, "IMU_APP_Data.ErrCounter (%u) == 1",
+                  (unsigned int)IMU_APP_Data.ErrCounter);
+}
+
+void Test_IMU_APP_TraceReplay(void)
+{
+    /*
+     * Test Case For:
+     * int32 IMU_APP_TraceReplay( const IMU_APP_TraceReplayCmd_t *Msg )
+     */
+    IMU_APP_TraceReplayCmd_t TestMsg;
+    UT_CheckEvent_t          EventTest;
+
+    memset(&TestMsg, 0, sizeof(TestMsg));
+    IMU_APP_Data.CmdCounter = 0;
+    IMU_APP_Data.ErrCounter = 0;
+
+    UT_CheckEvent_Setup(&EventTest, IMU_APP_TRACE_INF_EID, NULL);
+    UT_SetDefaultReturnValue(UT_KEY(bcm2835_trace_replay_load), 3);
+    UT_TEST_FUNCTION_RC(IMU_APP_TraceReplay(&TestMsg), CFE_SUCCESS);
+    UtAssert_True(EventTest.MatchCount == 1, "IMU_APP_TRACE_INF_EID generated (%u)",
+                  (unsigned int)EventTest.MatchCount);
+    UtAssert_True(IMU_APP_Data.CmdCounter == 1, "IMU_APP_Data.CmdCounter (%u) == 1",
+                  (unsigned int)IMU_APP_Data.CmdCounter);
+
+    UT_CheckEvent_Setup(&EventTest, IMU_APP_TRACE_ERR_EID, NULL);
+    UT_SetDefaultReturnValue(UT_KEY(bcm2835_trace_replay_load), -1);
+    UT_TEST_FUNCTION_RC(IMU_APP_TraceReplay(&TestMsg), CFE_STATUS_EXTERNAL_RESOURCE_FAIL);
+    UtAssert_True(EventTest.MatchCount == 1, "IMU_APP_TRACE_ERR_EID generated (%u)",
+                  (unsigned int)EventTest.MatchCount);
+    UtAssert_True(IMU_APP_Data.ErrCounter == 1, "IMU_APP_Data.ErrCounter (%u) == 1",
+                  (unsigned int)IMU_APP_Data.ErrCounter);
+}
+
+void Test_IMU_APP_AcqTask(void)
+{
+    /*
+     * Test Case For:
+     * void IMU_APP_AcqTask( void )
+     */
+    union
+    {
+        CFE_SB_Buffer_t SBBuf;
+        uint8           Bytes[IMU_APP_BATCH_SIZE(IMU_APP_BATCH_DEF, IMU_APP_BATCH_CHANNELS_MAX)];
+    } TestBuf[2];
+    CFE_SB_Buffer_t *BufPtr[2] = {&TestBuf[0].SBBuf, &TestBuf[1].SBBuf};
+
+    /* an unregistered task exits at once */
+    UT_SetDeferredRetcode(UT_KEY(CFE_ES_RegisterChildTask), 1, CFE_ES_ERR_RESOURCEID_NOT_VALID);
+    IMU_APP_AcqTask();
+    UtAssert_True(UT_GetStubCount(UT_KEY(CFE_ES_ExitChildTask)) == 1, "CFE_ES_ExitChildTask() called");
+    UtAssert_True(UT_GetStubCount(UT_KEY(bcm2835_periodic_init)) == 0, "bcm2835_periodic_init() not called");
+    UtAssert_True(UT_GetStubCount(UT_KEY(bcm2835_sb_pool_fill)) == 0, "bcm2835_sb_pool_fill() not called");
+
+    /* two periods, the first one late by two periods, the second one at a new rate and content */
+    IMU_APP_Data.RunStatus        = CFE_ES_RunStatus_APP_RUN;
+    IMU_APP_Data.SampleRateHz     = IMU_APP_SAMPLE_RATE_DEF;
+    IMU_APP_Data.Content          = IMU_APP_CONTENT_DEF;
+    IMU_APP_Data.AcqPlan.Content  = 0;
+    IMU_APP_Data.RingHead         = 0;
+    IMU_APP_Data.SamplesAcquired  = 5;
+    IMU_APP_Data.SamplesMissed    = 5;
+    IMU_APP_Data.SamplesFailed    = 5;
+    IMU_APP_Data.BatchesSent      = 5;
+    IMU_APP_Data.BatchesLost      = 5;
+    IMU_APP_Data.AcqResetCounters = true;
+    IMU_APP_Data.SamplesPerBatch  = IMU_APP_BATCH_DEF;
+    IMU_APP_Data.Batch            = NULL;
+    UT_SetDataBuffer(UT_KEY(bcm2835_sb_pool_get), BufPtr, sizeof(BufPtr), false);
+    UT_SetDeferredRetcode(UT_KEY(bcm2835_periodic_wait), 1, 2);
+    UT_SetHookFunction(UT_KEY(bcm2835_periodic_wait), UT_Imu_AcqWaitHook, NULL);
+
+    IMU_APP_AcqTask();
+
+    UtAssert_True(UT_GetStubCount(UT_KEY(bcm2835_periodic_init)) == 2, "bcm2835_periodic_init() called per rate");
+    UtAssert_True(UT_GetStubCount(UT_KEY(mpu9dof_read_burst)) == 2, "one sample per period");
+    UtAssert_True(IMU_APP_Data.SamplesAcquired == 2, "IMU_APP_Data.SamplesAcquired (%lu) == 2",
+                  (unsigned long)IMU_APP_Data.SamplesAcquired);
+    UtAssert_True(IMU_APP_Data.SamplesMissed == 2, "IMU_APP_Data.SamplesMissed (%lu) == 2",
+                  (unsigned long)IMU_APP_Data.SamplesMissed);
+    UtAssert_True(!IMU_APP_Data.AcqResetCounters, "counters reset done");
+    UtAssert_True(IMU_APP_Data.SamplesFailed == 0 && IMU_APP_Data.BatchesSent == 0, "other counters reset");
+
+    /* the batch of the old content is dropped when the plan is compiled again */
+    UtAssert_True(IMU_APP_Data.AcqPlan.Content == IMU_APP_CONTENT_ACCEL, "plan of the new content");
+    UtAssert_True(IMU_APP_Data.BatchesLost == 1, "IMU_APP_Data.BatchesLost (%lu) == 1",
+                  (unsigned long)IMU_APP_Data.BatchesLost);
+
+    /* the pool is set up for the largest batch, and returned with the unsent batch */
+    UtAssert_True(UT_GetStubCount(UT_KEY(bcm2835_sb_pool_init)) == 1, "bcm2835_sb_pool_init() called");
+    UtAssert_True(UT_GetStubCount(UT_KEY(bcm2835_sb_pool_drain)) == 1, "bcm2835_sb_pool_drain() called");
+    UtAssert_True(UT_GetStubCount(UT_KEY(CFE_SB_ReleaseMessageBuffer)) == 2, "old and unsent batches released");
+    UtAssert_True(IMU_APP_Data.Batch == NULL, "no batch");
+    UtAssert_True(UT_GetStubCount(UT_KEY(CFE_ES_ExitChildTask)) == 2, "CFE_ES_ExitChildTask() called");
+}
+
+void Test_IMU_APP_AcqSample(void)
+{
+    /*
+     * Test Case For:
+     * void IMU_APP_AcqSample( uint32 TimeoutMs )
+     */
+    /* Accel, temperature and gyro registers, big endian */
+    uint8            Burst[14] = {0xFF, 0xFE, 0, 2, 0, 3, 0, 40, 0, 4, 0, 5, 0, 6};
+    int16_t          Mag[3]    = {7, 8, 9};
+    IMU_APP_Sample_t Cached;
+
+    IMU_APP_Data.SampleRateHz    = IMU_APP_SAMPLE_RATE_DEF;
+    IMU_APP_Data.AcqCycles       = IMU_APP_SAMPLE_RATE_DEF - 1;
+    IMU_APP_Data.RingHead        = 0;
+    IMU_APP_Data.SamplesAcquired = 0;
+    IMU_APP_Data.SamplesBusBusy  = 0;
+    IMU_APP_Data.SamplesFailed   = 0;
+    IMU_APP_Data.SamplesPerBatch = IMU_APP_BATCH_DEF;
+    IMU_APP_Data.Ring[0].Seq     = 99;
+    IMU_APP_Data.Batch           = NULL;
+    IMU_APP_StatsInit();
+    IMU_APP_AcqCompile(IMU_APP_CONTENT_ACCEL | IMU_APP_CONTENT_GYRO | IMU_APP_CONTENT_MAG | IMU_APP_CONTENT_TEMP,
+                       &IMU_APP_Data.AcqPlan);
+
+    /* nominal case with a new mag measurement, the sample is kept and added to a batch */
+    UT_SetDataBuffer(UT_KEY(mpu9dof_read_burst), Burst, sizeof(Burst), false);
+    UT_SetDeferredRetcode(UT_KEY(mpu9dof_read_mag_ready), 1, 1);
+    UT_SetDataBuffer(UT_KEY(mpu9dof_read_mag_ready), Mag, sizeof(Mag), false);
+    UT_SetDataBuffer(UT_KEY(bcm2835_seqlock_write), &Cached, sizeof(Cached), false);
+    IMU_APP_AcqSample(10);
+    UtAssert_True(IMU_APP_Data.RingHead == 1 && IMU_APP_Data.Ring[0].Seq == 0, "sample 0 in the ring");
+    UtAssert_True(IMU_APP_Data.Ring[0].Accel_x == -2 && IMU_APP_Data.Ring[0].Temp == 40 &&
+                      IMU_APP_Data.Ring[0].Gyro_z == 6,
+                  "motion values of the burst");
+    UtAssert_True(IMU_APP_Data.Ring[0].Content == IMU_APP_Data.AcqPlan.Reads, "content of the sample");
+    UtAssert_True(Cached.Seq == 0 && Cached.Accel_x == -2, "sample published to the cache");
+    UtAssert_True(IMU_APP_Data.Ring[0].Mag_x == 7 && IMU_APP_Data.Ring[0].Flags == IMU_APP_SAMPLE_MAG_NEW,
+                  "new mag measurement");
+    UtAssert_True(IMU_APP_Data.SamplesAcquired == 1, "IMU_APP_Data.SamplesAcquired (%lu) == 1",
+                  (unsigned long)IMU_APP_Data.SamplesAcquired);
+    UtAssert_True(UT_GetStubCount(UT_KEY(bcm2835_i2c_sched_release)) == 1, "bcm2835_i2c_sched_release() called");
+    UtAssert_True(UT_GetStubCount(UT_KEY(bcm2835_sb_pool_get)) == 1, "bcm2835_sb_pool_get() called");
+    UtAssert_True(UT_GetStubCount(UT_KEY(mpu9dof_revalidate_i2c)) == 1, "mpu9dof_revalidate_i2c() called");
+
+    /* the clock is checked once a second only, the mag keeps its last measurement */
+    IMU_APP_AcqSample(10);
+    UtAssert_True(IMU_APP_Data.RingHead == 2 && IMU_APP_Data.Ring[1].Seq == 1, "sample 1 in the ring");
+    UtAssert_True(IMU_APP_Data.Ring[1].Mag_x == 7 && IMU_APP_Data.Ring[1].Flags == 0, "no new mag measurement");
+    UtAssert_True(UT_GetStubCount(UT_KEY(mpu9dof_revalidate_i2c)) == 1, "mpu9dof_revalidate_i2c() called once");
+
+    /* a failed read is counted and not kept */
+    UT_SetDeferredRetcode(UT_KEY(mpu9dof_read_burst), 1, BCM2835_I2C_REASON_ERROR_NACK);
+    IMU_APP_AcqSample(10);
+    UtAssert_True(IMU_APP_Data.RingHead == 2, "no sample in the ring");
+    UtAssert_True(UT_GetStubCount(UT_KEY(bcm2835_seqlock_write)) == 2, "bcm2835_seqlock_write() not called");
+    UtAssert_True(IMU_APP_Data.SamplesFailed == 1, "IMU_APP_Data.SamplesFailed (%lu) == 1",
+                  (unsigned long)IMU_APP_Data.SamplesFailed);
+    UtAssert_True(UT_GetStubCount(UT_KEY(mpu9dof_read_mag_ready)) == 2, "mpu9dof_read_mag_ready() not called");
+    UtAssert_True(UT_GetStubCount(UT_KEY(bcm2835_i2c_sched_release)) == 3, "bcm2835_i2c_sched_release() called");
+
+    /* without the bus the sample is counted as busy */
+    UT_SetDeferredRetcode(UT_KEY(bcm2835_i2c_sched_acquire), 1, BCM2835_I2C_SCHED_ERR_TIMEOUT);
+    IMU_APP_AcqSample(10);
+    UtAssert_True(IMU_APP_Data.RingHead == 2, "no sample in the ring");
+    UtAssert_True(IMU_APP_Data.SamplesBusBusy == 1, "IMU_APP_Data.SamplesBusBusy (%lu) == 1",
+                  (unsigned long)IMU_APP_Data.SamplesBusBusy);
+    UtAssert_True(UT_GetStubCount(UT_KEY(bcm2835_i2c_sched_release)) == 3, "bcm2835_i2c_sched_release() not called");
+    UtAssert_True(UT_GetStubCount(UT_KEY(bcm2835_sb_pool_get)) == 2, "bcm2835_sb_pool_get() not called");
+
+    /* the sensors outside the plan are not read and are 0 */
+    IMU_APP_AcqCompile(IMU_APP_CONTENT_ACCEL, &IMU_APP_Data.AcqPlan);
+    UT_SetDataBuffer(UT_KEY(mpu9dof_read_burst), Burst, 6, false);
+    IMU_APP_AcqSample(10);
+    UtAssert_True(IMU_APP_Data.RingHead == 3 && IMU_APP_Data.Ring[2].Accel_x == -2, "accel sample in the ring");
+    UtAssert_True(IMU_APP_Data.Ring[2].Gyro_z == 0 && IMU_APP_Data.Ring[2].Temp == 0 &&
+                      IMU_APP_Data.Ring[2].Mag_x == 0,
+                  "other values 0");
+    UtAssert_True(UT_GetStubCount(UT_KEY(mpu9dof_read_mag_ready)) == 2, "mpu9dof_read_mag_ready() not called");
+
+    IMU_APP_AcqCompile(IMU_APP_CONTENT_MAG, &IMU_APP_Data.AcqPlan);
+    IMU_APP_AcqSample(10);
+    UtAssert_True(IMU_APP_Data.RingHead == 4 && IMU_APP_Data.Ring[3].Mag_x == 7, "mag sample in the ring");
+    UtAssert_True(UT_GetStubCount(UT_KEY(mpu9dof_read_burst)) == 4, "mpu9dof_read_burst() not called");
+    UtAssert_True(UT_GetStubCount(UT_KEY(mpu9dof_read_mag_ready)) == 3, "mpu9dof_read_mag_ready() called");
+}
+
+void Test_IMU_APP_AcqCompile(void)
+{
+    /*
+     * Test Case For:
+     * void IMU_APP_AcqCompile( uint16 Content, IMU_APP_AcqPlan_t *Plan )
+     */
+    IMU_APP_AcqPlan_t Plan;
+
+    /* accel only, a 6 register burst */
+    IMU_APP_AcqCompile(IMU_APP_CONTENT_ACCEL, &Plan);
+    UtAssert_True(Plan.MotionReg == MPU9DOF_ACCEL_XOUT_H, "ACCEL: MotionReg (0x%02X) == MPU9DOF_ACCEL_XOUT_H",
+                  (unsigned int)Plan.MotionReg);
+    UtAssert_True(Plan.MotionLen == 6, "ACCEL: MotionLen (%u) == 6", (unsigned int)Plan.MotionLen);
+    UtAssert_True(!Plan.ReadMag, "ACCEL: magnetometer not read");
+
+    /* accel and gyro, one burst over the temperature in between */
+    IMU_APP_AcqCompile(IMU_APP_CONTENT_ACCEL | IMU_APP_CONTENT_GYRO, &Plan);
+    UtAssert_True(Plan.MotionReg == MPU9DOF_ACCEL_XOUT_H, "ACCEL|GYRO: MotionReg (0x%02X) == MPU9DOF_ACCEL_XOUT_H",
+                  (unsigned int)Plan.MotionReg);
+    UtAssert_True(Plan.MotionLen == 14, "ACCEL|GYRO: MotionLen (%u) == 14", (unsigned int)Plan.MotionLen);
+
+    /* temperature and gyro, the burst starts at the temperature */
+    IMU_APP_AcqCompile(IMU_APP_CONTENT_GYRO | IMU_APP_CONTENT_TEMP, &Plan);
+    UtAssert_True(Plan.MotionReg == MPU9DOF_TEMP_OUT_H, "GYRO|TEMP: MotionReg (0x%02X) == MPU9DOF_TEMP_OUT_H",
+                  (unsigned int)Plan.MotionReg);
+    UtAssert_True(Plan.MotionLen == 8, "GYRO|TEMP: MotionLen (%u) == 8", (unsigned int)Plan.MotionLen);
+
+    /* magnetometer only, no burst */
+    IMU_APP_AcqCompile(IMU_APP_CONTENT_MAG, &Plan);
+    UtAssert_True(Plan.MotionLen == 0, "MAG: MotionLen (%u) == 0", (unsigned int)Plan.MotionLen);
+    UtAssert_True(Plan.ReadMag, "MAG: magnetometer read");
+
+    /* attitude reads the accelerometer and magnetometer, but only reports the angles */
+    IMU_APP_AcqCompile(IMU_APP_CONTENT_ATTITUDE, &Plan);
+    UtAssert_True(Plan.Content == IMU_APP_CONTENT_ATTITUDE, "ATTITUDE: Content (0x%04X) == ATTITUDE",
+                  (unsigned int)Plan.Content);
+    UtAssert_True(Plan.Reads == (IMU_APP_CONTENT_ATTITUDE | IMU_APP_CONTENT_ACCEL | IMU_APP_CONTENT_MAG),
+                  "ATTITUDE: Reads (0x%04X) == ATTITUDE|ACCEL|MAG", (unsigned int)Plan.Reads);
+    UtAssert_True(Plan.MotionLen == 6, "ATTITUDE: MotionLen (%u) == 6", (unsigned int)Plan.MotionLen);
+    UtAssert_True(Plan.ReadMag, "ATTITUDE: magnetometer read");
+
+    /* the pool buffers must fit a batch of all the content */
+    UtAssert_True(IMU_APP_BATCH_CHANNELS(IMU_APP_CONTENT_ALL) == IMU_APP_BATCH_CHANNELS_MAX,
+                  "IMU_APP_BATCH_CHANNELS(IMU_APP_CONTENT_ALL) (%u) == IMU_APP_BATCH_CHANNELS_MAX",
+                  (unsigned int)IMU_APP_BATCH_CHANNELS(IMU_APP_CONTENT_ALL));
+}
+
+void Test_IMU_APP_AcqAttitude(void)
+{
+    /*
+     * Test Case For:
+     * void IMU_APP_AcqAttitude( IMU_APP_Sample_t *Sample )
+     */
+    IMU_APP_Sample_t Sample;
+
+    /* level, with the magnetic field along the accel X axis (mag Y) */
+    memset(&Sample, 0, sizeof(Sample));
+    Sample.Content = IMU_APP_CONTENT_ATTITUDE;
+    Sample.Accel_z = 1000;
+    Sample.Mag_y   = 100;
+    IMU_APP_AcqAttitude(&Sample);
+    UtAssert_True(Sample.Roll == 0 && Sample.Pitch == 0 && Sample.Heading == 0, "level, heading north (%d, %d, %d)",
+                  (int)Sample.Roll, (int)Sample.Pitch, (int)Sample.Heading);
+
+    /* the field along the accel Y axis (mag X) is a quarter turn */
+    Sample.Mag_x = 100;
+    Sample.Mag_y = 0;
+    IMU_APP_AcqAttitude(&Sample);
+    UtAssert_True(Sample.Heading == -16384, "Heading (%d) == -16384", (int)Sample.Heading);
+
+    /* rolled on its side, then upside down where +180 degrees saturates */
+    Sample.Accel_y = 1000;
+    Sample.Accel_z = 0;
+    IMU_APP_AcqAttitude(&Sample);
+    UtAssert_True(Sample.Roll == 16384 && Sample.Pitch == 0, "Roll (%d) == 16384", (int)Sample.Roll);
+
+    Sample.Accel_y = 0;
+    Sample.Accel_z = -1000;
+    IMU_APP_AcqAttitude(&Sample);
+    UtAssert_True(Sample.Roll == 32767, "Roll (%d) == 32767", (int)Sample.Roll);
+
+    /* no angles without ATTITUDE in the content */
+    Sample.Content = IMU_APP_CONTENT_ACCEL | IMU_APP_CONTENT_MAG;
+    IMU_APP_AcqAttitude(&Sample);
+    UtAssert_True(Sample.Roll == 0 && Sample.Pitch == 0 && Sample.Heading == 0, "angles 0");
+}
+
+void Test_IMU_APP_CacheGet(void)
+{
+    /*
+     * Test Case For:
+     * bool IMU_APP_CacheGet( IMU_APP_Sample_t *Sample, uint32 *AgeMs )
+     */
+    IMU_APP_Sample_t Cached;
+    IMU_APP_Sample_t Sample;
+    uint32           AgeMs = 0;
+
+    /* no sample yet */
+    UtAssert_True(!IMU_APP_CacheGet(&Sample, &AgeMs), "no sample in the cache");
+    UtAssert_True(AgeMs == 0, "no age");
+
+    /* the copy of the cache and its age */
+    memset(&Cached, 0, sizeof(Cached));
+    Cached.Seq = 42;
+    UT_SetDeferredRetcode(UT_KEY(bcm2835_seqlock_read), 1, 1);
+    UT_SetDataBuffer(UT_KEY(bcm2835_seqlock_read), &Cached, sizeof(Cached), false);
+    UT_SetDeferredRetcode(UT_KEY(CFE_TIME_Sub2MicroSecs), 1, 2500);
+    UtAssert_True(IMU_APP_CacheGet(&Sample, &AgeMs), "sample in the cache");
+    UtAssert_True(Sample.Seq == 42, "Sample.Seq (%lu) == 42", (unsigned long)Sample.Seq);
+    UtAssert_True(AgeMs == 2, "AgeMs (%lu) == 2", (unsigned long)AgeMs);
+}
+
+void Test_IMU_APP_BatchAdd(void)
+{
+    /*
+     * Test Case For:
+     * void IMU_APP_BatchAdd( const IMU_APP_Sample_t *Sample )
+     */
+    union
+    {
+        CFE_SB_Buffer_t    SBBuf;
+        IMU_APP_BatchTlm_t Batch;
+        uint8              Bytes[IMU_APP_BATCH_SIZE(2, 4)];
+    } TestBuf;
+    CFE_SB_Buffer_t *BufPtr      = &TestBuf.SBBuf;
+    const uint32 *   DeltaUs     = (const uint32 *)(&TestBuf.Batch + 1);
+    const int16_t *  Value       = (const int16_t *)(DeltaUs + 2);
+    const int16_t    Expected[8] = {1, 11, 2, 12, 3, 13, 4, 14};
+    IMU_APP_Sample_t Sample;
+    uint16           i;
+
+    memset(&TestBuf, 0, sizeof(TestBuf));
+    memset(&Sample, 0, sizeof(Sample));
+
+    IMU_APP_Data.Batch           = NULL;
+    IMU_APP_Data.SamplesPerBatch = 2;
+    IMU_APP_Data.SampleRateHz    = IMU_APP_SAMPLE_RATE_DEF;
+    IMU_APP_Data.BatchesSent     = 0;
+    IMU_APP_Data.BatchesLost     = 0;
+    IMU_APP_AcqCompile(IMU_APP_CONTENT_ACCEL | IMU_APP_CONTENT_TEMP, &IMU_APP_Data.AcqPlan);
+
+    /* no buffer in the pool nor SB memory, the sample is dropped with its batch */
+    IMU_APP_BatchAdd(&Sample);
+    UtAssert_True(IMU_APP_Data.Batch == NULL, "no batch");
+    UtAssert_True(IMU_APP_Data.BatchesLost == 1, "IMU_APP_Data.BatchesLost (%lu) == 1",
+                  (unsigned long)IMU_APP_Data.BatchesLost);
+
+    /* a batch of 2 samples of the accel and temperature */
+    UT_SetDataBuffer(UT_KEY(bcm2835_sb_pool_get), &BufPtr, sizeof(BufPtr), false);
+
+    Sample.Seq     = 7;
+    Sample.Accel_x = 1;
+    Sample.Accel_y = 2;
+    Sample.Accel_z = 3;
+    Sample.Temp    = 4;
+    Sample.Gyro_z  = 6;
+    IMU_APP_BatchAdd(&Sample);
+
+    UtAssert_True(IMU_APP_Data.Batch == &TestBuf.SBBuf, "batch allocated");
+    UtAssert_True(TestBuf.Batch.Payload.Count == 2, "Payload.Count (%u) == 2",
+                  (unsigned int)TestBuf.Batch.Payload.Count);
+    UtAssert_True(TestBuf.Batch.Payload.FirstSeq == 7, "Payload.FirstSeq (%lu) == 7",
+                  (unsigned long)TestBuf.Batch.Payload.FirstSeq);
+    UtAssert_True(TestBuf.Batch.Payload.RateHz == IMU_APP_SAMPLE_RATE_DEF, "Payload.RateHz (%u)",
+                  (unsigned int)TestBuf.Batch.Payload.RateHz);
+    UtAssert_True(TestBuf.Batch.Payload.Content == (IMU_APP_CONTENT_ACCEL | IMU_APP_CONTENT_TEMP),
+                  "Payload.Content (0x%04X) == ACCEL|TEMP", (unsigned int)TestBuf.Batch.Payload.Content);
+    UtAssert_True(UT_GetStubCount(UT_KEY(CFE_SB_TransmitBuffer)) == 0, "CFE_SB_TransmitBuffer() not called");
+
+    Sample.Seq     = 8;
+    Sample.Accel_x = 11;
+    Sample.Accel_y = 12;
+    Sample.Accel_z = 13;
+    Sample.Temp    = 14;
+    Sample.Gyro_z  = 16;
+    UT_SetDeferredRetcode(UT_KEY(CFE_TIME_Sub2MicroSecs), 1, 5000);
+    IMU_APP_BatchAdd(&Sample);
+
+    UtAssert_True(UT_GetStubCount(UT_KEY(CFE_SB_TransmitBuffer)) == 1, "CFE_SB_TransmitBuffer() called");
+    UtAssert_True(IMU_APP_Data.BatchesSent == 1, "IMU_APP_Data.BatchesSent (%lu) == 1",
+                  (unsigned long)IMU_APP_Data.BatchesSent);
+    UtAssert_True(IMU_APP_Data.Batch == NULL, "batch handed to SB");
+    UtAssert_True(UT_GetStubCount(UT_KEY(bcm2835_sb_pool_fill)) == 1, "bcm2835_sb_pool_fill() called");
+    UtAssert_True(DeltaUs[0] == 0 && DeltaUs[1] == 5000, "time deltas (%lu, %lu)", (unsigned long)DeltaUs[0],
+                  (unsigned long)DeltaUs[1]);
+
+    /* each channel is an array of Count values, in the order of the content bits */
+    for (i = 0; i < 8; i++)
+    {
+        UtAssert_True(Value[i] == Expected[i], "Value[%u] (%d) == %d", (unsigned int)i, (int)Value[i],
+                      (int)Expected[i]);
+    }
+
+    /* a batch SB does not take is released and counted as lost */
+    UT_SetDataBuffer(UT_KEY(bcm2835_sb_pool_get), &BufPtr, sizeof(BufPtr), false);
+    UT_SetDeferredRetcode(UT_KEY(CFE_SB_TransmitBuffer), 1, CFE_SB_BAD_ARGUMENT);
+    IMU_APP_BatchAdd(&Sample);
+    IMU_APP_BatchAdd(&Sample);
+    UtAssert_True(UT_GetStubCount(UT_KEY(CFE_SB_ReleaseMessageBuffer)) == 1, "CFE_SB_ReleaseMessageBuffer() called");
+    UtAssert_True(IMU_APP_Data.BatchesLost == 2, "IMU_APP_Data.BatchesLost (%lu) == 2",
+                  (unsigned long)IMU_APP_Data.BatchesLost);
+    UtAssert_True(IMU_APP_Data.Batch == NULL, "no batch");
+}
+
 void Test_IMU_APP_VerifyCmdLength(void)
 {
     /*
@@ -529,8 +1166,8 @@ void Test_IMU_APP_VerifyCmdLength(void)
      * test a match case
      */
     UT_SetDataBuffer(UT_KEY(CFE_MSG_GetSize), &size, sizeof(size), false);
-    UT_CheckEvent_Setup(&EventTest, IMU_APP_LEN_ERR_EID,
-                        "Invalid Msg length: ID = 0x%X,  CC = %u, Len = %u, Expected = %u");
+    UT_CheckLimitedEvent_Setup(&EventTest, IMU_APP_LEN_ERR_EID,
+                               "Invalid Msg length: ID = 0x%X,  CC = %u, Len = %u, Expected = %u");
 
     IMU_APP_VerifyCmdLength(NULL, size);
 
@@ -563,14 +1200,99 @@ void Test_IMU_APP_TblValidationFunc(void)
      */
     IMU_APP_Table_t TestTblData;
 
-    memset(&TestTblData, 0, sizeof(TestTblData));
-
-    /* nominal case (0) should succeed */
+    /* nominal case should succeed */
+    UT_Imu_ValidTable(&TestTblData);
     UT_TEST_FUNCTION_RC(IMU_APP_TblValidationFunc(&TestTblData), CFE_SUCCESS);
 
-    /* error case should return IMU_APP_TABLE_OUT_OF_RANGE_ERR_CODE */
+    /* error cases should return IMU_APP_TABLE_OUT_OF_RANGE_ERR_CODE */
     TestTblData.Int1 = 1 + IMU_APP_TBL_ELEMENT_1_MAX;
     UT_TEST_FUNCTION_RC(IMU_APP_TblValidationFunc(&TestTblData), IMU_APP_TABLE_OUT_OF_RANGE_ERR_CODE);
+
+    UT_Imu_ValidTable(&TestTblData);
+    TestTblData.SampleRateHz = IMU_APP_SAMPLE_RATE_MIN - 1;
+    UT_TEST_FUNCTION_RC(IMU_APP_TblValidationFunc(&TestTblData), IMU_APP_TABLE_OUT_OF_RANGE_ERR_CODE);
+    TestTblData.SampleRateHz = IMU_APP_SAMPLE_RATE_MAX + 1;
+    UT_TEST_FUNCTION_RC(IMU_APP_TblValidationFunc(&TestTblData), IMU_APP_TABLE_OUT_OF_RANGE_ERR_CODE);
+
+    UT_Imu_ValidTable(&TestTblData);
+    TestTblData.SamplesPerBatch = 0;
+    UT_TEST_FUNCTION_RC(IMU_APP_TblValidationFunc(&TestTblData), IMU_APP_TABLE_OUT_OF_RANGE_ERR_CODE);
+    TestTblData.SamplesPerBatch = IMU_APP_BATCH_MAX + 1;
+    UT_TEST_FUNCTION_RC(IMU_APP_TblValidationFunc(&TestTblData), IMU_APP_TABLE_OUT_OF_RANGE_ERR_CODE);
+
+    /* the content mask must select something, and only known bits */
+    UT_Imu_ValidTable(&TestTblData);
+    TestTblData.Content = 0;
+    UT_TEST_FUNCTION_RC(IMU_APP_TblValidationFunc(&TestTblData), IMU_APP_TABLE_OUT_OF_RANGE_ERR_CODE);
+    TestTblData.Content = IMU_APP_CONTENT_ALL + 1;
+    UT_TEST_FUNCTION_RC(IMU_APP_TblValidationFunc(&TestTblData), IMU_APP_TABLE_OUT_OF_RANGE_ERR_CODE);
+    TestTblData.Content = IMU_APP_CONTENT_ALL;
+    UT_TEST_FUNCTION_RC(IMU_APP_TblValidationFunc(&TestTblData), CFE_SUCCESS);
+
+    /* the spectrum fields are checked by IMU_APP_FftValidTable */
+    UT_Imu_ValidTable(&TestTblData);
+    TestTblData.FftWindow = IMU_APP_FFT_MIN + 1;
+    TestTblData.FftBlocks = 1;
+    UT_TEST_FUNCTION_RC(IMU_APP_TblValidationFunc(&TestTblData), IMU_APP_TABLE_OUT_OF_RANGE_ERR_CODE);
+}
+
+void Test_IMU_APP_LoadAcqConfig(void)
+{
+    /*
+     * Test Case For:
+     * void IMU_APP_LoadAcqConfig( void )
+     */
+    IMU_APP_Table_t TestTblData;
+    void *          TblPtr = &TestTblData;
+
+    /* no table, the defaults are used */
+    IMU_APP_Data.I2CPeriodUs = 0;
+    IMU_APP_LoadAcqConfig();
+    UtAssert_True(IMU_APP_Data.SampleRateHz == IMU_APP_SAMPLE_RATE_DEF,
+                  "IMU_APP_Data.SampleRateHz (%u) == IMU_APP_SAMPLE_RATE_DEF",
+                  (unsigned int)IMU_APP_Data.SampleRateHz);
+    UtAssert_True(IMU_APP_Data.SamplesPerBatch == IMU_APP_BATCH_DEF,
+                  "IMU_APP_Data.SamplesPerBatch (%u) == IMU_APP_BATCH_DEF",
+                  (unsigned int)IMU_APP_Data.SamplesPerBatch);
+    UtAssert_True(IMU_APP_Data.Content == IMU_APP_CONTENT_DEF, "IMU_APP_Data.Content (0x%04X) == IMU_APP_CONTENT_DEF",
+                  (unsigned int)IMU_APP_Data.Content);
+    UtAssert_True(UT_GetStubCount(UT_KEY(CFE_TBL_ReleaseAddress)) == 0, "CFE_TBL_ReleaseAddress() not called");
+    UtAssert_True(UT_GetStubCount(UT_KEY(bcm2835_i2c_sched_set_period)) == 0,
+                  "bcm2835_i2c_sched_set_period() not called before registration");
+
+    /* a new rate in the table updates the scheduler period */
+    UT_Imu_ValidTable(&TestTblData);
+    TestTblData.SampleRateHz    = 200;
+    TestTblData.SamplesPerBatch = 10;
+    TestTblData.Content         = IMU_APP_CONTENT_ALL;
+    IMU_APP_Data.I2CPeriodUs    = 1000000 / IMU_APP_SAMPLE_RATE_DEF;
+    UT_ClearDefaultReturnValue(UT_KEY(CFE_TBL_GetAddress));
+    UT_SetDataBuffer(UT_KEY(CFE_TBL_GetAddress), &TblPtr, sizeof(TblPtr), false);
+    IMU_APP_LoadAcqConfig();
+    UtAssert_True(IMU_APP_Data.SampleRateHz == 200, "IMU_APP_Data.SampleRateHz (%u) == 200",
+                  (unsigned int)IMU_APP_Data.SampleRateHz);
+    UtAssert_True(IMU_APP_Data.SamplesPerBatch == 10, "IMU_APP_Data.SamplesPerBatch (%u) == 10",
+                  (unsigned int)IMU_APP_Data.SamplesPerBatch);
+    UtAssert_True(IMU_APP_Data.Content == IMU_APP_CONTENT_ALL, "IMU_APP_Data.Content (0x%04X) == IMU_APP_CONTENT_ALL",
+                  (unsigned int)IMU_APP_Data.Content);
+    UtAssert_True(UT_GetStubCount(UT_KEY(CFE_TBL_ReleaseAddress)) == 1, "CFE_TBL_ReleaseAddress() called");
+    UtAssert_True(UT_GetStubCount(UT_KEY(bcm2835_i2c_sched_set_period)) == 1, "bcm2835_i2c_sched_set_period() called");
+    UtAssert_True(IMU_APP_Data.I2CPeriodUs == 5000, "IMU_APP_Data.I2CPeriodUs (%lu) == 5000",
+                  (unsigned long)IMU_APP_Data.I2CPeriodUs);
+
+    /* an unchanged period is not set again */
+    UT_SetDataBuffer(UT_KEY(CFE_TBL_GetAddress), &TblPtr, sizeof(TblPtr), false);
+    IMU_APP_LoadAcqConfig();
+    UtAssert_True(UT_GetStubCount(UT_KEY(bcm2835_i2c_sched_set_period)) == 1,
+                  "bcm2835_i2c_sched_set_period() not called again");
+
+    /* the period is kept if the scheduler rejects the new one */
+    TestTblData.SampleRateHz = 500;
+    UT_SetDataBuffer(UT_KEY(CFE_TBL_GetAddress), &TblPtr, sizeof(TblPtr), false);
+    UT_SetDeferredRetcode(UT_KEY(bcm2835_i2c_sched_set_period), 1, BCM2835_I2C_SCHED_ERR_INVALID);
+    IMU_APP_LoadAcqConfig();
+    UtAssert_True(IMU_APP_Data.I2CPeriodUs == 5000, "IMU_APP_Data.I2CPeriodUs (%lu) == 5000",
+                  (unsigned long)IMU_APP_Data.I2CPeriodUs);
 }
 
 void Test_IMU_APP_GetCrc(void)
@@ -604,6 +1326,13 @@ void Test_IMU_APP_GetCrc(void)
 void Imu_UT_Setup(void)
 {
     UT_ResetState(0);
+
+    /*
+     * No table by default: the functions that read it fall back
+     * to the defaults instead of dereferencing the stub address.
+     * The test cases that need a table clear this.
+     */
+    UT_SetDefaultReturnValue(UT_KEY(CFE_TBL_GetAddress), CFE_TBL_ERR_UNREGISTERED);
 }
 
 /*
@@ -621,10 +1350,20 @@ void UtTest_Setup(void)
     ADD_TEST(IMU_APP_ProcessCommandPacket);
     ADD_TEST(IMU_APP_ProcessGroundCommand);
     ADD_TEST(IMU_APP_ReportHousekeeping);
+    ADD_TEST(IMU_APP_ReportHousekeeping_Stats);
     ADD_TEST(IMU_APP_NoopCmd);
     ADD_TEST(IMU_APP_ResetCounters);
     ADD_TEST(IMU_APP_ProcessCC);
+    ADD_TEST(IMU_APP_TraceDump);
+    ADD_TEST(IMU_APP_TraceReplay);
+    ADD_TEST(IMU_APP_AcqTask);
+    ADD_TEST(IMU_APP_AcqSample);
+    ADD_TEST(IMU_APP_AcqCompile);
+    ADD_TEST(IMU_APP_AcqAttitude);
+    ADD_TEST(IMU_APP_CacheGet);
+    ADD_TEST(IMU_APP_BatchAdd);
     ADD_TEST(IMU_APP_VerifyCmdLength);
     ADD_TEST(IMU_APP_TblValidationFunc);
+    ADD_TEST(IMU_APP_LoadAcqConfig);
     ADD_TEST(IMU_APP_GetCrc);
 }
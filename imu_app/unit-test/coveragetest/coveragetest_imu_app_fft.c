@@ -0,0 +1,272 @@
+/*
+**  GSC-18128-1, "Core Flight Executive Version 6.7"
+**
+**  Copyright (c) 2006-2019 United States Government as represented by
+**  the Administrator of the National Aeronautics and Space Administration.
+**  All Rights Reserved.
+**
+**  Licensed under the Apache License, Version 2.0 (the "License");
+**  you may not use this file except in compliance with the License.
+**  You may obtain a copy of the License at
+**
+**    http://www.apache.org/licenses/LICENSE-2.0
+**
+**  Unless required by applicable law or agreed to in writing, software
+**  distributed under the License is distributed on an "AS IS" BASIS,
+**  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**  See the License for the specific language governing permissions and
+**  limitations under the License.
+*/
+
+/*
+** File: coveragetest_imu_app_fft.c
+**
+** Purpose:
+** Coverage Unit Test cases for the spectrum stage of the IMU Application
+**
+** Notes:
+** The power spectrum of a block is checked against a direct DFT of the
+** same windowed block, computed in double precision.
+*/
+
+/*
+ * Includes
+ */
+
+#include <math.h>
+
+#include "imu_app_coveragetest_common.h"
+#include "ut_imu_app.h"
+#include "imu_app_fft.h"
+
+/*
+ * The global data of the app is defined in imu_app.c, which is not
+ * part of this unit
+ */
+IMU_APP_Data_t IMU_APP_Data;
+
+/*
+ * Sets up a table the spectrum accepts: 200 Hz, 64 sample blocks and
+ * bands of 10 Hz up to the Nyquist frequency
+ */
+static void UT_Fft_ValidTable(IMU_APP_Table_t *TblPtr)
+{
+    uint16 b;
+
+    memset(TblPtr, 0, sizeof(*TblPtr));
+    TblPtr->SampleRateHz    = 200;
+    TblPtr->SamplesPerBatch = 25;
+    TblPtr->Content         = IMU_APP_CONTENT_ACCEL;
+    TblPtr->FftWindow       = 64;
+    TblPtr->FftBlocks       = 4;
+    for (b = 0; b <= IMU_APP_FFT_BANDS; b++)
+    {
+        TblPtr->BandEdgesHz[b] = 20 + 10 * b;
+    }
+}
+
+/*
+ * One-sided power of a block by a direct DFT, scaled as IMU_APP_FftAddPower
+ */
+static void UT_Fft_Reference(const float *x, uint16 N, double *Power)
+{
+    double Mean = 0;
+    double SumW2 = 0;
+    double w;
+    double Re;
+    double Im;
+    uint16 k;
+    uint16 n;
+
+    for (n = 0; n < N; n++)
+    {
+        Mean += x[n];
+    }
+    Mean /= N;
+
+    for (n = 0; n < N; n++)
+    {
+        w = 0.5 - 0.5 * cos(2 * M_PI * n / N);
+        SumW2 += w * w;
+    }
+
+    for (k = 0; k <= N / 2; k++)
+    {
+        Re = 0;
+        Im = 0;
+        for (n = 0; n < N; n++)
+        {
+            w = 0.5 - 0.5 * cos(2 * M_PI * n / N);
+            Re += (x[n] - Mean) * w * cos(2 * M_PI * k * n / N);
+            Im -= (x[n] - Mean) * w * sin(2 * M_PI * k * n / N);
+        }
+
+        Power[k] = (Re * Re + Im * Im) / (N * SumW2);
+        if (k != 0 && k != N / 2)
+        {
+            Power[k] *= 2;
+        }
+    }
+}
+
+/*
+**********************************************************************************
+**          TEST CASE FUNCTIONS
+**********************************************************************************
+*/
+
+void Test_IMU_APP_FftValidTable(void)
+{
+    /*
+     * Test Case For:
+     * bool IMU_APP_FftValidTable( const IMU_APP_Table_t *TblPtr )
+     */
+    IMU_APP_Table_t TestTblData;
+
+    UT_Fft_ValidTable(&TestTblData);
+    UtAssert_True(IMU_APP_FftValidTable(&TestTblData), "valid spectrum table accepted");
+
+    /* The band edges are not checked while the spectrum is disabled */
+    TestTblData.FftWindow      = 0;
+    TestTblData.BandEdgesHz[0] = 1000;
+    UtAssert_True(IMU_APP_FftValidTable(&TestTblData), "disabled spectrum accepted");
+
+    UT_Fft_ValidTable(&TestTblData);
+    TestTblData.FftWindow = 96;
+    UtAssert_True(!IMU_APP_FftValidTable(&TestTblData), "window not a power of 2 rejected");
+
+    TestTblData.FftWindow = IMU_APP_FFT_MIN / 2;
+    UtAssert_True(!IMU_APP_FftValidTable(&TestTblData), "window below IMU_APP_FFT_MIN rejected");
+
+    TestTblData.FftWindow = IMU_APP_FFT_MAX * 2;
+    UtAssert_True(!IMU_APP_FftValidTable(&TestTblData), "window above IMU_APP_FFT_MAX rejected");
+
+    UT_Fft_ValidTable(&TestTblData);
+    TestTblData.FftBlocks = 0;
+    UtAssert_True(!IMU_APP_FftValidTable(&TestTblData), "no blocks rejected");
+
+    /* The spectrum needs the accelerometer, read for ACCEL or ATTITUDE */
+    UT_Fft_ValidTable(&TestTblData);
+    TestTblData.Content = IMU_APP_CONTENT_GYRO | IMU_APP_CONTENT_MAG;
+    UtAssert_True(!IMU_APP_FftValidTable(&TestTblData), "content without the accelerometer rejected");
+
+    TestTblData.Content = IMU_APP_CONTENT_ATTITUDE;
+    UtAssert_True(IMU_APP_FftValidTable(&TestTblData), "attitude content accepted");
+
+    UT_Fft_ValidTable(&TestTblData);
+    TestTblData.BandEdgesHz[3] = TestTblData.BandEdgesHz[2];
+    UtAssert_True(!IMU_APP_FftValidTable(&TestTblData), "band edges not increasing rejected");
+
+    UT_Fft_ValidTable(&TestTblData);
+    TestTblData.BandEdgesHz[IMU_APP_FFT_BANDS] = TestTblData.SampleRateHz / 2 + 1;
+    UtAssert_True(!IMU_APP_FftValidTable(&TestTblData), "band edge above Nyquist rejected");
+}
+
+void Test_IMU_APP_FftAddPower(void)
+{
+    /*
+     * Test Case For:
+     * void IMU_APP_FftPlan( uint16 N )
+     * void IMU_APP_FftAddPower( const float *x, uint16 N, float *Power )
+     */
+    static float  Block[IMU_APP_FFT_MAX];
+    static float  Power[IMU_APP_FFT_MAX / 2 + 1];
+    static double Expected[IMU_APP_FFT_MAX / 2 + 1];
+    uint16        Windows[] = {IMU_APP_FFT_MIN, IMU_APP_FFT_MAX};
+    uint16        N;
+    uint16        i;
+    uint16        k;
+    uint32        Seed = 1;
+    double        MaxPower;
+    double        MaxError;
+
+    for (i = 0; i < sizeof(Windows) / sizeof(Windows[0]); i++)
+    {
+        N = Windows[i];
+
+        /* An offset, a tone and pseudo-random noise */
+        for (k = 0; k < N; k++)
+        {
+            Seed     = Seed * 1103515245 + 12345;
+            Block[k] = 500 + 1000 * (float)cos(2 * M_PI * 5 * k / N) + (float)((Seed >> 16) % 201) - 100;
+        }
+
+        UT_Fft_Reference(Block, N, Expected);
+
+        memset(Power, 0, sizeof(Power));
+        IMU_APP_FftPlan(N);
+        IMU_APP_FftAddPower(Block, N, Power);
+
+        MaxPower = 0;
+        MaxError = 0;
+        for (k = 0; k <= N / 2; k++)
+        {
+            MaxPower = fmax(MaxPower, Expected[k]);
+            MaxError = fmax(MaxError, fabs(Power[k] - Expected[k]));
+        }
+
+        UtAssert_True(MaxError < 1e-4 * MaxPower, "N = %u: spectrum matches the DFT (error %g of %g)",
+                      (unsigned int)N, MaxError, MaxPower);
+        UtAssert_True(Power[5] > Power[4] && Power[5] > Power[6], "N = %u: peak at the tone (%g)", (unsigned int)N,
+                      Power[5]);
+
+        /* The power of the following blocks adds up */
+        IMU_APP_FftAddPower(Block, N, Power);
+        UtAssert_True(fabs(Power[5] - 2 * Expected[5]) < 1e-4 * MaxPower, "N = %u: blocks accumulated",
+                      (unsigned int)N);
+    }
+}
+
+void Test_IMU_APP_FftParseval(void)
+{
+    /*
+     * Test Case For:
+     * void IMU_APP_FftAddPower( const float *x, uint16 N, float *Power )
+     */
+    static float Block[IMU_APP_FFT_MAX];
+    static float Power[IMU_APP_FFT_MAX / 2 + 1];
+    uint16       N = 256;
+    uint16       k;
+    double       Sum = 0;
+
+    /* The bins of a tone of amplitude A sum to its mean square, A * A / 2; the offset is removed */
+    for (k = 0; k < N; k++)
+    {
+        Block[k] = 100 + 1000 * (float)sin(2 * M_PI * 32 * k / N);
+    }
+
+    memset(Power, 0, sizeof(Power));
+    IMU_APP_FftPlan(N);
+    IMU_APP_FftAddPower(Block, N, Power);
+
+    for (k = 0; k <= N / 2; k++)
+    {
+        Sum += Power[k];
+    }
+
+    UtAssert_True(fabs(Sum - 500000.0) < 500000.0 * 1e-4, "bins sum to the mean square (%f)", Sum);
+    UtAssert_True(Power[0] < 1e-3, "offset removed (%g)", Power[0]);
+}
+
+/*
+ * Setup function prior to every test
+ */
+void Imu_UT_Setup(void)
+{
+    UT_ResetState(0);
+}
+
+/*
+ * Teardown function after every test
+ */
+void Imu_UT_TearDown(void) {}
+
+/*
+ * Register the test cases to execute with the unit test tool
+ */
+void UtTest_Setup(void)
+{
+    ADD_TEST(IMU_APP_FftValidTable);
+    ADD_TEST(IMU_APP_FftAddPower);
+    ADD_TEST(IMU_APP_FftParseval);
+}
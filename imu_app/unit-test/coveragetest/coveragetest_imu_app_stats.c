@@ -0,0 +1,216 @@
+/*
+**  GSC-18128-1, "Core Flight Executive Version 6.7"
+**
+**  Copyright (c) 2006-2019 United States Government as represented by
+**  the Administrator of the National Aeronautics and Space Administration.
+**  All Rights Reserved.
+**
+**  Licensed under the Apache License, Version 2.0 (the "License");
+**  you may not use this file except in compliance with the License.
+**  You may obtain a copy of the License at
+**
+**    http://www.apache.org/licenses/LICENSE-2.0
+**
+**  Unless required by applicable law or agreed to in writing, software
+**  distributed under the License is distributed on an "AS IS" BASIS,
+**  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**  See the License for the specific language governing permissions and
+**  limitations under the License.
+*/
+
+/*
+** File: coveragetest_imu_app_stats.c
+**
+** Purpose:
+** Coverage Unit Test cases for the statistics stage of the IMU Application
+**
+** Notes:
+** The streaming (Welford) update and the pairwise merge of the
+** accumulators are checked against the statistics computed directly.
+*/
+
+/*
+ * Includes
+ */
+
+#include <math.h>
+
+#include "imu_app_coveragetest_common.h"
+#include "ut_imu_app.h"
+#include "imu_app_stats.h"
+
+/*
+ * The global data of the app is defined in imu_app.c, which is not
+ * part of this unit
+ */
+IMU_APP_Data_t IMU_APP_Data;
+
+/*
+ * Values of the tests: mean 5.5, sum of squared deviations 82.5
+ */
+static const int16_t UT_StatsValues[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+
+#define UT_STATS_COUNT (sizeof(UT_StatsValues) / sizeof(UT_StatsValues[0]))
+#define UT_STATS_MEAN  5.5
+#define UT_STATS_M2    82.5
+
+/*
+**********************************************************************************
+**          TEST CASE FUNCTIONS
+**********************************************************************************
+*/
+
+void Test_IMU_APP_StatsUpdate(void)
+{
+    /*
+     * Test Case For:
+     * void IMU_APP_StatsUpdate( IMU_APP_Accum_t *Accum, int16_t Value )
+     */
+    IMU_APP_Accum_t Accum;
+    uint32          i;
+
+    memset(&Accum, 0, sizeof(Accum));
+
+    /* The order of the values sets the first Min and Max */
+    IMU_APP_StatsUpdate(&Accum, UT_StatsValues[4]);
+    for (i = 0; i < UT_STATS_COUNT; i++)
+    {
+        if (i != 4)
+        {
+            IMU_APP_StatsUpdate(&Accum, UT_StatsValues[i]);
+        }
+    }
+
+    UtAssert_True(Accum.Count == UT_STATS_COUNT, "Count (%lu) == %lu", (unsigned long)Accum.Count,
+                  (unsigned long)UT_STATS_COUNT);
+    UtAssert_True(fabs(Accum.Mean - UT_STATS_MEAN) < 1e-9, "Mean (%f) == %f", Accum.Mean, UT_STATS_MEAN);
+    UtAssert_True(fabs(Accum.M2 - UT_STATS_M2) < 1e-9, "M2 (%f) == %f", Accum.M2, UT_STATS_M2);
+    UtAssert_True(Accum.Min == 1 && Accum.Max == 10, "Min (%d) == 1, Max (%d) == 10", (int)Accum.Min,
+                  (int)Accum.Max);
+
+    /* A single negative value is both the minimum and the maximum */
+    memset(&Accum, 0, sizeof(Accum));
+    IMU_APP_StatsUpdate(&Accum, -32768);
+
+    UtAssert_True(Accum.Min == -32768 && Accum.Max == -32768, "Min and Max of one value");
+    UtAssert_True(Accum.M2 == 0, "M2 (%f) == 0", Accum.M2);
+}
+
+void Test_IMU_APP_StatsMerge(void)
+{
+    /*
+     * Test Case For:
+     * void IMU_APP_StatsMerge( IMU_APP_Accum_t *Into, const IMU_APP_Accum_t *From )
+     */
+    IMU_APP_Accum_t Into;
+    IMU_APP_Accum_t From;
+    IMU_APP_Accum_t Empty;
+    IMU_APP_Accum_t Copy;
+    uint32          i;
+
+    memset(&Into, 0, sizeof(Into));
+    memset(&From, 0, sizeof(From));
+    memset(&Empty, 0, sizeof(Empty));
+
+    /* Two batches of different sizes, the second holding the extremes */
+    for (i = 1; i < 4; i++)
+    {
+        IMU_APP_StatsUpdate(&Into, UT_StatsValues[i]);
+    }
+    IMU_APP_StatsUpdate(&From, UT_StatsValues[0]);
+    for (i = 4; i < UT_STATS_COUNT; i++)
+    {
+        IMU_APP_StatsUpdate(&From, UT_StatsValues[i]);
+    }
+
+    IMU_APP_StatsMerge(&Into, &From);
+
+    UtAssert_True(Into.Count == UT_STATS_COUNT, "Count (%lu) == %lu", (unsigned long)Into.Count,
+                  (unsigned long)UT_STATS_COUNT);
+    UtAssert_True(fabs(Into.Mean - UT_STATS_MEAN) < 1e-9, "Mean (%f) == %f", Into.Mean, UT_STATS_MEAN);
+    UtAssert_True(fabs(Into.M2 - UT_STATS_M2) < 1e-9, "M2 (%f) == %f", Into.M2, UT_STATS_M2);
+    UtAssert_True(Into.Min == 1 && Into.Max == 10, "Min (%d) == 1, Max (%d) == 10", (int)Into.Min, (int)Into.Max);
+
+    /* Merging an empty accumulator changes nothing */
+    Copy = Into;
+    IMU_APP_StatsMerge(&Into, &Empty);
+    UtAssert_True(memcmp(&Copy, &Into, sizeof(Copy)) == 0, "empty accumulator merged");
+
+    /* Merging into an empty accumulator copies the other */
+    IMU_APP_StatsMerge(&Empty, &From);
+    UtAssert_True(memcmp(&Empty, &From, sizeof(From)) == 0, "accumulator merged into an empty one");
+}
+
+void Test_IMU_APP_StatsAddTake(void)
+{
+    /*
+     * Test Case For:
+     * void IMU_APP_StatsAdd( const IMU_APP_Sample_t *Sample )
+     * void IMU_APP_StatsTake( IMU_APP_ChannelStats_t Stats[] )
+     */
+    IMU_APP_ChannelStats_t Stats[IMU_APP_STATS_CHANNELS];
+    IMU_APP_Sample_t       Sample;
+    uint32                 i;
+
+    UT_TEST_FUNCTION_RC(IMU_APP_StatsInit(), OS_SUCCESS);
+
+    memset(&Sample, 0, sizeof(Sample));
+    Sample.Content = IMU_APP_CONTENT_ACCEL | IMU_APP_CONTENT_TEMP;
+
+    /* Accumulators are handed over once per batch */
+    IMU_APP_Data.SamplesPerBatch = 4;
+    for (i = 0; i < 6; i++)
+    {
+        Sample.Accel_x = UT_StatsValues[i];
+        Sample.Temp    = 100;
+        Sample.Flags   = (i == 0) ? IMU_APP_SAMPLE_MAG_NEW : 0;
+        IMU_APP_StatsAdd(&Sample);
+    }
+
+    UtAssert_True(UT_GetStubCount(UT_KEY(OS_MutSemTake)) == 1, "one lock per batch (%lu)",
+                  (unsigned long)UT_GetStubCount(UT_KEY(OS_MutSemTake)));
+
+    IMU_APP_StatsTake(Stats);
+
+    /* Values 1 to 4: mean 2.5, sample variance 5 / 3 */
+    UtAssert_True(Stats[IMU_APP_CH_ACCEL_X].Count == 4, "Accel_x Count (%lu) == 4",
+                  (unsigned long)Stats[IMU_APP_CH_ACCEL_X].Count);
+    UtAssert_True(fabs(Stats[IMU_APP_CH_ACCEL_X].Mean - 2.5) < 1e-6, "Accel_x Mean (%f) == 2.5",
+                  Stats[IMU_APP_CH_ACCEL_X].Mean);
+    UtAssert_True(fabs(Stats[IMU_APP_CH_ACCEL_X].Variance - 5.0 / 3.0) < 1e-6, "Accel_x Variance (%f) == 5/3",
+                  Stats[IMU_APP_CH_ACCEL_X].Variance);
+    UtAssert_True(Stats[IMU_APP_CH_TEMP].Count == 4 && Stats[IMU_APP_CH_TEMP].Variance == 0,
+                  "constant Temp has no variance");
+
+    /* Only the content read is counted, the magnetometer when it has a new measurement */
+    UtAssert_True(Stats[IMU_APP_CH_GYRO_X].Count == 0, "Gyro_x not read");
+    UtAssert_True(Stats[IMU_APP_CH_MAG_X].Count == 1 && Stats[IMU_APP_CH_MAG_X].Variance == 0,
+                  "one new Mag_x measurement");
+
+    /* The window starts again, the last samples are still in the batch */
+    IMU_APP_StatsTake(Stats);
+    UtAssert_True(Stats[IMU_APP_CH_ACCEL_X].Count == 0, "new window is empty");
+}
+
+/*
+ * Setup function prior to every test
+ */
+void Imu_UT_Setup(void)
+{
+    UT_ResetState(0);
+}
+
+/*
+ * Teardown function after every test
+ */
+void Imu_UT_TearDown(void) {}
+
+/*
+ * Register the test cases to execute with the unit test tool
+ */
+void UtTest_Setup(void)
+{
+    ADD_TEST(IMU_APP_StatsUpdate);
+    ADD_TEST(IMU_APP_StatsMerge);
+    ADD_TEST(IMU_APP_StatsAddTake);
+}
@@ -36,6 +36,7 @@
 #define MPU9DOF_H
 
 #include "cfe.h"
+#include "bcm2835_lib.h"
 
 // -------------------------------------------------------------- PUBLIC MACROS 
 /**
@@ -66,10 +67,32 @@
 
 
 /**
- * \defgroup i2c speed. BAUDRATE
+ * \defgroup i2c speed. Clock used before and when the negotiation fails, and the
+ * highest clock tried by mpu9dof_negotiate_i2c for each device
  * \{
  */
-#define BAUDRATE             10000
+#define MPU9DOF_I2C_SPEED            BCM2835_I2C_SPEED_STANDARD
+#define MPU9DOF_I2C_SPEED_MAX_XLG    BCM2835_I2C_SPEED_FAST_PLUS
+#define MPU9DOF_I2C_SPEED_MAX_MAG    BCM2835_I2C_SPEED_FAST
+#define MPU9DOF_I2C_SPEED_TRIALS     4
+/** \} */
+
+/**
+ * \defgroup identification Expected identification register values
+ * \{
+ */
+#define MPU9DOF_WHO_AM_I_XLG_VALUE   0x71
+#define MPU9DOF_WHO_AM_I_MAG_VALUE   0x48
+/** \} */
+
+/**
+ * \defgroup i2c_bus BSC controller the sensor is wired to (see bcm2835I2CBus)
+ * \{
+ */
+#ifndef MPU9DOF_I2C_BUS
+#define MPU9DOF_I2C_BUS      BCM2835_I2C_BUS_BSC1
+#endif
+/** \} */
 
 /**
  * \defgroup i2c_address MPU9150A I2C address
@@ -102,6 +125,12 @@
 #define MPU9DOF_MAG_ASAY                          0x11  // Fuse ROM y-axis sensitivity adjustment value
 #define MPU9DOF_MAG_ASAZ                          0x12  // Fuse ROM z-axis sensitivity adjustment value
 
+#define MPU9DOF_MAG_ST1_DRDY                      0x01  // ST1: data ready
+#define MPU9DOF_MAG_ST2_DERR                      0x04  // ST2: data read error
+#define MPU9DOF_MAG_ST2_HOFL                      0x08  // ST2: magnetic sensor overflow
+#define MPU9DOF_MAG_SINGLE                        0x01  // CNTL: single measurement mode
+#define MPU9DOF_MAG_POLLS_MAX                     50    // Polls without data before the measurement is triggered again
+
 #define MPU9DOF_XGOFFS_TC                         0x00  // Bit 7 PWR_MODE, bits 6:1 XG_OFFS_TC, bit 0 OTP_BNK_VLD
 #define MPU9DOF_YGOFFS_TC                         0x01
 #define MPU9DOF_ZGOFFS_TC                         0x02
@@ -270,8 +299,9 @@ typedef struct
 
     // ctx variable 
 
-    uint8_t slave_address;
-    uint8_t magnetometer_address;
+    bcm2835_i2c_device_t xlg;   // Accelerometer and gyroscope
+    bcm2835_i2c_device_t mag;   // Magnetometer in bypass mode
+    uint16_t mag_polls;         // Polls of mpu9dof_read_mag_ready since the last measurement was triggered
 
 } mpu9dof_t;
 
@@ -285,6 +315,8 @@ typedef struct
 
     uint8_t i2c_address;
     uint8_t i2c_mag_address;
+    uint8_t i2c_bus;
+    uint32_t i2c_speed;
 
 } mpu9dof_cfg_t;
 
@@ -447,6 +479,67 @@ void mpu9dof_read_mag ( mpu9dof_t *ctx, int16_t *mag_x, int16_t *mag_y, int16_t
  */
 float mpu9dof_read_temperature ( mpu9dof_t *ctx );
 
+/**
+ * @brief Function read consecutive accel/gyro registers in one burst
+ *
+ * @param ctx             Click object.
+ * @param reg             First register
+ * @param data_buf        Output data buf
+ * @param len             Number of the registers to be read
+ *
+ * @returns               BCM2835_I2C_REASON_OK if successful
+ *
+ * @description Function reads len registers from reg in a single transaction, unlike
+ * mpu9dof_generic_read it reports the result of the transfer.
+ */
+uint8_t mpu9dof_read_burst ( mpu9dof_t *ctx, uint8_t reg, uint8_t *data_buf, uint8_t len );
+
+/**
+ * @brief Function read the magnetometer if it has new data
+ *
+ * @param ctx             Click object.
+ * @param mag             Magnetometer X-axis, Y-axis and Z-axis data
+ *
+ * @returns               1 if mag holds a new measurement, 0 otherwise
+ *
+ * @description Function reads ST1, the data and ST2 in one transaction. When the data is
+ * ready the next single measurement is started, so calling it every sample period reads
+ * each measurement once without waiting for the conversion. A measurement that never
+ * completes is triggered again after MPU9DOF_MAG_POLLS_MAX calls.
+ */
+uint8_t mpu9dof_read_mag_ready ( mpu9dof_t *ctx, int16_t mag[ 3 ] );
+
+/**
+ * @brief Get the I2C statistics of the sensor
+ *
+ * @param ctx             Click object.
+ * @param stats           Sum of the accel/gyro and magnetometer statistics.
+ *
+ * @description Function adds up the statistics of both I2C device handles.
+ */
+void mpu9dof_get_i2c_stats ( mpu9dof_t *ctx, bcm2835_i2c_device_stats_t *stats );
+
+/**
+ * @brief Negotiate the I2C clock of the sensor
+ *
+ * @param ctx             Click object.
+ *
+ * @description Function finds the highest reliable clock of the accel/gyro and the
+ * magnetometer. Each clock is verified with WHO_AM_I and a readback of the configuration
+ * written by mpu9dof_default_cfg. The caller must own the I2C bus.
+ */
+void mpu9dof_negotiate_i2c ( mpu9dof_t *ctx );
+
+/**
+ * @brief Revalidate the I2C clock of the sensor
+ *
+ * @param ctx             Click object.
+ *
+ * @description Function backs off the clock of a device that had transfer errors or fails
+ * its verification. Meant to be called periodically while the caller owns the I2C bus.
+ */
+void mpu9dof_revalidate_i2c ( mpu9dof_t *ctx );
+
 /**
  * @brief Get int pin state
  *
@@ -32,6 +32,49 @@
 
 #include "cfe.h"
 
+// ----------------------------------------------- PRIVATE FUNCTION DEFINITIONS
+
+// Function verify the accel/gyro: WHO_AM_I and the configuration of mpu9dof_default_cfg
+static uint8_t mpu9dof_verify_xlg ( bcm2835_i2c_device_t *dev, void *arg )
+{
+    const char expected[ 4 ] = { MPU9DOF_DEFAULT, MPU9DOF_BITS_DLPF_CFG_42HZ,
+                                 MPU9DOF_BITS_FS_1000DPS, MPU9DOF_BITS_AFSL_SEL_8G };
+    char reg[ 1 ];
+    char rx_buf[ 4 ] = { 0 };
+
+    reg[ 0 ] = MPU9DOF_WHO_AM_I_XLG;
+    if ( bcm2835_i2c_device_write_read_rs( dev, reg, 1, rx_buf, 1 ) != BCM2835_I2C_REASON_OK ||
+         rx_buf[ 0 ] != MPU9DOF_WHO_AM_I_XLG_VALUE )
+    {
+        return 0;
+    }
+
+    // SMPLRT_DIV, CONFIG, GYRO_CONFIG and ACCEL_CONFIG are consecutive
+    reg[ 0 ] = MPU9DOF_SMPLRT_DIV;
+    if ( bcm2835_i2c_device_write_read_rs( dev, reg, 1, rx_buf, 4 ) != BCM2835_I2C_REASON_OK )
+    {
+        return 0;
+    }
+
+    return ( memcmp( rx_buf, expected, 4 ) == 0 );
+}
+
+// Function verify the magnetometer: WHO_AM_I read twice
+static uint8_t mpu9dof_verify_mag ( bcm2835_i2c_device_t *dev, void *arg )
+{
+    char reg[ 1 ];
+    char rx_buf[ 2 ] = { 0 };
+
+    reg[ 0 ] = MPU9DOF_WHO_AM_I_MAG;
+    if ( bcm2835_i2c_device_write_read_rs( dev, reg, 1, &rx_buf[ 0 ], 1 ) != BCM2835_I2C_REASON_OK ||
+         bcm2835_i2c_device_write_read_rs( dev, reg, 1, &rx_buf[ 1 ], 1 ) != BCM2835_I2C_REASON_OK )
+    {
+        return 0;
+    }
+
+    return ( rx_buf[ 0 ] == MPU9DOF_WHO_AM_I_MAG_VALUE && rx_buf[ 1 ] == MPU9DOF_WHO_AM_I_MAG_VALUE );
+}
+
 // ------------------------------------------------ PUBLIC FUNCTION DEFINITIONS
 
 void mpu9dof_cfg_setup ( mpu9dof_cfg_t *cfg )
@@ -39,13 +82,16 @@ void mpu9dof_cfg_setup ( mpu9dof_cfg_t *cfg )
  
     cfg->i2c_address = MPU9DOF_XLG_I2C_ADDR_0;
     cfg->i2c_mag_address = MPU9DOF_M_I2C_ADDR_0;
+    cfg->i2c_bus = MPU9DOF_I2C_BUS;
+    cfg->i2c_speed = MPU9DOF_I2C_SPEED;
 }
 
 MPU9DOF_RETVAL mpu9dof_init ( mpu9dof_t *ctx, mpu9dof_cfg_t *cfg )
 {
 
-    ctx->slave_address = cfg->i2c_address;
-    ctx->magnetometer_address = cfg->i2c_mag_address;
+    bcm2835_i2c_device_init( &ctx->xlg, cfg->i2c_bus, cfg->i2c_address, cfg->i2c_speed );
+    bcm2835_i2c_device_init( &ctx->mag, cfg->i2c_bus, cfg->i2c_mag_address, cfg->i2c_speed );
+    ctx->mag_polls = 0;
     
     return MPU9DOF_OK;
 }
@@ -121,8 +167,7 @@ void mpu9dof_generic_write ( mpu9dof_t *ctx, uint8_t reg, uint8_t *data_buf, uin
         tx_buf[ cnt ] = data_buf[ cnt - 1 ]; 
     }
     
-    bcm2835_i2c_setSlaveAddress(ctx->slave_address);
-    bcm2835_i2c_write( tx_buf, len + 1 ); 
+    bcm2835_i2c_device_write( &ctx->xlg, tx_buf, len + 1 ); 
 }
 
 void mpu9dof_generic_read ( mpu9dof_t *ctx, uint8_t reg, char *data_buf, uint8_t len )
@@ -132,8 +177,7 @@ void mpu9dof_generic_read ( mpu9dof_t *ctx, uint8_t reg, char *data_buf, uint8_t
     tx_buf [ 0 ] = reg;
 
     
-    bcm2835_i2c_setSlaveAddress(ctx->slave_address);
-    bcm2835_i2c_write_read_rs( tx_buf, 1, data_buf, len );
+    bcm2835_i2c_device_write_read_rs( &ctx->xlg, tx_buf, 1, data_buf, len );
 }
 
 // Generic write data function MPU-9150 MAG 
@@ -144,8 +188,7 @@ void mpu9dof_write_data_mag ( mpu9dof_t *ctx, uint8_t address, uint8_t write_com
     tx_buf[ 0 ] = address;
     tx_buf[ 1 ] = write_command;
     
-    bcm2835_i2c_setSlaveAddress(ctx->magnetometer_address);
-    bcm2835_i2c_write( tx_buf, 2 ); 
+    bcm2835_i2c_device_write( &ctx->mag, tx_buf, 2 ); 
 }
 
 // Generic read data function MPU-9150 MAG 
@@ -156,8 +199,7 @@ char mpu9dof_read_data_mag ( mpu9dof_t *ctx, uint8_t address )
 
     write_reg[ 0 ] = address;
     
-    bcm2835_i2c_setSlaveAddress(ctx->magnetometer_address);
-    bcm2835_i2c_write_read_rs( write_reg, 1, read_reg, 1 );
+    bcm2835_i2c_device_write_read_rs( &ctx->mag, write_reg, 1, read_reg, 1 );
 
     return read_reg[ 0 ];
 }
@@ -220,6 +262,51 @@ void mpu9dof_read_mag ( mpu9dof_t *ctx, int16_t *mag_x, int16_t *mag_y, int16_t
     *mag_z = mpu9dof_get_axis_mag( ctx, MPU9DOF_MAG_ZOUT_L );
 }
 
+// Function read consecutive accel/gyro registers in one burst
+uint8_t mpu9dof_read_burst ( mpu9dof_t *ctx, uint8_t reg, uint8_t *data_buf, uint8_t len )
+{
+    char tx_buf[ 1 ];
+
+    tx_buf[ 0 ] = reg;
+    return bcm2835_i2c_device_write_read_rs( &ctx->xlg, tx_buf, 1, ( char * )data_buf, len );
+}
+
+// Function read the magnetometer if it has new data
+uint8_t mpu9dof_read_mag_ready ( mpu9dof_t *ctx, int16_t mag[ 3 ] )
+{
+    char tx_buf[ 1 ];
+    uint8_t rx_buf[ 8 ];
+    uint8_t cnt;
+
+    // ST1, HXL to HZH little endian, ST2. Reading ST2 ends the data read.
+    tx_buf[ 0 ] = MPU9DOF_MAG_ST1;
+    if ( bcm2835_i2c_device_write_read_rs( &ctx->mag, tx_buf, 1, ( char * )rx_buf, 8 ) != BCM2835_I2C_REASON_OK ||
+         ( rx_buf[ 0 ] & MPU9DOF_MAG_ST1_DRDY ) == 0 )
+    {
+        if ( ++ctx->mag_polls >= MPU9DOF_MAG_POLLS_MAX )
+        {
+            mpu9dof_write_data_mag( ctx, MPU9DOF_MAG_CNTL, MPU9DOF_MAG_SINGLE );
+            ctx->mag_polls = 0;
+        }
+        return 0;
+    }
+
+    mpu9dof_write_data_mag( ctx, MPU9DOF_MAG_CNTL, MPU9DOF_MAG_SINGLE );
+    ctx->mag_polls = 0;
+
+    if ( rx_buf[ 7 ] & ( MPU9DOF_MAG_ST2_DERR | MPU9DOF_MAG_ST2_HOFL ) )
+    {
+        return 0;
+    }
+
+    for ( cnt = 0; cnt < 3; cnt++ )
+    {
+        mag[ cnt ] = ( int16_t )( rx_buf[ 1 + 2 * cnt ] | ( rx_buf[ 2 + 2 * cnt ] << 8 ) );
+    }
+
+    return 1;
+}
+
 // Function read Temperature data from MPU-9150 XL G register
 float mpu9dof_read_temperature ( mpu9dof_t *ctx )
 {
@@ -238,6 +325,31 @@ float mpu9dof_read_temperature ( mpu9dof_t *ctx )
     return temperature;
 }
 
+// Function add up the I2C statistics of the accel/gyro and the magnetometer
+void mpu9dof_get_i2c_stats ( mpu9dof_t *ctx, bcm2835_i2c_device_stats_t *stats )
+{
+    stats->Transactions = ctx->xlg.stats.Transactions + ctx->mag.stats.Transactions;
+    stats->Bytes = ctx->xlg.stats.Bytes + ctx->mag.stats.Bytes;
+    stats->Errors = ctx->xlg.stats.Errors + ctx->mag.stats.Errors;
+    stats->BusTimeUs = ctx->xlg.stats.BusTimeUs + ctx->mag.stats.BusTimeUs;
+}
+
+// Function negotiate the I2C clock of the accel/gyro and the magnetometer
+void mpu9dof_negotiate_i2c ( mpu9dof_t *ctx )
+{
+    bcm2835_i2c_device_negotiate( &ctx->xlg, MPU9DOF_I2C_SPEED_MAX_XLG, MPU9DOF_I2C_SPEED_TRIALS,
+                                  mpu9dof_verify_xlg, ctx );
+    bcm2835_i2c_device_negotiate( &ctx->mag, MPU9DOF_I2C_SPEED_MAX_MAG, MPU9DOF_I2C_SPEED_TRIALS,
+                                  mpu9dof_verify_mag, ctx );
+}
+
+// Function back off the I2C clock of a device with errors
+void mpu9dof_revalidate_i2c ( mpu9dof_t *ctx )
+{
+    bcm2835_i2c_device_revalidate( &ctx->xlg, mpu9dof_verify_xlg, ctx );
+    bcm2835_i2c_device_revalidate( &ctx->mag, mpu9dof_verify_mag, ctx );
+}
+
 // Function of initialization for the cFS
 int32 MPU9DOF_LIB_Init(void)
 {
@@ -253,14 +365,11 @@ int32 MPU9DOF_LIB_Init(void)
     char            RxBuffer[1] = {0};
     
     // Initialize the i2c
-    if(!bcm2835_i2c_begin()){
+    if(!bcm2835_i2c_bus_begin(MPU9DOF_I2C_BUS)){
         OS_printf("MPU9DOF Lib: I2C begin failed \n");
         return CFE_STATUS_NOT_IMPLEMENTED;
     } 
     
-    // Set the baudrate to the standard freq. 100 KHz
-    bcm2835_i2c_set_baudrate(BAUDRATE);
-    
     // Initialize classes for the mpu9dof config
     mpu9dof_cfg_setup ( &mpu9dofconfig );
     mpu9dof_init ( &mpu9dofclass, &mpu9dofconfig );
@@ -270,7 +379,7 @@ int32 MPU9DOF_LIB_Init(void)
     mpu9dof_generic_read ( &mpu9dofclass, MPU9DOF_WHO_AM_I_XLG, RxBuffer, 1 );
     
     // Check for the expected value
-    if (RxBuffer[0] != 0x71){
+    if (RxBuffer[0] != MPU9DOF_WHO_AM_I_XLG_VALUE){
         OS_printf("MPU9DOF Lib not implemented. Sensor not found. Response: %c. ", RxBuffer[0]);
         return CFE_STATUS_NOT_IMPLEMENTED;
     }
@@ -0,0 +1,217 @@
+/*
+**  GSC-18128-1, "Core Flight Executive Version 6.7"
+**
+**  Copyright (c) 2006-2019 United States Government as represented by
+**  the Administrator of the National Aeronautics and Space Administration.
+**  All Rights Reserved.
+**
+**  Licensed under the Apache License, Version 2.0 (the "License");
+**  you may not use this file except in compliance with the License.
+**  You may obtain a copy of the License at
+**
+**    http://www.apache.org/licenses/LICENSE-2.0
+**
+**  Unless required by applicable law or agreed to in writing, software
+**  distributed under the License is distributed on an "AS IS" BASIS,
+**  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**  See the License for the specific language governing permissions and
+**  limitations under the License.
+*/
+
+/*
+** File: mpu9dof_lib_stubs.c
+**
+** Purpose:
+** Unit test stubs for the MPU9DOF library
+**
+** Notes:
+** This defines the same functions as the public API of the
+** Library, to support testing of the apps that use the sensor.
+**
+** Functions with output parameters zero them, then copy them from
+** the data buffer of the stub if the test case set one.
+*/
+
+/*
+ * The stub functions always share the same API header file as the
+ * main FSW code does.  This should define the same functions
+ * with the same parameters.
+ */
+#include "mpu9dof_lib.h"
+
+#include <string.h>
+
+/*
+ * The "utstubs.h" provides the generic stub framework from UT Assert
+ */
+#include "utstubs.h"
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* Initialization stubs                                            */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+int32 MPU9DOF_LIB_Init(void)
+{
+    return UT_DEFAULT_IMPL(MPU9DOF_LIB_Init);
+} /* End MPU9DOF_LIB_Init */
+
+void mpu9dof_cfg_setup(mpu9dof_cfg_t *cfg)
+{
+    UT_DEFAULT_IMPL(mpu9dof_cfg_setup);
+
+    memset(cfg, 0, sizeof(*cfg));
+    UT_Stub_CopyToLocal(UT_KEY(mpu9dof_cfg_setup), cfg, sizeof(*cfg));
+
+} /* End mpu9dof_cfg_setup */
+
+MPU9DOF_RETVAL mpu9dof_init(mpu9dof_t *ctx, mpu9dof_cfg_t *cfg)
+{
+    return UT_DEFAULT_IMPL(mpu9dof_init);
+} /* End mpu9dof_init */
+
+void mpu9dof_default_cfg(mpu9dof_t *ctx)
+{
+    UT_DEFAULT_IMPL(mpu9dof_default_cfg);
+} /* End mpu9dof_default_cfg */
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* Register access stubs                                           */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void mpu9dof_generic_write(mpu9dof_t *ctx, uint8_t reg, uint8_t *data_buf, uint8_t len)
+{
+    UT_Stub_RegisterContextGenericArg(UT_KEY(mpu9dof_generic_write), reg);
+
+    UT_DEFAULT_IMPL(mpu9dof_generic_write);
+
+} /* End mpu9dof_generic_write */
+
+void mpu9dof_generic_read(mpu9dof_t *ctx, uint8_t reg, char *data_buf, uint8_t len)
+{
+    UT_Stub_RegisterContextGenericArg(UT_KEY(mpu9dof_generic_read), reg);
+
+    UT_DEFAULT_IMPL(mpu9dof_generic_read);
+
+    memset(data_buf, 0, len);
+    UT_Stub_CopyToLocal(UT_KEY(mpu9dof_generic_read), data_buf, len);
+
+} /* End mpu9dof_generic_read */
+
+void mpu9dof_write_data_mag(mpu9dof_t *ctx, uint8_t address, uint8_t write_command)
+{
+    UT_DEFAULT_IMPL(mpu9dof_write_data_mag);
+} /* End mpu9dof_write_data_mag */
+
+char mpu9dof_read_data_mag(mpu9dof_t *ctx, uint8_t address)
+{
+    return UT_DEFAULT_IMPL(mpu9dof_read_data_mag);
+} /* End mpu9dof_read_data_mag */
+
+int16_t mpu9dof_get_axis(mpu9dof_t *ctx, uint8_t adr_reg_high)
+{
+    return UT_DEFAULT_IMPL(mpu9dof_get_axis);
+} /* End mpu9dof_get_axis */
+
+int16_t mpu9dof_get_axis_mag(mpu9dof_t *ctx, uint8_t adr_reg_low)
+{
+    return UT_DEFAULT_IMPL(mpu9dof_get_axis_mag);
+} /* End mpu9dof_get_axis_mag */
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* Measurement stubs                                               */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void mpu9dof_read_gyro(mpu9dof_t *ctx, int16_t *gyro_x, int16_t *gyro_y, int16_t *gyro_z)
+{
+    UT_DEFAULT_IMPL(mpu9dof_read_gyro);
+
+    *gyro_x = 0;
+    *gyro_y = 0;
+    *gyro_z = 0;
+
+} /* End mpu9dof_read_gyro */
+
+void mpu9dof_read_accel(mpu9dof_t *ctx, int16_t *accel_x, int16_t *accel_y, int16_t *accel_z)
+{
+    UT_DEFAULT_IMPL(mpu9dof_read_accel);
+
+    *accel_x = 0;
+    *accel_y = 0;
+    *accel_z = 0;
+
+} /* End mpu9dof_read_accel */
+
+void mpu9dof_read_mag(mpu9dof_t *ctx, int16_t *mag_x, int16_t *mag_y, int16_t *mag_z)
+{
+    UT_DEFAULT_IMPL(mpu9dof_read_mag);
+
+    *mag_x = 0;
+    *mag_y = 0;
+    *mag_z = 0;
+
+} /* End mpu9dof_read_mag */
+
+float mpu9dof_read_temperature(mpu9dof_t *ctx)
+{
+    return UT_DEFAULT_IMPL(mpu9dof_read_temperature);
+} /* End mpu9dof_read_temperature */
+
+uint8_t mpu9dof_read_burst(mpu9dof_t *ctx, uint8_t reg, uint8_t *data_buf, uint8_t len)
+{
+    uint8_t status;
+
+    UT_Stub_RegisterContextGenericArg(UT_KEY(mpu9dof_read_burst), reg);
+    UT_Stub_RegisterContextGenericArg(UT_KEY(mpu9dof_read_burst), len);
+
+    /* BCM2835_I2C_REASON_OK (0) unless the test case sets another value */
+    status = UT_DEFAULT_IMPL(mpu9dof_read_burst);
+
+    memset(data_buf, 0, len);
+    UT_Stub_CopyToLocal(UT_KEY(mpu9dof_read_burst), data_buf, len);
+
+    return status;
+
+} /* End mpu9dof_read_burst */
+
+uint8_t mpu9dof_read_mag_ready(mpu9dof_t *ctx, int16_t mag[3])
+{
+    uint8_t status;
+
+    /* No new measurement (0) unless the test case sets another value */
+    status = UT_DEFAULT_IMPL(mpu9dof_read_mag_ready);
+    if (status != 0)
+    {
+        memset(mag, 0, 3 * sizeof(mag[0]));
+        UT_Stub_CopyToLocal(UT_KEY(mpu9dof_read_mag_ready), mag, 3 * sizeof(mag[0]));
+    }
+
+    return status;
+
+} /* End mpu9dof_read_mag_ready */
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                                                 */
+/* I2C clock and statistics stubs                                  */
+/*                                                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void mpu9dof_get_i2c_stats(mpu9dof_t *ctx, bcm2835_i2c_device_stats_t *stats)
+{
+    UT_DEFAULT_IMPL(mpu9dof_get_i2c_stats);
+
+    memset(stats, 0, sizeof(*stats));
+    UT_Stub_CopyToLocal(UT_KEY(mpu9dof_get_i2c_stats), stats, sizeof(*stats));
+
+} /* End mpu9dof_get_i2c_stats */
+
+void mpu9dof_negotiate_i2c(mpu9dof_t *ctx)
+{
+    UT_DEFAULT_IMPL(mpu9dof_negotiate_i2c);
+} /* End mpu9dof_negotiate_i2c */
+
+void mpu9dof_revalidate_i2c(mpu9dof_t *ctx)
+{
+    UT_DEFAULT_IMPL(mpu9dof_revalidate_i2c);
+} /* End mpu9dof_revalidate_i2c */